@@ -125,6 +125,27 @@ Allocator& Allocator::get_default() noexcept
     return default_alloc;
 }
 
+bool Allocator::prefetch(ref_type ref, size_t size) const noexcept
+{
+    auto ref_translation_ptr = m_ref_translation_ptr.load(std::memory_order_acquire);
+    if (!ref_translation_ptr)
+        return false;
+#if REALM_ENABLE_ENCRYPTION
+    // Decrypted pages are filled in by decryption rather than being read from
+    // the file
+    if (ref_translation_ptr[0].encrypted_mapping)
+        return false;
+#endif
+    // Memory which is not part of the file is in memory already
+    if (!is_read_only(ref))
+        return true;
+    size_t idx = get_section_index(ref);
+    size_t offset = ref - get_section_base(idx);
+    size = std::min(size, get_section_base(1) - offset);
+    util::File::advise_map(ref_translation_ptr[idx].mapping_addr + offset, size, util::File::advice_WillNeed);
+    return true;
+}
+
 // This function is called to handle translation of a ref which is above the limit for its
 // memory mapping. This requires one of three:
 // * bumping the limit of the mapping. (if the entire array is inside the mapping)
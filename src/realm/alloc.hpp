@@ -114,6 +114,14 @@ public:
     /// Calls do_translate().
     char* translate(ref_type ref) const noexcept;
 
+    /// Advise the operating system that the specified part of the file will
+    /// be accessed soon, without accessing it. Parts of the range which lie
+    /// in another 64MB section of the file than \a ref are ignored. Returns
+    /// false if this allocator cannot make use of such advice at all, e.g.
+    /// because the file is encrypted, in which case accessing the memory to
+    /// find out what to advise would not be worthwhile either.
+    bool prefetch(ref_type ref, size_t size) const noexcept;
+
     /// Returns true if, and only if the object at the specified 'ref'
     /// is in the immutable part of the memory managed by this
     /// allocator. The method by which some objects become part of the
@@ -140,6 +140,7 @@ void SlabAlloc::detach() noexcept
         case attach_UnsharedFile:
             m_data = 0;
             m_mappings.clear();
+            m_access_advice = util::File::advice_Normal;
             m_youngest_live_version = 0;
             m_file.close();
             break;
@@ -715,7 +716,7 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
     auto physical_file_size = m_file.get_size();
     // Note that get_size() may (will) return a different size before and after
     // the call below to set_encryption_key.
-    m_file.set_encryption_key(cfg.encryption_key);
+    m_file.set_encryption_key(cfg.encryption_key, cfg.encryption_format);
     File::CloseGuard fcg(m_file);
 
     size_t size = 0;
@@ -1203,6 +1204,13 @@ void SlabAlloc::update_reader_view(size_t file_size)
 
     rebuild_freelists_from_slab();
 
+    // The kernel forgets the access pattern advice along with the mapping, so
+    // it must be given again for every section which was (re)mapped above
+    if (m_access_advice != util::File::advice_Normal) {
+        for (size_t k = (old_num_mappings > 0 ? old_num_mappings - 1 : 0); k < m_mappings.size(); ++k)
+            m_mappings[k].primary_mapping.advise(m_access_advice);
+    }
+
     // Build the fast path mapping
 
     // The fast path mapping is an array which will is used from multiple threads
@@ -1381,6 +1389,34 @@ void SlabAlloc::resize_file(size_t new_file_size)
         m_file.sync(); // Throws
 }
 
+void SlabAlloc::shrink_file(size_t new_file_size)
+{
+    REALM_ASSERT_EX(new_file_size == round_up_to_page_size(new_file_size), get_file_path_for_assertions());
+    if (new_file_size >= static_cast<size_t>(m_file.get_size()))
+        return;
+    m_file.resize(new_file_size); // Throws
+
+    bool disable_sync = get_disable_sync_to_disk() || m_cfg.disable_sync;
+    if (!disable_sync)
+        m_file.sync(); // Throws
+}
+
+void SlabAlloc::advise_file_mappings(util::File::MapAdvice advice) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mapping_mutex);
+    for (auto& entry : m_mappings)
+        entry.primary_mapping.advise(advice);
+}
+
+void SlabAlloc::set_file_access_advice(util::File::MapAdvice advice) noexcept
+{
+    REALM_ASSERT(advice != util::File::advice_WillNeed);
+    std::lock_guard<std::mutex> lock(m_mapping_mutex);
+    m_access_advice = advice;
+    for (auto& entry : m_mappings)
+        entry.primary_mapping.advise(advice);
+}
+
 #ifdef REALM_DEBUG
 void SlabAlloc::reserve_disk_space(size_t size)
 {
@@ -93,6 +93,10 @@ public:
     /// 32-byte key to use to encrypt and decrypt the backing storage,
     /// or nullptr to disable encryption.
     ///
+    /// \var Config::encryption_format
+    /// The format to encrypt the file in if it is empty. Non-empty files
+    /// keep their format.
+    ///
     /// \var Config::session_initiator
     /// If set, the caller is the session initiator and
     /// guarantees exclusive access to the file. If attaching in
@@ -114,6 +118,7 @@ public:
         bool clear_file = false;
         bool disable_sync = false;
         const char* encryption_key = nullptr;
+        util::File::EncryptionFormat encryption_format = util::File::encryption_AesCbcHmac;
     };
 
     struct Retry {
@@ -229,6 +234,26 @@ public:
     /// attached to a file. Doing so will result in undefined behavior.
     void resize_file(size_t new_file_size);
 
+    /// Truncate the attached file to the specified size, which must be page
+    /// aligned and must not be smaller than the logical size of any version
+    /// of the database that may still be accessed. Mappings of the released
+    /// part of the file are left in place, but must not be accessed.
+    ///
+    /// This function will call File::sync().
+    void shrink_file(size_t new_file_size);
+
+    /// Advise the operating system about how the currently mapped part of the
+    /// attached file will be accessed, see util::File::advise_map(). With
+    /// util::File::advice_WillNeed the file is read into memory in the
+    /// background. This has no effect for encrypted files.
+    void advise_file_mappings(util::File::MapAdvice) noexcept;
+
+    /// Set the access pattern advice (util::File::advice_Sequential,
+    /// util::File::advice_Random or util::File::advice_Normal) for the whole
+    /// attached file. Unlike advise_file_mappings(), the advice is remembered
+    /// and also applied to the mappings which are added when the file grows.
+    void set_file_access_advice(util::File::MapAdvice) noexcept;
+
 #ifdef REALM_DEBUG
     /// Deprecated method, only called from a unit test
     ///
@@ -589,6 +614,7 @@ private:
     uint64_t m_mapping_version = 1;
     uint64_t m_youngest_live_version = 1;
     std::mutex m_mapping_mutex;
+    util::File::MapAdvice m_access_advice = util::File::advice_Normal;
     util::File m_file;
     util::SharedFileInfo* m_realm_file_info = nullptr;
     // vectors where old mappings, are held from deletion to ensure translations are
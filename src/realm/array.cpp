@@ -33,6 +33,7 @@
 #endif
 
 #include <realm/utilities.hpp>
+#include <realm/util/file.hpp>
 #include <realm/array.hpp>
 #include <realm/array_basic.hpp>
 #include <realm/impl/destroy_guard.hpp>
@@ -281,6 +282,47 @@ void Array::destroy_children(size_t offset) noexcept
 }
 
 
+void Array::prefetch_deep(ref_type ref, Allocator& alloc) noexcept
+{
+    // Nothing is read if the advice would have no effect anyway
+    if (!alloc.prefetch(ref, NodeHeader::header_size))
+        return;
+    const char* header = alloc.translate(ref);
+    alloc.prefetch(ref, get_byte_size_from_header(header));
+    if (!get_hasrefs_from_header(header))
+        return;
+
+    // Children are only read if they have children of their own. The first
+    // child tells whether that is the case, as siblings are nodes of the same
+    // kind and, in a B+tree, at the same level. Leaves are advised without
+    // being read, assuming they are about as large as the first one.
+    size_t size = get_size_from_header(header);
+    bool descend = false;
+    size_t leaf_size = util::page_size();
+    bool first = true;
+    for (size_t i = 0; i < size; ++i) {
+        int64_t value = get(header, i);
+        // Skip null-refs and tagged integers, as in destroy_children()
+        if (value == 0 || (value & 1) != 0)
+            continue;
+        ref_type child_ref = to_ref(value);
+        if (first) {
+            first = false;
+            const char* child_header = alloc.translate(child_ref);
+            descend = get_hasrefs_from_header(child_header);
+            if (get_is_inner_bptree_node_from_header(header))
+                leaf_size = std::max(leaf_size, get_byte_size_from_header(child_header));
+        }
+        if (descend) {
+            prefetch_deep(child_ref, alloc);
+        }
+        else {
+            alloc.prefetch(child_ref, leaf_size);
+        }
+    }
+}
+
+
 ref_type Array::do_write_shallow(_impl::ArrayWriterBase& out) const
 {
     // Write flat array
@@ -318,6 +360,76 @@ ref_type Array::do_write_deep(_impl::ArrayWriterBase& out, bool only_if_modified
 }
 
 
+ref_type Array::write_unmodified(ref_type ref, Allocator& alloc, _impl::ArrayWriterBase& out)
+{
+    bool settled;
+    return write_unmodified(ref, alloc, out, settled); // Throws
+}
+
+
+ref_type Array::write_unmodified(ref_type ref, Allocator& alloc, _impl::ArrayWriterBase& out, bool& settled)
+{
+    // Subtrees found to stay in place by an earlier commit are not visited
+    // again, so that successive compaction steps do not have to walk the
+    // entire file.
+    settled = out.is_settled(ref);
+    if (settled)
+        return ref;
+
+    Array array(alloc);
+    array.init_from_ref(ref);
+    size_t byte_size = array.get_byte_size();
+    bool relocate = out.must_relocate(ref, byte_size); // Throws
+
+    // Subarrays must be visited even if this array stays where it is, as
+    // they may have to be relocated themselves. A copy with updated refs is
+    // only created once the first subarray has actually moved.
+    Array new_array(Allocator::get_default());
+    _impl::ShallowArrayDestroyGuard dg(&new_array);
+    bool all_settled = !relocate;
+    if (array.m_has_refs) {
+        size_t n = array.size();
+        for (size_t i = 0; i < n; ++i) {
+            int_fast64_t value = array.get(i);
+            bool is_ref = (value != 0 && (value & 1) == 0);
+            if (!is_ref)
+                continue;
+            if (!out.relocates_unmodified()) {
+                all_settled = false;
+                break;
+            }
+            ref_type subref = to_ref(value);
+            bool subref_settled;
+            ref_type new_subref = write_unmodified(subref, alloc, out, subref_settled); // Throws
+            all_settled = all_settled && subref_settled;
+            if (new_subref == subref)
+                continue;
+            if (!new_array.is_attached()) {
+                Type type = array.m_is_inner_bptree_node ? type_InnerBptreeNode : type_HasRefs;
+                new_array.create(type, array.m_context_flag); // Throws
+                for (size_t j = 0; j < n; ++j)
+                    new_array.add(array.get(j)); // Throws
+            }
+            new_array.set(i, from_ref(new_subref)); // Throws
+        }
+    }
+
+    ref_type new_ref;
+    if (new_array.is_attached()) {
+        new_ref = new_array.do_write_shallow(out); // Throws
+    }
+    else if (relocate) {
+        new_ref = array.do_write_shallow(out); // Throws
+    }
+    else {
+        settled = all_settled && out.settle(ref, array.m_has_refs); // Throws
+        return ref;
+    }
+    out.relocated(ref, byte_size);
+    return new_ref;
+}
+
+
 void Array::move(size_t begin, size_t end, size_t dest_begin)
 {
     REALM_ASSERT_3(begin, <=, end);
@@ -58,6 +58,7 @@ Searching: The main finding function is:
 #include <realm/column_fwd.hpp>
 #include <realm/array_direct.hpp>
 #include <realm/array_unsigned.hpp>
+#include <realm/impl/array_writer.hpp>
 
 /*
     MMX: mmintrin.h
@@ -86,9 +87,6 @@ inline T no0(T v)
 struct ObjKey;
 class Array;
 class GroupWriter;
-namespace _impl {
-class ArrayWriterBase;
-}
 
 template <class T>
 class BPlusTree;
@@ -424,6 +422,14 @@ public:
     /// destroy_deep() for every contained 'ref' element.
     static void destroy_deep(MemRef, Allocator&) noexcept;
 
+    /// Advise the operating system that the specified array node and all of
+    /// its children will be accessed soon, so that the parts of the file
+    /// holding them can be read in the background (see
+    /// Allocator::prefetch()). The node itself, and nodes which have children
+    /// of their own, are read to find their children, but leaves are not
+    /// accessed.
+    static void prefetch_deep(ref_type ref, Allocator& alloc) noexcept;
+
     // Clone deep
     static MemRef clone(MemRef, Allocator& from_alloc, Allocator& target_alloc);
 
@@ -442,7 +448,10 @@ public:
     /// to \a only_if_modified.
     ///
     /// \param only_if_modified Set to `false` to always write, or to `true` to
-    /// only write the array if it has been modified.
+    /// only write the array if it has been modified. Unmodified arrays are
+    /// still written if the writer asks for them to be relocated (see
+    /// _impl::ArrayWriterBase::must_relocate()), and so are unmodified arrays
+    /// whose subarrays were relocated.
     ref_type write(_impl::ArrayWriterBase& out, bool deep, bool only_if_modified) const;
 
     /// Same as non-static write() with `deep` set to true. This is for the
@@ -743,6 +752,8 @@ protected:
 private:
     ref_type do_write_shallow(_impl::ArrayWriterBase&) const;
     ref_type do_write_deep(_impl::ArrayWriterBase&, bool only_if_modified) const;
+    static ref_type write_unmodified(ref_type, Allocator&, _impl::ArrayWriterBase&);
+    static ref_type write_unmodified(ref_type, Allocator&, _impl::ArrayWriterBase&, bool& settled);
 
     friend class Allocator;
     friend class SlabAlloc;
@@ -1082,8 +1093,11 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
 {
     REALM_ASSERT(is_attached());
 
-    if (only_if_modified && m_alloc.is_read_only(m_ref))
-        return m_ref;
+    if (only_if_modified && m_alloc.is_read_only(m_ref)) {
+        if (REALM_LIKELY(!deep || !out.relocates_unmodified()))
+            return m_ref;
+        return write_unmodified(m_ref, m_alloc, out); // Throws
+    }
 
     if (!deep || !m_has_refs)
         return do_write_shallow(out); // Throws
@@ -1093,8 +1107,11 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
 
 inline ref_type Array::write(ref_type ref, Allocator& alloc, _impl::ArrayWriterBase& out, bool only_if_modified)
 {
-    if (only_if_modified && alloc.is_read_only(ref))
-        return ref;
+    if (only_if_modified && alloc.is_read_only(ref)) {
+        if (REALM_LIKELY(!out.relocates_unmodified()))
+            return ref;
+        return write_unmodified(ref, alloc, out); // Throws
+    }
 
     Array array(alloc);
     array.init_from_ref(ref);
@@ -25,6 +25,7 @@
 #include <mutex>
 #include <sstream>
 #include <type_traits>
+#include <thread>
 #include <random>
 
 #include <realm/util/features.h>
@@ -79,7 +80,8 @@ const uint16_t relaxed_sync_threshold = 50;
 //  9      Fair write transactions requires an additional condition variable,
 //         `write_fairness`
 // 10      Introducing SharedInfo::history_schema_version.
-const uint_fast16_t g_shared_info_version = 10;
+// 11      Introducing SharedInfo::commits_not_durable in place of filler_1.
+const uint_fast16_t g_shared_info_version = 11;
 
 // The following functions are carefully designed for minimal overhead
 // in case of contention among read transactions. In case of contention,
@@ -352,6 +354,20 @@ public:
         put_pos.store(uint32_t(next()), std::memory_order_release);
     }
 
+    // Visit all entries from the oldest to the last one. Caller must hold the
+    // write mutex, so that no entries are added or removed concurrently.
+    template <class F>
+    void for_each_entry(F&& func) const noexcept
+    {
+        uint_fast32_t idx = old_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            func(get(idx));
+            if (idx == put_pos.load(std::memory_order_relaxed))
+                break;
+            idx = get(idx).next;
+        }
+    }
+
     void cleanup() noexcept
     {
         // invariant: entry held by put_pos has count > 1.
@@ -494,7 +510,13 @@ struct alignas(8) DB::SharedInfo {
     /// Cleared by the daemon when it decides to exit.
     uint8_t daemon_ready = 0; // Offset 42
 
-    uint8_t filler_1; // Offset 43
+    /// Set (1) while the latest commits have been made without syncing them
+    /// to disk (see Transaction::commit_and_continue_writing()), and the file
+    /// header still refers to an earlier version. May be accessed only while
+    /// holding the write mutex. If it is set when the write mutex is acquired
+    /// by a DB object which did not make those commits, their writer died
+    /// before making them durable.
+    uint8_t commits_not_durable = 0; // Offset 43
 
     /// Stores a history schema version (as returned by
     /// Replication::get_history_schema_version()). Must match across all
@@ -606,7 +628,8 @@ DB::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht, int hsv
             std::is_same<decltype(sync_agent_present), uint8_t>::value &&
             offsetof(SharedInfo, daemon_started) == 41 && std::is_same<decltype(daemon_started), uint8_t>::value &&
             offsetof(SharedInfo, daemon_ready) == 42 && std::is_same<decltype(daemon_ready), uint8_t>::value &&
-            offsetof(SharedInfo, filler_1) == 43 && std::is_same<decltype(filler_1), uint8_t>::value &&
+            offsetof(SharedInfo, commits_not_durable) == 43 &&
+            std::is_same<decltype(commits_not_durable), uint8_t>::value &&
             offsetof(SharedInfo, history_schema_version) == 44 &&
             std::is_same<decltype(history_schema_version), uint16_t>::value && offsetof(SharedInfo, filler_2) == 46 &&
             std::is_same<decltype(filler_2), uint16_t>::value && offsetof(SharedInfo, shared_writemutex) == 48 &&
@@ -1012,6 +1035,7 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             cfg.clear_file = (options.durability == Durability::MemOnly && begin_new_session);
 
             cfg.encryption_key = m_key;
+            cfg.encryption_format = m_encryption_format;
             ref_type top_ref;
             try {
                 top_ref = alloc.attach_file(path, cfg); // Throws
@@ -1037,6 +1061,10 @@ void DB::do_open(const std::string& path, bool no_create_file, bool is_backend,
             }
             // If we fail in any way, we must detach the allocator.
             SlabAlloc::DetachGuard alloc_detach_guard(alloc);
+            if (options.access_advice != util::File::advice_Normal)
+                alloc.set_file_access_advice(options.access_advice);
+            if (options.prefetch_on_open)
+                alloc.advise_file_mappings(util::File::advice_WillNeed);
             alloc.note_reader_start(this);
             // must come after the alloc detach guard
             auto handler = [this, &alloc]() noexcept {
@@ -1383,7 +1411,8 @@ void DB::open(Replication& repl, const DBOptions options)
 // Unmapping (during close()) while transactions are live, is not considered an error. There
 // is a potential race between unmapping during close() and any operation carried out by a live
 // transaction. The user must ensure that this race never happens if she uses DB::close().
-bool DB::compact(bool bump_version_number, util::Optional<const char*> output_encryption_key)
+bool DB::compact(bool bump_version_number, util::Optional<const char*> output_encryption_key,
+                 util::Optional<util::File::EncryptionFormat> output_encryption_format)
 {
     std::string tmp_path = m_db_path + ".tmp_compaction_space";
 
@@ -1398,6 +1427,11 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
     SharedInfo* info = m_file_map.get_addr();
     Durability dura = Durability(info->durability);
     const char* write_key = bool(output_encryption_key) ? *output_encryption_key : m_key;
+    util::File::EncryptionFormat write_format = m_encryption_format;
+    if (output_encryption_format)
+        write_format = *output_encryption_format;
+    else if (m_key)
+        write_format = m_alloc.get_file().get_encryption_format();
     {
         std::unique_lock<InterprocessMutex> lock(m_controlmutex); // Throws
 
@@ -1430,7 +1464,7 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
             File file;
             file.open(tmp_path, File::access_ReadWrite, File::create_Must, 0);
             int incr = bump_version_number ? 1 : 0;
-            tr->write(file, write_key, info->latest_version_number + incr, true); // Throws
+            tr->write(file, write_key, info->latest_version_number + incr, true, write_format); // Throws
             // Data needs to be flushed to the disk before renaming.
             bool disable_sync = get_disable_sync_to_disk();
             if (!disable_sync && dura != Durability::Unsafe)
@@ -1474,6 +1508,7 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
         cfg.no_create = true;
         cfg.clear_file = false;
         cfg.encryption_key = write_key;
+        cfg.encryption_format = write_format;
         ref_type top_ref;
         top_ref = m_alloc.attach_file(m_db_path, cfg);
         m_alloc.init_mapping_management(info->latest_version_number);
@@ -1485,6 +1520,55 @@ bool DB::compact(bool bump_version_number, util::Optional<const char*> output_en
     return true;
 }
 
+DB::CompactionProgress DB::compact_step(size_t max_relocation_size)
+{
+    TransactionRef tr = start_write(); // Throws
+    // The budget is picked up (and cleared) by low_level_commit(). Clear it
+    // here as well in case the commit fails before that, while the write lock
+    // is still held.
+    m_compaction_budget = std::max(max_relocation_size, size_t(1));
+    auto reset_budget = util::make_scope_exit([&]() noexcept {
+        m_compaction_budget = 0;
+    });
+    m_compaction_progress = CompactionProgress();
+    tr->commit(); // Throws
+    return m_compaction_progress;
+}
+
+void DB::compact_incrementally(const IncrementalCompactionConfig& config)
+{
+    // Space vacated by a step only becomes free once the version committed by
+    // that step has been superseded, so it can take a couple of steps without
+    // visible progress before the file shrinks. Every commit also places a new
+    // top array and free-list near the end of the file, so once compaction has
+    // converged the size oscillates slightly; only a new minimum counts as
+    // progress.
+    // Steps which did not get to look at all of the file say nothing about
+    // whether more progress is possible.
+    const int max_idle_steps = 3;
+    int idle_steps = 0;
+    size_t min_file_size = std::numeric_limits<size_t>::max();
+    while (idle_steps < max_idle_steps) {
+        CompactionProgress progress = compact_step(config.max_relocation_size); // Throws
+        if (progress.relocated_size != 0 || progress.file_size < min_file_size) {
+            min_file_size = std::min(min_file_size, progress.file_size);
+            idle_steps = 0;
+        }
+        else if (!progress.incomplete) {
+            ++idle_steps;
+        }
+        if (config.progress_handler && !config.progress_handler(progress))
+            return;
+        if (config.pause_between_steps.count() > 0)
+            std::this_thread::sleep_for(config.pause_between_steps);
+    }
+}
+
+void DB::compact_incrementally()
+{
+    compact_incrementally(IncrementalCompactionConfig()); // Throws
+}
+
 uint_fast64_t DB::get_number_of_versions()
 {
     SharedInfo* info = m_file_map.get_addr();
@@ -1957,6 +2041,14 @@ bool DB::do_try_begin_write()
     return got_the_lock;
 }
 
+bool DB::probe_write_lock()
+{
+    if (!m_writemutex.try_lock())
+        return false;
+    m_writemutex.unlock();
+    return true;
+}
+
 void DB::do_begin_write()
 {
     SharedInfo* info = m_file_map.get_addr();
@@ -2027,6 +2119,24 @@ void DB::finish_begin_write()
         throw std::runtime_error("Crash of other process detected, session restart required");
     }
 
+    if (!info->commits_not_durable) {
+        // Another DB object may have made our earlier commits durable
+        m_last_durable_version = 0;
+    }
+    else if (!m_last_durable_version) {
+        // The writer which made the latest commits without syncing them to
+        // disk released the write mutex without making them durable, which
+        // means that it died. Make them durable before anything can overwrite
+        // the space of the version which the file header refers to.
+        try {
+            sync_latest_version(); // Throws
+        }
+        catch (...) {
+            m_writemutex.unlock();
+            throw;
+        }
+    }
+
 #ifdef REALM_ASYNC_DAEMON
     if (info->durability == static_cast<uint16_t>(Durability::Async)) {
 
@@ -2047,6 +2157,50 @@ void DB::finish_begin_write()
 }
 
 
+void DB::make_commits_durable()
+{
+    if (!m_last_durable_version)
+        return;
+
+    sync_latest_version(); // Throws
+    m_last_durable_version = 0;
+}
+
+void DB::sync_latest_version()
+{
+    ref_type top_ref;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        SharedInfo* r_info = m_reader_map.get_addr();
+        top_ref = to_ref(r_info->readers.get_last().current_top);
+    }
+
+    // This is the same as GroupWriter::commit(), except that the data of the
+    // latest version has already been written to the file, possibly through
+    // mappings which no longer exist, so the entire file is synced
+    SharedInfo* info = m_file_map.get_addr();
+    bool disable_sync = get_disable_sync_to_disk() || Durability(info->durability) == Durability::Unsafe;
+    util::File& file = m_alloc.get_file();
+    if (!disable_sync)
+        file.sync(); // Throws
+
+    using Header = SlabAlloc::Header;
+    util::File::Map<Header> map(file, util::File::access_ReadWrite); // Throws
+    Header& header = *map.get_addr();
+    unsigned new_flags = header.m_flags ^ SlabAlloc::flags_SelectBit;
+    int old_slot = (header.m_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0;
+    int new_slot = 1 - old_slot;
+    header.m_file_format[new_slot] = header.m_file_format[old_slot];
+    header.m_top_ref[new_slot] = top_ref;
+    if (!disable_sync)
+        map.sync(); // Throws
+    header.m_flags = uint8_t(new_flags);
+    if (!disable_sync)
+        map.sync(); // Throws
+
+    info->commits_not_durable = 0;
+}
+
 void DB::do_end_write() noexcept
 {
     SharedInfo* info = m_file_map.get_addr();
@@ -2059,7 +2213,7 @@ void DB::do_end_write() noexcept
 }
 
 
-Replication::version_type DB::do_commit(Transaction& transaction)
+Replication::version_type DB::do_commit(Transaction& transaction, bool commit_to_disk)
 {
     version_type current_version;
     {
@@ -2076,7 +2230,7 @@ Replication::version_type DB::do_commit(Transaction& transaction)
         // must call Replication::abort_transact().
         new_version = repl->prepare_commit(current_version); // Throws
         try {
-            low_level_commit(new_version, transaction); // Throws
+            low_level_commit(new_version, transaction, commit_to_disk); // Throws
         }
         catch (...) {
             repl->abort_transact();
@@ -2085,7 +2239,7 @@ Replication::version_type DB::do_commit(Transaction& transaction)
         repl->finalize_commit();
     }
     else {
-        low_level_commit(new_version, transaction); // Throws
+        low_level_commit(new_version, transaction, commit_to_disk); // Throws
     }
     return new_version;
 }
@@ -2181,7 +2335,7 @@ DB::version_type DB::get_version_of_latest_snapshot()
 }
 
 
-void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
+void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction, bool commit_to_disk)
 {
     SharedInfo* info = m_file_map.get_addr();
 
@@ -2218,8 +2372,28 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
 #endif // REALM_METRICS
 
     // info->readers.dump();
+    // Encrypted files are written through the encryption layer's own
+    // mappings, which are only flushed by the writer's own sync
+    if (m_key)
+        commit_to_disk = true;
+    // While some commits have not been made durable, the file header still
+    // refers to the last durable version. Its data must not be overwritten
+    // until a later commit has been synced, so it is treated as being read.
+    uint_fast64_t oldest_reusable_version = oldest_version;
+    if (m_last_durable_version)
+        oldest_reusable_version = std::min<uint_fast64_t>(oldest_version, m_last_durable_version);
+
     GroupWriter out(transaction, Durability(info->durability)); // Throws
-    out.set_versions(new_version, oldest_version);
+    out.set_versions(new_version, oldest_reusable_version);
+    bool compacting = m_compaction_budget != 0;
+    if (compacting) {
+        // Any commit made since the previous compacting commit, by this or
+        // another process, may have reused the space of the settled arrays
+        if (m_compaction_settled.version != transaction.get_version())
+            m_compaction_settled.refs.clear();
+        out.set_relocation_budget(m_compaction_budget, &m_compaction_settled);
+        m_compaction_budget = 0;
+    }
     ref_type new_top_ref;
     // Recursively write all changed arrays to end of file
     {
@@ -2238,7 +2412,21 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
         switch (Durability(info->durability)) {
             case Durability::Full:
             case Durability::Unsafe:
+                if (!commit_to_disk) {
+                    if (!m_last_durable_version)
+                        m_last_durable_version = transaction.get_version();
+                    info->commits_not_durable = 1;
+                    break;
+                }
+                if (m_last_durable_version) {
+                    // The earlier commits were written through mappings which
+                    // no longer exist, so sync the entire file
+                    if (Durability(info->durability) == Durability::Full && !get_disable_sync_to_disk())
+                        m_alloc.get_file().sync(); // Throws
+                }
                 out.commit(new_top_ref); // Throws
+                m_last_durable_version = 0;
+                info->commits_not_durable = 0;
                 break;
             case Durability::MemOnly:
             case Durability::Async:
@@ -2248,6 +2436,37 @@ void DB::low_level_commit(uint_fast64_t new_version, Transaction& transaction)
                 // mode the file on disk may very likely be in an invalid state.
                 break;
         }
+        if (compacting) {
+            size_t logical_file_size = out.get_logical_file_size();
+            bool durable = Durability(info->durability) == Durability::Full ||
+                           Durability(info->durability) == Durability::Unsafe;
+#ifndef _WIN32
+            // Shrink the file now that the new logical size has been committed,
+            // but never below the logical size of a version that a read
+            // transaction may still bind to. Encrypted files are left alone,
+            // as the encryption layer may still hold metadata for the
+            // released pages.
+            if (durable && !m_key && logical_file_size < out.get_file_size()) {
+                size_t target_size = logical_file_size;
+                SharedInfo* r_info = m_reader_map.get_addr();
+                r_info->readers.for_each_entry([&](const Ringbuffer::ReadCount& r) {
+                    if (r.current_top == 0)
+                        return;
+                    const char* top_header = m_alloc.translate(to_ref(r.current_top));
+                    auto size = to_size_t(Array::get(top_header, Group::s_file_size_ndx) / 2);
+                    target_size = std::max(target_size, size);
+                });
+                m_alloc.shrink_file(util::round_up_to_page_size(target_size)); // Throws
+            }
+#else
+            static_cast<void>(durable);
+#endif
+            m_compaction_progress.file_size = logical_file_size;
+            m_compaction_progress.relocated_size = out.get_relocated_size();
+            m_compaction_progress.released_size = out.get_released_size();
+            m_compaction_progress.incomplete = out.is_relocation_incomplete();
+            m_compaction_settled.version = new_version;
+        }
         size_t new_file_size = out.get_file_size();
         // We must reset the allocators free space tracking before communicating the new
         // version through the ring buffer. If not, a reader may start updating the allocators
@@ -2381,7 +2600,13 @@ Transaction::Transaction(DBRef _db, SlabAlloc* alloc, DB::ReadLockInfo& rli, DB:
 void Transaction::close()
 {
     if (m_transact_stage == DB::transact_Writing) {
-        rollback();
+        try {
+            rollback();
+        }
+        catch (...) {
+            // The write has ended even if the earlier commits of the write
+            // could not be made durable. They will be by the next writer.
+        }
     }
     if (m_transact_stage == DB::transact_Reading || m_transact_stage == DB::transact_Frozen) {
         do_end_read();
@@ -2462,6 +2687,16 @@ void Transaction::rollback()
 
     if (m_transact_stage != DB::transact_Writing)
         throw LogicError(LogicError::wrong_transact_state);
+
+    // The write is ended even if the earlier commits of the write can't be
+    // made durable, and the error is thrown afterwards
+    std::exception_ptr durability_error;
+    try {
+        db->make_commits_durable(); // Throws
+    }
+    catch (...) {
+        durability_error = std::current_exception();
+    }
     db->reset_free_space_tracking();
     db->do_end_write();
 
@@ -2469,6 +2704,8 @@ void Transaction::rollback()
         repl->abort_transact();
 
     do_end_read();
+    if (durability_error)
+        std::rethrow_exception(durability_error);
 }
 
 size_t Transaction::get_commit_size() const
@@ -2510,7 +2747,7 @@ DB::version_type Transaction::commit()
     return new_version;
 }
 
-void Transaction::commit_and_continue_writing()
+DB::version_type Transaction::commit_and_continue_writing(bool commit_to_disk)
 {
     if (!is_attached())
         throw LogicError(LogicError::wrong_transact_state);
@@ -2522,7 +2759,7 @@ void Transaction::commit_and_continue_writing()
     // before committing, allow any accessors at group level or below to sync
     flush_accessors_for_commit();
 
-    db->do_commit(*this); // Throws
+    DB::version_type new_version = db->do_commit(*this, commit_to_disk); // Throws
 
     // We need to set m_read_lock in order for wait_for_change to work.
     // To set it, we grab a readlock on the latest available snapshot
@@ -2535,6 +2772,10 @@ void Transaction::commit_and_continue_writing()
 
     bool writable = true;
     remap_and_update_refs(m_read_lock.m_top_ref, m_read_lock.m_file_size, writable); // Throws
+
+    // The next commit is based on the version which was just committed
+    initialize_replication(); // Throws
+    return new_version;
 }
 
 void Transaction::initialize_replication()
@@ -2675,6 +2916,7 @@ std::unique_ptr<ConstTableView> Transaction::import_copy_of(ConstTableView& tv,
 
 inline DB::DB(const DBOptions& options)
     : m_key(options.encryption_key)
+    , m_encryption_format(options.encryption_format)
     , m_upgrade_callback(std::move(options.upgrade_callback))
 {
 }
@@ -19,6 +19,7 @@
 #ifndef REALM_GROUP_SHARED_HPP
 #define REALM_GROUP_SHARED_HPP
 
+#include <chrono>
 #include <functional>
 #include <cstdint>
 #include <limits>
@@ -226,6 +227,12 @@ public:
     // an invalid TransactionRef is returned.
     TransactionRef start_write(bool nonblocking = false);
 
+    // Check whether the write lock is free by taking it without waiting and
+    // releasing it again right away. No write transaction is started, so this
+    // is much cheaper than start_write(true), but the lock may have been taken
+    // by someone else again by the time the caller acts on the result.
+    bool probe_write_lock();
+
 
     // report statistics of last commit done on THIS DB.
     // The free space reported is what can be expected to be freed
@@ -276,6 +283,10 @@ public:
     /// file will be unencrypted. Any other value will change the encryption of
     /// the file to the new 64 byte key.
     ///
+    /// If the output_encryption_format is `none`, an encrypted file keeps its
+    /// format, and a file which was not encrypted uses the format from
+    /// DBOptions. Otherwise the resulting file is encrypted in the given format.
+    ///
     /// FIXME: This function is not yet implemented in an exception-safe manner,
     /// therefore, if it throws, the application should not attempt to
     /// continue. If may not even be safe to destroy the DB object.
@@ -284,7 +295,62 @@ public:
     /// because it's not crash safe! It may corrupt your database if something fails
     ///
     /// WARNING: Compact() is not thread-safe with respect to a concurrent close()
-    bool compact(bool bump_version_number = false, util::Optional<const char*> output_encryption_key = util::none);
+    bool compact(bool bump_version_number = false, util::Optional<const char*> output_encryption_key = util::none,
+                 util::Optional<util::File::EncryptionFormat> output_encryption_format = util::none);
+
+    /// Result of a single step of incremental compaction.
+    struct CompactionProgress {
+        /// The logical size of the database file after the step.
+        size_t file_size = 0;
+        /// The number of bytes of live data that were moved away from the end
+        /// of the file.
+        size_t relocated_size = 0;
+        /// The number of bytes by which the file was shrunk.
+        size_t released_size = 0;
+        /// True if the step stopped before it had looked at all of the data
+        /// in the file. The next step continues where this one stopped.
+        bool incomplete = false;
+    };
+
+    /// Perform one step of incremental compaction. Unlike compact(), this
+    /// does not require exclusive access to the file, and readers are never
+    /// blocked.
+    ///
+    /// The step is an otherwise empty write transaction (which waits for
+    /// other writers like start_write() does). The commit releases any free
+    /// space at the end of the file, and moves unmodified arrays from the end
+    /// of the file into free space closer to its start. Roughly \a
+    /// max_relocation_size bytes are moved per step, and the number of arrays
+    /// inspected per step is bounded as well. The space vacated by
+    /// the moved arrays is released by a later step, once no live read
+    /// transaction refers to a version in which it was in use.
+    ///
+    /// The file itself is only shrunk for unencrypted files opened with
+    /// Durability::Full or Durability::Unsafe. Otherwise only the logical
+    /// size is reduced, which still allows the released space to be
+    /// reclaimed by compact().
+    ///
+    /// Steps must not be performed concurrently from multiple threads.
+    CompactionProgress compact_step(size_t max_relocation_size);
+
+    struct IncrementalCompactionConfig {
+        /// The approximate number of bytes moved per step.
+        size_t max_relocation_size = 1024 * 1024;
+        /// Time to wait between steps, giving other writers a chance to run.
+        std::chrono::milliseconds pause_between_steps{50};
+        /// Called after every step. Compaction stops if it returns false.
+        std::function<bool(const CompactionProgress&)> progress_handler;
+    };
+
+    /// Repeatedly call compact_step() until no further progress is made, or
+    /// until the progress handler asks for compaction to stop. This is meant
+    /// to be run on a background thread while the database is in use. As
+    /// vacated space can only be released when it is no longer referenced by
+    /// any live read transaction, long lived read transactions may cause
+    /// compaction to stop early, in which case it can simply be restarted
+    /// later.
+    void compact_incrementally(const IncrementalCompactionConfig&);
+    void compact_incrementally();
 
 #ifdef REALM_DEBUG
     void test_ringbuf();
@@ -399,6 +465,7 @@ private:
     std::string m_db_path;
     std::string m_coordination_dir;
     const char* m_key;
+    util::File::EncryptionFormat m_encryption_format;
     int m_file_format_version = 0;
     util::InterprocessMutex m_writemutex;
 #ifdef REALM_ASYNC_DAEMON
@@ -415,6 +482,20 @@ private:
     std::function<void(int, int)> m_upgrade_callback;
 
     std::shared_ptr<metrics::Metrics> m_metrics;
+
+    // Relocation budget for the next commit, set by compact_step() while it
+    // holds the write lock. The commit reports its result in
+    // m_compaction_progress.
+    size_t m_compaction_budget = 0;
+    CompactionProgress m_compaction_progress;
+    // Arrays which earlier steps found to stay where they are
+    _impl::SettledArrays m_compaction_settled;
+
+    // The version which the file header refers to while there are commits
+    // which have not been made durable yet, and zero otherwise. Only accessed
+    // while holding the write lock.
+    version_type m_last_durable_version = 0;
+
     /// Attach this DB instance to the specified database file.
     ///
     /// While at least one instance of DB exists for a specific
@@ -493,15 +574,22 @@ private:
     /// return true if write transaction can commence, false otherwise.
     bool do_try_begin_write();
     void do_begin_write();
-    version_type do_commit(Transaction&);
+    version_type do_commit(Transaction&, bool commit_to_disk = true);
     void do_end_write() noexcept;
+    // Make the latest version durable if the last commits were made with
+    // `commit_to_disk` set to false. Must be called while holding the write
+    // lock, before releasing it without a durable commit.
+    void make_commits_durable();
+    // Sync the file to disk and make the file header refer to the latest
+    // version. Must be called while holding the write lock.
+    void sync_latest_version();
 
     // make sure the given index is within the currently mapped area.
     // if not, expand the mapped area. Returns true if the area is expanded.
     bool grow_reader_mapping(uint_fast32_t index);
 
     // Must be called only by someone that has a lock on the write mutex.
-    void low_level_commit(uint_fast64_t new_version, Transaction& transaction);
+    void low_level_commit(uint_fast64_t new_version, Transaction& transaction, bool commit_to_disk = true);
 
     void do_async_commits();
 
@@ -565,6 +653,20 @@ public:
 
     // Live transactions state changes, often taking an observer functor:
     DB::version_type commit_and_continue_as_read();
+    /// Commit the changes made so far and continue the write transaction on
+    /// top of the new version.
+    ///
+    /// If \a commit_to_disk is false, the new version is immediately visible
+    /// to other readers and writers, but is not synced to disk. It becomes
+    /// durable with the next commit which is, or when the write transaction
+    /// ends. This allows several commits made by one writer to share a single
+    /// sync to disk. Until then, a crash leaves the file at the last durable
+    /// version, unless the file is still open elsewhere, in which case the
+    /// next writer makes the commits durable. If the write transaction ends
+    /// without a durable commit and the commits can't be made durable, it
+    /// still ends, and the error is thrown afterwards. Commits to encrypted
+    /// files are always synced.
+    DB::version_type commit_and_continue_writing(bool commit_to_disk = true);
     template <class O>
     void rollback_and_continue_as_read(O* observer);
     void rollback_and_continue_as_read()
@@ -629,7 +731,6 @@ private:
     bool internal_advance_read(O* observer, VersionID target_version, _impl::History&, bool);
     void set_transact_stage(DB::TransactStage stage) noexcept;
     void do_end_read() noexcept;
-    void commit_and_continue_writing();
     void initialize_replication();
 
     DBRef db;
@@ -920,6 +1021,16 @@ inline void Transaction::rollback_and_continue_as_read(O* observer)
         observer->parse_complete();           // Throws
     }
 
+    // The write is ended even if the earlier commits of the write can't be
+    // made durable, and the error is thrown afterwards
+    std::exception_ptr durability_error;
+    try {
+        db->make_commits_durable(); // Throws
+    }
+    catch (...) {
+        durability_error = std::current_exception();
+    }
+
     // Mark all managed space (beyond the attached file) as free.
     db->reset_free_space_tracking(); // Throws
 
@@ -936,6 +1047,8 @@ inline void Transaction::rollback_and_continue_as_read(O* observer)
 
     m_history = nullptr;
     set_transact_stage(DB::transact_Reading);
+    if (durability_error)
+        std::rethrow_exception(durability_error);
 }
 
 template <class O>
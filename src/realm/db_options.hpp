@@ -22,6 +22,8 @@
 #include <functional>
 #include <string>
 
+#include <realm/util/file.hpp>
+
 namespace realm {
 
 struct DBOptions {
@@ -68,6 +70,11 @@ struct DBOptions {
     /// indicate that encryption should not be used.
     const char* encryption_key;
 
+    /// The encryption format used if the Realm file is created when opened.
+    /// Existing files keep the format they were written in, but can be
+    /// converted with DB::compact().
+    util::File::EncryptionFormat encryption_format = util::File::encryption_AesCbcHmac;
+
     /// If \a allow_file_format_upgrade is set to `true`, this function will
     /// automatically upgrade the file format used in the specified Realm file
     /// if necessary (and if it is possible). In order to prevent this, set \a
@@ -101,6 +108,27 @@ struct DBOptions {
     /// is exceeded without being consumed, only the most recent entries will be stored.
     size_t metrics_buffer_size;
 
+    /// If true, the operating system is asked to start reading the Realm file
+    /// into memory in the background when it is opened, so that the first
+    /// transactions are not slowed down by a page fault for every page they
+    /// touch. This is mainly useful for files on slow storage which are small
+    /// enough to fit comfortably in memory. It has no effect for encrypted
+    /// files. Use Table::prefetch() or Query::prefetch() to read in only the
+    /// data which is about to be scanned.
+    bool prefetch_on_open = false;
+
+    /// How the Realm file will mostly be accessed. With
+    /// util::File::advice_Sequential the operating system reads far ahead on
+    /// every page fault, which suits workloads dominated by full table scans
+    /// and Query::find_all() without an index. With util::File::advice_Random
+    /// it does not read ahead at all, which suits workloads dominated by
+    /// primary key and index lookups, where the pages read ahead would just
+    /// evict useful ones. The kernel only honours such advice for a mapping
+    /// as a whole, so it applies to the entire file and not to individual
+    /// queries. util::File::advice_WillNeed is not allowed here, see
+    /// prefetch_on_open instead. It has no effect for encrypted files.
+    util::File::MapAdvice access_advice = util::File::advice_Normal;
+
     /// sys_tmp_dir will be used if the temp_dir is empty when creating DBOptions.
     /// It must be writable and allowed to create pipe/fifo file on it.
     /// set_sys_tmp_dir is not a thread-safe call and it is only supposed to be called once
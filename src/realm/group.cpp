@@ -252,6 +252,22 @@ TableKey Group::ndx2key(size_t ndx) const
     return Table::get_key_direct(m_tables.get_alloc(), ref);
 }
 
+uint64_t Group::compute_schema_hash() const
+{
+    REALM_ASSERT(is_attached());
+    uint64_t hash = 14695981039346656037ULL;
+    if (!m_tables.is_attached())
+        return hash;
+    Allocator& alloc = const_cast<SlabAlloc&>(m_alloc);
+    for (size_t ndx = 0; ndx < m_tables.size(); ++ndx) {
+        RefOrTagged rot = m_tables.get_as_ref_or_tagged(ndx);
+        if (rot.is_tagged() || !rot.get_as_ref())
+            continue;
+        hash = Table::get_schema_hash_direct(alloc, rot.get_as_ref(), m_table_names.get(ndx), hash);
+    }
+    return hash;
+}
+
 size_t Group::key2ndx_checked(TableKey key) const
 {
     size_t idx = key2ndx(key);
@@ -1162,19 +1178,20 @@ void Group::write(std::ostream& out, bool pad_for_encryption, uint_fast64_t vers
 }
 
 void Group::write(const std::string& path, const char* encryption_key, uint64_t version_number,
-                  bool write_history) const
+                  bool write_history, File::EncryptionFormat encryption_format) const
 {
     File file;
     int flags = 0;
     file.open(path, File::access_ReadWrite, File::create_Must, flags);
-    write(file, encryption_key, version_number, write_history);
+    write(file, encryption_key, version_number, write_history, encryption_format);
 }
 
-void Group::write(File& file, const char* encryption_key, uint_fast64_t version_number, bool write_history) const
+void Group::write(File& file, const char* encryption_key, uint_fast64_t version_number, bool write_history,
+                  File::EncryptionFormat encryption_format) const
 {
     REALM_ASSERT(file.get_size() == 0);
 
-    file.set_encryption_key(encryption_key);
+    file.set_encryption_key(encryption_key, encryption_format);
 
     // The aim is that the buffer size should be at least 1/256 of needed size but less than 64 Mb
     constexpr size_t upper_bound = 64 * 1024 * 1024;
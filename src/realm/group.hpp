@@ -243,6 +243,14 @@ public:
     /// Returns the keys for all tables in this group.
     TableKeys get_table_keys() const;
 
+    /// Compute a hash of the schema of this group: the names, keys and types
+    /// of all tables, and the names, types, attributes, keys and link targets
+    /// of all of their columns. The hash changes whenever the schema changes,
+    /// but not when objects are created, modified or removed. This reads the
+    /// underlying structures directly and does not create table accessors, so
+    /// it is much cheaper than inspecting every table.
+    uint64_t compute_schema_hash() const;
+
     /// \defgroup group_table_access Table Accessors
     ///
     /// has_table() returns true if, and only if this group contains a table
@@ -377,13 +385,17 @@ public:
     /// realm file with free list and history info. The version of the commit
     /// will be set to the value given here.
     ///
+    /// \param encryption_format The format to encrypt the new file in. Ignored
+    /// if \a encryption_key is null.
+    ///
     /// \throw util::File::AccessError If the file could not be
     /// opened. If the reason corresponds to one of the exception
     /// types that are derived from util::File::AccessError, the
     /// derived exception type is thrown. In particular,
     /// util::File::Exists will be thrown if the file exists already.
     void write(const std::string& file, const char* encryption_key = nullptr, uint64_t version = 0,
-               bool write_history = true) const;
+               bool write_history = true,
+               util::File::EncryptionFormat encryption_format = util::File::encryption_AesCbcHmac) const;
 
     /// Write this database to a memory buffer.
     ///
@@ -743,7 +755,8 @@ private:
 
     void mark_all_table_accessors() noexcept;
 
-    void write(util::File& file, const char* encryption_key, uint_fast64_t version_number, bool write_history) const;
+    void write(util::File& file, const char* encryption_key, uint_fast64_t version_number, bool write_history,
+               util::File::EncryptionFormat encryption_format = util::File::encryption_AesCbcHmac) const;
     void write(std::ostream&, bool pad, uint_fast64_t version_numer, bool write_history) const;
 
     std::shared_ptr<metrics::Metrics> get_metrics() const noexcept;
@@ -268,6 +268,11 @@ size_t GroupWriter::get_file_size() const noexcept
     return sz;
 }
 
+size_t GroupWriter::get_logical_file_size() const noexcept
+{
+    return to_size_t(m_group.m_top.get(2) / 2);
+}
+
 void GroupWriter::sync_all_mappings()
 {
     if (m_durability == Durability::Unsafe)
@@ -320,6 +325,9 @@ ref_type GroupWriter::write_group()
     read_in_freelist();
     // Now, 'm_size_map' holds all free elements candidate for recycling
 
+    if (m_relocation_budget)
+        prepare_relocation(); // Throws
+
     Array& top = m_group.m_top;
 #if REALM_ALLOC_DEBUG
     std::cout << "    In-file freelist after merge:  " << m_size_map.size() << std::endl;
@@ -385,6 +393,7 @@ ref_type GroupWriter::write_group()
 #endif
     max_free_list_size += free_read_only_size;
     max_free_list_size += m_not_free_in_file.size();
+    max_free_list_size += m_relocated.size();
     // The final allocation of free space (i.e., the call to
     // reserve_free_space() below) may add extra entries to the free-lists.
     // We reserve room for the worst case scenario, which is as follows:
@@ -575,7 +584,7 @@ size_t GroupWriter::recreate_freelist(size_t reserve_pos)
 {
     std::vector<FreeSpaceEntry> free_in_file;
     auto& new_free_space = m_group.m_alloc.get_free_read_only(); // Throws
-    auto nb_elements = m_size_map.size() + m_not_free_in_file.size() + new_free_space.size();
+    auto nb_elements = m_size_map.size() + m_not_free_in_file.size() + new_free_space.size() + m_relocated.size();
     free_in_file.reserve(nb_elements);
 
     size_t reserve_ndx = realm::npos;
@@ -597,6 +606,14 @@ size_t GroupWriter::recreate_freelist(size_t reserve_pos)
             free_in_file.emplace_back(free_space.first, free_space.second, m_current_version);
             locked_space_size += free_space.second;
         }
+
+        // Arrays moved by incremental compaction are still part of the
+        // previous versions, so their old positions are released just like
+        // the space freed by the transaction itself.
+        for (const auto& relocated : m_relocated) {
+            free_in_file.emplace_back(relocated.ref, relocated.size, m_current_version);
+            locked_space_size += relocated.size;
+        }
         m_locked_space_size = locked_space_size;
     }
 
@@ -655,6 +672,97 @@ size_t GroupWriter::recreate_freelist(size_t reserve_pos)
     return reserve_ndx;
 }
 
+void GroupWriter::prepare_relocation()
+{
+    // Free space at the end of the file is given up by reducing the logical
+    // file size. Only the free list of the new version is affected, so the
+    // caller may shrink the file itself once the commit has completed.
+    size_t logical_file_size = get_logical_file_size();
+    auto tail = std::find_if(m_size_map.begin(), m_size_map.end(), [&](auto& chunk) {
+        return chunk.second + chunk.first == logical_file_size;
+    });
+    if (tail != m_size_map.end()) {
+        size_t chunk_pos = tail->second;
+        size_t new_file_size = util::round_up_to_page_size(chunk_pos);
+        if (new_file_size < logical_file_size) {
+            m_size_map.erase(tail);
+            if (new_file_size > chunk_pos)
+                m_size_map.emplace(new_file_size - chunk_pos, chunk_pos);
+            m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
+            m_released_size = logical_file_size - new_file_size;
+            logical_file_size = new_file_size;
+        }
+    }
+
+    // Everything beyond the limit could in principle be moved into the free
+    // space below it. Once that has happened (and the versions still
+    // referring to the old positions are gone) the tail can be released.
+    size_t free_space = 0;
+    for (const auto& chunk : m_size_map)
+        free_space += chunk.first;
+    size_t limit = util::round_up_to_page_size(logical_file_size - free_space);
+    if (limit < logical_file_size) {
+        m_relocation_limit = limit;
+        m_relocate_unmodified = true;
+        // Visiting an array costs about as much as reading its header, so the
+        // walk is bounded by a number of arrays rather than by their size. The
+        // bound is well above the maximum number of children of a single
+        // array, such that every commit settles at least one more subtree.
+        m_visit_budget = std::max(m_relocation_budget / 64, size_t(16 * 1024));
+        if (m_settled) {
+            // Arrays recorded as settled only lie below the previous limit
+            if (limit < m_settled->limit)
+                m_settled->refs.clear();
+            m_settled->limit = limit;
+        }
+    }
+}
+
+bool GroupWriter::must_relocate(ref_type ref, size_t size)
+{
+    if (--m_visit_budget == 0) {
+        m_relocate_unmodified = false;
+        m_relocation_incomplete = true;
+    }
+    if (ref < m_relocation_limit)
+        return false;
+    // Only move the array if it can be placed below the limit. Otherwise it
+    // would just end up somewhere else in the tail.
+    if (search_free_space_below_limit(size) == m_size_map.end())
+        return false;
+    m_relocated_size += size;
+    if (size >= m_relocation_budget) {
+        m_relocation_budget = 0;
+        m_relocate_unmodified = false;
+        m_relocation_incomplete = true;
+    }
+    else {
+        m_relocation_budget -= size;
+    }
+    return true;
+}
+
+void GroupWriter::relocated(ref_type ref, size_t size)
+{
+    m_relocated.emplace_back(ref, size, m_current_version);
+}
+
+bool GroupWriter::is_settled(ref_type ref)
+{
+    return m_settled && m_settled->refs.count(ref) != 0;
+}
+
+bool GroupWriter::settle(ref_type ref, bool has_refs)
+{
+    if (ref >= m_relocation_limit)
+        return false;
+    // Leaves are cheap to revisit, and recording them would make the set as
+    // large as the file.
+    if (m_settled && has_refs)
+        m_settled->refs.insert(ref); // Throws
+    return true;
+}
+
 void GroupWriter::FreeList::merge_adjacent_entries_in_freelist()
 {
     if (size() > 1) {
@@ -770,9 +878,33 @@ GroupWriter::FreeListElement GroupWriter::search_free_space_in_part_of_freelist(
 }
 
 
+GroupWriter::FreeListElement GroupWriter::search_free_space_below_limit(size_t size)
+{
+    SlabAlloc& alloc = m_group.m_alloc;
+    for (auto it = m_size_map.lower_bound(size); it != m_size_map.end(); ++it) {
+        size_t start_pos = it->second;
+        if (start_pos + size > m_relocation_limit)
+            continue;
+        size_t chunk_size = std::min(it->first, m_relocation_limit - start_pos);
+        size_t alloc_pos = alloc.find_section_in_range(start_pos, chunk_size, size);
+        if (alloc_pos == 0)
+            continue;
+        if (alloc_pos != start_pos) {
+            it = split_freelist_chunk(it, alloc_pos);
+        }
+        return it;
+    }
+    return m_size_map.end();
+}
+
+
 GroupWriter::FreeListElement GroupWriter::reserve_free_space(size_t size)
 {
-    auto chunk = search_free_space_in_part_of_freelist(size);
+    // During incremental compaction, space below the relocation limit is
+    // preferred, so that the tail of the file is not filled up again.
+    auto chunk = m_relocation_limit ? search_free_space_below_limit(size) : m_size_map.end();
+    if (chunk == m_size_map.end())
+        chunk = search_free_space_in_part_of_freelist(size);
     while (chunk == m_size_map.end()) {
         // No free space, so we have to extend the file.
         auto new_chunk = extend_free_space(size);
@@ -71,7 +71,48 @@ public:
 
     size_t get_file_size() const noexcept;
 
+    /// The size of the file as recorded in the group. This may be smaller
+    /// than get_file_size() after free space at the end of the file has been
+    /// released during incremental compaction.
+    size_t get_logical_file_size() const noexcept;
+
+    /// Enable incremental compaction for this commit: Free space at the end of
+    /// the file is released, and unmodified arrays located in the tail of the
+    /// file are moved into free space closer to the start of the file, such
+    /// that the tail can be released by a later commit. At most \a max_bytes
+    /// worth of arrays are moved (although a single array larger than that
+    /// is still moved). Must be called before write_group().
+    ///
+    /// The number of unmodified arrays visited is bounded as well. If \a
+    /// settled is specified, arrays found to stay in place are recorded
+    /// there, and skipped by later commits using the same object, such that
+    /// those commits continue where this one stopped.
+    void set_relocation_budget(size_t max_bytes, _impl::SettledArrays* settled = nullptr) noexcept;
+
+    /// Number of bytes moved away from the tail of the file by write_group().
+    size_t get_relocated_size() const noexcept
+    {
+        return m_relocated_size;
+    }
+
+    /// Number of bytes by which write_group() reduced the logical file size.
+    size_t get_released_size() const noexcept
+    {
+        return m_released_size;
+    }
+
+    /// True if write_group() stopped visiting unmodified arrays before it had
+    /// seen all of them, so a later commit may find more arrays to move.
+    bool is_relocation_incomplete() const noexcept
+    {
+        return m_relocation_incomplete;
+    }
+
     ref_type write_array(const char*, size_t, uint32_t) override;
+    bool must_relocate(ref_type, size_t) override;
+    void relocated(ref_type, size_t) override;
+    bool is_settled(ref_type) override;
+    bool settle(ref_type, bool) override;
 
 #ifdef REALM_DEBUG
     void dump();
@@ -100,6 +141,13 @@ private:
     size_t m_free_space_size = 0;
     size_t m_locked_space_size = 0;
     Durability m_durability;
+    size_t m_relocation_budget = 0;
+    size_t m_relocation_limit = 0; // Arrays at or beyond this position are relocated
+    size_t m_relocated_size = 0;
+    size_t m_released_size = 0;
+    size_t m_visit_budget = 0; // Number of unmodified arrays that may still be visited
+    bool m_relocation_incomplete = false;
+    _impl::SettledArrays* m_settled = nullptr;
 
     struct FreeSpaceEntry {
         FreeSpaceEntry(size_t r, size_t s, uint64_t v)
@@ -122,11 +170,15 @@ private:
     };
     //  m_free_in_file;
     std::vector<FreeSpaceEntry> m_not_free_in_file;
+    std::vector<FreeSpaceEntry> m_relocated; // Previous positions of relocated arrays
     std::multimap<size_t, size_t> m_size_map;
     using FreeListElement = std::multimap<size_t, size_t>::iterator;
 
     void read_in_freelist();
     size_t recreate_freelist(size_t reserve_pos);
+    // Release free space at the end of the file and determine which part of
+    // the file should be evacuated.
+    void prepare_relocation();
     // Currently cached memory mappings. We keep as many as 16 1MB windows
     // open for writing. The allocator will favor sequential allocation
     // from a modest number of windows, depending upon fragmentation, so
@@ -172,6 +224,10 @@ private:
     /// specified size. Return a pair with index and size of the found chunk.
     FreeListElement search_free_space_in_part_of_freelist(size_t size);
 
+    /// Search for a block as big as the specified size which lies entirely
+    /// below the relocation limit.
+    FreeListElement search_free_space_below_limit(size_t size);
+
     /// Extend the file to ensure that a chunk of free space of the
     /// specified size is available. The specified size does not need
     /// to be 8-byte aligned. This function guarantees that it will
@@ -196,6 +252,12 @@ inline void GroupWriter::set_versions(uint64_t current, uint64_t read_lock) noex
     m_readlock_version = read_lock;
 }
 
+inline void GroupWriter::set_relocation_budget(size_t max_bytes, _impl::SettledArrays* settled) noexcept
+{
+    m_relocation_budget = max_bytes;
+    m_settled = settled;
+}
+
 } // namespace realm
 
 #endif // REALM_GROUP_WRITER_HPP
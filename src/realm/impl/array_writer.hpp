@@ -21,9 +21,23 @@
 
 #include <realm/alloc.hpp>
 
+#include <unordered_set>
+
 namespace realm {
 namespace _impl {
 
+/// Unmodified arrays which, together with all arrays they refer to, were
+/// found by an earlier commit to lie below the relocation limit, such that
+/// later commits need not visit them again (see
+/// ArrayWriterBase::is_settled()). Only arrays with subarrays are recorded.
+/// The refs are only meaningful in the version committed by the commit which
+/// recorded them, as any other commit may free and reuse their space.
+struct SettledArrays {
+    size_t limit = 0;
+    uint_fast64_t version = 0;
+    std::unordered_set<ref_type> refs;
+};
+
 class ArrayWriterBase {
 public:
     virtual ~ArrayWriterBase()
@@ -36,6 +50,45 @@ public:
     /// Returns the ref (position in the target stream) of the written copy of
     /// the specified array data.
     virtual ref_type write_array(const char* data, size_t size, uint32_t checksum) = 0;
+
+    /// Returns true if arrays that are unmodified in the current transaction
+    /// must still be visited, because some of them may have to be moved to a
+    /// new position (see GroupWriter::set_relocation_budget()).
+    bool relocates_unmodified() const noexcept
+    {
+        return m_relocate_unmodified;
+    }
+
+    /// Called for every unmodified array visited while
+    /// relocates_unmodified() is true. Returns true if the specified array
+    /// must be written to a new position.
+    virtual bool must_relocate(ref_type, size_t)
+    {
+        return false;
+    }
+
+    /// Called when an unmodified array has been written to a new position,
+    /// such that the space it occupied can be released.
+    virtual void relocated(ref_type, size_t) {}
+
+    /// Returns true if the specified unmodified array, and every array it
+    /// refers to, is known to stay where it is, so that it need not be
+    /// visited.
+    virtual bool is_settled(ref_type)
+    {
+        return false;
+    }
+
+    /// Called for an unmodified array which stays where it is, once all of
+    /// its subarrays have been visited and found to be settled. Returns true
+    /// if the array itself is settled too.
+    virtual bool settle(ref_type, bool)
+    {
+        return false;
+    }
+
+protected:
+    bool m_relocate_unmodified = false;
 };
 
 } // namespace impl_
@@ -22,6 +22,8 @@
 #include <realm/object-store/index_set.hpp>
 #include <realm/object-store/util/atomic_shared_ptr.hpp>
 
+#include <realm/keys.hpp>
+
 #include <exception>
 #include <memory>
 #include <type_traits>
@@ -33,6 +35,15 @@ namespace _impl {
 class CollectionNotifier;
 }
 
+// A path from an object to one of its properties or the property of an object it
+// links to, as the table and column of each step. For example `owner.name` on a
+// Dog is {{Dog, owner}, {Person, name}}. Every step but the last must be a link
+// or a list of links to the table of the next step.
+using KeyPath = std::vector<std::pair<TableKey, ColKey>>;
+// The properties observed by a notification callback. Modifications to other
+// properties are not reported to callbacks registered with a non-empty array.
+using KeyPathArray = std::vector<KeyPath>;
+
 // A token which keeps an asynchronous query alive
 struct NotificationToken {
     NotificationToken() = default;
@@ -291,7 +291,6 @@ void CollectionChangeBuilder::verify()
 namespace {
 struct RowInfo {
     int64_t key;
-    size_t prev_tv_index;
     size_t tv_index;
 };
 
@@ -350,190 +349,245 @@ void calculate_moves_backlinks(std::vector<RowInfo>& new_rows, IndexSet& removed
 }
 #endif
 
-class LongestCommonSubsequenceCalculator {
-public:
-    // A pair of an object key and an index in the table view
-    struct Row {
-        int64_t key;
-        size_t tv_index;
+// Buffers used while calculating a changeset. A notifier recalculates the
+// changes for its whole collection every time it runs, so these are kept per
+// thread and reused rather than reallocated for each calculation.
+struct ScratchBuffers {
+    // The rows of the old and new collections sorted by key
+    std::vector<RowInfo> old_rows, new_rows;
+    // For each row in the old collection, its index in the new one, or npos
+    // if it was removed (or moved, once moves have been calculated)
+    std::vector<size_t> next_index;
+    // For each row in the new collection, its index in the old one, or npos
+    // if it was inserted (or moved)
+    std::vector<size_t> prev_index;
+    // For each row in the new collection, whether it was modified
+    std::vector<char> modified;
+
+    // A pair of rows from the old and new collections which have the same key
+    // and so could be matched with each other when calculating moves
+    struct Match {
+        size_t old_index;
+        size_t new_index;
+        // The weight of the heaviest sequence of matches starting with this one
+        uint64_t weight;
     };
+    std::vector<Match> matches;
+    // Fenwick tree over new indices holding the heaviest sequence of matches
+    // starting at or after each index
+    std::vector<uint64_t> heaviest;
+    // Whether each row in the range being diffed is part of that sequence
+    std::vector<char> old_kept, new_kept;
+};
 
-    struct Match {
-        // The index in `a` at which this match begins
-        size_t i;
-        // The index in `b` at which this match begins
-        size_t j;
-        // The length of this match
-        size_t size;
-        // The number of rows in this block which were modified
-        size_t modified;
+ScratchBuffers& scratch_buffers()
+{
+    thread_local ScratchBuffers buffers;
+    return buffers;
+}
+
+template <typename T>
+void build_row_info(std::vector<T> const& rows, std::vector<RowInfo>& info)
+{
+    info.clear();
+    info.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        info.push_back({static_cast<int64_t>(rows[i]), i});
+
+    // Rows in table order are already sorted
+    auto less = [](auto& lft, auto& rgt) {
+        return std::tie(lft.key, lft.tv_index) < std::tie(rgt.key, rgt.tv_index);
     };
-    std::vector<Match> m_longest_matches;
-
-    LongestCommonSubsequenceCalculator(std::vector<Row>& a, std::vector<Row>& b, size_t start_index,
-                                       IndexSet const& modifications)
-        : m_modified(modifications)
-        , a(a)
-        , b(b)
-    {
-        find_longest_matches(start_index, a.size(), start_index, b.size());
-        m_longest_matches.push_back({a.size(), b.size(), 0});
-    }
+    if (!std::is_sorted(begin(info), end(info), less))
+        std::sort(begin(info), end(info), less);
+}
 
-private:
-    IndexSet const& m_modified;
-
-    // The two arrays of rows being diffed
-    // a is sorted by tv_index, b is sorted by key
-    std::vector<Row>&a, &b;
-
-    // Find the longest matching range in (a + begin1, a + end1) and (b + begin2, b + end2)
-    // "Matching" is defined as "has the same row index"; the TV index is just
-    // there to let us turn an index in a/b into an index which can be reported
-    // in the output changeset.
-    //
-    // This is done with the O(N) space variant of the dynamic programming
-    // algorithm for longest common subsequence, where N is the maximum number
-    // of the most common row index (which for everything but linkview-derived
-    // TVs will be 1).
-    Match find_longest_match(size_t begin1, size_t end1, size_t begin2, size_t end2)
-    {
-        struct Length {
-            size_t j, len;
-        };
-        // The length of the matching block for each `j` for the previously checked row
-        std::vector<Length> prev;
-        // The length of the matching block for each `j` for the row currently being checked
-        std::vector<Length> cur;
-
-        // Calculate the length of the matching block *ending* at b[j], which
-        // is 1 if b[j - 1] did not match, and b[j - 1] + 1 otherwise.
-        auto length = [&](size_t j) -> size_t {
-            for (auto const& pair : prev) {
-                if (pair.j + 1 == j)
-                    return pair.len + 1;
-            }
-            return 1;
-        };
-
-        // Iterate over each `j` which has the same row index as a[i] and falls
-        // within the range begin2 <= j < end2
-        auto for_each_b_match = [&](size_t i, auto&& f) {
-            auto ai = a[i].key;
-            // Find the TV indicies at which this row appears in the new results
-            // There should always be at least one (or it would have been
-            // filtered out earlier), but there can be multiple if there are dupes
-            auto it = lower_bound(begin(b), end(b), ai, [](auto lft, auto rgt) {
-                return lft.key < rgt;
-            });
-            REALM_ASSERT(it != end(b) && it->key == ai);
-            for (; it != end(b) && it->key == ai; ++it) {
-                size_t j = it->tv_index;
-                if (j < begin2)
-                    continue;
-                if (j >= end2)
-                    break; // b is sorted by tv_index so this can't transition from false to true
-                f(j);
-            }
-        };
-
-        Match best = {begin1, begin2, 0, 0};
-        for (size_t i = begin1; i < end1; ++i) {
-            // prev = std::move(cur), but avoids discarding prev's heap allocation
-            cur.swap(prev);
-            cur.clear();
-
-            for_each_b_match(i, [&](size_t j) {
-                size_t size = length(j);
-
-                cur.push_back({j, size});
-
-                // If the matching block ending at a[i] and b[j] is longer than
-                // the previous one, select it as the best
-                if (size > best.size)
-                    best = {i - size + 1, j - size + 1, size, IndexSet::npos};
-                // Given two equal-length matches, prefer the one with fewer modified rows
-                else if (size == best.size) {
-                    if (best.modified == IndexSet::npos)
-                        best.modified = m_modified.count(best.j - size + 1, best.j + 1);
-                    auto count = m_modified.count(j - size + 1, j + 1);
-                    if (count < best.modified)
-                        best = {i - size + 1, j - size + 1, size, count};
-                }
-
-                // The best block should always fall within the range being searched
-                REALM_ASSERT(best.i >= begin1 && best.i + best.size <= end1);
-                REALM_ASSERT(best.j >= begin2 && best.j + best.size <= end2);
-            });
+// Collect the pairs of rows which can be matched with each other in the ranges
+// [old_begin, old_end) of the old rows and [new_begin, new_end) of the new rows,
+// ordered by old index and then new index
+void collect_matches(ScratchBuffers& scratch, bool has_duplicates, size_t old_begin, size_t old_end,
+                     size_t new_begin, size_t new_end)
+{
+    auto& matches = scratch.matches;
+    matches.clear();
+
+    if (!has_duplicates) {
+        // Each row can only be matched with the row it was paired with
+        for (size_t i = old_begin; i < old_end; ++i) {
+            size_t j = scratch.next_index[i];
+            if (j != IndexSet::npos)
+                matches.push_back({i, j, 0});
         }
-        return best;
+        return;
     }
 
-    void find_longest_matches(size_t begin1, size_t end1, size_t begin2, size_t end2)
-    {
-        // FIXME: recursion could get too deep here
-        // recursion depth worst case is currently O(N) and each recursion uses 320 bytes of stack
-        // could reduce worst case to O(sqrt(N)) (and typical case to O(log N))
-        // biasing equal selections towards the middle, but that's still
-        // insufficient for Android's 8 KB stacks
-        auto m = find_longest_match(begin1, end1, begin2, end2);
-        if (!m.size)
-            return;
-        if (m.i > begin1 && m.j > begin2)
-            find_longest_matches(begin1, m.i, begin2, m.j);
-        m_longest_matches.push_back(m);
-        if (m.i + m.size < end2 && m.j + m.size < end2)
-            find_longest_matches(m.i + m.size, end1, m.j + m.size, end2);
+    // Every remaining row in the old collection can be matched with every
+    // remaining row with the same key in the new collection
+    auto in_range = [&](size_t i, size_t j) {
+        return i >= old_begin && i < old_end && j >= new_begin && j < new_end;
+    };
+    auto& old_rows = scratch.old_rows;
+    auto& new_rows = scratch.new_rows;
+    size_t i = 0, j = 0;
+    while (i < old_rows.size() && j < new_rows.size()) {
+        auto key = old_rows[i].key;
+        if (key < new_rows[j].key) {
+            ++i;
+            continue;
+        }
+        if (new_rows[j].key < key) {
+            ++j;
+            continue;
+        }
+
+        size_t old_group_end = i, new_group_end = j;
+        while (old_group_end < old_rows.size() && old_rows[old_group_end].key == key)
+            ++old_group_end;
+        while (new_group_end < new_rows.size() && new_rows[new_group_end].key == key)
+            ++new_group_end;
+        for (; i < old_group_end; ++i) {
+            size_t old_index = old_rows[i].tv_index;
+            if (scratch.next_index[old_index] == IndexSet::npos)
+                continue;
+            for (size_t k = j; k < new_group_end; ++k) {
+                size_t new_index = new_rows[k].tv_index;
+                if (scratch.prev_index[new_index] != IndexSet::npos && in_range(old_index, new_index))
+                    matches.push_back({old_index, new_index, 0});
+            }
+        }
+        j = new_group_end;
     }
-};
 
-void calculate_moves_sorted(std::vector<RowInfo>& rows, CollectionChangeSet& changeset)
-{
-    // The RowInfo array contains information about the old and new TV indices of
-    // each row, which we need to turn into two sequences of rows, which we'll
-    // then find matches in
-    std::vector<LongestCommonSubsequenceCalculator::Row> a, b;
-
-    a.reserve(rows.size());
-    for (auto& row : rows)
-        a.push_back({row.key, row.prev_tv_index});
-    std::sort(begin(a), end(a), [](auto lft, auto rgt) {
-        return std::tie(lft.tv_index, lft.key) < std::tie(rgt.tv_index, rgt.key);
+    std::sort(begin(matches), end(matches), [](auto& lft, auto& rgt) {
+        return std::tie(lft.old_index, lft.new_index) < std::tie(rgt.old_index, rgt.new_index);
     });
+}
 
-    // Before constructing `b`, first find the first index in `a` which will
-    // actually differ in `b`, and skip everything else if there aren't any
-    size_t first_difference = IndexSet::npos;
-    for (size_t i = 0; i < a.size(); ++i) {
-        if (a[i].key != rows[i].key) {
-            first_difference = i;
+// Find the rows which have to be moved to turn the old collection into the new
+// one, and mark them as removed from the old collection and inserted into the
+// new one.
+//
+// The rows which do not move are the longest common subsequence of the two
+// collections. As every row is matched with at most a few others (only rows
+// with duplicate keys have more than one potential match), this is calculated
+// by finding the heaviest increasing sequence of matches with a Fenwick tree,
+// which takes O(M log N) time for M matches rather than the O(N^2) of the
+// general algorithm. When there are several equally long sequences, the one
+// which leaves the most unmodified rows in place is picked so that modified
+// rows are the ones reported as moved, and then the one using the earliest
+// rows.
+void calculate_moves_sorted(ScratchBuffers& scratch, bool has_duplicates)
+{
+    auto& next_index = scratch.next_index;
+    auto& prev_index = scratch.prev_index;
+    size_t old_size = next_index.size(), new_size = prev_index.size();
+
+    // Skip over the rows at the beginning (and, if all keys are unique, the
+    // end) which are in the same order in both collections, and skip
+    // everything if there aren't any which have moved
+    size_t old_begin = 0, new_begin = 0;
+    while (true) {
+        while (old_begin < old_size && next_index[old_begin] == IndexSet::npos)
+            ++old_begin;
+        while (new_begin < new_size && prev_index[new_begin] == IndexSet::npos)
+            ++new_begin;
+        if (old_begin == old_size || prev_index[new_begin] != old_begin)
             break;
-        }
+        ++old_begin;
+        ++new_begin;
     }
-    if (first_difference == IndexSet::npos)
+    if (old_begin == old_size)
         return;
 
-    // Note that `b` is sorted by key, while `a` is sorted by tv_index
-    b.reserve(rows.size());
-    for (size_t i = 0; i < rows.size(); ++i)
-        b.push_back({rows[i].key, i});
-    std::sort(begin(b), end(b), [](auto lft, auto rgt) {
-        return std::tie(lft.key, lft.tv_index) < std::tie(rgt.key, rgt.tv_index);
-    });
+    size_t old_end = old_size, new_end = new_size;
+    if (!has_duplicates) {
+        while (true) {
+            while (next_index[old_end - 1] == IndexSet::npos)
+                --old_end;
+            while (prev_index[new_end - 1] == IndexSet::npos)
+                --new_end;
+            if (prev_index[new_end - 1] != old_end - 1)
+                break;
+            --old_end;
+            --new_end;
+        }
+    }
+
+    collect_matches(scratch, has_duplicates, old_begin, old_end, new_begin, new_end);
+    auto& matches = scratch.matches;
+
+    // Each match adds one to the length of the sequence in the high bits of
+    // the weight, and one to the low bits if the row was not modified
+    const uint64_t length_weight = uint64_t(new_size) + 1;
+    auto weight = [&](size_t new_index) {
+        return length_weight + (scratch.modified[new_index] ? 0 : 1);
+    };
+
+    // Fenwick tree over reversed new indices, so that the prefix maximum is
+    // the heaviest sequence starting after a given new index
+    auto& heaviest = scratch.heaviest;
+    size_t range = new_end - new_begin;
+    heaviest.assign(range + 1, 0);
+    auto position = [&](size_t new_index) {
+        return new_end - new_index;
+    };
+    auto heaviest_after = [&](size_t new_index) {
+        uint64_t ret = 0;
+        for (size_t p = position(new_index) - 1; p > 0; p -= p & (0 - p))
+            ret = std::max(ret, heaviest[p]);
+        return ret;
+    };
+    auto update = [&](size_t new_index, uint64_t value) {
+        for (size_t p = position(new_index); p <= range; p += p & (0 - p))
+            heaviest[p] = std::max(heaviest[p], value);
+    };
 
-    // Calculate the LCS of the two sequences
-    auto matches =
-        LongestCommonSubsequenceCalculator(a, b, first_difference, changeset.modifications).m_longest_matches;
-
-    // And then insert and delete rows as needed to align them
-    size_t i = first_difference, j = first_difference;
-    for (auto match : matches) {
-        for (; i < match.i; ++i)
-            changeset.deletions.add(a[i].tv_index);
-        for (; j < match.j; ++j)
-            changeset.insertions.add(rows[j].tv_index);
-        i += match.size;
-        j += match.size;
+    // Calculate the heaviest sequence starting at each match, working
+    // backwards from the end. Matches for the same old row can't follow each
+    // other, so they are only added to the tree once all have been calculated.
+    uint64_t best = 0;
+    for (size_t end = matches.size(); end > 0;) {
+        size_t begin = end - 1;
+        while (begin > 0 && matches[begin - 1].old_index == matches[end - 1].old_index)
+            --begin;
+        for (size_t k = begin; k < end; ++k) {
+            matches[k].weight = weight(matches[k].new_index) + heaviest_after(matches[k].new_index);
+            best = std::max(best, matches[k].weight);
+        }
+        for (size_t k = begin; k < end; ++k)
+            update(matches[k].new_index, matches[k].weight);
+        end = begin;
+    }
+
+    // Walk forward picking the first match which can continue the heaviest
+    // sequence, and mark everything else in the range as moved
+    auto& old_kept = scratch.old_kept;
+    auto& new_kept = scratch.new_kept;
+    old_kept.assign(old_end - old_begin, false);
+    new_kept.assign(range, false);
+    size_t last_new_index = IndexSet::npos;
+    for (size_t k = 0; k < matches.size() && best > 0; ++k) {
+        auto& match = matches[k];
+        if (last_new_index != IndexSet::npos && match.new_index <= last_new_index)
+            continue;
+        if (match.weight != best)
+            continue;
+        old_kept[match.old_index - old_begin] = true;
+        new_kept[match.new_index - new_begin] = true;
+        best -= weight(match.new_index);
+        last_new_index = match.new_index;
+        // Skip the other matches for this old row
+        while (k + 1 < matches.size() && matches[k + 1].old_index == match.old_index)
+            ++k;
+    }
+
+    for (size_t i = old_begin; i < old_end; ++i) {
+        if (!old_kept[i - old_begin])
+            next_index[i] = IndexSet::npos;
+    }
+    for (size_t j = new_begin; j < new_end; ++j) {
+        if (!new_kept[j - new_begin])
+            prev_index[j] = IndexSet::npos;
     }
 }
 
@@ -563,55 +617,72 @@ void verify_changeset(std::vector<T> const& prev_rows, std::vector<T> const& nex
 #endif
 }
 
-void calculate(CollectionChangeBuilder& ret, std::vector<RowInfo> old_rows, std::vector<RowInfo> new_rows,
-               std::function<bool(int64_t)> key_did_change, bool in_table_order)
+template <typename T>
+void calculate(CollectionChangeBuilder& ret, std::vector<T> const& prev_rows, std::vector<T> const& next_rows,
+               std::function<bool(int64_t)> const& key_did_change, bool in_table_order)
 {
+    // Nothing was inserted, deleted or moved, so only modifications need to
+    // be checked for
+    if (prev_rows == next_rows) {
+        for (size_t i = 0; i < next_rows.size(); ++i) {
+            if (key_did_change(static_cast<int64_t>(next_rows[i])))
+                ret.modifications.add(i);
+        }
+        return;
+    }
+
+    auto& scratch = scratch_buffers();
+    build_row_info(prev_rows, scratch.old_rows);
+    build_row_info(next_rows, scratch.new_rows);
+    auto& old_rows = scratch.old_rows;
+    auto& new_rows = scratch.new_rows;
+    scratch.next_index.assign(prev_rows.size(), IndexSet::npos);
+    scratch.prev_index.assign(next_rows.size(), IndexSet::npos);
+    scratch.modified.assign(next_rows.size(), false);
+
     // Now that our old and new sets of rows are sorted by key, we can
-    // iterate over them and either record old+new TV indices for rows present
-    // in both, or mark them as inserted/deleted if they appear only in one
+    // iterate over them and pair up the rows present in both. Rows which
+    // appear only in one are inserted or deleted.
+    bool has_duplicates = false;
     size_t i = 0, j = 0;
     while (i < old_rows.size() && j < new_rows.size()) {
-        auto old_index = old_rows[i];
-        auto& new_index = new_rows[j];
-        if (old_index.key == new_index.key) {
-            new_index.prev_tv_index = old_rows[i].tv_index;
+        auto& old_row = old_rows[i];
+        auto& new_row = new_rows[j];
+        if (old_row.key == new_row.key) {
+            scratch.next_index[old_row.tv_index] = new_row.tv_index;
+            scratch.prev_index[new_row.tv_index] = old_row.tv_index;
+            has_duplicates = has_duplicates || (i > 0 && old_rows[i - 1].key == old_row.key) ||
+                             (j > 0 && new_rows[j - 1].key == new_row.key);
             ++i;
             ++j;
         }
-        else if (old_index.key < new_index.key) {
-            ret.deletions.add(old_index.tv_index);
+        else if (old_row.key < new_row.key) {
             ++i;
         }
         else {
-            ret.insertions.add(new_index.tv_index);
             ++j;
         }
     }
 
-    for (; i < old_rows.size(); ++i)
-        ret.deletions.add(old_rows[i].tv_index);
-    for (; j < new_rows.size(); ++j)
-        ret.insertions.add(new_rows[j].tv_index);
-
-    // Filter out the new insertions since we don't need them for any of the
-    // further calculations
-    new_rows.erase(std::remove_if(begin(new_rows), end(new_rows),
-                                  [](auto& row) {
-                                      return row.prev_tv_index == IndexSet::npos;
-                                  }),
-                   end(new_rows));
-    std::sort(begin(new_rows), end(new_rows), [](auto& lft, auto& rgt) {
-        return lft.tv_index < rgt.tv_index;
-    });
-
-    for (auto& row : new_rows) {
-        if (key_did_change(row.key)) {
-            ret.modifications.add(row.tv_index);
+    for (size_t k = 0; k < next_rows.size(); ++k) {
+        if (scratch.prev_index[k] != IndexSet::npos && key_did_change(static_cast<int64_t>(next_rows[k]))) {
+            scratch.modified[k] = true;
+            ret.modifications.add(k);
         }
     }
 
     if (!in_table_order)
-        calculate_moves_sorted(new_rows, ret);
+        calculate_moves_sorted(scratch, has_duplicates);
+
+    // Rows which were moved are reported as deleted and inserted
+    for (size_t k = 0; k < prev_rows.size(); ++k) {
+        if (scratch.next_index[k] == IndexSet::npos)
+            ret.deletions.add(k);
+    }
+    for (size_t k = 0; k < next_rows.size(); ++k) {
+        if (scratch.prev_index[k] == IndexSet::npos)
+            ret.insertions.add(k);
+    }
 }
 
 } // Anonymous namespace
@@ -621,20 +692,8 @@ CollectionChangeBuilder CollectionChangeBuilder::calculate(std::vector<int64_t>
                                                            std::function<bool(int64_t)> key_did_change,
                                                            bool in_table_order)
 {
-
-    auto build_row_info = [](auto& rows) {
-        std::vector<RowInfo> info;
-        info.reserve(rows.size());
-        for (size_t i = 0; i < rows.size(); ++i)
-            info.push_back({rows[i], IndexSet::npos, i});
-        std::sort(begin(info), end(info), [](auto& lft, auto& rgt) {
-            return lft.key < rgt.key;
-        });
-        return info;
-    };
-
     CollectionChangeBuilder ret;
-    ::calculate(ret, build_row_info(prev_rows), build_row_info(next_rows), std::move(key_did_change), in_table_order);
+    ::calculate(ret, prev_rows, next_rows, key_did_change, in_table_order);
     ret.verify();
     verify_changeset(prev_rows, next_rows, ret);
     return ret;
@@ -644,20 +703,8 @@ CollectionChangeBuilder CollectionChangeBuilder::calculate(std::vector<size_t> c
                                                            std::vector<size_t> const& next_rows,
                                                            std::function<bool(int64_t)> key_did_change)
 {
-
-    auto build_row_info = [](auto& rows) {
-        std::vector<RowInfo> info;
-        info.reserve(rows.size());
-        for (size_t i = 0; i < rows.size(); ++i)
-            info.push_back({static_cast<int64_t>(rows[i]), IndexSet::npos, i});
-        std::sort(begin(info), end(info), [](auto& lft, auto& rgt) {
-            return lft.key < rgt.key;
-        });
-        return info;
-    };
-
     CollectionChangeBuilder ret;
-    ::calculate(ret, build_row_info(prev_rows), build_row_info(next_rows), std::move(key_did_change), false);
+    ::calculate(ret, prev_rows, next_rows, key_did_change, false);
     ret.verify();
     verify_changeset(prev_rows, next_rows, ret);
     return ret;
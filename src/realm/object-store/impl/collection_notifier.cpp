@@ -65,6 +65,9 @@ CollectionNotifier::get_modification_checker(TransactionChangeInfo const& info,
             return false;
         };
     }
+    if (m_key_path_tree) {
+        return KeyPathChangeChecker(info, *root_table, *m_key_path_tree);
+    }
     if (m_related_tables.size() == 1) {
         auto& object_set = info.tables.find(m_related_tables[0].table_key.value)->second;
         return [&](ObjectChangeSet::ObjectKeyType object_key) {
@@ -194,6 +197,130 @@ bool DeepChangeChecker::operator()(ObjKeyType key)
     return check_row(m_root_table, key, 0);
 }
 
+KeyPathTree::KeyPathTree(TableKey root_table, KeyPathArray const& key_paths)
+{
+    m_nodes.push_back({root_table, {}, {}, {}});
+    for (auto& key_path : key_paths) {
+        size_t node = 0;
+        for (size_t i = 0; i < key_path.size(); ++i) {
+            ColKey col_key = key_path[i].second;
+            size_t col_ndx = col_key.get_index().val;
+            auto& observed = m_nodes[node].observed_columns;
+            if (observed.size() <= col_ndx)
+                observed.resize(col_ndx + 1);
+            observed[col_ndx] = true;
+            if (i + 1 == key_path.size())
+                break;
+
+            auto& children = m_nodes[node].children;
+            auto it = std::find_if(children.begin(), children.end(), [&](size_t child) {
+                return m_nodes[child].link_col == col_key;
+            });
+            if (it != children.end()) {
+                node = *it;
+                continue;
+            }
+            size_t child = m_nodes.size();
+            children.push_back(child);
+            m_nodes.push_back({key_path[i + 1].first, col_key, {}, {}});
+            node = child;
+        }
+    }
+}
+
+void KeyPathTree::validate(Group const& group, TableKey root_table, KeyPathArray const& key_paths)
+{
+    auto table_exists = [&](TableKey table_key) {
+        for (auto key : group.get_table_keys()) {
+            if (key == table_key)
+                return true;
+        }
+        return false;
+    };
+    for (auto& key_path : key_paths) {
+        if (key_path.empty())
+            throw std::invalid_argument("Key path must not be empty");
+        if (key_path.front().first != root_table)
+            throw std::invalid_argument("Key path must start at the observed object type");
+
+        for (size_t i = 0; i < key_path.size(); ++i) {
+            TableKey table_key = key_path[i].first;
+            ColKey col_key = key_path[i].second;
+            if (!table_exists(table_key))
+                throw std::invalid_argument("Key path contains an invalid table");
+            auto table = group.get_table(table_key);
+            if (!table->valid_column(col_key))
+                throw std::invalid_argument("Key path contains an invalid property");
+            if (i + 1 == key_path.size())
+                break;
+
+            auto type = table->get_column_type(col_key);
+            if ((type != type_Link && type != type_LinkList) ||
+                table->get_link_target(col_key)->get_key() != key_path[i + 1].first)
+                throw std::invalid_argument("Key path property must link to the type of the next property");
+        }
+    }
+}
+
+KeyPathChangeChecker::KeyPathChangeChecker(TransactionChangeInfo const& info, Table const& root_table,
+                                           KeyPathTree const& key_paths)
+{
+    auto& nodes = key_paths.nodes();
+    auto& group = *root_table.get_parent_group();
+
+    // The objects in each node's table which had an observed property modified.
+    // Child nodes always come after their parent, so walking the nodes
+    // backwards reaches each node only after all of its descendants.
+    std::vector<std::unordered_set<ObjKeyType>> modified(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0;) {
+        auto& node = nodes[i];
+        auto mark_modified = [&](ObjKeyType obj_key, ObjectChangeSet::ColKeyType col_key) {
+            if (i > 0) {
+                modified[i].insert(obj_key);
+                return;
+            }
+            auto& columns = m_modified[obj_key];
+            if (std::find(columns.begin(), columns.end(), col_key) == columns.end())
+                columns.push_back(col_key);
+        };
+
+        auto it = info.tables.find(node.table_key.value);
+        if (it != info.tables.end()) {
+            for (auto& modification : it->second.get_modifications()) {
+                for (auto col_key : modification.second) {
+                    if (node.observes(ColKey(col_key)))
+                        mark_modified(modification.first, col_key);
+                }
+            }
+        }
+        if (node.children.empty())
+            continue;
+
+        auto table = group.get_table(node.table_key);
+        for (size_t child : node.children) {
+            auto& link_col = nodes[child].link_col;
+            if (modified[child].empty() || !table->valid_column(link_col))
+                continue;
+            auto target = group.get_table(nodes[child].table_key);
+            for (auto obj_key : modified[child]) {
+                if (!target->is_valid(ObjKey(obj_key)))
+                    continue;
+                auto obj = target->get_object(ObjKey(obj_key));
+                size_t backlinks = obj.get_backlink_count(*table, link_col);
+                for (size_t j = 0; j < backlinks; ++j)
+                    mark_modified(obj.get_backlink(*table, link_col, j).value, link_col.value);
+            }
+        }
+    }
+}
+
+std::vector<ObjectChangeSet::ColKeyType> const*
+KeyPathChangeChecker::get_columns_modified(ObjKeyType obj_key) const
+{
+    auto it = m_modified.find(obj_key);
+    return it != m_modified.end() ? &it->second : nullptr;
+}
+
 CollectionNotifier::CollectionNotifier(std::shared_ptr<Realm> realm)
     : m_realm(std::move(realm))
     , m_sg_version(Realm::Internal::get_transaction(*m_realm).get_version_of_current_transaction())
@@ -212,13 +339,19 @@ void CollectionNotifier::release_data() noexcept
     m_sg = nullptr;
 }
 
-uint64_t CollectionNotifier::add_callback(CollectionChangeCallback callback)
+uint64_t CollectionNotifier::add_callback(CollectionChangeCallback callback, KeyPathArray key_paths)
 {
     m_realm->verify_thread();
+    if (!key_paths.empty()) {
+        if (!m_root_table_key)
+            throw std::invalid_argument("Key paths can only be observed on collections of objects");
+        KeyPathTree::validate(m_realm->read_group(), m_root_table_key, key_paths);
+    }
 
     util::CheckedLockGuard lock(m_callback_mutex);
     auto token = m_next_token++;
-    m_callbacks.push_back({std::move(callback), {}, {}, token, false, false});
+    m_callbacks.push_back({std::move(callback), {}, {}, token, false, false, std::move(key_paths)});
+    m_key_paths_changed = true;
     if (m_callback_index == npos) { // Don't need to wake up if we're already sending notifications
         Realm::Internal::get_coordinator(*m_realm).wake_up_notifier_worker();
         m_have_callbacks = true;
@@ -247,6 +380,7 @@ void CollectionNotifier::remove_callback(uint64_t token)
 
         old = std::move(*it);
         m_callbacks.erase(it);
+        m_key_paths_changed = true;
 
         m_have_callbacks = !m_callbacks.empty();
     }
@@ -298,13 +432,83 @@ std::unique_lock<std::mutex> CollectionNotifier::lock_target()
 }
 
 void CollectionNotifier::set_table(ConstTableRef table)
+{
+    m_root_table_key = table->get_key();
+    m_check_linked_objects = true;
+    update_related_tables(*table);
+}
+
+void CollectionNotifier::update_related_tables(Table const& root_table)
 {
     m_related_tables.clear();
-    DeepChangeChecker::find_related_tables(m_related_tables, *table);
+    if (!m_key_path_tree && m_check_linked_objects)
+        DeepChangeChecker::find_related_tables(m_related_tables, root_table);
+
+    auto add_tables = [&](KeyPathTree const& key_paths) {
+        for (auto& node : key_paths.nodes()) {
+            if (std::none_of(m_related_tables.begin(), m_related_tables.end(), [&](auto& tbl) {
+                    return tbl.table_key == node.table_key;
+                }))
+                m_related_tables.push_back({node.table_key, {}});
+        }
+    };
+    if (m_key_path_tree)
+        add_tables(*m_key_path_tree);
+    for (auto& filter : m_key_path_filters)
+        add_tables(filter.key_paths);
+}
+
+void CollectionNotifier::update_key_path_tree()
+{
+    KeyPathArray key_paths;
+    std::vector<std::pair<uint64_t, KeyPathArray>> filters;
+    {
+        util::CheckedLockGuard lock(m_callback_mutex);
+        if (!m_key_paths_changed)
+            return;
+        m_key_paths_changed = false;
+
+        // A callback without key paths observes everything, so the key paths
+        // of the other callbacks can't narrow what the notifier has to check
+        bool observes_everything = false;
+        for (auto& callback : m_callbacks) {
+            if (callback.key_paths.empty())
+                observes_everything = true;
+            else
+                key_paths.insert(key_paths.end(), callback.key_paths.begin(), callback.key_paths.end());
+        }
+        if (observes_everything)
+            key_paths.clear();
+
+        // Unless every callback observes the same key paths, the changes of
+        // those with key paths are narrowed down separately
+        bool same_key_paths = std::all_of(m_callbacks.begin(), m_callbacks.end(), [&](auto& callback) {
+            return callback.key_paths == m_callbacks.front().key_paths;
+        });
+        if (!same_key_paths) {
+            for (auto& callback : m_callbacks) {
+                if (!callback.key_paths.empty())
+                    filters.push_back({callback.token, callback.key_paths});
+            }
+        }
+    }
+
+    if (!m_root_table_key ||
+        (key_paths.empty() && filters.empty() && !m_key_path_tree && m_key_path_filters.empty()))
+        return;
+    if (key_paths.empty())
+        m_key_path_tree.reset();
+    else
+        m_key_path_tree = std::make_unique<KeyPathTree>(m_root_table_key, key_paths);
+    m_key_path_filters.clear();
+    for (auto& filter : filters)
+        m_key_path_filters.push_back({filter.first, KeyPathTree(m_root_table_key, filter.second), {}, false});
+    update_related_tables(*m_sg->get_table(m_root_table_key));
 }
 
 void CollectionNotifier::add_required_change_info(TransactionChangeInfo& info)
 {
+    update_key_path_tree();
     if (!do_add_required_change_info(info) || m_related_tables.empty()) {
         return;
     }
@@ -321,6 +525,10 @@ void CollectionNotifier::prepare_handover()
     do_prepare_handover(*m_sg);
     add_changes(std::move(m_change));
     REALM_ASSERT(m_change.empty());
+    for (auto& filter : m_key_path_filters) {
+        filter.change = {};
+        filter.has_change = false;
+    }
     m_has_run = true;
 
 #ifdef REALM_DEBUG
@@ -428,10 +636,16 @@ void CollectionNotifier::add_changes(CollectionChangeBuilder change)
 {
     util::CheckedLockGuard lock(m_callback_mutex);
     for (auto& callback : m_callbacks) {
+        auto filter = std::find_if(m_key_path_filters.begin(), m_key_path_filters.end(), [&](auto& filter) {
+            return filter.token == callback.token && filter.has_change;
+        });
         if (callback.skip_next) {
             REALM_ASSERT_DEBUG(callback.accumulated_changes.empty());
             callback.skip_next = false;
         }
+        else if (filter != m_key_path_filters.end()) {
+            callback.accumulated_changes.merge(std::move(filter->change));
+        }
         else {
             if (&callback == &m_callbacks.back())
                 callback.accumulated_changes.merge(std::move(change));
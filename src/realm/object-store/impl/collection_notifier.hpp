@@ -37,6 +37,7 @@
 #include <unordered_set>
 
 namespace realm {
+class Group;
 class Realm;
 class Transaction;
 
@@ -100,6 +101,63 @@ private:
     bool check_outgoing_links(TableKey table_key, Table const& table, int64_t obj_key, size_t depth = 0);
 };
 
+// The key paths observed by the callbacks of a notifier, compiled into a tree
+// with a node for each distinct key path prefix. Each node holds a bitmap of the
+// columns observed on its table at that point in the key paths.
+class KeyPathTree {
+public:
+    struct Node {
+        TableKey table_key;
+        // The link column in the parent node's table which leads to this node
+        ColKey link_col;
+        // Indexed by column index
+        std::vector<bool> observed_columns;
+        std::vector<size_t> children;
+
+        bool observes(ColKey col) const noexcept
+        {
+            size_t ndx = col.get_index().val;
+            return ndx < observed_columns.size() && observed_columns[ndx];
+        }
+    };
+
+    KeyPathTree(TableKey root_table, KeyPathArray const& key_paths);
+
+    // nodes()[0] is the root table
+    std::vector<Node> const& nodes() const noexcept
+    {
+        return m_nodes;
+    }
+
+    // Throws std::invalid_argument if the key paths do not start at
+    // `root_table` or are not valid paths in `group`
+    static void validate(Group const& group, TableKey root_table, KeyPathArray const& key_paths);
+
+private:
+    std::vector<Node> m_nodes;
+};
+
+// Checks for modifications to the properties in a KeyPathTree. Rather than
+// walking the links of each object being checked, the objects with a modified
+// observed property are found once from the change info, and then followed
+// backwards along the key paths through their backlinks to the root table.
+class KeyPathChangeChecker {
+public:
+    KeyPathChangeChecker(TransactionChangeInfo const& info, Table const& root_table, KeyPathTree const& key_paths);
+
+    bool operator()(ObjKeyType obj_key) const
+    {
+        return m_modified.count(obj_key) != 0;
+    }
+
+    // The observed columns of the object which were modified, either directly
+    // or through the objects they link to, or nullptr if none were
+    std::vector<ObjectChangeSet::ColKeyType> const* get_columns_modified(ObjKeyType obj_key) const;
+
+private:
+    std::unordered_map<ObjKeyType, std::vector<ObjectChangeSet::ColKeyType>> m_modified;
+};
+
 // A base class for a notifier that keeps a collection up to date and/or
 // generates detailed change notifications on a background thread. This manages
 // most of the lifetime-management issues related to sharing an object between
@@ -120,7 +178,10 @@ public:
     // Add a callback to be called each time the collection changes
     // This can only be called from the target collection's thread
     // Returns a token which can be passed to remove_callback()
-    uint64_t add_callback(CollectionChangeCallback callback) REQUIRES(!m_callback_mutex);
+    // If `key_paths` is non-empty, only modifications to the properties in
+    // those key paths are reported to the callback.
+    uint64_t add_callback(CollectionChangeCallback callback, KeyPathArray key_paths = {})
+        REQUIRES(!m_callback_mutex);
     // Remove a previously added token. The token is no longer valid after
     // calling this function and must not be used again. This function can be
     // called from any thread.
@@ -173,6 +234,21 @@ public:
         return m_has_run;
     }
 
+    // The Transaction of the worker which this notifier should be attached to,
+    // if it shares work with other notifiers. Notifiers attached to the same
+    // worker are run one after the other, so the work is done only once.
+    virtual Transaction* get_preferred_transaction() const
+    {
+        return nullptr;
+    }
+
+    // Get the Transaction which this notifier is attached to, if any
+    // precondition: RealmCoordinator::m_notifier_mutex is locked *or* is called on worker thread
+    Transaction* get_transaction() const noexcept
+    {
+        return m_sg.get();
+    }
+
     // Attach the handed-over query to `sg`. Must not be already attached to a Transaction.
     // precondition: RealmCoordinator::m_notifier_mutex is locked
     void attach_to(std::shared_ptr<Transaction> sg);
@@ -199,6 +275,25 @@ public:
 protected:
     void add_changes(CollectionChangeBuilder change) REQUIRES(!m_callback_mutex);
     void set_table(ConstTableRef table);
+    // Set the table whose objects the notifier reports changes to without
+    // checking the objects they link to, unless key paths are observed
+    void set_table_key(TableKey table_key) noexcept
+    {
+        m_root_table_key = table_key;
+    }
+    // The key paths observed by all callbacks, or nullptr if any callback
+    // observes every property
+    KeyPathTree const* get_key_path_tree() const noexcept
+    {
+        return m_key_path_tree.get();
+    }
+    // Calculate the changes for each callback which observes fewer properties
+    // than the notifier as a whole. `fn` is called with a KeyPathChangeChecker
+    // for the key paths of each such callback, and returns its changes. The
+    // other callbacks, and those for which this is not called in a run, are
+    // given m_change.
+    template <typename Fn>
+    void calculate_key_path_changes(TransactionChangeInfo const& info, Table const& root_table, Fn&& fn);
     std::unique_lock<std::mutex> lock_target();
     Transaction& source_shared_group();
 
@@ -228,6 +323,26 @@ private:
     bool m_error = false;
     std::vector<DeepChangeChecker::RelatedTable> m_related_tables;
 
+    // The table whose objects the notifier reports changes to, if any
+    TableKey m_root_table_key;
+    // Whether the objects linked to from m_root_table_key are checked for
+    // modifications when no key paths are observed
+    bool m_check_linked_objects = false;
+    std::unique_ptr<KeyPathTree> m_key_path_tree;
+
+    // The key paths and changes of a callback which observes fewer properties
+    // than the notifier as a whole. Only used on the worker thread.
+    struct KeyPathFilter {
+        uint64_t token;
+        KeyPathTree key_paths;
+        CollectionChangeBuilder change;
+        bool has_change;
+    };
+    std::vector<KeyPathFilter> m_key_path_filters;
+    // Set when callbacks are added or removed, so that the key path tree is
+    // rebuilt on the worker thread before the next run
+    bool m_key_paths_changed GUARDED_BY(m_callback_mutex) = false;
+
     struct Callback {
         CollectionChangeCallback fn;
         CollectionChangeBuilder accumulated_changes;
@@ -235,6 +350,7 @@ private:
         uint64_t token;
         bool initial_delivered;
         bool skip_next;
+        KeyPathArray key_paths;
     };
 
     // Currently registered callbacks and a mutex which must always be held
@@ -263,8 +379,20 @@ private:
     void for_each_callback(Fn&& fn) REQUIRES(!m_callback_mutex);
 
     std::vector<Callback>::iterator find_callback(uint64_t token);
+    void update_key_path_tree() REQUIRES(!m_callback_mutex);
+    void update_related_tables(Table const& root_table);
 };
 
+template <typename Fn>
+void CollectionNotifier::calculate_key_path_changes(TransactionChangeInfo const& info, Table const& root_table,
+                                                    Fn&& fn)
+{
+    for (auto& filter : m_key_path_filters) {
+        filter.change = fn(KeyPathChangeChecker(info, root_table, filter.key_paths));
+        filter.has_change = true;
+    }
+}
+
 // A smart pointer to a CollectionNotifier that unregisters the notifier when
 // the pointer is destroyed. Movable. Copying will produce a null Handle.
 template <typename T>
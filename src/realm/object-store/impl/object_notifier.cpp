@@ -28,13 +28,15 @@ ObjectNotifier::ObjectNotifier(std::shared_ptr<Realm> realm, TableKey table, Obj
     , m_table(table)
     , m_obj(obj)
 {
+    set_table_key(table);
 }
 
 bool ObjectNotifier::do_add_required_change_info(TransactionChangeInfo& info)
 {
     m_info = &info;
     info.tables[m_table.value];
-    return false;
+    // The related tables are only those of the observed key paths, if any
+    return true;
 }
 
 void ObjectNotifier::run()
@@ -54,11 +56,27 @@ void ObjectNotifier::run()
         return;
     }
 
-    auto column_modifications = change.get_columns_modified(m_obj.value);
-    if (!column_modifications)
+    auto table = get_transaction()->get_table(m_table);
+    calculate_key_path_changes(*m_info, *table, [&](KeyPathChangeChecker const& checker) {
+        CollectionChangeBuilder change;
+        report_modifications(change, checker.get_columns_modified(m_obj.value));
+        return change;
+    });
+    if (auto key_paths = get_key_path_tree()) {
+        KeyPathChangeChecker checker(*m_info, *table, *key_paths);
+        report_modifications(m_change, checker.get_columns_modified(m_obj.value));
         return;
-    m_change.modifications.add(0);
-    for (auto col : *column_modifications) {
-        m_change.columns[col].add(0);
+    }
+    report_modifications(m_change, change.get_columns_modified(m_obj.value));
+}
+
+template <typename Columns>
+void ObjectNotifier::report_modifications(CollectionChangeBuilder& change, Columns const* columns)
+{
+    if (!columns)
+        return;
+    change.modifications.add(0);
+    for (auto col : *columns) {
+        change.columns[col].add(0);
     }
 }
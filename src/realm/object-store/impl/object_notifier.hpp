@@ -36,6 +36,8 @@ private:
     TransactionChangeInfo* m_info;
 
     void run() override;
+    template <typename Columns>
+    void report_modifications(CollectionChangeBuilder& change, Columns const* columns);
 
     bool do_add_required_change_info(TransactionChangeInfo& info) override;
 };
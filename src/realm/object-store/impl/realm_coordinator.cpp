@@ -20,8 +20,10 @@
 
 #include <realm/object-store/impl/collection_notifier.hpp>
 #include <realm/object-store/impl/external_commit_helper.hpp>
+#include <realm/object-store/impl/results_notifier.hpp>
 #include <realm/object-store/impl/transact_log_handler.hpp>
 #include <realm/object-store/impl/weak_realm_notifier.hpp>
+#include <realm/object-store/binding_callback_thread_observer.hpp>
 #include <realm/object-store/binding_context.hpp>
 #include <realm/object-store/object_schema.hpp>
 #include <realm/object-store/object_store.hpp>
@@ -42,9 +44,12 @@
 #include <realm/history.hpp>
 #include <realm/string_data.hpp>
 #include <realm/util/fifo_helper.hpp>
+#include <realm/util/function_ref.hpp>
 #include <realm/sync/config.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 
 using namespace realm;
@@ -524,6 +529,15 @@ void RealmCoordinator::open_db()
 
 void RealmCoordinator::close()
 {
+    std::unique_ptr<WriteLockWaiter> waiter;
+    {
+        util::CheckedLockGuard lock(m_realm_mutex);
+        waiter = std::move(m_write_lock_waiter);
+        m_realms_waiting_for_write_lock.clear();
+    }
+    // Has to be destroyed without holding the lock as the thread acquires it
+    waiter = nullptr;
+
     m_db->close();
     m_db = nullptr;
 }
@@ -588,10 +602,17 @@ void RealmCoordinator::advance_schema_cache(uint64_t previous, uint64_t next)
     m_schema_transaction_version_max = std::max(next, m_schema_transaction_version_max);
 }
 
-RealmCoordinator::RealmCoordinator() {}
+RealmCoordinator::RealmCoordinator()
+    : m_query_result_cache(std::make_shared<QueryResultCache>())
+{
+}
 
 RealmCoordinator::~RealmCoordinator()
 {
+    // Waits for the write lock waiter thread to join. This must happen before
+    // anything else as the thread accesses m_weak_realm_notifiers.
+    m_write_lock_waiter = nullptr;
+
     {
         std::lock_guard<std::mutex> coordinator_lock(s_coordinator_mutex);
         for (auto it = s_coordinators_per_path.begin(); it != s_coordinators_per_path.end();) {
@@ -605,6 +626,7 @@ RealmCoordinator::~RealmCoordinator()
     }
     // Waits for the worker thread to join
     m_notifier = nullptr;
+    m_notifier_workers = nullptr;
 
     // Ensure the notifiers aren't holding on to Transactions after we destroy
     // the History object the DB depends on
@@ -630,6 +652,9 @@ void RealmCoordinator::unregister_realm(Realm* realm)
             return notifier.expired() || notifier.is_for_realm(realm);
         });
         m_weak_realm_notifiers.erase(new_end, end(m_weak_realm_notifiers));
+        m_realms_waiting_for_write_lock.erase(
+            std::remove(begin(m_realms_waiting_for_write_lock), end(m_realms_waiting_for_write_lock), realm),
+            end(m_realms_waiting_for_write_lock));
     }
 }
 
@@ -726,15 +751,46 @@ void RealmCoordinator::commit_write(Realm& realm)
         }
     }
 
+    announce_commit(&realm, tr.get_version());
+}
+
+void RealmCoordinator::announce_batched_commits(Realm& realm)
+{
+    REALM_ASSERT(!realm.is_in_transaction());
+
+    Transaction& tr = Realm::Internal::get_transaction(realm);
+    {
+        // The write was rolled back to the batch's last commit, which the
+        // Realm's notifiers skip just as if commit_write() had made it
+        util::CheckedLockGuard l(m_notifier_mutex);
+        bool have_notifiers = std::any_of(m_notifiers.begin(), m_notifiers.end(), [&](auto&& notifier) {
+            return notifier->is_for_realm(realm);
+        });
+        if (have_notifiers) {
+            m_notifier_skip_version = tr.get_version_of_current_transaction();
+        }
+    }
+
+    announce_commit(&realm, tr.get_version());
+}
+
+void RealmCoordinator::announce_batched_commits(DB::version_type version)
+{
+    announce_commit(nullptr, version);
+}
+
+void RealmCoordinator::announce_commit(Realm* realm, DB::version_type version)
+{
 #if REALM_ENABLE_SYNC
     // Realm could be closed in did_change. So send sync notification first before did_change.
     if (m_sync_session) {
-        auto version = tr.get_version();
         SyncSession::Internal::nonsync_transact_notify(*m_sync_session, version);
     }
+#else
+    static_cast<void>(version);
 #endif
-    if (realm.m_binding_context) {
-        realm.m_binding_context->did_change({}, {});
+    if (realm && realm->m_binding_context) {
+        realm->m_binding_context->did_change({}, {});
     }
 
     if (m_notifier) {
@@ -742,6 +798,133 @@ void RealmCoordinator::commit_write(Realm& realm)
     }
 }
 
+void RealmCoordinator::commit_write_and_continue(Realm& realm)
+{
+    REALM_ASSERT(!m_config.immutable());
+    REALM_ASSERT(realm.is_in_transaction());
+
+    // Nothing outside of this Realm is told about the commit yet, as it will
+    // be followed by more commits in the same write. The final commit_write()
+    // sets the skip version to the last version, which suppresses all of them,
+    // and if there is none the Realm calls announce_batched_commits() instead.
+    Realm::Internal::get_transaction(realm).commit_and_continue_writing(false);
+}
+
+class RealmCoordinator::WriteLockWaiter {
+public:
+    WriteLockWaiter(std::shared_ptr<DB> db, std::function<void()> on_available)
+        : m_db(std::move(db))
+        , m_on_available(std::move(on_available))
+        , m_thread([this] {
+            thread_main();
+        })
+    {
+    }
+
+    ~WriteLockWaiter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_one();
+        m_thread.join();
+    }
+
+    // Call the on_available function once the write lock is next observed to
+    // be available. Multiple calls before that happens are coalesced.
+    void wait()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_waiting = true;
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    std::shared_ptr<DB> m_db;
+    std::function<void()> m_on_available;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_waiting = false;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    void thread_main()
+    {
+        // The write lock is a robust mutex which may be held by another
+        // process, so there is nothing to wait on other than the lock itself.
+        // Blocking on it would make the thread impossible to stop, so instead
+        // poll for it with an increasing delay.
+        constexpr auto min_delay = std::chrono::milliseconds(1);
+        constexpr auto max_delay = std::chrono::milliseconds(32);
+        auto delay = min_delay;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop) {
+            if (!m_waiting) {
+                m_cv.wait(lock, [&] {
+                    return m_stop || m_waiting;
+                });
+                delay = min_delay;
+                continue;
+            }
+
+            lock.unlock();
+            bool available;
+            try {
+                available = m_db->probe_write_lock();
+            }
+            catch (...) {
+                // Let the waiting Realms report the error when they try to
+                // begin the write themselves
+                available = true;
+            }
+            lock.lock();
+
+            if (available) {
+                m_waiting = false;
+                lock.unlock();
+                m_on_available();
+                lock.lock();
+                continue;
+            }
+
+            m_cv.wait_for(lock, delay, [&] {
+                return m_stop;
+            });
+            delay = std::min(delay * 2, max_delay);
+        }
+    }
+};
+
+bool RealmCoordinator::write_lock_available(Realm& realm)
+{
+    if (m_db->probe_write_lock())
+        return true;
+
+    util::CheckedLockGuard lock(m_realm_mutex);
+    if (std::find(m_realms_waiting_for_write_lock.begin(), m_realms_waiting_for_write_lock.end(), &realm) ==
+        m_realms_waiting_for_write_lock.end())
+        m_realms_waiting_for_write_lock.push_back(&realm);
+    if (!m_write_lock_waiter) {
+        m_write_lock_waiter = std::make_unique<WriteLockWaiter>(m_db, [this] {
+            util::CheckedLockGuard lock(m_realm_mutex);
+            for (auto& notifier : m_weak_realm_notifiers) {
+                if (std::find_if(m_realms_waiting_for_write_lock.begin(), m_realms_waiting_for_write_lock.end(),
+                                 [&](Realm* realm) {
+                                     return notifier.is_for_realm(realm);
+                                 }) != m_realms_waiting_for_write_lock.end())
+                    notifier.notify();
+            }
+            m_realms_waiting_for_write_lock.clear();
+        });
+    }
+    m_write_lock_waiter->wait();
+    return false;
+}
+
 void RealmCoordinator::enable_wait_for_change()
 {
     m_db->enable_wait_for_change();
@@ -801,6 +984,8 @@ void RealmCoordinator::clean_up_dead_notifiers()
 
     if (swap_remove(m_notifiers) && m_notifiers.empty()) {
         m_notifier_sg = nullptr;
+        for (auto& sg : m_notifier_worker_sgs)
+            sg = nullptr;
         m_notifier_skip_version = {0, 0};
     }
     if (swap_remove(m_new_notifiers) && m_new_notifiers.empty()) {
@@ -924,6 +1109,199 @@ private:
 };
 } // anonymous namespace
 
+// A set of threads which, together with the notifier thread, run the notifiers
+// attached to the different notifier transactions. Threads are only started
+// once a notifier is attached to the transaction they run.
+class RealmCoordinator::NotifierWorkers {
+public:
+    ~NotifierWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_work_cv.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    // Call `fn(0)` on the calling thread and `fn(i)` on the i'th worker for
+    // each of the first `count` workers, starting any of them which have not
+    // been started yet, and return once all of the calls have returned. If any
+    // of them throws, the first exception is rethrown.
+    void run(size_t count, util::FunctionRef<void(size_t)> fn)
+    {
+        m_threads.reserve(count);
+        while (m_threads.size() < count) {
+            size_t index = m_threads.size() + 1;
+            m_threads.emplace_back([this, index] {
+                thread_main(index);
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_fn = &fn;
+        m_active = count;
+        m_pending = count;
+        ++m_generation;
+        lock.unlock();
+        m_work_cv.notify_all();
+
+        std::exception_ptr error;
+        try {
+            fn(0);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        m_done_cv.wait(lock, [&] {
+            return m_pending == 0;
+        });
+        m_fn = nullptr;
+        if (!error)
+            error = std::move(m_error);
+        m_error = nullptr;
+        lock.unlock();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    util::FunctionRef<void(size_t)>* m_fn = nullptr;
+    uint64_t m_generation = 0;
+    size_t m_active = 0;
+    size_t m_pending = 0;
+    std::exception_ptr m_error;
+    bool m_stop = false;
+
+    void thread_main(size_t index)
+    {
+        if (g_binding_callback_thread_observer)
+            g_binding_callback_thread_observer->did_create_thread();
+
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_work_cv.wait(lock, [&] {
+                return m_stop || m_generation != generation;
+            });
+            if (m_stop)
+                break;
+            generation = m_generation;
+            if (index > m_active)
+                continue;
+            auto fn = m_fn;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                (*fn)(index);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            if (error && !m_error)
+                m_error = std::move(error);
+            if (--m_pending == 0)
+                m_done_cv.notify_all();
+        }
+        lock.unlock();
+
+        if (g_binding_callback_thread_observer)
+            g_binding_callback_thread_observer->will_destroy_thread();
+    }
+};
+
+std::vector<size_t> RealmCoordinator::get_notifier_worker_loads()
+{
+    // Index 0 is the notifier thread, i.e. m_notifier_sg
+    std::vector<size_t> loads(m_notifier_worker_sgs.size() + 1);
+    if (m_notifier_worker_sgs.empty())
+        return loads;
+    for (auto& notifier : m_notifiers) {
+        auto it = std::find_if(m_notifier_worker_sgs.begin(), m_notifier_worker_sgs.end(), [&](auto& sg) {
+            return sg && sg.get() == notifier->get_transaction();
+        });
+        ++loads[it == m_notifier_worker_sgs.end() ? 0 : it - m_notifier_worker_sgs.begin() + 1];
+    }
+    return loads;
+}
+
+void RealmCoordinator::attach_to_notifier_worker(CollectionNotifier& notifier, std::vector<size_t>& loads)
+{
+    // Attach the notifier to the transaction of the least loaded worker,
+    // creating the transaction if needed, unless it shares work with notifiers
+    // on a specific worker. All of them are at the same version as m_notifier_sg.
+    size_t index = std::min_element(loads.begin(), loads.end()) - loads.begin();
+    if (auto preferred = notifier.get_preferred_transaction()) {
+        if (preferred == m_notifier_sg.get())
+            index = 0;
+        for (size_t i = 0; i < m_notifier_worker_sgs.size(); ++i) {
+            if (m_notifier_worker_sgs[i].get() == preferred)
+                index = i + 1;
+        }
+    }
+    ++loads[index];
+    if (index == 0) {
+        notifier.attach_to(m_notifier_sg);
+        return;
+    }
+    auto& sg = m_notifier_worker_sgs[index - 1];
+    if (!sg)
+        sg = m_notifier_sg->duplicate();
+    notifier.attach_to(sg);
+}
+
+void RealmCoordinator::advance_notifier_worker_sgs()
+{
+    auto version = m_notifier_sg->get_version_of_current_transaction();
+    for (auto& sg : m_notifier_worker_sgs) {
+        if (sg && sg->get_version_of_current_transaction() != version)
+            sg->advance_read(version);
+    }
+}
+
+void RealmCoordinator::run_notifiers(std::vector<CollectionNotifier*> const& notifiers)
+{
+    // Group the notifiers by the transaction which they are attached to, and
+    // run each group on the thread which owns that transaction. The relative
+    // order of the notifiers within each group is preserved.
+    std::vector<std::vector<CollectionNotifier*>> groups(m_notifier_worker_sgs.size() + 1);
+    size_t worker_count = 0;
+    for (auto notifier : notifiers) {
+        size_t index = 0;
+        for (size_t i = 0; i < m_notifier_worker_sgs.size(); ++i) {
+            if (m_notifier_worker_sgs[i] && m_notifier_worker_sgs[i].get() == notifier->get_transaction()) {
+                index = i + 1;
+                break;
+            }
+        }
+        groups[index].push_back(notifier);
+        worker_count = std::max(worker_count, index);
+    }
+
+    if (worker_count == 0) {
+        for (auto notifier : notifiers)
+            notifier->run();
+        return;
+    }
+
+    if (!m_notifier_workers)
+        m_notifier_workers = std::make_unique<NotifierWorkers>();
+    m_notifier_workers->run(worker_count, [&](size_t index) {
+        for (auto notifier : groups[index])
+            notifier->run();
+    });
+}
+
 void RealmCoordinator::run_async_notifiers()
 {
     util::CheckedUniqueLock lock(m_notifier_mutex);
@@ -937,6 +1315,10 @@ void RealmCoordinator::run_async_notifiers()
 
     if (!m_notifier_sg) {
         m_notifier_sg = m_db->start_read();
+        size_t thread_count = m_config.max_notifier_threads;
+        if (thread_count == 0)
+            thread_count = std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+        m_notifier_worker_sgs.resize(thread_count - 1);
     }
 
     if (m_async_error) {
@@ -1015,9 +1397,13 @@ void RealmCoordinator::run_async_notifiers()
         // be here even if the notifiers don't need to rerun.
         notifiers = m_notifiers;
     }
+    auto notifier_worker_loads = get_notifier_worker_loads();
     m_notifiers.insert(m_notifiers.end(), new_notifiers.begin(), new_notifiers.end());
     lock.unlock();
 
+    // The notifiers to run, in the order in which they used to be run serially
+    std::vector<CollectionNotifier*> notifiers_to_run;
+
     if (skip_version.version) {
         REALM_ASSERT(!notifiers.empty());
         REALM_ASSERT(version >= skip_version);
@@ -1025,9 +1411,12 @@ void RealmCoordinator::run_async_notifiers()
         for (auto& notifier : notifiers)
             notifier->add_required_change_info(change_info.current());
         change_info.advance_to_final(skip_version);
+        advance_notifier_worker_sgs();
 
         for (auto& notifier : notifiers)
-            notifier->run();
+            notifiers_to_run.push_back(notifier.get());
+        run_notifiers(notifiers_to_run);
+        notifiers_to_run.clear();
 
         util::CheckedLockGuard lock(m_notifier_mutex);
         for (auto& notifier : notifiers)
@@ -1041,18 +1430,22 @@ void RealmCoordinator::run_async_notifiers()
         notifier->add_required_change_info(change_info.current());
     }
     change_info.advance_to_final(version);
+    advance_notifier_worker_sgs();
 
-    // Attach the new notifiers to the main SG and move them to the main list
+    // Attach the new notifiers to the notifier transactions, spreading them
+    // over the workers
     for (auto& notifier : new_notifiers) {
-        notifier->attach_to(m_notifier_sg);
-        notifier->run();
+        attach_to_notifier_worker(*notifier, notifier_worker_loads);
+        notifiers_to_run.push_back(notifier.get());
     }
 
     // Change info is now all ready, so the notifiers can now perform their
-    // background work
+    // background work. Each worker reads from its own transaction, so they can
+    // run concurrently.
     for (auto& notifier : notifiers) {
-        notifier->run();
+        notifiers_to_run.push_back(notifier.get());
     }
+    run_notifiers(notifiers_to_run);
 
     // Reacquire the lock while updating the fields that are actually read on
     // other threads
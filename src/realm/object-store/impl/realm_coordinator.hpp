@@ -39,6 +39,7 @@ class Transaction;
 namespace _impl {
 class CollectionNotifier;
 class ExternalCommitHelper;
+class QueryResultCache;
 class WeakRealmNotifier;
 
 // RealmCoordinator manages the weak cache of Realm instances and communication
@@ -137,6 +138,12 @@ public:
     void send_commit_notifications(Realm&);
     void wake_up_notifier_worker();
 
+    // The query results shared between the notifiers for equivalent queries
+    std::shared_ptr<QueryResultCache> const& get_query_result_cache() const noexcept
+    {
+        return m_query_result_cache;
+    }
+
     // Clear the weak Realm cache for all paths
     // Should only be called in test code, as continuing to use the previously
     // cached instances will have odd results
@@ -189,6 +196,24 @@ public:
     // other Realm instances for that path, including in other processes
     void commit_write(Realm& realm) REQUIRES(!m_notifier_mutex);
 
+    // Commit a Realm's current write transaction without syncing it to disk
+    // and leave the Realm in a write transaction. Notifications are not sent
+    // until the next call to commit_write(), which also makes this commit
+    // durable.
+    void commit_write_and_continue(Realm& realm);
+
+    // Send the notifications for commits made with commit_write_and_continue()
+    // when the Realm's write transaction ended without a final commit_write().
+    // If the Realm is being closed, pass only the last version committed.
+    void announce_batched_commits(Realm& realm) REQUIRES(!m_notifier_mutex);
+    void announce_batched_commits(DB::version_type version);
+
+    // Probe whether the write lock is currently free, without starting a write
+    // transaction. If not, the Realm is notified via its scheduler once the
+    // lock is observed to be free. Another writer may still take the lock
+    // before the Realm begins its write, in which case beginning it blocks.
+    bool write_lock_available(Realm& realm) REQUIRES(!m_realm_mutex);
+
     void enable_wait_for_change();
     bool wait_for_change(std::shared_ptr<Transaction> tr);
     void wait_for_change_release();
@@ -234,6 +259,22 @@ private:
     // group's transaction version
     // Will have a read transaction iff m_new_notifiers is non-empty
     std::shared_ptr<Transaction> m_advancer_sg;
+
+    // Transactions used for running async notifiers on the notifier workers,
+    // one per worker. Each is kept at the same version as m_notifier_sg, and
+    // is created when the first notifier is attached to it.
+    std::vector<std::shared_ptr<Transaction>> m_notifier_worker_sgs;
+    // Threads which run the notifiers attached to m_notifier_worker_sgs
+    // concurrently with the ones attached to m_notifier_sg
+    class NotifierWorkers;
+    std::unique_ptr<NotifierWorkers> m_notifier_workers;
+    // Thread which waits for the write lock on behalf of Realms with pending
+    // async writes, so that their schedulers' threads don't wait out other
+    // writers' transactions
+    class WriteLockWaiter;
+    std::unique_ptr<WriteLockWaiter> m_write_lock_waiter GUARDED_BY(m_realm_mutex);
+    std::vector<Realm*> m_realms_waiting_for_write_lock GUARDED_BY(m_realm_mutex);
+    const std::shared_ptr<QueryResultCache> m_query_result_cache;
     std::exception_ptr m_async_error;
 
     std::unique_ptr<_impl::ExternalCommitHelper> m_notifier;
@@ -258,8 +299,13 @@ private:
     void do_get_realm(Realm::Config config, std::shared_ptr<Realm>& realm, util::Optional<VersionID> version,
                       util::CheckedUniqueLock& realm_lock) REQUIRES(m_realm_mutex);
     void run_async_notifiers() REQUIRES(!m_notifier_mutex);
+    std::vector<size_t> get_notifier_worker_loads() REQUIRES(m_notifier_mutex);
+    void attach_to_notifier_worker(CollectionNotifier&, std::vector<size_t>& loads);
+    void advance_notifier_worker_sgs();
+    void run_notifiers(std::vector<CollectionNotifier*> const& notifiers);
     void advance_helper_shared_group_to_latest();
     void clean_up_dead_notifiers() REQUIRES(m_notifier_mutex);
+    void announce_commit(Realm* realm, DB::version_type version);
 
     std::vector<std::shared_ptr<_impl::CollectionNotifier>> notifiers_for_realm(Realm&) REQUIRES(m_notifier_mutex);
 };
@@ -18,8 +18,13 @@
 
 #include <realm/object-store/impl/results_notifier.hpp>
 
+#include <realm/object-store/impl/realm_coordinator.hpp>
 #include <realm/object-store/shared_realm.hpp>
 
+#include <realm/util/serializer.hpp>
+#include <realm/util/to_string.hpp>
+
+#include <algorithm>
 #include <numeric>
 
 using namespace realm;
@@ -37,11 +42,15 @@ using namespace realm::_impl;
 //     - Writes to m_query
 //   * do_add_required_change_info() called with notifier lock held
 //     - Writes to m_info
+//     - Reads m_can_update_incrementally
 //   * run() called with no locks held
 //     - Reads m_query
 //     - Reads m_info
 //     - Reads m_need_to_run <-- FIXME: data race?
 //     - Writes m_run_tv
+//     - Writes m_can_update_incrementally
+//     - Reads and writes m_query_result_cache, which has its own lock as
+//       it's shared with the coordinator's other notifiers
 //   * do_prepare_handover() called with notifier lock held
 //     - Reads m_run_tv
 //     - Writes m_handover_transaction
@@ -57,18 +66,113 @@ using namespace realm::_impl;
 //     - Reads m_deliver_handover
 //     - Reads m_results_were_used
 
+std::string QueryResultCache::make_key(ConstTableRef const& table, Query const& query,
+                                       DescriptorOrdering const& ordering, bool in_table_order)
+{
+    // The description of a query restricted by a view doesn't include the view
+    if (!table || !query.produces_results_in_table_order())
+        return {};
+
+    try {
+        // Unlike the description shown to users, the key must tell apart every
+        // floating point value
+        util::serializer::SerialisationState state;
+        state.exact_floating_point = true;
+        auto description = query.get_description(state);
+        return util::format("%1 %2 %3 %4%5", table->get_key().value, int(in_table_order), description.size(),
+                            description, ordering.get_description(table));
+    }
+    catch (std::exception const&) {
+        // Not every kind of query can be described
+        return {};
+    }
+}
+
+void QueryResultCache::add_subscriber(std::string const& key)
+{
+    util::CheckedLockGuard lock(m_mutex);
+    ++m_subscriptions[key].subscribers;
+}
+
+void QueryResultCache::remove_subscriber(std::string const& key)
+{
+    util::CheckedLockGuard lock(m_mutex);
+    auto it = m_subscriptions.find(key);
+    REALM_ASSERT(it != m_subscriptions.end());
+    if (--it->second.subscribers == 0)
+        m_subscriptions.erase(it);
+}
+
+util::Optional<QueryResultCache::Entry> QueryResultCache::get(std::string const& key, VersionID version) const
+{
+    util::CheckedLockGuard lock(m_mutex);
+    auto it = m_subscriptions.find(key);
+    if (it == m_subscriptions.end() || !it->second.entry.rows || it->second.entry.version != version)
+        return util::none;
+    return it->second.entry;
+}
+
+void QueryResultCache::set(std::string const& key, Entry entry)
+{
+    util::CheckedLockGuard lock(m_mutex);
+    auto it = m_subscriptions.find(key);
+    if (it == m_subscriptions.end())
+        return;
+    auto& current = it->second.entry;
+    if (current.rows && current.version > entry.version)
+        return;
+    // Don't replace changes for this version with results which have none
+    if (current.rows && current.version == entry.version && current.changes && !entry.changes)
+        return;
+    current = std::move(entry);
+}
+
+Transaction* QueryResultCache::get_transaction(std::string const& key) const
+{
+    util::CheckedLockGuard lock(m_mutex);
+    auto it = m_subscriptions.find(key);
+    return it == m_subscriptions.end() ? nullptr : it->second.transaction;
+}
+
+void QueryResultCache::set_transaction(std::string const& key, Transaction* transaction)
+{
+    util::CheckedLockGuard lock(m_mutex);
+    auto it = m_subscriptions.find(key);
+    if (it != m_subscriptions.end())
+        it->second.transaction = transaction;
+}
+
 ResultsNotifier::ResultsNotifier(Results& target)
     : ResultsNotifierBase(target.get_realm())
     , m_query(std::make_unique<Query>(target.get_query()))
     , m_descriptor_ordering(target.get_descriptor_ordering())
     , m_target_is_in_table_order(target.is_in_table_order())
 {
+    if (auto base_ordering = target.get_window_base_ordering())
+        m_window_base_ordering = *base_ordering;
     auto table = m_query->get_table();
     if (table) {
         set_table(table);
+        m_query_result_key =
+            QueryResultCache::make_key(table, *m_query, m_descriptor_ordering, m_target_is_in_table_order);
+    }
+    if (!m_query_result_key.empty()) {
+        m_query_result_cache = Realm::Internal::get_coordinator(*target.get_realm()).get_query_result_cache();
+        m_query_result_cache->add_subscriber(m_query_result_key);
     }
 }
 
+ResultsNotifier::~ResultsNotifier()
+{
+    if (m_query_result_cache)
+        m_query_result_cache->remove_subscriber(m_query_result_key);
+}
+
+Transaction* ResultsNotifier::get_preferred_transaction() const
+{
+    return m_query_result_cache ? m_query_result_cache->get_transaction(m_query_result_key) : nullptr;
+}
+
 void ResultsNotifier::release_data() noexcept
 {
     m_query = {};
@@ -77,6 +181,8 @@ void ResultsNotifier::release_data() noexcept
     m_handover_transaction = {};
     m_delivered_tv = {};
     m_delivered_transaction = {};
+    m_handover_total_count = util::none;
+    m_delivered_total_count = util::none;
     CollectionNotifier::release_data();
 }
 
@@ -96,10 +202,27 @@ bool ResultsNotifier::get_tableview(TableView& out)
     return true;
 }
 
+bool ResultsNotifier::get_total_count(size_t& out)
+{
+    if (!m_delivered_total_count || !m_delivered_transaction)
+        return false;
+    auto& transaction = source_shared_group();
+    if (transaction.get_transact_stage() != DB::transact_Reading)
+        return false;
+    if (m_delivered_transaction->get_version_of_current_transaction() !=
+        transaction.get_version_of_current_transaction())
+        return false;
+
+    out = *m_delivered_total_count;
+    return true;
+}
+
 bool ResultsNotifier::do_add_required_change_info(TransactionChangeInfo& info)
 {
     m_info = &info;
-    return m_query->get_table() && has_run() && have_callbacks();
+    // Incremental updates need the changes to the table even if there's no
+    // one to report them to
+    return m_query->get_table() && has_run() && (have_callbacks() || m_can_update_incrementally);
 }
 
 bool ResultsNotifier::need_to_run()
@@ -109,8 +232,12 @@ bool ResultsNotifier::need_to_run()
     {
         auto lock = lock_target();
         // Don't run the query if the results aren't actually going to be used
-        if (!get_realm() || (!have_callbacks() && !m_results_were_used))
+        if (!get_realm() || (!have_callbacks() && !m_results_were_used)) {
+            // The changes made to the table while not running are not
+            // tracked, so m_previous_rows can't be updated from them later
+            m_can_update_incrementally = false;
             return false;
+        }
     }
 
     // If we've run previously, check if we need to rerun
@@ -123,25 +250,109 @@ bool ResultsNotifier::need_to_run()
     return true;
 }
 
-void ResultsNotifier::calculate_changes()
+bool ResultsNotifier::update_incrementally()
 {
-    if (has_run() && have_callbacks()) {
-        std::vector<int64_t> next_rows;
-        next_rows.reserve(m_run_tv.size());
-        for (size_t i = 0; i < m_run_tv.size(); ++i)
-            next_rows.push_back(m_run_tv.get_key(i).value);
+    if (!m_can_update_incrementally)
+        return false;
 
-        m_change = CollectionChangeBuilder::calculate(m_previous_rows, next_rows,
-                                                      get_modification_checker(*m_info, m_query->get_table()),
-                                                      m_target_is_in_table_order);
+    auto& table = m_query->get_table();
+    auto it = m_info->tables.find(table->get_key().value);
+    if (it == m_info->tables.end() || it->second.clear_did_occur())
+        return false;
+    auto& changes = it->second;
 
-        m_previous_rows = std::move(next_rows);
+    // Each inserted or modified object is checked against the query
+    // individually, which stops being cheaper than rerunning the query once a
+    // significant part of the table has changed
+    size_t changed = changes.insertions_size() + changes.modifications_size();
+    if (changed > table->size() / 4)
+        return false;
+
+    std::vector<ObjKey> matches;
+    matches.reserve(changed);
+    for (auto key : changes.get_insertions())
+        matches.push_back(ObjKey(key));
+    for (auto& modification : changes.get_modifications())
+        matches.push_back(ObjKey(modification.first));
+
+    // Every changed object is removed from the previous results, and then the
+    // ones which still match are merged back in
+    std::vector<ObjKey> removed;
+    removed.reserve(changes.deletions_size() + matches.size());
+    for (auto key : changes.get_deletions())
+        removed.push_back(ObjKey(key));
+    removed.insert(removed.end(), matches.begin(), matches.end());
+    std::sort(removed.begin(), removed.end());
+
+    m_query->filter(matches);
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+    // Table order is key order, so this is a merge of two sorted sequences
+    std::vector<ObjKey> rows;
+    rows.reserve(m_previous_rows.size() + matches.size());
+    auto removed_it = removed.begin();
+    auto match_it = matches.begin();
+    for (auto value : m_previous_rows) {
+        ObjKey key(value);
+        while (match_it != matches.end() && *match_it < key)
+            rows.push_back(*match_it++);
+        while (removed_it != removed.end() && *removed_it < key)
+            ++removed_it;
+        if (removed_it == removed.end() || key < *removed_it)
+            rows.push_back(key);
     }
-    else {
-        m_previous_rows.resize(m_run_tv.size());
-        for (size_t i = 0; i < m_run_tv.size(); ++i)
-            m_previous_rows[i] = m_run_tv.get_key(i).value;
+    rows.insert(rows.end(), match_it, matches.end());
+
+    m_run_tv = m_query->create_view(rows);
+    return true;
+}
+
+void ResultsNotifier::calculate_changes(util::Optional<QueryResultCache::Entry> const& shared_result)
+{
+    std::vector<int64_t> next_rows;
+    next_rows.reserve(m_run_tv.size());
+    for (size_t i = 0; i < m_run_tv.size(); ++i)
+        next_rows.push_back(m_run_tv.get_key(i).value);
+
+    // Callbacks observing key paths are only told about some modifications,
+    // so those changes can't be shared with other notifiers
+    bool share_changes = m_query_result_cache && !get_key_path_tree();
+    std::shared_ptr<const CollectionChangeBuilder> changes;
+    if (has_run() && have_callbacks()) {
+        calculate_key_path_changes(*m_info, *m_query->get_table(), [&](KeyPathChangeChecker const& checker) {
+            return CollectionChangeBuilder::calculate(
+                m_previous_rows, next_rows,
+                [&](int64_t key) {
+                    return checker(key);
+                },
+                m_target_is_in_table_order);
+        });
+        if (share_changes && shared_result && shared_result->changes &&
+            shared_result->changes_from == m_previous_rows_version) {
+            m_change = *shared_result->changes;
+        }
+        else {
+            m_change = CollectionChangeBuilder::calculate(m_previous_rows, next_rows,
+                                                          get_modification_checker(*m_info, m_query->get_table()),
+                                                          m_target_is_in_table_order);
+            if (share_changes)
+                changes = std::make_shared<const CollectionChangeBuilder>(m_change);
+        }
+    }
+
+    auto version = get_transaction()->get_version_of_current_transaction();
+    if (m_query_result_cache && (!shared_result || changes)) {
+        std::shared_ptr<const std::vector<ObjKey>> rows;
+        if (shared_result)
+            rows = shared_result->rows;
+        else
+            rows = std::make_shared<const std::vector<ObjKey>>(next_rows.begin(), next_rows.end());
+        m_query_result_cache->set(m_query_result_key, {version, rows, m_previous_rows_version, changes});
     }
+
+    m_previous_rows = std::move(next_rows);
+    m_previous_rows_version = version;
 }
 
 void ResultsNotifier::run()
@@ -157,18 +368,42 @@ void ResultsNotifier::run()
     if (!need_to_run())
         return;
 
-    m_query->sync_view_if_needed();
-    m_run_tv = m_query->find_all();
-    m_run_tv.apply_descriptor_ordering(m_descriptor_ordering);
-    m_run_tv.sync_if_needed();
+    // If a notifier for an equivalent query has already run at this version,
+    // use its results rather than running the query again
+    util::Optional<QueryResultCache::Entry> shared_result;
+    if (m_query_result_cache)
+        shared_result = m_query_result_cache->get(m_query_result_key,
+                                                  get_transaction()->get_version_of_current_transaction());
+    if (shared_result) {
+        m_run_tv = m_query->create_view(*shared_result->rows, m_descriptor_ordering);
+    }
+    else if (!update_incrementally()) {
+        m_query->sync_view_if_needed();
+        // Lets queries which are only limited stop once the limit is reached
+        m_run_tv = m_query->find_all(m_descriptor_ordering);
+        m_run_tv.sync_if_needed();
+    }
     m_last_seen_version = m_run_tv.ObjList::get_dependency_versions();
 
-    calculate_changes();
+    // Counting the matches doesn't need them to be materialized or sorted, so
+    // it's far cheaper than evaluating the whole Results
+    if (m_window_base_ordering) {
+        m_query->sync_view_if_needed();
+        m_run_total_count = m_query->count(*m_window_base_ordering);
+    }
+
+    // Queries which read other objects than the ones they match, or whose
+    // results aren't in table order, have to be rerun on every change
+    m_can_update_incrementally = m_descriptor_ordering.is_empty() && m_query->produces_results_in_table_order() &&
+                                 !m_query->follows_links();
+
+    calculate_changes(shared_result);
 }
 
 void ResultsNotifier::do_prepare_handover(Transaction& sg)
 {
     m_handover_tv.reset();
+    m_handover_total_count = util::none;
     if (m_handover_transaction)
         m_handover_transaction->advance_read(sg.get_version_of_current_transaction());
 
@@ -178,6 +413,8 @@ void ResultsNotifier::do_prepare_handover(Transaction& sg)
             m_handover_transaction = sg.duplicate();
         m_handover_tv = m_run_tv.clone_for_handover(m_handover_transaction.get(), PayloadPolicy::Move);
         m_run_tv = {};
+        if (m_window_base_ordering)
+            m_handover_total_count = m_run_total_count;
     }
 }
 
@@ -188,6 +425,7 @@ bool ResultsNotifier::prepare_to_deliver()
     if (!realm) {
         m_handover_tv.reset();
         m_delivered_tv.reset();
+        m_delivered_total_count = util::none;
         return false;
     }
     if (!m_handover_tv) {
@@ -198,6 +436,7 @@ bool ResultsNotifier::prepare_to_deliver()
         if (transaction_is_stale) {
             m_delivered_tv.reset();
             m_delivered_transaction.reset();
+            m_delivered_total_count = util::none;
         }
         return true;
     }
@@ -210,6 +449,8 @@ bool ResultsNotifier::prepare_to_deliver()
         m_delivered_transaction = m_handover_transaction->duplicate();
     m_delivered_tv = m_delivered_transaction->import_copy_of(*m_handover_tv, PayloadPolicy::Move);
     m_handover_tv.reset();
+    m_delivered_total_count = std::move(m_handover_total_count);
+    m_handover_total_count = util::none;
 
     return true;
 }
@@ -218,6 +459,8 @@ void ResultsNotifier::do_attach_to(Transaction& sg)
 {
     if (m_query->get_table())
         m_query = sg.import_copy_of(*m_query, PayloadPolicy::Move);
+    if (m_query_result_cache)
+        m_query_result_cache->set_transaction(m_query_result_key, &sg);
 }
 
 ListResultsNotifier::ListResultsNotifier(Results& target)
@@ -232,6 +475,7 @@ ListResultsNotifier::ListResultsNotifier(Results& target)
         if (descr->get_type() == DescriptorType::Distinct)
             m_distinct = true;
     }
+    m_window_size = target.window_size();
 }
 
 void ListResultsNotifier::release_data() noexcept
@@ -253,6 +497,18 @@ bool ListResultsNotifier::get_list_indices(ListIndices& out)
     return true;
 }
 
+bool ListResultsNotifier::get_total_count(size_t& out)
+{
+    if (!m_delivered_total_count)
+        return false;
+    auto& transaction = source_shared_group();
+    if (m_delivered_transaction_version != transaction.get_version_of_current_transaction())
+        return false;
+
+    out = *m_delivered_total_count;
+    return true;
+}
+
 bool ListResultsNotifier::do_add_required_change_info(TransactionChangeInfo& info)
 {
     if (!m_list->is_attached())
@@ -282,8 +538,9 @@ bool ListResultsNotifier::need_to_run()
 void ListResultsNotifier::calculate_changes()
 {
     // Unsorted lists can just forward the changeset directly from the
-    // transaction log parsing, but sorted lists need to perform diffing
-    if (has_run() && have_callbacks() && (m_sort_order || m_distinct)) {
+    // transaction log parsing, but sorted and windowed lists need to perform
+    // diffing
+    if (has_run() && have_callbacks() && (m_sort_order || m_distinct || m_window_size)) {
         // Update each of the row indices in m_previous_indices to the equivalent
         // new index in the new list
         if (!m_change.insertions.empty() || !m_change.deletions.empty()) {
@@ -322,9 +579,15 @@ void ListResultsNotifier::run()
     else if (m_sort_order)
         m_list->sort(*m_run_indices, *m_sort_order);
     else {
-        m_run_indices->resize(m_list->size());
+        // Without sorting only the indices inside the window are needed
+        m_run_indices->resize(std::min(m_list->size(), m_window_size.value_or(npos)));
         std::iota(m_run_indices->begin(), m_run_indices->end(), 0);
     }
+    if (m_window_size) {
+        m_run_total_count = m_distinct ? m_run_indices->size() : m_list->size();
+        if (m_run_indices->size() > *m_window_size)
+            m_run_indices->resize(*m_window_size);
+    }
 
     calculate_changes();
 }
@@ -333,6 +596,7 @@ void ListResultsNotifier::do_prepare_handover(Transaction& sg)
 {
     if (m_run_indices) {
         m_handover_indices = std::move(m_run_indices);
+        m_handover_total_count = m_run_total_count;
         m_run_indices = {};
     }
     else {
@@ -354,6 +618,8 @@ bool ListResultsNotifier::prepare_to_deliver()
     m_delivered_indices = std::move(m_handover_indices);
     m_delivered_transaction_version = m_handover_transaction_version;
     m_handover_indices = {};
+    if (m_window_size)
+        m_delivered_total_count = m_handover_total_count;
 
     return true;
 }
@@ -23,9 +23,54 @@
 #include <realm/object-store/results.hpp>
 
 #include <realm/db.hpp>
+#include <realm/util/optional.hpp>
 
 namespace realm {
 namespace _impl {
+// The results of the queries run by the ResultsNotifiers of a coordinator,
+// shared between the notifiers for equivalent queries so that each distinct
+// query is only run and diffed once per version, however many Results are
+// observing it.
+class QueryResultCache {
+public:
+    struct Entry {
+        // The version which the query was run at
+        VersionID version;
+        std::shared_ptr<const std::vector<ObjKey>> rows;
+        // The changes from the results at `changes_from` to `rows`, if they
+        // were calculated
+        VersionID changes_from;
+        std::shared_ptr<const CollectionChangeBuilder> changes;
+    };
+
+    // A key identifying the query, the table it's run on and the ordering
+    // applied to its results, or an empty string if it can't be identified
+    static std::string make_key(ConstTableRef const& table, Query const& query, DescriptorOrdering const& ordering,
+                                bool in_table_order);
+
+    // Results are only stored for keys which have at least one subscriber
+    void add_subscriber(std::string const& key) REQUIRES(!m_mutex);
+    void remove_subscriber(std::string const& key) REQUIRES(!m_mutex);
+
+    // The results stored for `key` if they're from `version`
+    util::Optional<Entry> get(std::string const& key, VersionID version) const REQUIRES(!m_mutex);
+    // Store the results for `key`, replacing any from an older version
+    void set(std::string const& key, Entry entry) REQUIRES(!m_mutex);
+
+    // The transaction which a notifier for `key` was most recently attached to
+    Transaction* get_transaction(std::string const& key) const REQUIRES(!m_mutex);
+    void set_transaction(std::string const& key, Transaction* transaction) REQUIRES(!m_mutex);
+
+private:
+    struct Subscription {
+        size_t subscribers = 0;
+        Transaction* transaction = nullptr;
+        Entry entry;
+    };
+    mutable util::CheckedMutex m_mutex;
+    std::unordered_map<std::string, Subscription> m_subscriptions GUARDED_BY(m_mutex);
+};
+
 class ResultsNotifierBase : public CollectionNotifier {
 public:
     using ListIndices = util::Optional<std::vector<size_t>>;
@@ -39,17 +84,34 @@ public:
     {
         return false;
     }
+    // Get the total count of a windowed Results as of the version which the
+    // most recently delivered results are for, if they're for the current
+    // version of the Realm
+    virtual bool get_total_count(size_t&)
+    {
+        return false;
+    }
 };
 
 class ResultsNotifier : public ResultsNotifierBase {
 public:
     ResultsNotifier(Results& target);
+    ~ResultsNotifier();
     bool get_tableview(TableView& out) override;
+    bool get_total_count(size_t& out) override;
+    Transaction* get_preferred_transaction() const override;
 
 private:
     std::unique_ptr<Query> m_query;
     DescriptorOrdering m_descriptor_ordering;
     bool m_target_is_in_table_order;
+    // The ordering which the target's window is taken from, if it's windowed
+    util::Optional<DescriptorOrdering> m_window_base_ordering;
+
+    // The coordinator's cache of query results, if the query can be shared
+    // with other notifiers, and the key identifying the query in it
+    std::shared_ptr<QueryResultCache> m_query_result_cache;
+    std::string m_query_result_key;
 
     // The TableView resulting from running the query. Will be detached unless
     // the query was (re)run since the last time the handover object was created
@@ -60,18 +122,33 @@ private:
     TransactionRef m_delivered_transaction;
     std::unique_ptr<TableView> m_delivered_tv;
 
+    // The total count for windowed targets, which is handed over along with
+    // the TableView
+    size_t m_run_total_count = 0;
+    util::Optional<size_t> m_handover_total_count;
+    util::Optional<size_t> m_delivered_total_count;
+
     // The table version from the last time the query was run. Used to avoid
     // rerunning the query when there's no chance of it changing.
     TableVersions m_last_seen_version;
 
     // The rows from the previous run of the query, for calculating diffs
     std::vector<int64_t> m_previous_rows;
+    // The version which m_previous_rows are from
+    VersionID m_previous_rows_version;
+
+    // True if the query only depends on the table it's run on, produces
+    // results in table order and m_previous_rows is up to date, so that the
+    // results can be updated from the changes made to the table rather than
+    // by rerunning the query
+    bool m_can_update_incrementally = false;
 
     TransactionChangeInfo* m_info = nullptr;
     bool m_results_were_used = true;
 
     bool need_to_run();
-    void calculate_changes();
+    bool update_incrementally();
+    void calculate_changes(util::Optional<QueryResultCache::Entry> const& shared_result);
 
     void run() override;
     void do_prepare_handover(Transaction&) override;
@@ -86,18 +163,24 @@ class ListResultsNotifier : public ResultsNotifierBase {
 public:
     ListResultsNotifier(Results& target);
     bool get_list_indices(ListIndices& out) override;
+    bool get_total_count(size_t& out) override;
 
 private:
     std::shared_ptr<CollectionBase> m_list;
     util::Optional<bool> m_sort_order;
     bool m_distinct = false;
+    // The size of the target's window, if it's windowed
+    util::Optional<size_t> m_window_size;
 
     ListIndices m_run_indices;
+    size_t m_run_total_count = 0;
 
     VersionID m_handover_transaction_version;
     ListIndices m_handover_indices;
+    size_t m_handover_total_count = 0;
     VersionID m_delivered_transaction_version;
     ListIndices m_delivered_indices;
+    util::Optional<size_t> m_delivered_total_count;
 
     // The rows from the previous run of the query, for calculating diffs
     std::vector<size_t> m_previous_indices;
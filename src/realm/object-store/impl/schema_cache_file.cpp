@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2020 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include <realm/object-store/impl/schema_cache_file.hpp>
+
+#include <realm/object-store/object_schema.hpp>
+#include <realm/object-store/property.hpp>
+#include <realm/object-store/schema.hpp>
+
+#include <realm/util/file.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+using namespace realm;
+using namespace realm::_impl;
+
+namespace {
+// Bump whenever the layout below changes
+constexpr uint32_t cache_format_version = 1;
+constexpr char cache_magic[8] = {'R', 'L', 'M', 'S', 'C', 'H', 'M', 'A'};
+// Anything larger than this is not something we wrote
+constexpr size_t max_cache_size = 64 * 1024 * 1024;
+
+// All values are written in native byte order. The schema hash is computed
+// from the values in a fixed byte order, so a file written by a machine with
+// a different byte order simply fails to validate.
+class Writer {
+public:
+    template <typename T>
+    void add(T value)
+    {
+        static_assert(std::is_integral<T>::value, "");
+        m_buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void add(std::string const& str)
+    {
+        add(uint64_t(str.size()));
+        m_buffer.append(str);
+    }
+    std::string const& buffer() const noexcept
+    {
+        return m_buffer;
+    }
+
+private:
+    std::string m_buffer;
+};
+
+class Reader {
+public:
+    Reader(const char* data, size_t size)
+        : m_data(data)
+        , m_end(data + size)
+    {
+    }
+
+    // Return false if there isn't enough data left for the value
+    template <typename T>
+    bool get(T& value) noexcept
+    {
+        static_assert(std::is_integral<T>::value, "");
+        if (size_t(m_end - m_data) < sizeof(value))
+            return false;
+        std::memcpy(&value, m_data, sizeof(value));
+        m_data += sizeof(value);
+        return true;
+    }
+    bool get(std::string& str)
+    {
+        uint64_t size;
+        if (!get(size) || size > uint64_t(m_end - m_data))
+            return false;
+        str.assign(m_data, size_t(size));
+        m_data += size;
+        return true;
+    }
+    bool at_end() const noexcept
+    {
+        return m_data == m_end;
+    }
+
+private:
+    const char* m_data;
+    const char* m_end;
+};
+
+void write_header(Writer& writer, uint64_t schema_version, uint64_t schema_hash)
+{
+    for (char c : cache_magic)
+        writer.add(c);
+    writer.add(cache_format_version);
+    // The columns included in the schema depend on whether sync is enabled
+#if REALM_ENABLE_SYNC
+    writer.add(uint8_t(1));
+#else
+    writer.add(uint8_t(0));
+#endif
+    writer.add(schema_version);
+    writer.add(schema_hash);
+}
+
+bool read_object_schema(Reader& reader, ObjectSchema& object_schema)
+{
+    uint32_t table_key;
+    uint8_t is_embedded;
+    uint64_t property_count;
+    if (!reader.get(object_schema.name) || !reader.get(table_key) || !reader.get(is_embedded) ||
+        !reader.get(object_schema.primary_key) || !reader.get(property_count))
+        return false;
+    object_schema.table_key = TableKey(table_key);
+    object_schema.is_embedded = is_embedded != 0;
+
+    for (uint64_t i = 0; i < property_count; ++i) {
+        Property property;
+        uint16_t type;
+        uint8_t is_primary, is_indexed;
+        int64_t col_key;
+        if (!reader.get(property.name) || !reader.get(type) || !reader.get(property.object_type) ||
+            !reader.get(is_primary) || !reader.get(is_indexed) || !reader.get(col_key))
+            return false;
+        property.type = PropertyType(type);
+        property.is_primary = is_primary != 0;
+        property.is_indexed = is_indexed != 0;
+        property.column_key = ColKey(col_key);
+        object_schema.persisted_properties.push_back(std::move(property));
+    }
+    return true;
+}
+} // anonymous namespace
+
+std::string schema_cache_file::path_for(std::string const& realm_path)
+{
+    // The management directory is created by DB and is removed along with the
+    // Realm file by Realm::delete_files()
+    return realm_path + ".management/schema.cache";
+}
+
+util::Optional<Schema> schema_cache_file::read(std::string const& path, uint64_t schema_version,
+                                               uint64_t schema_hash) noexcept
+{
+    try {
+        if (!util::File::exists(path))
+            return util::none;
+        util::File file(path);
+        auto size = file.get_size();
+        if (size <= 0 || uint64_t(size) > max_cache_size)
+            return util::none;
+        std::string buffer(size_t(size), '\0');
+        if (file.read(&buffer[0], buffer.size()) != buffer.size())
+            return util::none;
+
+        Writer expected_header;
+        write_header(expected_header, schema_version, schema_hash);
+        auto& header = expected_header.buffer();
+        if (buffer.compare(0, header.size(), header) != 0)
+            return util::none;
+
+        Reader reader(buffer.data() + header.size(), buffer.size() - header.size());
+        uint64_t object_count;
+        if (!reader.get(object_count))
+            return util::none;
+        std::vector<ObjectSchema> object_schemas;
+        for (uint64_t i = 0; i < object_count; ++i) {
+            ObjectSchema object_schema;
+            if (!read_object_schema(reader, object_schema))
+                return util::none;
+            object_schemas.push_back(std::move(object_schema));
+        }
+        if (!reader.at_end())
+            return util::none;
+        return Schema(std::move(object_schemas));
+    }
+    catch (...) {
+        return util::none;
+    }
+}
+
+void schema_cache_file::write(std::string const& path, Schema const& schema, uint64_t schema_version,
+                              uint64_t schema_hash) noexcept
+{
+    std::string tmp_path;
+    try {
+        Writer writer;
+        write_header(writer, schema_version, schema_hash);
+        writer.add(uint64_t(schema.size()));
+        for (auto& object_schema : schema) {
+            writer.add(object_schema.name);
+            writer.add(uint32_t(object_schema.table_key.value));
+            writer.add(uint8_t(bool(object_schema.is_embedded)));
+            writer.add(object_schema.primary_key);
+            writer.add(uint64_t(object_schema.persisted_properties.size()));
+            for (auto& property : object_schema.persisted_properties) {
+                writer.add(property.name);
+                writer.add(uint16_t(property.type));
+                writer.add(property.object_type);
+                writer.add(uint8_t(bool(property.is_primary)));
+                writer.add(uint8_t(bool(property.is_indexed)));
+                writer.add(int64_t(property.column_key.value));
+            }
+        }
+
+        // Several threads or processes may be writing the cache at once, so
+        // each needs its own temporary file
+        auto unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                      size_t(std::chrono::steady_clock::now().time_since_epoch().count());
+        tmp_path = path + "." + std::to_string(unique) + ".tmp";
+        {
+            util::File file(tmp_path, util::File::mode_Write);
+            file.write(writer.buffer().data(), writer.buffer().size());
+        }
+        util::File::move(tmp_path, path);
+    }
+    catch (...) {
+        if (!tmp_path.empty()) {
+            try {
+                util::File::try_remove(tmp_path);
+            }
+            catch (...) {
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2020 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_SCHEMA_CACHE_FILE_HPP
+#define REALM_OS_SCHEMA_CACHE_FILE_HPP
+
+#include <realm/util/optional.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace realm {
+class Schema;
+
+namespace _impl {
+namespace schema_cache_file {
+// A persistent copy of the schema read from a Realm file, stored in the file's
+// management directory so that opening the file in a new process does not
+// have to build the schema from the tables in the file.
+//
+// Entries are tagged with the schema version and the hash computed by
+// Group::compute_schema_hash(), and are only used if both still match the
+// file. The cache is purely an optimization: all I/O errors and malformed
+// cache files are ignored and result in the schema being read from the file.
+
+// The path of the schema cache for the Realm file at `realm_path`
+std::string path_for(std::string const& realm_path);
+
+// Read the schema stored at `path` if it was written for the given schema
+// version and schema hash
+util::Optional<Schema> read(std::string const& path, uint64_t schema_version, uint64_t schema_hash) noexcept;
+
+// Replace the schema stored at `path`. The new cache file is written to a
+// temporary file and then moved into place, so concurrent readers in other
+// processes never see a partially written file.
+void write(std::string const& path, Schema const& schema, uint64_t schema_version, uint64_t schema_hash) noexcept;
+} // namespace schema_cache_file
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_OS_SCHEMA_CACHE_FILE_HPP
@@ -86,19 +86,28 @@ void SetNotifier::run()
     if (m_type == PropertyType::Object) {
         REALM_ASSERT(dynamic_cast<LnkSet*>(&*m_set));
         auto& set = static_cast<LnkSet&>(*m_set);
-        auto object_did_change = get_modification_checker(*m_info, set.get_target_table());
-        for (size_t i = 0; i < set.size(); ++i) {
-            if (m_change.modifications.contains(i))
-                continue;
-            if (object_did_change(set.get(i).value))
-                m_change.modifications.add(i);
-        }
+        auto add_modifications = [&](CollectionChangeBuilder& change, auto const& object_did_change) {
+            for (size_t i = 0; i < set.size(); ++i) {
+                if (change.modifications.contains(i))
+                    continue;
+                if (object_did_change(set.get(i).value))
+                    change.modifications.add(i);
+            }
 
-        for (auto const& move : m_change.moves) {
-            if (m_change.modifications.contains(move.to))
-                continue;
-            if (object_did_change(set.get(move.to).value))
-                m_change.modifications.add(move.to);
-        }
+            for (auto const& move : change.moves) {
+                if (change.modifications.contains(move.to))
+                    continue;
+                if (object_did_change(set.get(move.to).value))
+                    change.modifications.add(move.to);
+            }
+        };
+
+        // The changes to the set itself are reported to every callback
+        calculate_key_path_changes(*m_info, *set.get_target_table(), [&](KeyPathChangeChecker const& checker) {
+            CollectionChangeBuilder change = m_change;
+            add_modifications(change, checker);
+            return change;
+        });
+        add_modifications(m_change, get_modification_checker(*m_info, set.get_target_table()));
     }
 }
@@ -393,7 +393,7 @@ bool List::operator==(List const& rgt) const noexcept
            m_list_base->get_col_key() == rgt.m_list_base->get_col_key();
 }
 
-NotificationToken List::add_notification_callback(CollectionChangeCallback cb) &
+NotificationToken List::add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths) &
 {
     verify_attached();
     m_realm->verify_notifications_available();
@@ -409,7 +409,7 @@ NotificationToken List::add_notification_callback(CollectionChangeCallback cb) &
         m_notifier = std::make_shared<ListNotifier>(m_realm, *m_list_base, m_type);
         RealmCoordinator::register_notifier(m_notifier);
     }
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(key_paths))};
 }
 
 List List::freeze(std::shared_ptr<Realm> const& frozen_realm) const
@@ -102,7 +102,7 @@ public:
 
     bool operator==(List const& rgt) const noexcept;
 
-    NotificationToken add_notification_callback(CollectionChangeCallback cb) &;
+    NotificationToken add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths = {}) &;
 
     template <typename Context>
     auto get(Context&, size_t row_ndx) const;
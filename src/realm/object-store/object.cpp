@@ -126,7 +126,7 @@ Object::Object(Object&&) = default;
 Object& Object::operator=(Object const&) = default;
 Object& Object::operator=(Object&&) = default;
 
-NotificationToken Object::add_notification_callback(CollectionChangeCallback callback) &
+NotificationToken Object::add_notification_callback(CollectionChangeCallback callback, KeyPathArray key_paths) &
 {
     verify_attached();
     m_realm->verify_notifications_available();
@@ -134,7 +134,7 @@ NotificationToken Object::add_notification_callback(CollectionChangeCallback cal
         m_notifier = std::make_shared<_impl::ObjectNotifier>(m_realm, m_obj.get_table()->get_key(), m_obj.get_key());
         _impl::RealmCoordinator::register_notifier(m_notifier);
     }
-    return {m_notifier, m_notifier->add_callback(std::move(callback))};
+    return {m_notifier, m_notifier->add_callback(std::move(callback), std::move(key_paths))};
 }
 
 void Object::verify_attached() const
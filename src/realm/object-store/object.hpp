@@ -111,7 +111,7 @@ public:
     // Returns whether or not this Object is frozen.
     bool is_frozen() const noexcept;
 
-    NotificationToken add_notification_callback(CollectionChangeCallback callback) &;
+    NotificationToken add_notification_callback(CollectionChangeCallback callback, KeyPathArray key_paths = {}) &;
 
     template <typename ValueType>
     void set_column_value(StringData prop_name, ValueType&& value)
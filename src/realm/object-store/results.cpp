@@ -25,6 +25,7 @@
 #include <realm/object-store/object_store.hpp>
 #include <realm/object-store/schema.hpp>
 
+#include <numeric>
 #include <stdexcept>
 
 namespace realm {
@@ -228,10 +229,19 @@ void Results::evaluate_sort_and_distinct_on_list()
             do_distinct = true;
     }
 
+    // A window is only applied after sorting and distinct, and without either
+    // only the indices inside the window are needed
+    auto limit = m_descriptor_ordering.get_min_limit();
     if (do_distinct)
         m_collection->distinct(*m_list_indices, sort_order);
     else if (sort_order)
         m_collection->sort(*m_list_indices, *sort_order);
+    else {
+        m_list_indices->resize(std::min(m_collection->size(), limit.value_or(npos)));
+        std::iota(m_list_indices->begin(), m_list_indices->end(), 0);
+    }
+    if (limit && m_list_indices->size() > *limit)
+        m_list_indices->resize(*limit);
 }
 
 template <typename T>
@@ -964,8 +974,11 @@ Results Results::sort(SortDescriptor&& sort) const
     new_order.append_sort(std::move(sort));
     if (m_mode == Mode::LinkList)
         return Results(m_realm, m_link_list, util::none, std::move(sort));
-    else if (m_mode == Mode::List)
+    else if (m_mode == Mode::List) {
+        if (m_descriptor_ordering.will_apply_limit())
+            throw UnimplementedOperationException("Sorting a windowed Results of a list is not yet implemented");
         return Results(m_realm, m_collection, std::move(new_order));
+    }
     return Results(m_realm, do_get_query(), std::move(new_order));
 }
 
@@ -983,6 +996,64 @@ Results Results::limit(size_t max_count) const
     return Results(m_realm, get_query(), std::move(new_order));
 }
 
+Results Results::window(size_t window_size) const
+{
+    DescriptorOrdering base_ordering = m_window ? m_window->base_ordering : m_descriptor_ordering;
+    DescriptorOrdering new_order = base_ordering;
+    new_order.append_limit(window_size);
+
+    util::CheckedUniqueLock lock(m_mutex);
+    Results results = m_mode == Mode::List ? Results(m_realm, m_collection, std::move(new_order))
+                                           : Results(m_realm, do_get_query(), std::move(new_order));
+    results.m_window = Window{std::move(base_ordering), window_size};
+    return results;
+}
+
+Results Results::extend_window(size_t additional) const
+{
+    if (!m_window)
+        throw std::logic_error("Cannot extend the window of a Results which is not windowed");
+    return window(m_window->size + additional);
+}
+
+util::Optional<size_t> Results::window_size() const noexcept
+{
+    if (!m_window)
+        return util::none;
+    return m_window->size;
+}
+
+DescriptorOrdering const* Results::get_window_base_ordering() const noexcept
+{
+    return m_window ? &m_window->base_ordering : nullptr;
+}
+
+size_t Results::total_count()
+{
+    util::CheckedUniqueLock lock(m_mutex);
+    if (!m_window)
+        return do_size();
+
+    validate_read();
+    // The count delivered along with the notifier's results can't be used
+    // in a write transaction as it may have been changed by the write
+    size_t count;
+    if (m_notifier && !m_realm->is_in_transaction() && m_notifier->get_total_count(count))
+        return count;
+
+    if (m_mode == Mode::List) {
+        if (!m_window->base_ordering.will_apply_distinct())
+            return m_collection->size();
+        std::vector<size_t> indices;
+        m_collection->distinct(indices);
+        return indices.size();
+    }
+
+    Query query = do_get_query();
+    query.sync_view_if_needed();
+    return query.count(m_window->base_ordering);
+}
+
 Results Results::apply_ordering(DescriptorOrdering&& ordering)
 {
     DescriptorOrdering new_order = m_descriptor_ordering;
@@ -1018,8 +1089,11 @@ Results Results::distinct(DistinctDescriptor&& uniqueness) const
     DescriptorOrdering new_order = m_descriptor_ordering;
     new_order.append_distinct(std::move(uniqueness));
     util::CheckedUniqueLock lock(m_mutex);
-    if (m_mode == Mode::List)
+    if (m_mode == Mode::List) {
+        if (m_descriptor_ordering.will_apply_limit())
+            throw UnimplementedOperationException("Distinct on a windowed Results of a list is not yet implemented");
         return Results(m_realm, m_collection, std::move(new_order));
+    }
     return Results(m_realm, do_get_query(), std::move(new_order));
 }
 
@@ -1111,10 +1185,10 @@ void Results::prepare_async(ForCallback force) NO_THREAD_SAFETY_ANALYSIS
     _impl::RealmCoordinator::register_notifier(m_notifier);
 }
 
-NotificationToken Results::add_notification_callback(CollectionChangeCallback cb) &
+NotificationToken Results::add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths) &
 {
     prepare_async(ForCallback{true});
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(key_paths))};
 }
 
 // This function cannot be called on frozen results and so does not require locking
@@ -1178,8 +1252,11 @@ Results Results::freeze(std::shared_ptr<Realm> const& frozen_realm)
     switch (m_mode) {
         case Mode::Table:
             return Results(frozen_realm, frozen_realm->import_copy_of(m_table));
-        case Mode::List:
-            return Results(frozen_realm, frozen_realm->import_copy_of(*m_collection), m_descriptor_ordering);
+        case Mode::List: {
+            Results results(frozen_realm, frozen_realm->import_copy_of(*m_collection), m_descriptor_ordering);
+            results.m_window = m_window;
+            return results;
+        }
         case Mode::LinkList: {
             std::shared_ptr<LnkLst> frozen_ll(
                 frozen_realm->import_copy_of(std::make_unique<LnkLst>(*m_link_list)).release());
@@ -1188,12 +1265,17 @@ Results Results::freeze(std::shared_ptr<Realm> const& frozen_realm)
             // include them here.
             return Results(frozen_realm, std::move(frozen_ll));
         }
-        case Mode::Query:
-            return Results(frozen_realm, *frozen_realm->import_copy_of(m_query, PayloadPolicy::Copy),
-                           m_descriptor_ordering);
+        case Mode::Query: {
+            Results results(frozen_realm, *frozen_realm->import_copy_of(m_query, PayloadPolicy::Copy),
+                            m_descriptor_ordering);
+            results.m_window = m_window;
+            return results;
+        }
         case Mode::TableView: {
-            Results results(frozen_realm, *frozen_realm->import_copy_of(m_table_view, PayloadPolicy::Copy),
+            Results results(frozen_realm,
+                            std::move(*frozen_realm->import_copy_of(m_table_view, PayloadPolicy::Copy)),
                             m_descriptor_ordering);
+            results.m_window = m_window;
             results.assert_unlocked();
             results.evaluate_query_if_needed(false);
             return results;
@@ -141,6 +141,27 @@ public:
     // Create a new Results with only the first `max_count` entries
     Results limit(size_t max_count) const REQUIRES(!m_mutex);
 
+    // Create a new Results which only evaluates the first `window_size`
+    // entries of this Results, for displaying part of a Results which is too
+    // large to evaluate in full. Unsorted queries stop once the window has been
+    // filled, sorted ones only sort the entries which end up in the window, and
+    // notifications only report changes to the entries in the window. Windowing
+    // a Results which is already windowed replaces the window.
+    Results window(size_t window_size) const REQUIRES(!m_mutex);
+    // Create a new Results whose window is `additional` entries larger than
+    // this one's. Throws std::logic_error if this Results is not windowed.
+    Results extend_window(size_t additional) const REQUIRES(!m_mutex);
+    // Get the size of the window, or none if this Results is not windowed
+    util::Optional<size_t> window_size() const noexcept;
+    // Get the ordering which the window is applied on top of, or null if this
+    // Results is not windowed
+    DescriptorOrdering const* get_window_base_ordering() const noexcept;
+    // Get the number of entries in the Results which the window is taken from,
+    // which is the same as size() if this Results is not windowed. This does
+    // not evaluate the entries outside of the window, and is O(1) when the
+    // results delivered by the most recent notification are current.
+    size_t total_count() REQUIRES(!m_mutex);
+
     // Create a new Results by adding sort and distinct combinations
     Results apply_ordering(DescriptorOrdering&& ordering) REQUIRES(!m_mutex);
 
@@ -252,7 +273,9 @@ public:
     // Create an async query from this Results
     // The query will be run on a background thread and delivered to the callback,
     // and then rerun after each commit (if needed) and redelivered if it changed
-    NotificationToken add_notification_callback(CollectionChangeCallback cb) &;
+    // If `key_paths` is non-empty, modifications are only reported for changes
+    // to the properties named by the key paths
+    NotificationToken add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths = {}) &;
 
     // Returns whether the rows are guaranteed to be in table order.
     bool is_in_table_order() const;
@@ -298,6 +321,14 @@ private:
     std::shared_ptr<CollectionBase> m_collection;
     util::Optional<std::vector<size_t>> m_list_indices GUARDED_BY(m_mutex);
 
+    // The ordering which the window of a windowed Results is taken from, and
+    // the size of the window, which is applied as a limit on top of it
+    struct Window {
+        DescriptorOrdering base_ordering;
+        size_t size;
+    };
+    util::Optional<Window> m_window;
+
     _impl::CollectionNotifier::Handle<_impl::ResultsNotifierBase> m_notifier;
 
     Mode m_mode GUARDED_BY(m_mutex) = Mode::Empty;
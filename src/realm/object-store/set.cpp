@@ -181,7 +181,7 @@ Set Set::freeze(const std::shared_ptr<Realm>& realm) const
     return *this;
 }
 
-NotificationToken Set::add_notification_callback(CollectionChangeCallback cb) &
+NotificationToken Set::add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths) &
 {
     if (m_notifier && !m_notifier->have_callbacks())
         m_notifier.reset();
@@ -189,7 +189,7 @@ NotificationToken Set::add_notification_callback(CollectionChangeCallback cb) &
         m_notifier = std::make_shared<SetNotifier>(m_realm, *m_set_base, m_type);
         RealmCoordinator::register_notifier(m_notifier);
     }
-    return {m_notifier, m_notifier->add_callback(std::move(cb))};
+    return {m_notifier, m_notifier->add_callback(std::move(cb), std::move(key_paths))};
 }
 
 #define REALM_PRIMITIVE_SET_TYPE(T)                                                                                  \
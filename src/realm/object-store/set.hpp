@@ -93,7 +93,7 @@ public:
 
     bool operator==(const Set& rhs) const noexcept;
 
-    NotificationToken add_notification_callback(CollectionChangeCallback cb) &;
+    NotificationToken add_notification_callback(CollectionChangeCallback cb, KeyPathArray key_paths = {}) &;
 
     struct InvalidEmbeddedOperationException : std::logic_error {
         InvalidEmbeddedOperationException()
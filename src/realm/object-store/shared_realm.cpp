@@ -20,6 +20,7 @@
 
 #include <realm/object-store/impl/collection_notifier.hpp>
 #include <realm/object-store/impl/realm_coordinator.hpp>
+#include <realm/object-store/impl/schema_cache_file.hpp>
 #include <realm/object-store/impl/transact_log_handler.hpp>
 
 #include <realm/object-store/audit.hpp>
@@ -58,7 +59,7 @@ Realm::Realm(Config config, util::Optional<VersionID> version, std::shared_ptr<_
 {
     if (!coordinator->get_cached_schema(m_schema, m_schema_version, m_schema_transaction_version)) {
         m_group = coordinator->begin_read();
-        read_schema_from_group_if_needed();
+        read_initial_schema();
         coordinator->cache_schema(m_schema, m_schema_version, m_schema_transaction_version);
         m_group = nullptr;
     }
@@ -207,6 +208,33 @@ void Realm::read_schema_from_group_if_needed()
     notify_schema_changed();
 }
 
+void Realm::read_initial_schema()
+{
+    bool use_cache_file = m_config.persist_schema_cache && !m_config.immutable() && !m_config.in_memory &&
+                          m_config.realm_data.is_null() && m_config.encryption_key.empty();
+    if (!use_cache_file) {
+        read_schema_from_group_if_needed();
+        return;
+    }
+
+    // Hashing the structure of the tables is much cheaper than building the
+    // schema from them, as it doesn't require creating any table accessors
+    Group& group = read_group();
+    uint64_t schema_version = ObjectStore::get_schema_version(group);
+    uint64_t schema_hash = group.compute_schema_hash();
+    auto path = schema_cache_file::path_for(m_config.path);
+    if (auto schema = schema_cache_file::read(path, schema_version, schema_hash)) {
+        m_schema = std::move(*schema);
+        m_schema_version = schema_version;
+        m_schema_transaction_version = transaction().get_version_of_current_transaction().version;
+        return;
+    }
+
+    read_schema_from_group_if_needed();
+    if (!m_schema.empty() && m_schema_version != ObjectStore::NotVersioned)
+        schema_cache_file::write(path, m_schema, m_schema_version, schema_hash);
+}
+
 bool Realm::reset_file(Schema& schema, std::vector<SchemaChange>& required_changes)
 {
     // FIXME: this does not work if multiple processes try to open the file at
@@ -649,7 +677,11 @@ void Realm::commit_transaction()
     else {
         m_coordinator->commit_write(*this);
     }
+    m_has_unannounced_commits = false;
     cache_new_schema();
+
+    if (has_pending_async_work() && !m_is_running_async_writes)
+        m_scheduler->notify();
 }
 
 void Realm::cancel_transaction()
@@ -661,7 +693,178 @@ void Realm::cancel_transaction()
         throw InvalidTransactionException("Can't cancel a non-existing write transaction");
     }
 
-    transaction::cancel(transaction(), m_binding_context.get());
+    // Rolling back can fail to make the batch's previous commits durable, but
+    // the write has still ended and the commits have to be announced
+    std::exception_ptr error;
+    try {
+        transaction::cancel(transaction(), m_binding_context.get());
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    if (m_has_unannounced_commits && !is_in_transaction()) {
+        m_has_unannounced_commits = false;
+        m_coordinator->announce_batched_commits(*this);
+    }
+    if (error)
+        std::rethrow_exception(error);
+
+    if (has_pending_async_work() && !m_is_running_async_writes)
+        m_scheduler->notify();
+}
+
+Realm::AsyncHandle Realm::async_begin_transaction(std::function<void()> the_write_block)
+{
+    verify_thread();
+    verify_open();
+    check_can_create_write_transaction(this);
+    REALM_ASSERT(the_write_block);
+
+    if (!m_scheduler || !m_scheduler->can_deliver_notifications()) {
+        throw InvalidTransactionException(
+            "Asynchronous write transactions require a Realm whose scheduler can deliver notifications");
+    }
+
+    m_async_write_q.push_back({++m_last_async_handle, std::move(the_write_block)});
+    m_scheduler->notify();
+    return m_last_async_handle;
+}
+
+Realm::AsyncHandle Realm::async_commit_transaction(std::function<void(std::exception_ptr)> the_done_block)
+{
+    check_can_create_write_transaction(this);
+    verify_thread();
+
+    if (!is_in_transaction()) {
+        throw InvalidTransactionException("Can't commit a non-existing write transaction");
+    }
+    if (!m_scheduler || !m_scheduler->can_deliver_notifications()) {
+        throw InvalidTransactionException(
+            "Asynchronous write transactions require a Realm whose scheduler can deliver notifications");
+    }
+
+    // Within an async write the commit is made by run_async_writes() once the
+    // write function returns, so that it can be batched with the next one
+    if (m_is_running_async_writes) {
+        if (m_async_commit_requested) {
+            throw InvalidTransactionException("The write transaction is already being committed");
+        }
+        m_async_commit_requested = true;
+        m_async_commit_q.push_back({++m_last_async_handle, std::move(the_done_block), nullptr});
+        return m_last_async_handle;
+    }
+
+    // There's nothing to batch this commit with, so just commit it
+    m_async_commit_q.push_back({++m_last_async_handle, std::move(the_done_block), nullptr});
+    auto handle = m_last_async_handle;
+    try {
+        commit_transaction();
+    }
+    catch (...) {
+        m_async_commit_q.back().error = std::current_exception();
+        if (is_in_transaction())
+            cancel_transaction();
+    }
+    m_scheduler->notify();
+    return handle;
+}
+
+bool Realm::async_cancel_transaction(AsyncHandle handle)
+{
+    verify_thread();
+    auto it = std::find_if(m_async_write_q.begin(), m_async_write_q.end(), [&](auto& desc) {
+        return desc.handle == handle;
+    });
+    if (it == m_async_write_q.end())
+        return false;
+    m_async_write_q.erase(it);
+    return true;
+}
+
+void Realm::run_async_writes()
+{
+    if (m_is_running_async_writes || m_async_write_q.empty() || is_in_transaction())
+        return;
+    // Rather than blocking until the write lock is available we get notified
+    // again once it is. The lock could be taken by someone else between here
+    // and beginning the write, in which case we do block, but only briefly.
+    if (!m_coordinator->write_lock_available(*this))
+        return;
+
+    auto retain_self = shared_from_this();
+    m_is_running_async_writes = true;
+    auto cleanup = util::make_scope_exit([this]() noexcept {
+        m_is_running_async_writes = false;
+    });
+
+    // Writes queued by the writes in this batch are run by the next batch so
+    // that a write which keeps queuing more writes can't starve everything else
+    size_t remaining = m_async_write_q.size();
+    while (remaining > 0 && !m_async_write_q.empty()) {
+        --remaining;
+        if (!is_in_transaction())
+            begin_transaction();
+
+        auto write = std::move(m_async_write_q.front());
+        m_async_write_q.pop_front();
+        m_async_commit_requested = false;
+        try {
+            write.writer();
+        }
+        catch (...) {
+            if (is_in_transaction())
+                cancel_transaction();
+            // Deliver the completions for the batch's previous commits and
+            // run the rest of the queue once the error has been handled
+            if (!is_closed() && has_pending_async_work())
+                m_scheduler->notify();
+            throw;
+        }
+        if (is_closed())
+            return;
+        // The write function committed or cancelled the transaction itself
+        if (!is_in_transaction())
+            continue;
+        // The write function left the transaction for the caller to end, and
+        // the rest of the queue is run once it has done so
+        if (!m_async_commit_requested)
+            return;
+
+        try {
+            if (remaining > 0 && !m_async_write_q.empty()) {
+                m_coordinator->commit_write_and_continue(*this);
+                m_has_unannounced_commits = true;
+                cache_new_schema();
+            }
+            else {
+                commit_transaction();
+            }
+        }
+        catch (...) {
+            // Rolling back makes the batch's previous commits durable
+            m_async_commit_q.back().error = std::current_exception();
+            if (is_in_transaction())
+                cancel_transaction();
+        }
+    }
+
+    m_is_running_async_writes = false;
+    run_async_completions();
+    if (!is_closed() && !m_async_write_q.empty())
+        m_scheduler->notify();
+}
+
+void Realm::run_async_completions()
+{
+    // Commits are only known to be durable once the write transaction has
+    // ended, as a commit made as part of a batch is synced by the batch's
+    // final commit
+    while (!m_async_commit_q.empty() && !is_in_transaction() && !is_closed()) {
+        auto desc = std::move(m_async_commit_q.front());
+        m_async_commit_q.pop_front();
+        if (desc.when_completed)
+            desc.when_completed(desc.error);
+    }
 }
 
 void Realm::invalidate()
@@ -734,6 +937,14 @@ void Realm::notify()
     // strong reference to `this`
     auto retain_self = shared_from_this();
 
+    if (has_pending_async_work()) {
+        run_async_completions();
+        run_async_writes();
+        if (is_closed() || is_in_transaction()) {
+            return;
+        }
+    }
+
     if (m_binding_context) {
         m_binding_context->before_notify();
         if (is_closed() || is_in_transaction()) {
@@ -890,12 +1101,19 @@ void Realm::close()
         m_coordinator->unregister_realm(this);
     }
     if (!m_config.immutable() && m_group) {
+        auto version = transaction().get_version();
         transaction().close();
+        if (m_has_unannounced_commits && m_coordinator) {
+            m_has_unannounced_commits = false;
+            m_coordinator->announce_batched_commits(version);
+        }
     }
 
     m_group = nullptr;
     m_binding_context = nullptr;
     m_coordinator = nullptr;
+    m_async_write_q.clear();
+    m_async_commit_q.clear();
 }
 
 AuditInterface* Realm::audit_context() const noexcept
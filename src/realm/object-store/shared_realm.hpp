@@ -26,6 +26,8 @@
 #include <realm/db.hpp>
 #include <realm/version_id.hpp>
 
+#include <deque>
+#include <functional>
 #include <memory>
 
 namespace realm {
@@ -54,6 +56,7 @@ class AnyHandover;
 class CollectionNotifier;
 class RealmCoordinator;
 class RealmFriend;
+class ResultsNotifier;
 } // namespace _impl
 
 // How to handle update_schema() being called on a file which has
@@ -194,6 +197,15 @@ public:
         // because it's not crash safe! It may corrupt your database if something fails
         ShouldCompactOnLaunchFunction should_compact_on_launch_function;
 
+        // If true, the schema read from the file is stored in a cache file
+        // alongside it, which lets the first open of the file in a process
+        // skip building the schema from the tables in the file. The cached
+        // schema is used only if the schema version and the structure of the
+        // tables in the file are unchanged since it was written. This has no
+        // effect for in-memory, encrypted and immutable Realms, for which the
+        // schema is always read from the file.
+        bool persist_schema_cache = false;
+
         // WARNING: The original read_only() has been renamed to immutable().
         bool immutable() const
         {
@@ -224,6 +236,15 @@ public:
         // speeds up tests that don't need notifications.
         bool automatic_change_notifications = true;
 
+        // The maximum number of threads used to run the background work of the
+        // change notifications (rerunning queries and calculating changes),
+        // including the thread which change notifications are produced on. If
+        // zero, one thread per hardware thread is used, up to 8. Additional
+        // threads, and the read transactions they use, are only created once
+        // there are enough notifiers to keep them busy. Only the value used by
+        // the first Realm opened for a file has any effect.
+        size_t max_notifier_threads = 1;
+
         // The Scheduler which this Realm should be bound to. If not supplied,
         // a default one for the current thread will be used.
         std::shared_ptr<util::Scheduler> scheduler;
@@ -294,6 +315,35 @@ public:
     void cancel_transaction();
     bool is_in_transaction() const noexcept;
 
+    // Asynchronous write transactions. These require a Realm whose scheduler
+    // can deliver notifications.
+    //
+    // `async_begin_transaction()` queues a function which is called on the
+    // Realm's scheduler inside a write transaction once the write lock has
+    // been acquired, without ever blocking the scheduler's thread while
+    // waiting for the lock. The function can end the write transaction
+    // itself with `commit_transaction()` or `cancel_transaction()`, call
+    // `async_commit_transaction()` to commit once it returns, or leave the
+    // Realm in the write transaction for the caller to end later.
+    //
+    // All of the functions which are queued when the write lock is acquired
+    // are run as a single batch in which `async_commit_transaction()` commits
+    // without syncing to disk, and the last of the batch's commits makes all of
+    // them durable together. Completion callbacks are called on the scheduler
+    // once the commit has been made durable, with the error which made the
+    // commit fail if it did. A commit which fails is rolled back without
+    // affecting the batch's other commits.
+    using AsyncHandle = unsigned;
+    AsyncHandle async_begin_transaction(std::function<void()> the_write_block);
+    AsyncHandle async_commit_transaction(std::function<void(std::exception_ptr)> the_done_block = nullptr);
+    // Remove a function queued by `async_begin_transaction()` which has not
+    // been called yet. Returns false if it has already been called.
+    bool async_cancel_transaction(AsyncHandle handle);
+    bool is_in_async_transaction() const noexcept
+    {
+        return m_is_running_async_writes;
+    }
+
     // Returns a frozen copy for the current version of this Realm
     SharedRealm freeze();
 
@@ -393,6 +443,7 @@ public:
     class Internal {
         friend class _impl::CollectionNotifier;
         friend class _impl::RealmCoordinator;
+        friend class _impl::ResultsNotifier;
         friend class TestHelper;
         friend class ThreadSafeReference;
 
@@ -407,7 +458,8 @@ public:
 
         // CollectionNotifier needs to be able to access the owning
         // coordinator to wake up the worker thread when a callback is
-        // added, and coordinators need to be able to get themselves from a Realm
+        // added, ResultsNotifier to share query results with the other
+        // notifiers, and coordinators need to be able to get themselves from a Realm
         static _impl::RealmCoordinator& get_coordinator(Realm& realm)
         {
             return *realm.m_coordinator;
@@ -448,6 +500,29 @@ private:
     // primary key values)
     bool m_in_migration = false;
 
+    struct AsyncWriteDesc {
+        AsyncHandle handle;
+        std::function<void()> writer;
+    };
+    struct AsyncCommitDesc {
+        AsyncHandle handle;
+        std::function<void(std::exception_ptr)> when_completed;
+        std::exception_ptr error;
+    };
+    std::deque<AsyncWriteDesc> m_async_write_q;
+    // Completions for commits which are waiting to be delivered, which happens
+    // once the Realm is no longer in a write transaction
+    std::deque<AsyncCommitDesc> m_async_commit_q;
+    AsyncHandle m_last_async_handle = 0;
+    // True while running a batch of async writes
+    bool m_is_running_async_writes = false;
+    // Set by async_commit_transaction() while running an async write, which
+    // defers the commit until the write function returns
+    bool m_async_commit_requested = false;
+    // True if the batch made commits which nothing outside of this Realm has
+    // been told about yet, as the batch's final commit hasn't been made
+    bool m_has_unannounced_commits = false;
+
     void begin_read(VersionID);
     bool do_refresh();
 
@@ -459,12 +534,22 @@ private:
     // Ensure that m_schema and m_schema_version match that of the current
     // version of the file
     void read_schema_from_group_if_needed();
+    // Read the schema for a Realm which was opened without one cached by the
+    // coordinator, using the persistent schema cache if it is enabled
+    void read_initial_schema();
 
     void add_schema_change_handler();
     void cache_new_schema();
     void translate_schema_error();
     void notify_schema_changed();
 
+    void run_async_writes();
+    void run_async_completions();
+    bool has_pending_async_work() const noexcept
+    {
+        return !m_async_write_q.empty() || !m_async_commit_q.empty();
+    }
+
     Transaction& transaction();
     Transaction& transaction() const;
     std::shared_ptr<Transaction> transaction_ref();
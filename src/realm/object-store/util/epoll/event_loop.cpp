@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2020 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include <realm/object-store/util/epoll/event_loop.hpp>
+
+#include <realm/util/assert.hpp>
+
+#include <errno.h>
+#include <iterator>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <unistd.h>
+
+using namespace realm;
+using namespace realm::util;
+
+EpollEventLoop::EpollEventLoop()
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_event_fd == -1) {
+        int err = errno;
+        ::close(m_epoll_fd);
+        throw std::system_error(err, std::system_category());
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_event_fd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_event_fd, &event) != 0) {
+        int err = errno;
+        ::close(m_event_fd);
+        ::close(m_epoll_fd);
+        throw std::system_error(err, std::system_category());
+    }
+}
+
+EpollEventLoop::~EpollEventLoop()
+{
+    ::close(m_event_fd);
+    ::close(m_epoll_fd);
+}
+
+void EpollEventLoop::post(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending_work.push_back(std::move(fn));
+    }
+    signal();
+}
+
+void EpollEventLoop::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop_requested = true;
+    }
+    signal();
+}
+
+void EpollEventLoop::signal()
+{
+    uint64_t one = 1;
+    while (::write(m_event_fd, &one, sizeof(one)) == -1) {
+        int err = errno;
+        // EAGAIN means that the counter is about to overflow, which can only
+        // happen if there's a wakeup pending which hasn't been consumed yet
+        if (err == EAGAIN)
+            return;
+        if (err != EINTR)
+            throw std::system_error(err, std::system_category());
+    }
+}
+
+void EpollEventLoop::consume_wakeup()
+{
+    uint64_t count;
+    ssize_t ret = ::read(m_event_fd, &count, sizeof(count));
+    static_cast<void>(ret); // EAGAIN just means that there was nothing to consume
+}
+
+bool EpollEventLoop::wait()
+{
+    while (true) {
+        // Reset the counter before checking for work so that anything posted
+        // after the check results in epoll_wait() returning immediately
+        consume_wakeup();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop_requested) {
+                m_stop_requested = false;
+                return false;
+            }
+            if (!m_pending_work.empty())
+                return true;
+        }
+
+        epoll_event ev{};
+        if (epoll_wait(m_epoll_fd, &ev, 1, -1) == -1 && errno != EINTR)
+            throw std::system_error(errno, std::system_category());
+    }
+}
+
+size_t EpollEventLoop::run_pending_work()
+{
+    std::vector<std::function<void()>> work;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(work, m_pending_work);
+    }
+
+    size_t i = 0;
+    try {
+        for (; i < work.size(); ++i)
+            work[i]();
+    }
+    catch (...) {
+        // Put back the work which we didn't get to so that it's run by the
+        // next call to run() rather than silently dropped
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending_work.insert(m_pending_work.begin(), std::make_move_iterator(work.begin() + i + 1),
+                              std::make_move_iterator(work.end()));
+        if (!m_pending_work.empty())
+            signal();
+        throw;
+    }
+    return work.size();
+}
+
+void EpollEventLoop::run()
+{
+    REALM_ASSERT(is_on_thread());
+    while (wait())
+        run_pending_work();
+}
+
+bool EpollEventLoop::run_until(std::function<bool()> predicate)
+{
+    REALM_ASSERT(is_on_thread());
+    if (predicate())
+        return true;
+    while (wait()) {
+        run_pending_work();
+        if (predicate())
+            return true;
+    }
+    return predicate();
+}
+
+size_t EpollEventLoop::poll()
+{
+    REALM_ASSERT(is_on_thread());
+    consume_wakeup();
+    return run_pending_work();
+}
@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2020 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#ifndef REALM_OS_UTIL_EPOLL_EVENT_LOOP_HPP
+#define REALM_OS_UTIL_EPOLL_EVENT_LOOP_HPP
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace realm {
+namespace util {
+
+// A minimal event loop for Linux processes which do not otherwise have one
+// (servers, command-line tools, headless services). Work is submitted from any
+// thread with post() and is executed in submission order by the thread which
+// runs the loop. The loop sleeps in epoll_wait() on an eventfd while there is
+// no work, so idle loops do not consume any CPU.
+//
+// The loop is bound to the thread which created it, and run(), run_until() and
+// poll() must only be called on that thread. Use Scheduler::make_epoll() to
+// create a scheduler which delivers Realm notifications on the loop.
+class EpollEventLoop {
+public:
+    EpollEventLoop();
+    ~EpollEventLoop();
+
+    EpollEventLoop(const EpollEventLoop&) = delete;
+    EpollEventLoop& operator=(const EpollEventLoop&) = delete;
+
+    // Schedule execution of the given function on the loop's thread.
+    //
+    // This function can be called from any thread, including from within a
+    // function which is currently being run by the loop.
+    void post(std::function<void()>);
+
+    // Run the loop until stop() is called.
+    void run();
+
+    // Run the loop until the given predicate returns true or stop() is called.
+    // The predicate is checked before waiting for the first time and after
+    // each batch of work. Returns the final value of the predicate.
+    bool run_until(std::function<bool()> predicate);
+
+    // Run all work which is currently pending without waiting for more, and
+    // return the number of functions which were run.
+    size_t poll();
+
+    // Make the current or next call to run() or run_until() return once the
+    // function currently being run (if any) completes.
+    //
+    // This function can be called from any thread.
+    void stop();
+
+    // Check if the caller is currently running on the loop's thread.
+    //
+    // This function can be called from any thread.
+    bool is_on_thread() const noexcept
+    {
+        return m_thread_id == std::this_thread::get_id();
+    }
+
+    // The epoll file descriptor used by the loop. It becomes readable whenever
+    // there is pending work, so it can be registered with an outer poll() or
+    // epoll loop which then calls poll() on this loop when it is signalled.
+    int get_fd() const noexcept
+    {
+        return m_epoll_fd;
+    }
+
+private:
+    int m_epoll_fd = -1;
+    int m_event_fd = -1;
+    std::thread::id m_thread_id = std::this_thread::get_id();
+
+    std::mutex m_mutex;
+    std::vector<std::function<void()>> m_pending_work;
+    bool m_stop_requested = false;
+
+    void signal();
+    void consume_wakeup();
+    // Block until there is pending work or stop() is called. Returns false if
+    // the loop was asked to stop.
+    bool wait();
+    size_t run_pending_work();
+};
+
+} // namespace util
+} // namespace realm
+
+#endif // REALM_OS_UTIL_EPOLL_EVENT_LOOP_HPP
@@ -29,6 +29,17 @@
 #include <realm/object-store/util/generic/scheduler.hpp>
 #endif
 
+#if REALM_HAVE_EPOLL
+#include <realm/object-store/util/epoll/event_loop.hpp>
+#endif
+
+#if REALM_ENABLE_SYNC
+#include <realm/util/network.hpp>
+#endif
+
+#include <atomic>
+#include <thread>
+
 namespace {
 using namespace realm;
 
@@ -58,6 +69,107 @@ public:
 private:
     VersionID m_version;
 };
+
+// Base class for schedulers which deliver notifications by posting work to an
+// event loop which is owned by someone else. Calls to notify() made before the
+// callback has run are coalesced into a single invocation, and work which is
+// still queued when the scheduler is destroyed does nothing.
+class PostingScheduler : public util::Scheduler {
+public:
+    bool can_deliver_notifications() const noexcept override
+    {
+        return true;
+    }
+
+    void set_notify_callback(std::function<void()> fn) override
+    {
+        m_callback = std::make_shared<Callback>(std::move(fn));
+    }
+
+    void notify() override
+    {
+        auto callback = m_callback;
+        if (!callback || callback->pending.exchange(true))
+            return;
+        post([weak_callback = std::weak_ptr<Callback>(callback)] {
+            if (auto callback = weak_callback.lock()) {
+                callback->pending = false;
+                callback->fn();
+            }
+        });
+    }
+
+protected:
+    virtual void post(std::function<void()>) = 0;
+
+private:
+    struct Callback {
+        Callback(std::function<void()> fn)
+            : fn(std::move(fn))
+        {
+        }
+        std::function<void()> fn;
+        std::atomic<bool> pending{false};
+    };
+    std::shared_ptr<Callback> m_callback;
+};
+
+#if REALM_HAVE_EPOLL
+class EpollScheduler : public PostingScheduler {
+public:
+    EpollScheduler(std::shared_ptr<util::EpollEventLoop> loop)
+        : m_loop(std::move(loop))
+    {
+    }
+
+    bool is_on_thread() const noexcept override
+    {
+        return m_loop->is_on_thread();
+    }
+    bool is_same_as(const Scheduler* other) const noexcept override
+    {
+        auto o = dynamic_cast<const EpollScheduler*>(other);
+        return (o && (o->m_loop == m_loop));
+    }
+
+private:
+    std::shared_ptr<util::EpollEventLoop> m_loop;
+
+    void post(std::function<void()> fn) override
+    {
+        m_loop->post(std::move(fn));
+    }
+};
+#endif
+
+#if REALM_ENABLE_SYNC
+class NetworkServiceScheduler : public PostingScheduler {
+public:
+    NetworkServiceScheduler(util::network::Service& service)
+        : m_service(service)
+    {
+    }
+
+    bool is_on_thread() const noexcept override
+    {
+        return m_id == std::this_thread::get_id();
+    }
+    bool is_same_as(const Scheduler* other) const noexcept override
+    {
+        auto o = dynamic_cast<const NetworkServiceScheduler*>(other);
+        return (o && (&o->m_service == &m_service) && (o->m_id == m_id));
+    }
+
+private:
+    util::network::Service& m_service;
+    std::thread::id m_id = std::this_thread::get_id();
+
+    void post(std::function<void()> fn) override
+    {
+        m_service.post(std::move(fn)); // Throws
+    }
+};
+#endif
 } // anonymous namespace
 
 namespace realm {
@@ -69,5 +181,19 @@ std::shared_ptr<Scheduler> Scheduler::get_frozen(VersionID version)
 {
     return std::make_shared<FrozenScheduler>(version);
 }
+
+#if REALM_HAVE_EPOLL
+std::shared_ptr<Scheduler> Scheduler::make_epoll(std::shared_ptr<EpollEventLoop> loop)
+{
+    return std::make_shared<EpollScheduler>(std::move(loop));
+}
+#endif
+
+#if REALM_ENABLE_SYNC
+std::shared_ptr<Scheduler> Scheduler::make_network_service(network::Service& service)
+{
+    return std::make_shared<NetworkServiceScheduler>(service);
+}
+#endif
 } // namespace util
 } // namespace realm
@@ -44,6 +44,11 @@
 
 namespace realm {
 namespace util {
+class EpollEventLoop;
+namespace network {
+class Service;
+}
+
 // A Scheduler combines two related concepts related to our implementation of
 // thread confinement: checking if we are currently on the correct thread, and
 // sending a notification to a thread-confined object from another thread.
@@ -96,6 +101,21 @@ public:
     static std::shared_ptr<Scheduler> make_runloop();
 #endif
 
+#if REALM_HAVE_EPOLL
+    // Create a scheduler which delivers notifications on the given event loop.
+    // The Realm must be used on the thread which owns the event loop.
+    static std::shared_ptr<Scheduler> make_epoll(std::shared_ptr<EpollEventLoop>);
+#endif
+
+#if REALM_ENABLE_SYNC
+    // Create a scheduler which delivers notifications by posting to the given
+    // network service, bound to the calling thread. This is intended for
+    // processes which already run a Service event loop (such as a sync server)
+    // and open Realms from within its handlers. The service must outlive the
+    // scheduler and all Realms using it.
+    static std::shared_ptr<Scheduler> make_network_service(network::Service&);
+#endif
+
     // For platforms with no default scheduler implementation, register a factory
     // function which can produce custom schedulers.
     static void set_default_factory(std::function<std::shared_ptr<Scheduler>()>);
@@ -1391,6 +1391,34 @@ TableView Query::find_all(size_t start, size_t end, size_t limit)
     return ret;
 }
 
+void Query::filter(std::vector<ObjKey>& keys) const
+{
+    REALM_ASSERT(!m_view);
+    init();
+
+    auto end = std::remove_if(keys.begin(), keys.end(), [&](ObjKey key) {
+        return !m_table->is_valid(key) || !eval_object(m_table->get_object(key));
+    });
+    keys.erase(end, keys.end());
+}
+
+TableView Query::create_view(const std::vector<ObjKey>& keys)
+{
+    return create_view(keys, DescriptorOrdering());
+}
+
+TableView Query::create_view(const std::vector<ObjKey>& keys, const DescriptorOrdering& descriptor)
+{
+    TableView ret(m_table, *this, 0, size_t(-1), size_t(-1));
+    for (auto key : keys)
+        ret.m_key_values.add(key);
+    // The ordering is only stored so that it is applied if the view is synced
+    ret.m_descriptor_ordering = descriptor;
+    ret.m_descriptor_ordering.collect_dependencies(m_table.unchecked_ptr());
+    ret.m_last_seen_versions = ret.get_dependency_versions();
+    return ret;
+}
+
 
 size_t Query::do_count(size_t limit) const
 {
@@ -1668,6 +1696,20 @@ void* Query::query_thread(void* arg)
 
 #endif // REALM_MULTITHREADQUERY
 
+void Query::prefetch() const
+{
+    if (!m_table)
+        return;
+    std::vector<ColKey> columns;
+    for (auto& group : m_groups) {
+        if (group.m_root_node)
+            group.m_root_node->get_condition_columns(columns);
+    }
+    // A query without conditions reads no columns
+    if (!columns.empty())
+        m_table->prefetch(columns);
+}
+
 std::string Query::validate()
 {
     if (!m_groups.size())
@@ -1831,6 +1873,14 @@ Query Query::operator!()
     return q;
 }
 
+bool Query::follows_links() const
+{
+    std::vector<TableKey> tables;
+    if (ParentNode* root = root_node())
+        root->get_link_dependencies(tables);
+    return !tables.empty();
+}
+
 void Query::get_outside_versions(TableVersions& versions) const
 {
     if (m_table) {
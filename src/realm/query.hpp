@@ -236,6 +236,20 @@ public:
     ObjKey find();
     TableView find_all(size_t start = 0, size_t end = size_t(-1), size_t limit = size_t(-1));
 
+    // Remove the objects which do not match the query from `keys`. This is much
+    // cheaper than find_all() when only a few objects need to be checked, such
+    // as the ones modified by a transaction. Objects which no longer exist are
+    // removed as well. Not supported for queries restricted by a view.
+    void filter(std::vector<ObjKey>& keys) const;
+
+    // Create a view of this query containing `keys` without running the query.
+    // `keys` must be exactly the objects matched by the query in the current
+    // version, in table order, and the view is considered to be in sync.
+    TableView create_view(const std::vector<ObjKey>& keys);
+    // Create a view containing `keys` which must be exactly the objects
+    // returned by find_all(descriptor) in the current version, in that order.
+    TableView create_view(const std::vector<ObjKey>& keys, const DescriptorOrdering& descriptor);
+
     // Aggregates
     size_t count() const;
     TableView find_all(const DescriptorOrdering& descriptor);
@@ -282,11 +296,19 @@ public:
         return !m_view;
     }
 
+    // True if evaluating the query for an object reads other objects than that
+    // one, i.e. the query follows links or backlinks.
+    bool follows_links() const;
+
     // Calls sync_if_needed on the restricting view, if present.
     // Returns the current version of the table(s) this query depends on,
     // or empty vector if the query is not associated with a table.
     TableVersions sync_view_if_needed() const;
 
+    // Advise the operating system that the columns read by the conditions of
+    // this query will be scanned soon. See Table::prefetch().
+    void prefetch() const;
+
     std::string validate();
 
     std::string get_description() const;
@@ -733,6 +733,11 @@ void ExpressionNode::collect_dependencies(std::vector<TableKey>& tables) const
     m_expression->collect_dependencies(tables);
 }
 
+void ExpressionNode::collect_condition_columns(std::vector<ColKey>& columns) const
+{
+    m_expression->collect_condition_columns(columns);
+}
+
 size_t ExpressionNode::find_first_local(size_t start, size_t end)
 {
     return m_expression->find_first(start, end);
@@ -221,6 +221,21 @@ public:
     {
     }
 
+    void get_condition_columns(std::vector<ColKey>& columns) const
+    {
+        collect_condition_columns(columns);
+        if (m_child)
+            m_child->get_condition_columns(columns);
+    }
+
+    // Add the columns of m_table which are read when evaluating this condition
+    virtual void collect_condition_columns(std::vector<ColKey>& columns) const
+    {
+        if (m_condition_column_key &&
+            std::find(columns.begin(), columns.end(), m_condition_column_key) == columns.end())
+            columns.push_back(m_condition_column_key);
+    }
+
     virtual size_t find_first_local(size_t start, size_t end) = 0;
 
     virtual void aggregate_local_prepare(Action TAction, DataType col_id, bool nullable);
@@ -905,7 +920,7 @@ public:
     {
         REALM_ASSERT(m_condition_column_key);
         return state.describe_column(ParentNode::m_table, m_condition_column_key) + " " + describe_condition() + " " +
-               util::serializer::print_value(FloatDoubleNode::m_value);
+               util::serializer::print_value(FloatDoubleNode::m_value, state);
     }
     std::string describe_condition() const override
     {
@@ -1569,7 +1584,7 @@ public:
         return state.describe_column(ParentNode::m_table, m_condition_column_key) + " " + this->describe_condition() +
                " " +
                (m_value_is_null ? util::serializer::print_value(realm::null())
-                                : util::serializer::print_value(m_value));
+                                : util::serializer::print_value(m_value, state));
     }
 
 protected:
@@ -2201,6 +2216,13 @@ public:
         }
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        for (const auto& cond : m_conditions) {
+            cond->get_condition_columns(columns);
+        }
+    }
+
     void init(bool will_query_ranges) override
     {
         ParentNode::init(will_query_ranges);
@@ -2378,6 +2400,13 @@ public:
         }
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        if (m_condition) {
+            m_condition->get_condition_columns(columns);
+        }
+    }
+
 
     std::unique_ptr<ParentNode> clone() const override
     {
@@ -2522,6 +2551,7 @@ public:
     void table_changed() override;
     void cluster_changed() override;
     void collect_dependencies(std::vector<TableKey>&) const override;
+    void collect_condition_columns(std::vector<ColKey>&) const override;
 
     virtual std::string describe(util::serializer::SerialisationState& state) const override;
 
@@ -50,14 +50,23 @@ void LinkMap::set_base_table(ConstTableRef table)
 
 void LinkMap::collect_dependencies(std::vector<TableKey>& tables) const
 {
-    for (auto& t : m_tables) {
-        TableKey k = t->get_key();
+    // The base table is the one being queried, so only the tables reached by
+    // following links are dependencies
+    for (size_t i = 1; i < m_tables.size(); ++i) {
+        TableKey k = m_tables[i]->get_key();
         if (find(tables.begin(), tables.end(), k) == tables.end()) {
             tables.push_back(k);
         }
     }
 }
 
+void LinkMap::collect_condition_columns(ColKey column, std::vector<ColKey>& columns) const
+{
+    ColKey col_key = m_link_column_keys.empty() ? column : m_link_column_keys[0];
+    if (col_key && find(columns.begin(), columns.end(), col_key) == columns.end())
+        columns.push_back(col_key);
+}
+
 std::string LinkMap::description(util::serializer::SerialisationState& state) const
 {
     std::string s;
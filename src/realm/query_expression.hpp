@@ -695,6 +695,9 @@ public:
     virtual void set_base_table(ConstTableRef table) = 0;
     virtual void set_cluster(const Cluster*) = 0;
     virtual void collect_dependencies(std::vector<TableKey>&) const {}
+    // Add the columns of the base table which are read when evaluating the
+    // expression
+    virtual void collect_condition_columns(std::vector<ColKey>&) const {}
     virtual ConstTableRef get_base_table() const = 0;
     virtual std::string description(util::serializer::SerialisationState& state) const = 0;
 
@@ -736,6 +739,10 @@ public:
 
     virtual void collect_dependencies(std::vector<TableKey>&) const {}
 
+    // Add the columns of the base table which are read when evaluating the
+    // subexpression
+    virtual void collect_condition_columns(std::vector<ColKey>&) const {}
+
     virtual bool has_constant_evaluation() const
     {
         return false;
@@ -1177,7 +1184,7 @@ public:
     {
     }
 
-    std::string description(util::serializer::SerialisationState&) const override
+    std::string description(util::serializer::SerialisationState& state) const override
     {
         if (ValueBase::m_from_link_list) {
             return util::serializer::print_value(util::to_string(ValueBase::size()) +
@@ -1187,7 +1194,7 @@ public:
             if (get(0).is_null())
                 return "NULL";
             else
-                return util::serializer::print_value(get(0).template get<T>());
+                return util::serializer::print_value(get(0).template get<T>(), state);
         }
         return "";
     }
@@ -1720,6 +1727,11 @@ public:
 
     void collect_dependencies(std::vector<TableKey>& tables) const;
 
+    // Add the column of the base table which is read when the specified column
+    // is reached through this link map: the first link column, or the column
+    // itself if there are no links.
+    void collect_condition_columns(ColKey column, std::vector<ColKey>& columns) const;
+
     virtual std::string description(util::serializer::SerialisationState& state) const;
 
     ObjKey get_unary_link_or_not_found(size_t index) const
@@ -1896,6 +1908,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(m_column_key, columns);
+    }
+
 
     bool links_exist() const
     {
@@ -2329,6 +2346,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     // Return main table of query (table on which table->where()... is invoked). Note that this is not the same as
     // any linked-to payload tables
     ConstTableRef get_base_table() const override
@@ -2407,6 +2429,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         size_t count = m_link_map.count_links(index);
@@ -2476,6 +2503,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         size_t count;
@@ -2695,6 +2727,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     std::string description(util::serializer::SerialisationState& state) const override
     {
         return state.describe_expression_type(m_comparison_type) + state.describe_columns(m_link_map, ColKey());
@@ -2825,6 +2862,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(m_column_key, columns);
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         if constexpr (realm::is_any_v<T, ObjectId, Int, Bool, UUID>) {
@@ -3017,6 +3059,11 @@ public:
         m_list.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_list.collect_condition_columns(columns);
+    }
+
     std::unique_ptr<Subexpr> clone() const override
     {
         return std::unique_ptr<Subexpr>(new ColumnListElementLength<T>(*this));
@@ -3086,6 +3133,11 @@ public:
         m_list.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_list.collect_condition_columns(columns);
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         if constexpr (realm::is_any_v<T, ObjectId, Int, Bool, UUID>) {
@@ -3319,6 +3371,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(m_column_key, columns);
+    }
+
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
     // and binds it to a Query at a later time
     ConstTableRef get_base_table() const override
@@ -3515,6 +3572,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     void evaluate(size_t, ValueBase&) override
     {
         // SubColumns can only be used in an expression in conjunction with its aggregate methods.
@@ -3591,6 +3653,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         std::vector<ObjKey> keys = m_link_map.get_links(index);
@@ -3656,6 +3723,11 @@ public:
         m_link_map.collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_link_map.collect_condition_columns(ColKey(), columns);
+    }
+
     void evaluate(size_t index, ValueBase& destination) override
     {
         std::vector<ObjKey> links = m_link_map.get_links(index);
@@ -3926,6 +3998,11 @@ public:
         m_left->collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_left->collect_condition_columns(columns);
+    }
+
     // Recursively fetch tables of columns in expression tree. Used when user first builds a stand-alone expression
     // and binds it to a Query at a later time
     ConstTableRef get_base_table() const override
@@ -3996,6 +4073,12 @@ public:
         m_right->set_base_table(table);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_left->collect_condition_columns(columns);
+        m_right->collect_condition_columns(columns);
+    }
+
     void set_cluster(const Cluster* cluster) override
     {
         m_left->set_cluster(cluster);
@@ -4134,6 +4217,12 @@ public:
         m_right->collect_dependencies(tables);
     }
 
+    void collect_condition_columns(std::vector<ColKey>& columns) const override
+    {
+        m_left->collect_condition_columns(columns);
+        m_right->collect_condition_columns(columns);
+    }
+
     size_t find_first(size_t start, size_t end) const override
     {
         if (m_has_matches) {
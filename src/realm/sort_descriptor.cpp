@@ -252,7 +252,16 @@ BaseDescriptor::Sorter SortDescriptor::sorter(Table const& table, const IndexPai
 
 void SortDescriptor::execute(IndexPairs& v, const Sorter& predicate, const BaseDescriptor* next) const
 {
-    std::sort(v.begin(), v.end(), std::ref(predicate));
+    // If only the first entries are kept, only those have to be sorted. The
+    // predicate is a total ordering, so this selects exactly the entries which
+    // a full sort followed by the limit would.
+    size_t limit = size_t(-1);
+    if (next && next->get_type() == DescriptorType::Limit)
+        limit = static_cast<const LimitDescriptor*>(next)->get_limit();
+    if (limit < v.size())
+        std::partial_sort(v.begin(), v.begin() + limit, v.end(), std::ref(predicate));
+    else
+        std::sort(v.begin(), v.end(), std::ref(predicate));
 
     // not doing this on the last step is an optimisation
     if (next) {
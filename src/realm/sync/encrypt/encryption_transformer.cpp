@@ -89,7 +89,8 @@ Replication::HistoryType peek_history_type(const std::string& file_name, const c
     return Replication::HistoryType(history_type);
 }
 
-void do_transform(const std::string& file_name, const char* read_key, const char* write_key, bool verbose)
+void do_transform(const std::string& file_name, const char* read_key, const char* write_key,
+                  util::Optional<util::File::EncryptionFormat> write_format, bool verbose)
 {
     bool success = false;
     const bool bump_version_number = false; // for all history types we can keep the current version
@@ -97,13 +98,13 @@ void do_transform(const std::string& file_name, const char* read_key, const char
         case Replication::hist_None: {
             bool no_create = true;
             auto sg = DB::create(file_name, no_create, DBOptions{read_key});
-            success = sg->compact(bump_version_number, write_key);
+            success = sg->compact(bump_version_number, write_key, write_format);
             break;
         }
         case Replication::hist_InRealm: {
             std::unique_ptr<Replication> hist(make_in_realm_history(file_name));
             auto sg = DB::create(*hist, DBOptions(read_key));
-            success = sg->compact(bump_version_number, write_key);
+            success = sg->compact(bump_version_number, write_key, write_format);
             break;
         }
         case Replication::hist_OutOfRealm:
@@ -112,7 +113,7 @@ void do_transform(const std::string& file_name, const char* read_key, const char
         case Replication::hist_SyncClient: {
             std::unique_ptr<Replication> reference_history = realm::sync::make_client_replication(file_name);
             auto sg = DB::create(*reference_history, DBOptions(read_key));
-            success = sg->compact(bump_version_number, write_key);
+            success = sg->compact(bump_version_number, write_key, write_format);
             break;
         }
         case Replication::hist_SyncServer: {
@@ -120,7 +121,7 @@ void do_transform(const std::string& file_name, const char* read_key, const char
             _impl::ServerHistory::DummyCompactionControl compaction_control;
             _impl::ServerHistory history{file_name, context, compaction_control};
             auto sg = DB::create(history, DBOptions(read_key));
-            success = sg->compact(bump_version_number, write_key);
+            success = sg->compact(bump_version_number, write_key, write_format);
             break;
         }
     }
@@ -133,7 +134,7 @@ void do_transform(const std::string& file_name, const char* read_key, const char
 }
 
 void parallel_transform(const std::vector<std::string>& paths, const char* read_key, const char* write_key,
-                        bool verbose, size_t jobs)
+                        util::Optional<util::File::EncryptionFormat> write_format, bool verbose, size_t jobs)
 {
     REALM_ASSERT(jobs > 0);
     std::vector<std::thread> threads;
@@ -142,9 +143,9 @@ void parallel_transform(const std::vector<std::string>& paths, const char* read_
         size_t begin_index = next_index;
         size_t end_index = std::min(next_index + items_per_thread, paths.size());
 
-        threads.emplace_back([begin_index, end_index, &paths, read_key, write_key, verbose] {
+        threads.emplace_back([begin_index, end_index, &paths, read_key, write_key, write_format, verbose] {
             for (size_t i = begin_index; i < end_index; i++) {
-                do_transform(paths[i], read_key, write_key, verbose);
+                do_transform(paths[i], read_key, write_key, write_format, verbose);
             }
         });
     }
@@ -181,11 +182,11 @@ size_t encryption_transformer::encrypt_transform(const encryption_transformer::C
 
     try {
         if (config.jobs) {
-            parallel_transform(paths, read_key, write_key, config.verbose, *config.jobs);
+            parallel_transform(paths, read_key, write_key, config.output_format, config.verbose, *config.jobs);
         }
         else {
             for (auto& path : paths) {
-                do_transform(path, read_key, write_key, config.verbose);
+                do_transform(path, read_key, write_key, config.output_format, config.verbose);
             }
         }
     }
@@ -4,6 +4,7 @@
 #include <array>
 #include <string>
 
+#include <realm/util/file.hpp>
 #include <realm/util/optional.hpp>
 
 namespace realm {
@@ -12,6 +13,8 @@ namespace encryption_transformer {
 struct Configuration {
     util::Optional<std::array<char, 64>> input_key;
     util::Optional<std::array<char, 64>> output_key;
+    // If unset, encrypted files keep their encryption format
+    util::Optional<util::File::EncryptionFormat> output_format;
     bool verbose = false;
     enum class TransformType {
         File,
@@ -20,7 +20,7 @@ void usage(char* prog)
 {
     std::cerr
         << "Synopsis: " << prog
-        << " [-i INPUT_KEY_FILE][-o OUTPUT_KEY_FILE][-l LIST_FILE_PATH][-f FILE][-j JOBS][-v][-h]\n"
+        << " [-i INPUT_KEY_FILE][-o OUTPUT_KEY_FILE][-l LIST_FILE_PATH][-f FILE][-j JOBS][-g][-v][-h]\n"
            "Transform Realm file encryption state.\n"
            "Both the input and output keys are optional.\n"
            "When a key is omitted, it means no encryption is used in that direction.\n"
@@ -38,12 +38,14 @@ void usage(char* prog)
            "  -t, --output_key_env         The name of the environment variable containing the Base64 encoding of\n"
            "                               the 64 byte encryption key to be used for writing\n"
            "  -t, --jobs                   Number of parallel jobs\n"
+           "  -g, --gcm                    Write encrypted files in the AES-GCM encryption format. Without this\n"
+           "                               option, encrypted files keep their format\n"
            "  -v, --verbose                Turn on verbose output. WARNING: The keys will be visible on the "
            "console!\n"
            "\n";
 }
 
-const char* optstring = "hi:o:l:f:vn:t:j:";
+const char* optstring = "hi:o:l:f:vn:t:j:g";
 
 struct option longopts[] = {{"help", no_argument, nullptr, 'h'},
                             {"input_key_file", optional_argument, nullptr, 'i'},
@@ -53,7 +55,8 @@ struct option longopts[] = {{"help", no_argument, nullptr, 'h'},
                             {"verbose", no_argument, nullptr, 'v'},
                             {"input_key_env", optional_argument, nullptr, 'n'},
                             {"output_key_env", optional_argument, nullptr, 't'},
-                            {"jobs", optional_argument, nullptr, 'j'}};
+                            {"jobs", optional_argument, nullptr, 'j'},
+                            {"gcm", no_argument, nullptr, 'g'}};
 
 struct EncryptionCLIArgs {
     std::string input_key_file;
@@ -63,6 +66,7 @@ struct EncryptionCLIArgs {
     std::string input_key_env_name;
     std::string output_key_env_name;
     bool verbose = false;
+    bool gcm = false;
     util::Optional<size_t> jobs;
 };
 
@@ -100,6 +104,9 @@ EncryptionCLIArgs parse_arguments(int argc, char* argv[])
             case 'v':
                 config.verbose = true;
                 break;
+            case 'g':
+                config.gcm = true;
+                break;
             default:
                 usage(argv[0]);
                 std::exit(EXIT_FAILURE);
@@ -161,6 +168,8 @@ int main(int argc, char* argv[])
     encryption_transformer::Configuration config;
     config.verbose = cli_config.verbose;
     config.jobs = cli_config.jobs;
+    if (cli_config.gcm)
+        config.output_format = util::File::encryption_AesGcm;
     if (cli_config.jobs && *cli_config.jobs <= 0) {
         std::cerr << "Config error: jobs cannot be less than 1\n\n";
         usage(argv[0]);
@@ -1,7 +1,9 @@
 #include <realm/sync/noinst/changeset_index.hpp>
 #include <realm/sync/object_id.hpp>
+#include <realm/util/overload.hpp>
 
-#include <iterator> // std::distance, std::advance
+#include <algorithm> // std::sort, std::unique
+#include <iterator>  // std::distance, std::advance
 
 using namespace realm::sync;
 
@@ -235,6 +237,104 @@ size_t get_object_ids_in_instruction(const Changeset& changeset, const sync::Ins
     return 0;
 }
 
+void ChangesetObjects::reset(const Changeset& changeset)
+{
+    using Instruction = realm::sync::Instruction;
+
+    hashes.clear();
+    has_schema_changes = false;
+    has_destructive_schema_changes = false;
+    for (auto it = changeset.begin(); it != changeset.end(); ++it) {
+        if (!*it)
+            continue;
+
+        const auto& instr = **it;
+        if (is_schema_change(instr)) {
+            has_schema_changes = true;
+            if (instr.get_if<Instruction::EraseTable>() || instr.get_if<Instruction::EraseColumn>())
+                has_destructive_schema_changes = true;
+            continue;
+        }
+        GlobalID ids[2];
+        size_t num_ids = get_object_ids_in_instruction(changeset, instr, ids, 2);
+        for (size_t i = 0; i < num_ids; ++i)
+            hashes.push_back(hash_object_id(ids[i])); // Throws
+    }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+}
+
+
+void ObjectFilter::reset(size_t num_objects)
+{
+    // With 16 bits per object and two probes, the rate of false positives is
+    // below 1.5%.
+    size_t num_words = 16;
+    while (num_words * 64 < num_objects * 16)
+        num_words *= 2;
+    m_words.assign(num_words, 0); // Throws
+    m_bit_mask = num_words * 64 - 1;
+}
+
+
+void ObjectFilter::add(const ChangesetObjects& objects)
+{
+    for (std::uint_fast64_t hash : objects.hashes) {
+        std::uint_fast64_t bit_1 = hash & m_bit_mask;
+        std::uint_fast64_t bit_2 = (hash >> 32) & m_bit_mask;
+        m_words[bit_1 / 64] |= std::uint_fast64_t(1) << (bit_1 % 64);
+        m_words[bit_2 / 64] |= std::uint_fast64_t(1) << (bit_2 % 64);
+    }
+}
+
+
+bool ObjectFilter::may_intersect(const ChangesetObjects& objects) const noexcept
+{
+    for (std::uint_fast64_t hash : objects.hashes) {
+        std::uint_fast64_t bit_1 = hash & m_bit_mask;
+        std::uint_fast64_t bit_2 = (hash >> 32) & m_bit_mask;
+        if ((m_words[bit_1 / 64] >> (bit_1 % 64) & 1) != 0 && (m_words[bit_2 / 64] >> (bit_2 % 64) & 1) != 0)
+            return true;
+    }
+    return false;
+}
+
+
+std::uint_fast64_t hash_object_id(const ChangesetIndex::GlobalID& id) noexcept
+{
+    std::uint_fast64_t pk_hash = mpark::visit(util::overload{
+                                                  [](mpark::monostate) -> std::uint_fast64_t {
+                                                      return 0;
+                                                  },
+                                                  [](int64_t value) -> std::uint_fast64_t {
+                                                      return std::uint_fast64_t(value);
+                                                  },
+                                                  [](StringData value) -> std::uint_fast64_t {
+                                                      return value.hash();
+                                                  },
+                                                  [](GlobalKey value) -> std::uint_fast64_t {
+                                                      return value.hi() * 0x9E3779B97F4A7C15 ^ value.lo();
+                                                  },
+                                                  [](ObjectId value) -> std::uint_fast64_t {
+                                                      return value.hash();
+                                                  },
+                                                  [](UUID value) -> std::uint_fast64_t {
+                                                      return value.hash();
+                                                  },
+                                              },
+                                              id.object_id);
+    std::uint_fast64_t hash = std::uint_fast64_t(id.table_name.hash()) * 0x9E3779B97F4A7C15;
+    hash ^= pk_hash + id.object_id.index();
+    // Finalizer of SplitMix64, such that all bits of the result depend on all
+    // bits of the input.
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EB;
+    hash ^= hash >> 31;
+    return hash;
+}
+
 auto ChangesetIndex::get_schema_changes_for_class(StringData class_name) const -> const Ranges*
 {
     return const_cast<ChangesetIndex*>(this)->get_schema_changes_for_class(class_name);
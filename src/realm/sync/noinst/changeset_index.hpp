@@ -98,6 +98,13 @@ struct ChangesetIndex {
         return m_num_conflict_groups;
     }
 
+    /// True if a scanned changeset contains destructive schema changes, in
+    /// which case every instruction conflicts with every other instruction.
+    bool contains_destructive_schema_changes() const noexcept
+    {
+        return m_contains_destructive_schema_changes;
+    }
+
     struct RangeIterator;
 
     RangeIterator erase_instruction(RangeIterator);
@@ -139,6 +146,46 @@ private:
 };
 
 
+/// A summary of the objects referenced by a changeset. Together with
+/// ObjectFilter, it allows the merge algorithm to recognize changesets that
+/// cannot conflict with any instruction in a set of other changesets, without
+/// adding them to a ChangesetIndex.
+struct ChangesetObjects {
+    /// Hashes (see hash_object_id()) of the IDs of all the objects referenced
+    /// by the changeset, including link targets. Sorted, and without
+    /// duplicates.
+    util::metered::vector<std::uint_fast64_t> hashes;
+
+    /// True if the changeset contains schema changes, which conflict with
+    /// everything.
+    bool has_schema_changes = false;
+
+    /// True if the changeset erases tables or columns, which causes every
+    /// instruction to conflict with every other instruction (see
+    /// ChangesetIndex::contains_destructive_schema_changes()).
+    bool has_destructive_schema_changes = false;
+
+    void reset(const sync::Changeset&);
+};
+
+/// A Bloom filter over object IDs. It may report that a changeset references
+/// an object that was added to the filter, when in fact it does not, but never
+/// the other way around.
+class ObjectFilter {
+public:
+    /// Clear the filter, and size it for the specified number of objects.
+    void reset(size_t num_objects);
+
+    void add(const ChangesetObjects&);
+    bool may_intersect(const ChangesetObjects&) const noexcept;
+
+private:
+    util::metered::vector<std::uint_fast64_t> m_words;
+    std::uint_fast64_t m_bit_mask = 0;
+};
+
+std::uint_fast64_t hash_object_id(const ChangesetIndex::GlobalID&) noexcept;
+
 /// Collapse and compact adjacent and overlapping ranges.
 void compact_ranges(ChangesetIndex::Ranges& ranges, bool is_sorted = false);
 
@@ -361,6 +361,20 @@ void Connection::websocket_handshake_completion_handler(const HTTPHeaders& heade
                 if (good_version) {
                     logger.detail("Negotiated protocol version: %1", value_2);
                     m_negotiated_protocol_version = value_2;
+                    m_compression_codec = _impl::compression::Codec::zlib;
+                    auto j = headers.find(sync::get_compression_http_header_name());
+                    if (j != headers.end()) {
+                        // The server only chooses among the codecs announced
+                        // in the request, but if it chose something else,
+                        // stick to zlib, which it is known to understand.
+                        if (auto codec = _impl::compression::find_codec(j->second)) {
+                            logger.detail("Negotiated compression codec: %1", j->second);
+                            m_compression_codec = *codec;
+                        }
+                        else {
+                            logger.error("Bad compression codec from server: '%1'", j->second); // Throws
+                        }
+                    }
                     handle_connection_established(); // Throws
                     return;
                 }
@@ -948,6 +962,11 @@ void Connection::initiate_websocket_handshake()
     headers["User-Agent"] = client.get_user_agent_string(); // Throws
     set_http_request_headers(headers);                      // Throws
 
+    // Offer the codecs that are faster than zlib, if any.
+    std::string codec_names = _impl::compression::get_fast_codec_names(); // Throws
+    if (!codec_names.empty())
+        headers[sync::get_compression_http_header_name()] = std::move(codec_names); // Throws
+
     m_websocket.initiate_client_handshake(path, m_http_host, sec_websocket_protocol,
                                           std::move(headers)); // Throws
 }
@@ -2283,9 +2302,9 @@ void Session::send_upload_message()
     OutputBuffer& out = m_conn.get_output_buffer();
     session_ident_type session_ident = get_ident();
     upload_message_builder.make_upload_message(protocol_version, out, session_ident, progress_client_version,
-                                               progress_server_version,
-                                               locked_server_version); // Throws
-    m_conn.initiate_write_message(out, this);                          // Throws
+                                               progress_server_version, locked_server_version,
+                                               m_conn.get_compression_codec()); // Throws
+    m_conn.initiate_write_message(out, this);                                   // Throws
 
     // Other messages may be waiting to be sent
     enlist_to_send(); // Throws
@@ -287,6 +287,11 @@ public:
     /// than or equal to sync::get_current_protocol_version().
     int get_negotiated_protocol_version() noexcept;
 
+    /// Returns the codec that bodies of UPLOAD messages are compressed with.
+    /// This is zlib unless the server chose a faster codec in the HTTP
+    /// response (`Realm-Sync-Compression` header).
+    _impl::compression::Codec get_compression_codec() noexcept;
+
     // Overriding methods in util::websocket::Config
     util::Logger& websocket_get_logger() noexcept override;
     std::mt19937_64& websocket_get_random() noexcept override;
@@ -383,6 +388,7 @@ private:
     util::Optional<util::HTTPClient<Connection>> m_proxy_client;
     ReconnectInfo m_reconnect_info;
     int m_negotiated_protocol_version = 0;
+    _impl::compression::Codec m_compression_codec = _impl::compression::Codec::zlib;
 
     enum class State { disconnected, connecting, connected };
     State m_state = State::disconnected;
@@ -1213,6 +1219,11 @@ inline int ClientImplBase::Connection::get_negotiated_protocol_version() noexcep
     return m_negotiated_protocol_version;
 }
 
+inline _impl::compression::Codec ClientImplBase::Connection::get_compression_codec() noexcept
+{
+    return m_compression_codec;
+}
+
 inline ClientImplBase::Connection::~Connection() {}
 
 template <class H>
@@ -1202,7 +1202,7 @@ void client_reset::transfer_group(const Transaction& group_src, Transaction& gro
                     auto val_src = src.get_any(col_key_src);
                     auto val_dst = dst.get_any(col_key_dst);
                     if (val_src != val_dst) {
-                        dst.set(col_key_dst, val_src);
+                        dst.set_any(col_key_dst, val_src);
                         updated = true;
                     }
                 }
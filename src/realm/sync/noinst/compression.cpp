@@ -4,6 +4,14 @@
 #include <zlib.h>
 #include <zconf.h> // for zlib
 
+#if REALM_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#if REALM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <realm/sync/noinst/compression.hpp>
 #include <realm/util/assert.hpp>
 #include <realm/util/aes_cryptor.hpp>
@@ -48,6 +56,8 @@ public:
                 return "Missing block header";
             case error::invalid_block_size:
                 return "Invalid block size";
+            case error::unsupported_codec:
+                return "Unsupported compression codec";
         }
         REALM_UNREACHABLE();
     }
@@ -70,6 +80,130 @@ void custom_free(void* opaque, void* addr)
     return alloc.free(addr);
 }
 
+
+#if REALM_HAVE_LZ4
+
+std::size_t lz4_allocate_and_compress(realm::_impl::compression::CompressMemoryArena& compress_memory_arena,
+                                      realm::BinaryData uncompressed_buf, std::vector<char>& compressed_buf)
+{
+    using realm::_impl::compression::error;
+    if (uncompressed_buf.size() > std::size_t(LZ4_MAX_INPUT_SIZE))
+        throw std::system_error(make_error_code(error::invalid_input));
+    int uncompressed_size = int(uncompressed_buf.size());
+    std::size_t bound = std::size_t(LZ4_compressBound(uncompressed_size));
+    if (compressed_buf.size() < bound)
+        compressed_buf.resize(bound); // Throws
+
+    // The state of the compressor is taken from the arena, such that it is
+    // not allocated for every body.
+    std::size_t state_size = std::size_t(LZ4_sizeofState());
+    if (compress_memory_arena.size() < state_size)
+        compress_memory_arena.resize(state_size); // Throws
+    compress_memory_arena.reset();
+    void* state = compress_memory_arena.alloc(state_size);
+    REALM_ASSERT(state);
+
+    int acceleration = 1;
+    int compressed_size =
+        LZ4_compress_fast_extState(state, uncompressed_buf.data(), compressed_buf.data(), uncompressed_size,
+                                   int(bound), acceleration);
+    if (REALM_UNLIKELY(compressed_size <= 0))
+        throw std::system_error(make_error_code(error::compress_error));
+    return std::size_t(compressed_size);
+}
+
+std::error_code lz4_decompress(const char* compressed_buf, std::size_t compressed_size, char* decompressed_buf,
+                               std::size_t decompressed_size)
+{
+    using realm::_impl::compression::error;
+    constexpr std::size_t max_size = std::size_t(std::numeric_limits<int>::max());
+    if (compressed_size > max_size || decompressed_size > max_size)
+        return error::invalid_input;
+    int size = LZ4_decompress_safe(compressed_buf, decompressed_buf, int(compressed_size), int(decompressed_size));
+    if (size < 0)
+        return error::corrupt_input;
+    if (std::size_t(size) != decompressed_size)
+        return error::incorrect_decompressed_size;
+    return std::error_code{};
+}
+
+#endif // REALM_HAVE_LZ4
+
+
+#if REALM_HAVE_ZSTD
+
+// Zstd at level 1 is faster than zlib at level 1, and compresses better.
+constexpr int g_zstd_compression_level = 1;
+
+struct ZstdContextDeleter {
+    void operator()(ZSTD_CCtx* context) const noexcept
+    {
+        ZSTD_freeCCtx(context);
+    }
+    void operator()(ZSTD_DCtx* context) const noexcept
+    {
+        ZSTD_freeDCtx(context);
+    }
+};
+
+// Zstd contexts own several hundred KiB of tables, which the codec cannot take
+// from a custom allocator through its stable API, so each thread keeps a
+// context of each kind for reuse rather than creating one per body.
+ZSTD_CCtx& get_zstd_compress_context()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, ZstdContextDeleter> context;
+    if (!context) {
+        context.reset(ZSTD_createCCtx());
+        if (!context)
+            throw std::bad_alloc();
+    }
+    return *context;
+}
+
+ZSTD_DCtx* get_zstd_decompress_context() noexcept
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, ZstdContextDeleter> context;
+    if (!context)
+        context.reset(ZSTD_createDCtx());
+    return context.get();
+}
+
+std::size_t zstd_allocate_and_compress(realm::BinaryData uncompressed_buf, std::vector<char>& compressed_buf)
+{
+    using realm::_impl::compression::error;
+    std::size_t bound = ZSTD_compressBound(uncompressed_buf.size());
+    if (ZSTD_isError(bound))
+        throw std::system_error(make_error_code(error::invalid_input));
+    if (compressed_buf.size() < bound)
+        compressed_buf.resize(bound); // Throws
+
+    ZSTD_CCtx& context = get_zstd_compress_context(); // Throws
+    std::size_t compressed_size =
+        ZSTD_compressCCtx(&context, compressed_buf.data(), compressed_buf.size(), uncompressed_buf.data(),
+                          uncompressed_buf.size(), g_zstd_compression_level);
+    if (REALM_UNLIKELY(ZSTD_isError(compressed_size)))
+        throw std::system_error(make_error_code(error::compress_error));
+    return compressed_size;
+}
+
+std::error_code zstd_decompress(const char* compressed_buf, std::size_t compressed_size, char* decompressed_buf,
+                                std::size_t decompressed_size)
+{
+    using realm::_impl::compression::error;
+    ZSTD_DCtx* context = get_zstd_decompress_context();
+    if (!context)
+        return error::out_of_memory;
+    std::size_t size =
+        ZSTD_decompressDCtx(context, decompressed_buf, decompressed_size, compressed_buf, compressed_size);
+    if (ZSTD_isError(size))
+        return error::corrupt_input;
+    if (size != decompressed_size)
+        return error::incorrect_decompressed_size;
+    return std::error_code{};
+}
+
+#endif // REALM_HAVE_ZSTD
+
 } // unnamed namespace
 
 
@@ -87,6 +221,72 @@ std::error_code compression::make_error_code(error error_code) noexcept
 }
 
 
+bool compression::is_codec_available(Codec codec) noexcept
+{
+    switch (codec) {
+        case Codec::none:
+            return false;
+        case Codec::zlib:
+            return true;
+        case Codec::lz4:
+#if REALM_HAVE_LZ4
+            return true;
+#else
+            return false;
+#endif
+        case Codec::zstd:
+#if REALM_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+
+const char* compression::get_codec_name(Codec codec) noexcept
+{
+    switch (codec) {
+        case Codec::none:
+            return "none";
+        case Codec::zlib:
+            return "zlib";
+        case Codec::lz4:
+            return "lz4";
+        case Codec::zstd:
+            return "zstd";
+    }
+    return "unknown";
+}
+
+
+util::Optional<compression::Codec> compression::find_codec(util::StringView name) noexcept
+{
+    for (Codec codec : {Codec::zlib, Codec::lz4, Codec::zstd}) {
+        if (name == util::StringView(get_codec_name(codec)) && is_codec_available(codec))
+            return codec;
+    }
+    return util::none;
+}
+
+
+std::string compression::get_fast_codec_names()
+{
+    // Zstd is preferred, as it compresses nearly as well as zlib at a fraction
+    // of the cost. LZ4 is faster still, but compresses less.
+    std::string names;
+    for (Codec codec : {Codec::zstd, Codec::lz4}) {
+        if (is_codec_available(codec)) {
+            if (!names.empty())
+                names += ", ";
+            names += get_codec_name(codec); // Throws
+        }
+    }
+    return names;
+}
+
+
 // zlib compression level: 1-9, 1 fastest.
 
 // zlib deflateBound()
@@ -274,16 +474,66 @@ std::error_code compression::decompress(const char* compressed_buf, std::size_t
 }
 
 
+std::error_code compression::decompress(Codec codec, const char* compressed_buf, std::size_t compressed_size,
+                                        char* decompressed_buf, std::size_t decompressed_size)
+{
+    switch (codec) {
+        case Codec::none:
+            break;
+        case Codec::zlib:
+            return decompress(compressed_buf, compressed_size, decompressed_buf, decompressed_size);
+        case Codec::lz4:
+#if REALM_HAVE_LZ4
+            return lz4_decompress(compressed_buf, compressed_size, decompressed_buf, decompressed_size);
+#else
+            break;
+#endif
+        case Codec::zstd:
+#if REALM_HAVE_ZSTD
+            return zstd_decompress(compressed_buf, compressed_size, decompressed_buf, decompressed_size);
+#else
+            break;
+#endif
+    }
+    return error::unsupported_codec;
+}
+
+
 std::size_t compression::allocate_and_compress(CompressMemoryArena& compress_memory_arena,
-                                               BinaryData uncompressed_buf, std::vector<char>& compressed_buf)
+                                               BinaryData uncompressed_buf, std::vector<char>& compressed_buf,
+                                               Codec codec)
 {
+    switch (codec) {
+        case Codec::none:
+            throw std::system_error(make_error_code(error::unsupported_codec));
+        case Codec::zlib:
+            break;
+        case Codec::lz4:
+#if REALM_HAVE_LZ4
+            return lz4_allocate_and_compress(compress_memory_arena, uncompressed_buf, compressed_buf); // Throws
+#else
+            throw std::system_error(make_error_code(error::unsupported_codec));
+#endif
+        case Codec::zstd:
+#if REALM_HAVE_ZSTD
+            return zstd_allocate_and_compress(uncompressed_buf, compressed_buf); // Throws
+#else
+            throw std::system_error(make_error_code(error::unsupported_codec));
+#endif
+    }
+
     const int compression_level = 1;
     std::size_t compressed_size = 0;
 
     compress_memory_arena.reset();
 
-    if (compressed_buf.size() < 256)
-        compressed_buf.resize(256); // Throws
+    // Make room for the compressed data up front, such that the data is
+    // normally compressed in a single pass, rather than being compressed again
+    // every time the buffer turns out to be too small. compressBound() applies
+    // to the default window size and memory level, as used by compress().
+    std::size_t bound = std::max(std::size_t(::compressBound(uLong(uncompressed_buf.size()))), std::size_t(256));
+    if (compressed_buf.size() < bound)
+        compressed_buf.resize(bound); // Throws
 
     for (;;) {
         std::error_code ec =
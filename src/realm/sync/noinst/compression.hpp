@@ -13,6 +13,7 @@
 #include <realm/binary_data.hpp>
 #include <realm/util/file.hpp>
 #include <realm/util/optional.hpp>
+#include <realm/util/string_view.hpp>
 
 namespace realm {
 namespace _impl {
@@ -31,6 +32,7 @@ enum class error {
     decryption_error = 10,
     missing_block_header = 11,
     invalid_block_size = 12,
+    unsupported_codec = 13,
 };
 
 const std::error_category& error_category() noexcept;
@@ -108,6 +110,40 @@ private:
 };
 
 
+/// The codecs by which the bodies of UPLOAD and DOWNLOAD messages can be
+/// compressed. The values are those of the `is_body_compressed` field of the
+/// headers of those messages, so zero means that the body is not compressed,
+/// and one means zlib, which every peer understands. A peer only sends bodies
+/// compressed by LZ4 or Zstd when the other peer has announced that it can
+/// decompress them (see sync::get_compression_http_header_name()).
+///
+/// LZ4 and Zstd are only available when Realm is built with `REALM_USE_LZ4`
+/// and `REALM_USE_ZSTD` respectively.
+enum class Codec {
+    none = 0,
+    zlib = 1,
+    lz4 = 2,
+    zstd = 3,
+};
+
+/// Returns true if, and only if bodies can be compressed and decompressed by
+/// the specified codec in this build.
+bool is_codec_available(Codec) noexcept;
+
+/// The name by which the specified codec is announced in the WebSocket
+/// handshake.
+const char* get_codec_name(Codec) noexcept;
+
+/// Returns the available codec (see is_codec_available()) with the specified
+/// name, or none if there is no such codec.
+util::Optional<Codec> find_codec(util::StringView name) noexcept;
+
+/// Returns the names of the available codecs other than zlib, in order of
+/// preference and separated by commas, as announced in the WebSocket
+/// handshake. Returns the empty string if neither LZ4 nor Zstd is available.
+std::string get_fast_codec_names();
+
+
 /// compress_bound() calculates an upper bound on the size of the compressed
 /// data. The caller can use this function to allocate memory buffer calling
 /// compress(). \a uncompressed_buf is the buffer with uncompressed data. The
@@ -137,9 +173,20 @@ std::error_code compress(const char* uncompressed_buf, size_t uncompressed_size,
 std::error_code decompress(const char* compressed_buf, size_t compressed_size, char* decompressed_buf,
                            size_t decompressed_size);
 
+/// Same as decompress() above, except that the data is decompressed by the
+/// specified codec. Returns error::unsupported_codec if the codec is not
+/// available in this build, or is Codec::none.
+std::error_code decompress(Codec codec, const char* compressed_buf, size_t compressed_size, char* decompressed_buf,
+                           size_t decompressed_size);
+
 
+/// allocate_and_compress() compresses \a uncompressed_buf by the specified
+/// codec into \a compressed_buf, which is grown as needed, and returns the
+/// size of the compressed data. Memory needed by the codec is taken from \a
+/// compress_memory_arena, which is also grown as needed. The codec must be
+/// available in this build, and must not be Codec::none. Throws on errors.
 size_t allocate_and_compress(CompressMemoryArena& compress_memory_arena, BinaryData uncompressed_buf,
-                             std::vector<char>& compressed_buf);
+                             std::vector<char>& compressed_buf, Codec codec = Codec::zlib);
 
 /// compress_file() compresses the file at path \a src_path into \a dst_path.
 /// The function returns {} on success and returns an error if the source file
@@ -96,7 +96,8 @@ void ClientProtocol::UploadMessageBuilder::make_upload_message(int protocol_vers
                                                                session_ident_type session_ident,
                                                                version_type progress_client_version,
                                                                version_type progress_server_version,
-                                                               version_type locked_server_version)
+                                                               version_type locked_server_version,
+                                                               _impl::compression::Codec codec)
 {
     static_cast<void>(protocol_version);
     BinaryData body = {m_body_buffer.data(), std::size_t(m_body_buffer.size())};
@@ -106,16 +107,17 @@ void ClientProtocol::UploadMessageBuilder::make_upload_message(int protocol_vers
 
     if (body.size() > g_max_uncompressed) {
         compressed_body_size = _impl::compression::allocate_and_compress(m_compress_memory_arena, body,
-                                                                         m_compression_buffer); // Throws
+                                                                         m_compression_buffer, codec); // Throws
     }
 
     // The compressed body is only sent if it is smaller than the uncompressed body.
     bool is_body_compressed = (compressed_body_size < body.size());
     if (!is_body_compressed)
         compressed_body_size = 0;
+    auto body_codec = (is_body_compressed ? codec : _impl::compression::Codec::none);
 
     // The header of the upload message.
-    out << "upload " << session_ident << " " << int(is_body_compressed) << " " << body.size() << " "
+    out << "upload " << session_ident << " " << int(body_codec) << " " << body.size() << " "
         << compressed_body_size;
     out << " " << progress_client_version << " " << progress_server_version << " " << locked_server_version; // Throws
     out << "\n";                                                                                             // Throws
@@ -230,26 +232,42 @@ void ServerProtocol::make_download_message(int protocol_version, OutputBuffer& o
                                            version_type upload_client_version, version_type upload_server_version,
                                            std::uint_fast64_t downloadable_bytes, std::size_t num_changesets,
                                            const char* body, std::size_t uncompressed_body_size,
-                                           std::size_t compressed_body_size, bool body_is_compressed,
-                                           util::Logger& logger)
+                                           std::size_t compressed_body_size,
+                                           _impl::compression::Codec body_codec, util::Logger& logger)
+{
+    make_download_message_header(protocol_version, out, session_ident, download_server_version,
+                                 download_client_version, latest_server_version, latest_server_version_salt,
+                                 upload_client_version, upload_server_version, downloadable_bytes, num_changesets,
+                                 uncompressed_body_size, compressed_body_size, body_codec,
+                                 logger); // Throws
+
+    bool body_is_compressed = (body_codec != _impl::compression::Codec::none);
+    std::size_t body_size = (body_is_compressed ? compressed_body_size : uncompressed_body_size);
+    out.write(body, body_size);
+}
+
+
+void ServerProtocol::make_download_message_header(
+    int protocol_version, OutputBuffer& out, session_ident_type session_ident, version_type download_server_version,
+    version_type download_client_version, version_type latest_server_version, salt_type latest_server_version_salt,
+    version_type upload_client_version, version_type upload_server_version, std::uint_fast64_t downloadable_bytes,
+    std::size_t num_changesets, std::size_t uncompressed_body_size, std::size_t compressed_body_size,
+    _impl::compression::Codec body_codec, util::Logger& logger)
 {
     static_cast<void>(protocol_version);
     // The header of the download message.
     out << "download " << session_ident << " " << download_server_version << " " << download_client_version << " "
         << latest_server_version << " " << latest_server_version_salt << " " << upload_client_version << " "
-        << upload_server_version << " " << downloadable_bytes << " " << int(body_is_compressed) << " "
+        << upload_server_version << " " << downloadable_bytes << " " << int(body_codec) << " "
         << uncompressed_body_size << " " << compressed_body_size << "\n"; // Throws
 
-    std::size_t body_size = (body_is_compressed ? compressed_body_size : uncompressed_body_size);
-    out.write(body, body_size);
-
     logger.detail("Sending: DOWNLOAD(download_server_version=%1, download_client_version=%2, "
                   "latest_server_version=%3, latest_server_version_salt=%4, "
                   "upload_client_version=%5, upload_server_version=%6, "
                   "num_changesets=%7, is_body_compressed=%8, body_size=%9, "
                   "compressed_body_size=%10)",
                   download_server_version, download_client_version, latest_server_version, latest_server_version_salt,
-                  upload_client_version, upload_server_version, num_changesets, body_is_compressed,
+                  upload_client_version, upload_server_version, num_changesets, int(body_codec),
                   uncompressed_body_size, compressed_body_size); // Throws
 }
 
@@ -93,9 +93,11 @@ public:
         void add_changeset(version_type client_version, version_type server_version, timestamp_type origin_timestamp,
                            file_ident_type origin_file_ident, ChunkedBinaryData changeset);
 
+        /// The body is compressed by the specified codec, unless it is small,
+        /// or does not get smaller by compression.
         void make_upload_message(int protocol_version, OutputBuffer&, session_ident_type session_ident,
                                  version_type progress_client_version, version_type progress_server_version,
-                                 version_type locked_server_version);
+                                 version_type locked_server_version, _impl::compression::Codec codec);
 
     private:
         std::size_t m_num_changesets = 0;
@@ -194,11 +196,13 @@ public:
             // if is_body_compressed == true, we must decompress the received body.
             if (is_body_compressed) {
                 uncompressed_body_buffer.reset(new char[uncompressed_body_size]);
-                std::error_code ec = _impl::compression::decompress(
-                    body.data(), compressed_body_size, uncompressed_body_buffer.get(), uncompressed_body_size);
+                auto codec = _impl::compression::Codec(is_body_compressed);
+                std::error_code ec =
+                    _impl::compression::decompress(codec, body.data(), compressed_body_size,
+                                                   uncompressed_body_buffer.get(), uncompressed_body_size);
 
                 if (ec) {
-                    logger.error("compression::inflate: %1", ec.message());
+                    logger.error("compression::decompress: %1", ec.message());
                     connection.handle_protocol_error(Error::bad_decompression);
                     return;
                 }
@@ -516,7 +520,18 @@ public:
                                version_type upload_client_version, version_type upload_server_version,
                                std::uint_fast64_t downloadable_bytes, std::size_t num_changesets, const char* body,
                                std::size_t uncompressed_body_size, std::size_t compressed_body_size,
-                               bool body_is_compressed, util::Logger&);
+                               _impl::compression::Codec body_codec, util::Logger&);
+
+    /// Same as make_download_message(), except that the body is not written
+    /// to the output buffer. The caller must send the body immediately after
+    /// the header, as part of the same WebSocket message.
+    void make_download_message_header(int protocol_version, OutputBuffer&, session_ident_type session_ident,
+                                      version_type download_server_version, version_type download_client_version,
+                                      version_type latest_server_version, salt_type latest_server_version_salt,
+                                      version_type upload_client_version, version_type upload_server_version,
+                                      std::uint_fast64_t downloadable_bytes, std::size_t num_changesets,
+                                      std::size_t uncompressed_body_size, std::size_t compressed_body_size,
+                                      _impl::compression::Codec body_codec, util::Logger&);
 
     void make_mark_message(OutputBuffer&, session_ident_type session_ident, request_ident_type request_ident);
 
@@ -611,11 +626,13 @@ public:
             // if is_body_compressed == true, we must decompress the received body.
             if (is_body_compressed) {
                 uncompressed_body_buffer.reset(new char[uncompressed_body_size]);
-                std::error_code ec = _impl::compression::decompress(
-                    body.data(), compressed_body_size, uncompressed_body_buffer.get(), uncompressed_body_size);
+                auto codec = _impl::compression::Codec(is_body_compressed);
+                std::error_code ec =
+                    _impl::compression::decompress(codec, body.data(), compressed_body_size,
+                                                   uncompressed_body_buffer.get(), uncompressed_body_size);
 
                 if (ec) {
-                    logger.error("compression::inflate: %1", ec.message());
+                    logger.error("compression::decompress: %1", ec.message());
                     connection.handle_protocol_error(Error::bad_decompression);
                     return;
                 }
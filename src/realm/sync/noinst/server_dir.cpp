@@ -14,10 +14,11 @@ bool valid_virt_path_segment(const std::string& seg)
     if (seg.front() == '.')
         return false;
     // Prevent spurious clashes between directory names and file names
-    // created by appending `.realm`, `.realm.lock`, or `.realm.management`
-    // to the last component of client specified virtual paths.
+    // created by appending `.realm`, `.realm.lock`, `.realm.management`, or
+    // `.realm.state` to the last component of client specified virtual paths.
     bool possible_clash = (StringData(seg).ends_with(".realm") || StringData(seg).ends_with(".realm.lock") ||
-                           StringData(seg).ends_with(".realm.management"));
+                           StringData(seg).ends_with(".realm.management") ||
+                           StringData(seg).ends_with(".realm.state"));
     if (possible_clash)
         return false;
     std::locale c_loc = std::locale::classic();
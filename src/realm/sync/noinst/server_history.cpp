@@ -340,6 +340,17 @@ void ServerHistory::get_status(VersionInfo& version_info, bool& has_upstream_syn
 }
 
 
+TransactionRef ServerHistory::start_read(SaltedVersion& server_version) const
+{
+    TransactionRef rt = m_shared_group->start_read(); // Throws
+    version_type realm_version = rt->get_version();
+    const_cast<ServerHistory*>(this)->set_group(rt.get());
+    ensure_updated(realm_version); // Throws
+    server_version = get_salted_server_version();
+    return rt;
+}
+
+
 version_type ServerHistory::get_compacted_until_version() const
 {
     TransactionRef rt = m_shared_group->start_read(); // Throws
@@ -1022,6 +1033,31 @@ bool ServerHistory::fetch_download_info(file_ident_type client_file_ident, Downl
 }
 
 
+bool ServerHistory::has_changesets_from(file_ident_type client_file_ident, version_type begin_version,
+                                        version_type end_version) const
+{
+    REALM_ASSERT(client_file_ident != 0);
+    REALM_ASSERT(begin_version <= end_version);
+
+    TransactionRef tr = m_shared_group->start_read(); // Throws
+    version_type realm_version = tr->get_version();
+    const_cast<ServerHistory*>(this)->set_group(tr.get());
+    ensure_updated(realm_version); // Throws
+
+    REALM_ASSERT(begin_version >= m_history_base_version);
+    REALM_ASSERT(end_version <= get_server_version());
+    std::size_t begin_ndx = to_size_t(begin_version - m_history_base_version);
+    std::size_t end_ndx = to_size_t(end_version - m_history_base_version);
+    for (std::size_t i = begin_ndx; i < end_ndx; ++i) {
+        HistoryEntry entry;
+        entry.origin_file_ident = file_ident_type(m_acc->sh_origin_files.get(i));
+        if (received_from(entry, client_file_ident))
+            return true;
+    }
+    return false;
+}
+
+
 void ServerHistory::add_upstream_sync_status()
 {
     TransactionRef tr = m_shared_group->start_write(); // Throws
@@ -240,6 +240,10 @@ public:
     void get_status(sync::VersionInfo&, bool& has_upstream_status, file_ident_type& partial_file_ident,
                     version_type& partial_progress_reference_version) const;
 
+    /// Start a read transaction on the latest snapshot of the Realm, and get
+    /// the salted server version of that snapshot.
+    TransactionRef start_read(SaltedVersion& server_version) const;
+
     /// For testing purposes
     version_type get_compacted_until_version() const;
 
@@ -396,6 +400,14 @@ public:
                              std::uint_fast64_t& cumulative_byte_size_total, bool disable_download_compaction,
                              std::size_t accum_byte_size_soft_limit = 0x20000) const;
 
+    /// Returns true if any of the history entries in the range
+    /// (`begin_version`, `end_version`] were received from the specified
+    /// client file, that is, if fetch_download_info() would filter out any
+    /// changesets in that range on behalf of the client. Only the origin of
+    /// each entry is inspected, not the changeset.
+    bool has_changesets_from(file_ident_type client_file_ident, version_type begin_version,
+                             version_type end_version) const;
+
     /// The application must call this function before using the history as an
     /// upstream client history.
     ///
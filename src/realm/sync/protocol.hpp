@@ -33,6 +33,14 @@ constexpr const char* get_websocket_protocol_prefix() noexcept
     return "com.mongodb.realm-sync/";
 }
 
+/// The HTTP header by which the client announces the codecs, other than zlib,
+/// that it can compress message bodies with, and by which the server reports
+/// the codec chosen for the connection. See `doc/protocol.md`.
+constexpr const char* get_compression_http_header_name() noexcept
+{
+    return "Realm-Sync-Compression";
+}
+
 
 /// Supported protocol envelopes:
 ///
@@ -9,6 +9,7 @@
 #include <queue>
 #include <set>
 #include <map>
+#include <list>
 #include <memory>
 #include <sstream>
 #include <chrono>
@@ -17,6 +18,7 @@
 #include <functional>
 #include <algorithm>
 #include <atomic>
+#include <tuple>
 #include <thread>
 
 #include <realm/sync/encrypt/fingerprint.hpp>
@@ -45,6 +47,9 @@
 #include <realm/version.hpp>
 #include <realm/string_data.hpp>
 #include <realm/binary_data.hpp>
+#include <realm/list.hpp>
+#include <realm/set.hpp>
+#include <realm/dictionary.hpp>
 #include <realm/sync/noinst/file_descriptors.hpp>
 #include <realm/sync/noinst/common_dir.hpp>
 #include <realm/sync/noinst/compression.hpp>
@@ -62,6 +67,7 @@
 #include <realm/sync/access_control.hpp>
 #include <realm/sync/server.hpp>
 #include <realm/sync/changeset.hpp>
+#include <realm/sync/object.hpp>
 
 // NOTE: The protocol specification is in `/doc/protocol.md`
 
@@ -201,6 +207,8 @@ bool determine_try_again(ProtocolError error_code) noexcept
 
 
 class ServerFile;
+class Worker;
+class NetworkShard;
 class ServerImpl;
 class HTTPConnection;
 class SyncConnection;
@@ -230,13 +238,16 @@ public:
 };
 
 
+// Shared by all network shards of the server (see NetworkShard).
 struct Gauges {
-    double connection_online = 0;
-    double connection_total = 0;
-    double session_online = 0;
-    double session_total = 0;
-    double realms_open = 0;
-    std::map<std::string, double> user_sessions;
+    std::atomic<std::int_fast64_t> connection_online{0};
+    std::atomic<std::int_fast64_t> connection_total{0};
+    std::atomic<std::int_fast64_t> session_online{0};
+    std::atomic<std::int_fast64_t> session_total{0};
+    std::atomic<std::int_fast64_t> realms_open{0};
+
+    util::Mutex user_sessions_mutex;
+    std::map<std::string, double> user_sessions; // Protected by `user_sessions_mutex`
 };
 
 
@@ -254,17 +265,496 @@ struct ChangesetGroupStats {
 };
 
 
-struct DownloadCache {
-    std::unique_ptr<char[]> body;
+struct DownloadCacheEntry {
+    std::shared_ptr<char[]> body;
     std::size_t uncompressed_body_size;
     std::size_t compressed_body_size;
     bool body_is_compressed;
-    version_type end_version;
     DownloadCursor download_progress;
     std::uint_fast64_t downloadable_bytes;
     std::size_t num_changesets;
     std::size_t accum_original_size;
     std::size_t accum_compacted_size;
+
+    std::size_t get_body_size() const noexcept
+    {
+        return (body_is_compressed ? compressed_body_size : uncompressed_body_size);
+    }
+};
+
+
+// A cache of DOWNLOAD message bodies (compressed when compression pays off),
+// shared by all sessions of a network shard (see NetworkShard). An entry is identified by the server
+// file, the download cursor that the body was produced from, the salted
+// server version that it was produced up to, the limit on the size of the
+// body that was in effect, and the codec that the body was compressed with.
+//
+// Only bodies from which no changesets were filtered out on behalf of the
+// receiving client are cached, that is, bodies produced for clients that have
+// no changesets of their own in the downloaded range. Such a body depends on
+// the client only through the last integrated client version of the download
+// cursor, which is stated for every changeset in the body, so it can be
+// shared by all clients with the same last integrated client version and no
+// changesets of their own in the range. This includes every client that has
+// never uploaded anything, and clients that reconnect after having uploaded
+// changesets further back in the history. When bootstrapping many clients
+// from a large history, the first client populates the cache one DOWNLOAD
+// message at a time, and the following clients, which traverse the history
+// in the same steps, are served from it.
+//
+// Unpinned entries are evicted in least recently used order when the
+// accumulated size of the cached bodies exceeds the configured limit. Pinned
+// entries (the bootstrap entries cached when
+// `Server::Config::enable_download_bootstrap_cache` is set) are exempt from
+// the limit, but at most one is retained per server file and codec.
+//
+// Since a server file is served by only one network shard, every entry of a
+// particular file is found in the cache of that shard.
+//
+// Must be accessed only by the thread that executes the event loop of the
+// network shard that owns it.
+class DownloadCache {
+public:
+    struct Key {
+        std::string virt_path;
+        version_type begin_server_version;
+        version_type last_integrated_client_version;
+        version_type end_server_version;
+        salt_type end_server_version_salt;
+        std::size_t max_download_size;
+        _impl::compression::Codec codec;
+
+        bool operator<(const Key& other) const noexcept
+        {
+            return std::tie(virt_path, begin_server_version, last_integrated_client_version, end_server_version,
+                            end_server_version_salt, max_download_size, codec) <
+                   std::tie(other.virt_path, other.begin_server_version, other.last_integrated_client_version,
+                            other.end_server_version, other.end_server_version_salt, other.max_download_size,
+                            other.codec);
+        }
+    };
+
+    explicit DownloadCache(std::size_t max_size) noexcept
+        : m_max_size{max_size}
+    {
+    }
+
+    // Returns null if there is no matching entry. Otherwise the entry is
+    // marked as most recently used.
+    const DownloadCacheEntry* find(const Key& key) noexcept
+    {
+        auto i = m_index.find(key);
+        if (i == m_index.end())
+            return nullptr;
+        Slot& slot = *i->second;
+        if (!slot.pinned)
+            m_lru.splice(m_lru.begin(), m_lru, i->second);
+        return &slot.entry;
+    }
+
+    // Insert an entry that shares the specified body. The body is not copied,
+    // and it remains valid for as long as a reference to it is held, even if
+    // the entry is evicted. Returns false if the entry was not cached,
+    // because it would not fit within the size limit.
+    bool insert(Key key, std::shared_ptr<char[]> body, const DownloadCacheEntry& entry, bool pinned)
+    {
+        std::size_t body_size = entry.get_body_size();
+        if (!pinned && body_size > m_max_size)
+            return false;
+        if (pinned)
+            erase_pinned(key.virt_path, key.codec);
+        auto i = m_index.find(key);
+        if (i != m_index.end())
+            erase(i);
+
+        Slot slot;
+        slot.entry.body = std::move(body);
+        slot.entry.uncompressed_body_size = entry.uncompressed_body_size;
+        slot.entry.compressed_body_size = entry.compressed_body_size;
+        slot.entry.body_is_compressed = entry.body_is_compressed;
+        slot.entry.download_progress = entry.download_progress;
+        slot.entry.downloadable_bytes = entry.downloadable_bytes;
+        slot.entry.num_changesets = entry.num_changesets;
+        slot.entry.accum_original_size = entry.accum_original_size;
+        slot.entry.accum_compacted_size = entry.accum_compacted_size;
+        slot.pinned = pinned;
+        m_lru.push_front(std::move(slot)); // Throws
+        auto j = m_lru.begin();
+        try {
+            auto p = m_index.emplace(std::move(key), j); // Throws
+            j->index_pos = p.first;
+        }
+        catch (...) {
+            m_lru.pop_front();
+            throw;
+        }
+        if (pinned) {
+            m_pinned_size += body_size;
+        }
+        else {
+            m_size += body_size;
+            evict();
+        }
+        return true;
+    }
+
+    // Discard all entries associated with the specified server file.
+    void erase_file(const std::string& virt_path) noexcept
+    {
+        auto i = m_index.lower_bound(Key{virt_path, 0, 0, 0, 0, 0, _impl::compression::Codec::none});
+        while (i != m_index.end() && i->first.virt_path == virt_path)
+            i = erase(i);
+    }
+
+    // Discard the pinned entry associated with the specified server file and
+    // codec, if any. Unpinned entries of the file are retained.
+    void erase_pinned(const std::string& virt_path, _impl::compression::Codec codec) noexcept
+    {
+        auto i = m_index.lower_bound(Key{virt_path, 0, 0, 0, 0, 0, _impl::compression::Codec::none});
+        while (i != m_index.end() && i->first.virt_path == virt_path) {
+            if (i->second->pinned && i->first.codec == codec) {
+                i = erase(i);
+                continue;
+            }
+            ++i;
+        }
+    }
+
+    // Accumulated size of the cached bodies, excluding pinned entries.
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    std::size_t pinned_size() const noexcept
+    {
+        return m_pinned_size;
+    }
+
+    std::size_t num_entries() const noexcept
+    {
+        return m_index.size();
+    }
+
+private:
+    struct Slot;
+    using List = std::list<Slot>;
+    using Index = std::map<Key, List::iterator>;
+
+    struct Slot {
+        DownloadCacheEntry entry;
+        bool pinned;
+        Index::iterator index_pos;
+    };
+
+    const std::size_t m_max_size;
+    std::size_t m_size = 0;
+    std::size_t m_pinned_size = 0;
+
+    // Most recently used first.
+    List m_lru;
+    Index m_index;
+
+    Index::iterator erase(Index::iterator i) noexcept
+    {
+        List::iterator j = i->second;
+        std::size_t body_size = j->entry.get_body_size();
+        if (j->pinned) {
+            m_pinned_size -= body_size;
+        }
+        else {
+            m_size -= body_size;
+        }
+        m_lru.erase(j);
+        return m_index.erase(i);
+    }
+
+    void evict() noexcept
+    {
+        auto i = m_lru.end();
+        while (m_size > m_max_size && i != m_lru.begin()) {
+            --i;
+            if (i->pinned)
+                continue;
+            auto j = i;
+            ++i;
+            erase(j->index_pos);
+        }
+    }
+};
+
+
+// A state Realm is a client-side Realm file produced from a snapshot of a
+// server-side file (see ServerFile::worker_produce_state_realm()). Unless the
+// server-side files are encrypted, it is stored compressed in blocks (see
+// compression::compress_file_in_blocks()), otherwise it is stored as a Realm
+// file encrypted with the same key, and compressed as it is sent (see
+// compression::extract_blocks_from_file()).
+//
+// References are only held by the thread that executes the event loop of the
+// network shard that serves the server file. When the last reference has gone away, which may be well after the
+// state Realm has been superseded by a newer one, the file is removed by the
+// worker thread as part of the next work unit of the server file (see
+// ServerFile::unblock_work()).
+struct StateRealm {
+    SaltedVersion server_version;
+    std::string path;
+};
+
+
+// Copies the contents of the class tables of a server-side Realm into an
+// empty client-side Realm, as part of producing a state Realm. Top-level
+// objects keep their primary keys, or their object identifiers if they have
+// no primary key, as that is what synchronization identifies them by. Embedded
+// objects are copied along with their parent objects.
+//
+// Embedded objects can only be copied when they are referred to by a link
+// column or a list of links. An std::runtime_error is thrown for any other
+// reference to an embedded object, in which case the state Realm must not be
+// used.
+class StateRealmCopier {
+public:
+    StateRealmCopier(const Transaction& src, Transaction& dst) noexcept
+        : m_src{src}
+        , m_dst{dst}
+    {
+    }
+
+    void copy()
+    {
+        copy_tables();  // Throws
+        copy_columns(); // Throws
+        copy_objects(); // Throws
+    }
+
+private:
+    struct TableInfo {
+        ConstTableRef src;
+        TableRef dst;
+        // All columns of the source table except the primary key column,
+        // paired with the corresponding columns of the target table
+        std::vector<std::pair<ColKey, ColKey>> columns;
+    };
+
+    const Transaction& m_src;
+    Transaction& m_dst;
+    std::map<TableKey, TableInfo> m_tables; // Keyed by source table
+
+    void copy_tables()
+    {
+        for (TableKey key : m_src.get_table_keys()) {
+            ConstTableRef table = m_src.get_table(key);
+            StringData name = table->get_name();
+            if (!name.begins_with("class_"))
+                continue;
+            TableRef table_2;
+            if (table->is_embedded()) {
+                table_2 = m_dst.add_embedded_table(name); // Throws
+            }
+            else if (ColKey pk_col = table->get_primary_key_column()) {
+                table_2 = m_dst.add_table_with_primary_key(name, table->get_column_type(pk_col),
+                                                           table->get_column_name(pk_col),
+                                                           table->is_nullable(pk_col)); // Throws
+            }
+            else {
+                table_2 = sync::create_table(m_dst, name); // Throws
+            }
+            m_tables[key] = TableInfo{table, table_2, {}}; // Throws
+        }
+    }
+
+    void copy_columns()
+    {
+        for (auto& entry : m_tables) {
+            TableInfo& info = entry.second;
+            const Table& table = *info.src;
+            Table& table_2 = *info.dst;
+            ColKey pk_col = table.get_primary_key_column();
+            for (ColKey col : table.get_column_keys()) {
+                if (col == pk_col)
+                    continue;
+                StringData name = table.get_column_name(col);
+                ColKey col_2;
+                if (Table::is_link_type(col.get_type())) {
+                    Table& target = *get_target(info, col).dst;
+                    if (col.is_list() || col.get_type() == col_type_LinkList) {
+                        col_2 = table_2.add_column_list(target, name); // Throws
+                    }
+                    else if (col.is_set()) {
+                        col_2 = table_2.add_column_set(target, name); // Throws
+                    }
+                    else if (col.is_dictionary()) {
+                        col_2 = table_2.add_column_dictionary(target, name,
+                                                              table.get_dictionary_key_type(col)); // Throws
+                    }
+                    else {
+                        col_2 = table_2.add_column(target, name); // Throws
+                    }
+                }
+                else {
+                    DataType type = table.get_column_type(col);
+                    bool nullable = table.is_nullable(col);
+                    if (col.is_list()) {
+                        col_2 = table_2.add_column_list(type, name, nullable); // Throws
+                    }
+                    else if (col.is_set()) {
+                        col_2 = table_2.add_column_set(type, name, nullable); // Throws
+                    }
+                    else if (col.is_dictionary()) {
+                        col_2 = table_2.add_column_dictionary(type, name,
+                                                              table.get_dictionary_key_type(col)); // Throws
+                    }
+                    else {
+                        col_2 = table_2.add_column(type, name, nullable); // Throws
+                    }
+                }
+                if (table.has_search_index(col))
+                    table_2.add_search_index(col_2); // Throws
+                info.columns.emplace_back(col, col_2); // Throws
+            }
+        }
+    }
+
+    void copy_objects()
+    {
+        // All top-level objects are created before any values are copied, such
+        // that links between them can be established.
+        for (auto& entry : m_tables) {
+            TableInfo& info = entry.second;
+            if (info.src->is_embedded())
+                continue;
+            ColKey pk_col = info.src->get_primary_key_column();
+            for (const Obj& obj : *info.src) {
+                if (pk_col) {
+                    info.dst->create_object_with_primary_key(obj.get_any(pk_col)); // Throws
+                }
+                else {
+                    info.dst->create_object(obj.get_object_id()); // Throws
+                }
+            }
+        }
+        for (auto& entry : m_tables) {
+            TableInfo& info = entry.second;
+            if (info.src->is_embedded())
+                continue;
+            for (const Obj& obj : *info.src) {
+                Obj obj_2 = info.dst->get_object(translate(info, obj.get_key()));
+                copy_values(info, obj, obj_2); // Throws
+            }
+        }
+    }
+
+    void copy_values(TableInfo& info, const Obj& obj, Obj& obj_2)
+    {
+        for (const auto& pair : info.columns) {
+            ColKey col = pair.first, col_2 = pair.second;
+            if (col.get_type() == col_type_LinkList || (col.is_list() && col.get_type() == col_type_Link)) {
+                TableInfo& target = get_target(info, col);
+                LnkLst list = obj.get_linklist(col);
+                LnkLst list_2 = obj_2.get_linklist(col_2);
+                for (size_t i = 0; i < list.size(); ++i) {
+                    ObjKey key = list.get(i);
+                    if (target.src->is_embedded()) {
+                        Obj embedded_2 = list_2.create_and_insert_linked_object(i); // Throws
+                        copy_values(target, target.src->get_object(key), embedded_2);
+                    }
+                    else {
+                        list_2.add(translate(target, key)); // Throws
+                    }
+                }
+            }
+            else if (col.is_list()) {
+                LstBasePtr list = obj.get_listbase_ptr(col);
+                LstBasePtr list_2 = obj_2.get_listbase_ptr(col_2);
+                for (size_t i = 0; i < list->size(); ++i) {
+                    Mixed value = list->get_any(i);
+                    if (translate(info, col, value))
+                        list_2->insert_any(list_2->size(), value); // Throws
+                }
+            }
+            else if (col.is_set()) {
+                SetBasePtr set = obj.get_setbase_ptr(col);
+                SetBasePtr set_2 = obj_2.get_setbase_ptr(col_2);
+                for (size_t i = 0; i < set->size(); ++i) {
+                    Mixed value = set->get_any(i);
+                    if (translate(info, col, value))
+                        set_2->insert_any(value); // Throws
+                }
+            }
+            else if (col.is_dictionary()) {
+                Dictionary dict = obj.get_dictionary(col);
+                Dictionary dict_2 = obj_2.get_dictionary(col_2);
+                for (auto element : dict) {
+                    Mixed value = element.second;
+                    if (translate(info, col, value))
+                        dict_2.insert(element.first, value); // Throws
+                }
+            }
+            else if (col.get_type() == col_type_Link) {
+                if (obj.is_null(col))
+                    continue;
+                TableInfo& target = get_target(info, col);
+                ObjKey key = obj.get<ObjKey>(col);
+                if (target.src->is_embedded()) {
+                    Obj embedded_2 = obj_2.create_and_set_linked_object(col_2); // Throws
+                    copy_values(target, target.src->get_object(key), embedded_2);
+                }
+                else if (!key.is_unresolved()) {
+                    obj_2.set(col_2, translate(target, key)); // Throws
+                }
+            }
+            else {
+                Mixed value = obj.get_any(col);
+                if (!value.is_null() && translate(info, col, value))
+                    obj_2.set_any(col_2, value); // Throws
+            }
+        }
+    }
+
+    TableInfo& get_target(const TableInfo& info, ColKey col)
+    {
+        return m_tables.at(info.src->get_link_target(col)->get_key()); // Throws
+    }
+
+    ObjKey translate(const TableInfo& info, ObjKey key)
+    {
+        return info.dst->get_objkey(info.src->get_object_id(key));
+    }
+
+    // Translates a link to a top-level object in `value` to refer to the
+    // corresponding object in the target Realm. Returns false if `value` is an
+    // unresolved link, which must be left out.
+    bool translate(TableInfo& info, ColKey col, Mixed& value)
+    {
+        if (value.is_null())
+            return true;
+        TableInfo* target;
+        ObjKey key;
+        if (value.get_type() == type_Link) {
+            target = &get_target(info, col);
+            key = value.get<ObjKey>();
+        }
+        else if (value.get_type() == type_TypedLink) {
+            ObjLink link = value.get<ObjLink>();
+            target = &m_tables.at(link.get_table_key()); // Throws
+            key = link.get_obj_key();
+        }
+        else {
+            return true;
+        }
+        if (target->src->is_embedded())
+            throw std::runtime_error("Cannot copy reference to embedded object");
+        if (key.is_unresolved())
+            return false;
+        ObjKey key_2 = translate(*target, key);
+        if (value.get_type() == type_Link) {
+            value = Mixed{key_2};
+        }
+        else {
+            value = Mixed{ObjLink{target->dst->get_key(), key_2}};
+        }
+        return true;
+    }
 };
 
 
@@ -279,6 +769,7 @@ public:
 
     bool request_compaction = false;
     bool request_deletion = false;
+    bool request_state_realm = false;
 
     // Only for reference files
     bool might_produce_new_sync_version = false;
@@ -299,16 +790,27 @@ public:
 
     VersionInfo version_info;
 
+    // The point in time where the work unit was passed to the worker
+    SteadyTimePoint enqueue_time;
+
     // Result of integration of changesets from downstream clients
     IntegrationResult integration_result;
     milliseconds_type integration_duration = 0;
 
+    // The state Realm produced on request, or null if production failed.
+    std::shared_ptr<StateRealm> state_realm;
+
+    // Files of state Realms that are no longer referenced, and are to be
+    // removed by the worker thread.
+    std::vector<std::string> obsolete_state_realm_paths;
+
     void reset() noexcept
     {
         has_primary_work = false;
 
         request_compaction = false;
         request_deletion = false;
+        request_state_realm = false;
 
         might_produce_new_sync_version = false;
         group_has_compaction_requests = false;
@@ -325,6 +827,8 @@ public:
 
         version_info = {};
         integration_result = {};
+        state_realm.reset();
+        obsolete_state_realm_paths.clear();
     }
 };
 
@@ -341,6 +845,16 @@ public:
     std::unique_ptr<ServerHistory> reference_hist;
     DBRef reference_sg;
 
+    // The number of work units that were waiting in the queue of the worker
+    // when the current work unit was taken out of it.
+    std::size_t queue_length = 0;
+
+    // Work unit queue metrics keys, tagged with the number of the worker. They
+    // are not tagged with the virtual path of the file, as that would create a
+    // separate metrics series for every file served.
+    std::string queue_time_metric;
+    std::string queue_length_metric;
+
     WorkerState()
         : scratch_memory{AllocationMetricsContext::get_current().get_metric(g_worker_scratch_metric)}
     {
@@ -378,19 +892,6 @@ inline SteadyTimePoint IntegrationReporterImpl::get_session_start_time() const n
 }
 
 
-// ============================ SessionQueue ============================
-
-class SessionQueue {
-public:
-    void push_back(Session*) noexcept;
-    Session* pop_front() noexcept;
-    void clear() noexcept;
-
-private:
-    Session* m_back = nullptr;
-};
-
-
 // ============================ FileIdentReceiver ============================
 
 class FileIdentReceiver {
@@ -521,7 +1022,7 @@ public:
     // Logger to be used by the worker thread
     util::PrefixLogger wlogger;
 
-    ServerFile(ServerImpl& server, ServerFileAccessCache& cache, const std::string& virt_path, std::string real_path,
+    ServerFile(NetworkShard& shard, Worker& worker, const std::string& virt_path, std::string real_path,
                bool disable_sync_to_disk);
     ~ServerFile() noexcept;
 
@@ -533,6 +1034,11 @@ public:
         return m_server;
     }
 
+    NetworkShard& get_shard() noexcept
+    {
+        return m_shard;
+    }
+
     const std::string& get_real_path() const noexcept
     {
         return m_file.realm_path;
@@ -573,8 +1079,6 @@ public:
         return m_version_info.sync_version;
     }
 
-    DownloadCache& get_download_cache() noexcept;
-
     void register_client_access(file_ident_type client_file_ident);
 
     using file_ident_request_type = std::int_fast64_t;
@@ -634,6 +1138,14 @@ public:
 
     void initiate_deletion(std::int_fast64_t conn_id);
 
+    // Get a state Realm for a session that asked for the state of this
+    // file. The most recently produced one is returned if it is at the latest
+    // sync version, or if the session does not need a recent one. Otherwise,
+    // production of a new one is initiated, null is returned, and the new state
+    // Realm will be passed to Session::receive_state_realm() of all sessions
+    // whose client file identifier is not yet known.
+    std::shared_ptr<StateRealm> get_state_realm(bool need_recent);
+
     // get_latest_client_version() returns the client version of the latest
     // changeset that originated from the client with the ident
     // 'client_file_ident'.
@@ -643,6 +1155,8 @@ public:
 
 private:
     ServerImpl& m_server;
+    NetworkShard& m_shard;
+    Worker& m_worker;
     ServerFileAccessCache::Slot m_file;
     const ClientFileBlacklist m_client_file_blacklist; // Sorted ascendingly
 
@@ -741,6 +1255,17 @@ private:
     // `m_has_blocked_work`).
     bool m_request_deletion = false;
 
+    // A value of true counts towards outstanding blocked work (see
+    // `m_has_blocked_work`).
+    bool m_request_state_realm = false;
+
+    // The most recently produced state Realm, if any.
+    std::shared_ptr<StateRealm> m_state_realm;
+
+    // All state Realms whose files have not yet been handed over to the
+    // worker thread for removal, including `m_state_realm`.
+    std::vector<std::pair<std::weak_ptr<StateRealm>, std::string>> m_produced_state_realms;
+
     // A file, that is not a partial file, is considered *exposed to the worker
     // thread* from the point in time where it is submitted to the worker
     // (Worker::enqueue()) and up until the point in time where
@@ -796,8 +1321,6 @@ private:
     // must be rejected at receipt of the BIND message.
     bool m_realm_deletion_is_ongoing = false;
 
-    DownloadCache m_download_cache;
-
     static ClientFileBlacklist make_client_file_blacklist(const ServerImpl&, const std::string& virt_path);
 
     void changesets_from_downstream_added(std::size_t num_changesets, std::size_t num_bytes) noexcept;
@@ -809,10 +1332,13 @@ private:
 
     /// Resume history scanning in all sessions bound to this file. To be called
     /// after a successfull integration of a changeset.
-    void resume_download() noexcept;
+    void resume_download();
+
+    std::string get_state_realm_dir() const;
 
     // NOTE: These functions are executed by the worker thread
     void worker_allocate_file_identifiers();
+    void worker_produce_state_realm();
     bool worker_integrate_changes_from_downstream(WorkerState&);
     ServerHistory& get_client_file_history(WorkerState& state, std::unique_ptr<ServerHistory>& hist_ptr,
                                            DBRef& sg_ptr);
@@ -830,6 +1356,7 @@ private:
     bool group_perform_file_deletions();
     void perform_file_deletion();
     void perform_file_deletion_after_state_realm_deletion();
+    void collect_obsolete_state_realms();
 
     // Overriding member functions in CompactionControl
     LastClientAccessesRange get_last_client_accesses() override final;
@@ -837,11 +1364,6 @@ private:
 };
 
 
-inline DownloadCache& ServerFile::get_download_cache() noexcept
-{
-    return m_download_cache;
-}
-
 inline void ServerFile::changesets_from_downstream_added(std::size_t num_changesets, std::size_t num_bytes) noexcept
 {
     bool first_changeset = (m_group_blocked_changesets_from_downstream_stats.num_changesets == 0);
@@ -874,18 +1396,27 @@ inline void ServerFile::group_finalize_work_stage_2()
 // ============================ Worker ============================
 
 // All write transaction on server-side Realm files performed on behalf of the
-// server, must be performed by the worker thread, not the network event loop
+// server, must be performed by a worker thread, not the network event loop
 // thread. This is to ensure that the network event loop thread never gets
 // blocked waiting for the worker thread to end a long running write
 // transaction.
 //
+// There is one Worker object, and one thread, per integration worker (see
+// Server::Config::num_integration_workers). Each server file is assigned to
+// one worker when it is created, and all its work units are executed by that
+// worker. Consequently, work units of a particular file are executed in order,
+// while work units of files assigned to different workers are executed
+// concurrently. Each worker has its own file access cache, transformer, and
+// integration reporter, so workers share no mutable state other than the
+// metrics object.
+//
 // FIXME: Currently, the event loop thread does perform a number of write
 // transactions, but only on subtier nodes of a star topology server cluster.
 class Worker : public ServerHistory::Context {
 public:
     util::PrefixLogger logger;
 
-    explicit Worker(ServerImpl&);
+    Worker(ServerImpl&, int worker_ndx, const std::string& logger_prefix, long max_open_files);
 
     ServerFileAccessCache& get_file_access_cache() noexcept;
     SteadyTimePoint get_integration_session_start_time() const noexcept;
@@ -937,77 +1468,317 @@ inline SteadyTimePoint Worker::get_integration_session_start_time() const noexce
 }
 
 
-// ============================ ServerImpl ============================
+// ============================ NetworkShard ============================
 
-class ServerImpl : public ServerImplBase, public ServerHistory::Context {
-public:
-    std::uint_fast64_t errors_seen = 0;
+// A message produced by a session, when it was granted an opportunity to send
+// (see NetworkShard::send_session_message()). The message is written to the
+// socket by the sync connection that the session is associated with.
+//
+// If `body_size` is zero, `head` holds the entire message. Otherwise the
+// message is completed by the body, which is written directly from the memory
+// that is kept alive by `body_owner`. `head` is empty if the session had
+// nothing to send.
+struct OutgoingMessage {
+    std::vector<char> head;
+    const char* body = nullptr;
+    std::size_t body_size = 0;
+    std::shared_ptr<const void> body_owner;
+
+    // True if the session wants another opportunity to send a message.
+    bool enlist = false;
+
+    // True if the session has sent its ERROR message, which means that the
+    // session will be destroyed when the UNBIND message is received.
+    bool error_message_sent = false;
+};
 
-    std::atomic<milliseconds_type> m_par_time;
-    std::atomic<milliseconds_type> m_seq_time;
 
-    util::Mutex last_client_accesses_mutex;
+// The parts of the state of a sync connection that are needed by the sessions
+// associated with it. It is shared by the connection and its sessions, and it
+// is immutable, so it may be accessed by any thread.
+struct SyncConnectionInfo {
+    const std::int_fast64_t id;
 
-    util::Logger& logger;
+    // The protocol version in use by the connected client.
+    const int client_protocol_version;
 
-    util::network::Service& get_service() noexcept
-    {
-        return m_service;
-    }
+    // The codec that UPLOAD and DOWNLOAD message bodies are compressed with.
+    const _impl::compression::Codec compression_codec;
 
-    const util::network::Service& get_service() const noexcept
-    {
-        return m_service;
-    }
+    // The user agent description passed by the client.
+    const std::string client_user_agent;
 
-    std::mt19937_64& get_random() noexcept
-    {
-        return m_random;
-    }
+    const std::string remote_endpoint;
 
-    const Server::Config& get_config() const noexcept
-    {
-        return m_config;
-    }
+    util::PrefixLogger logger;
+};
 
-    std::size_t get_max_upload_backlog() const noexcept
-    {
-        return m_max_upload_backlog;
-    }
 
-    const std::string& get_root_dir() const noexcept
-    {
-        return m_root_dir;
-    }
+// A network shard is an event loop, executed by a dedicated thread, together
+// with the client connections that are assigned to it, the server files that
+// are pinned to it, and the sessions that are bound to those server files. All
+// of these objects are accessed only by the thread that executes the event
+// loop of the network shard that owns them. In particular, each server file is
+// accessed by one thread only, apart from the work units that are carried out
+// by its worker (see Worker).
+//
+// Connections are assigned to network shards in round-robin order as they are
+// accepted. Server files are pinned to network shards according to a hash of
+// their virtual paths (see ServerImpl::get_file_shard()). A sync connection is
+// responsible for socket I/O, SSL/TLS, WebSocket framing, message parsing and
+// decompression, and batching of outgoing messages. A session is owned by the
+// network shard of the server file that it is bound to, which need not be the
+// network shard of its connection. That network shard processes the messages
+// received on behalf of the session, and produces the messages sent by it,
+// including the assembly and compression of DOWNLOAD messages. Messages are
+// passed between the two network shards by posting handlers to their event
+// loops. Since connections and sessions may be destroyed while such a handler
+// is in flight, handlers refer to connections and sessions only by their
+// identifiers.
+//
+// When Server::Config::num_network_shards is zero, there is only one network
+// shard, and it uses the main event loop (ServerImpl::get_service()).
+class NetworkShard : public ServerHistory::Context {
+public:
+    // If `service` is null, the network shard gets an event loop of its own,
+    // which must be executed by a dedicated thread (see is_threaded()).
+    NetworkShard(ServerImpl&, util::network::Service* service, long max_open_files,
+                 std::size_t download_cache_max_size);
+    ~NetworkShard() noexcept;
+
+    ServerImpl& get_server() noexcept;
+    util::network::Service& get_service() noexcept;
+    std::mt19937_64& get_random() noexcept;
+    ServerProtocol& get_server_protocol() noexcept;
+    _impl::compression::CompressMemoryArena& get_compress_memory_arena() noexcept;
+    MiscBuffers& get_misc_buffers() noexcept;
+    DownloadCache& get_download_cache() noexcept;
+    ServerFileAccessCache& get_file_access_cache() noexcept;
 
-    util::network::ssl::Context& get_ssl_context() noexcept
-    {
-        return *m_ssl_context;
-    }
+    bool is_threaded() const noexcept;
 
-    const AccessControl& get_access_control() const noexcept
-    {
-        return m_access_control;
-    }
+    // Execute the specified handler on the event loop of this network shard.
+    // May be called by any thread.
+    template <class H>
+    void post(H handler);
 
-    ProtocolVersionRange get_protocol_version_range() const noexcept
-    {
-        return m_protocol_version_range;
-    }
+    HTTPConnection* get_http_connection(std::int_fast64_t conn_id) noexcept;
+    void add_http_connection(std::unique_ptr<HTTPConnection>);
+    void remove_http_connection(std::int_fast64_t conn_id) noexcept;
 
-    ServerProtocol& get_server_protocol() noexcept
-    {
-        return m_server_protocol;
-    }
+    SyncConnection* get_sync_connection(std::int_fast64_t conn_id) noexcept;
+    void add_sync_connection(std::unique_ptr<SyncConnection>);
+    void remove_sync_connection(std::int_fast64_t conn_id) noexcept;
+
+    // These may be called by any thread.
+    std::size_t get_number_of_http_connections() const noexcept;
+    std::size_t get_number_of_sync_connections() const noexcept;
+
+    Session* get_session(std::int_fast64_t conn_id, session_ident_type) noexcept;
+    Session& create_session(std::shared_ptr<SyncConnectionInfo>, session_ident_type);
+
+    // Destroy the specified session, and let its connection know, unless
+    // `notify_connection` is false.
+    void discard_session(std::int_fast64_t conn_id, session_ident_type, bool notify_connection = true);
+
+    // Terminate and destroy all the sessions of the specified connection that
+    // are owned by this network shard.
+    void terminate_sessions(std::int_fast64_t conn_id);
+
+    // Grant the specified session an opportunity to send a message, and pass
+    // the resulting message back to the connection (see
+    // SyncConnection::receive_session_message()). A message is always passed
+    // back, even if the session no longer exists.
+    void send_session_message(std::int_fast64_t conn_id, session_ident_type);
+
+    // True if the specified session is currently executing
+    // Session::send_message().
+    bool is_sending_session(const Session*) const noexcept;
+
+    // While a session is executing Session::send_message(), it should get the
+    // output buffer and insert a message, after which it calls
+    // initiate_write_output_buffer(). If `body_size` is nonzero, the message
+    // is completed by the specified body, which is not copied, and is kept
+    // alive by `body_owner` until it has been written.
+    OutputBuffer& get_output_buffer();
+    void initiate_write_output_buffer(const char* body = nullptr, std::size_t body_size = 0,
+                                      std::shared_ptr<const void> body_owner = nullptr);
+
+    // virt_path must be valid when get_or_create_file() is called, and the
+    // file must be pinned to this network shard.
+    util::bind_ptr<ServerFile> get_or_create_file(const std::string& virt_path);
+    util::bind_ptr<ServerFile> get_file(const std::string& virt_path) noexcept;
+    void remove_file(const std::string& virt_path);
 
-    _impl::compression::CompressMemoryArena& get_compress_memory_arena() noexcept
-    {
-        return m_compress_memory_arena;
-    }
+    void reap_connections(SteadyTimePoint now);
+    void close_connections();
+
+    // Overriding member functions in _impl::ServerHistory::Context
+    bool owner_is_sync_server() const noexcept override final;
+    std::mt19937_64& server_history_get_random() noexcept override final;
+    bool get_compaction_params(bool&, std::chrono::seconds&, std::chrono::seconds&) noexcept override final;
+    Clock::time_point get_compaction_clock_now() const noexcept override final;
+
+private:
+    ServerImpl& m_server;
+    std::unique_ptr<util::network::Service> m_own_service;
+    util::network::Service& m_service;
+    Optional<util::network::DeadlineTimer> m_keep_running_timer;
+    AllocationMetricsContext& m_allocation_metrics_context;
+    std::mt19937_64 m_random;
+    ServerFileAccessCache m_file_access_cache;
+    ServerProtocol m_server_protocol;
+    _impl::compression::CompressMemoryArena m_compress_memory_arena;
+    MiscBuffers m_misc_buffers;
+    DownloadCache m_download_cache;
+    OutputBuffer m_output_buffer;
+
+    // Not null while a session is executing Session::send_message().
+    Session* m_sending_session = nullptr;
+    OutgoingMessage* m_outgoing_message = nullptr;
+
+    std::map<std::string, util::bind_ptr<ServerFile>> m_files; // Key is virtual path
+    std::map<std::int_fast64_t, std::unique_ptr<HTTPConnection>> m_http_connections;
+    std::map<std::int_fast64_t, std::unique_ptr<SyncConnection>> m_sync_connections;
+    std::atomic<std::size_t> m_num_http_connections{0};
+    std::atomic<std::size_t> m_num_sync_connections{0};
+
+    // Sessions by connection identifier. Sessions must be destroyed before
+    // the server files that they are bound to.
+    std::map<std::int_fast64_t, std::map<session_ident_type, std::unique_ptr<Session>>> m_sessions;
+
+    void start_keep_running_timer();
+
+    void run();
+    void stop() noexcept;
+
+    friend class util::ThreadExecGuardWithParent<NetworkShard, ServerImpl>;
+};
+
+
+inline ServerImpl& NetworkShard::get_server() noexcept
+{
+    return m_server;
+}
+
+inline util::network::Service& NetworkShard::get_service() noexcept
+{
+    return m_service;
+}
+
+inline std::mt19937_64& NetworkShard::get_random() noexcept
+{
+    return m_random;
+}
+
+inline ServerProtocol& NetworkShard::get_server_protocol() noexcept
+{
+    return m_server_protocol;
+}
+
+inline _impl::compression::CompressMemoryArena& NetworkShard::get_compress_memory_arena() noexcept
+{
+    return m_compress_memory_arena;
+}
+
+inline MiscBuffers& NetworkShard::get_misc_buffers() noexcept
+{
+    return m_misc_buffers;
+}
+
+inline DownloadCache& NetworkShard::get_download_cache() noexcept
+{
+    return m_download_cache;
+}
+
+inline ServerFileAccessCache& NetworkShard::get_file_access_cache() noexcept
+{
+    return m_file_access_cache;
+}
+
+inline bool NetworkShard::is_threaded() const noexcept
+{
+    return bool(m_own_service);
+}
+
+template <class H>
+inline void NetworkShard::post(H handler)
+{
+    m_service.post(std::move(handler)); // Throws
+}
 
-    MiscBuffers& get_misc_buffers() noexcept
+inline std::size_t NetworkShard::get_number_of_http_connections() const noexcept
+{
+    return m_num_http_connections;
+}
+
+inline std::size_t NetworkShard::get_number_of_sync_connections() const noexcept
+{
+    return m_num_sync_connections;
+}
+
+inline bool NetworkShard::is_sending_session(const Session* sess) const noexcept
+{
+    return (sess == m_sending_session);
+}
+
+
+// ============================ ServerImpl ============================
+
+class ServerImpl : public ServerImplBase, public ServerHistory::Context {
+public:
+    std::uint_fast64_t errors_seen = 0;
+
+    std::atomic<milliseconds_type> m_par_time;
+    std::atomic<milliseconds_type> m_seq_time;
+
+    util::Mutex last_client_accesses_mutex;
+
+    util::Logger& logger;
+
+    util::network::Service& get_service() noexcept
+    {
+        return m_service;
+    }
+
+    const util::network::Service& get_service() const noexcept
+    {
+        return m_service;
+    }
+
+    std::mt19937_64& get_random() noexcept
+    {
+        return m_random;
+    }
+
+    const Server::Config& get_config() const noexcept
+    {
+        return m_config;
+    }
+
+    std::size_t get_max_upload_backlog() const noexcept
+    {
+        return m_max_upload_backlog;
+    }
+
+    const std::string& get_root_dir() const noexcept
+    {
+        return m_root_dir;
+    }
+
+    util::network::ssl::Context& get_ssl_context() noexcept
+    {
+        return *m_ssl_context;
+    }
+
+    const AccessControl& get_access_control() const noexcept
+    {
+        return m_access_control;
+    }
+
+    ProtocolVersionRange get_protocol_version_range() const noexcept
     {
-        return m_misc_buffers;
+        return m_protocol_version_range;
     }
 
     int_fast64_t get_current_server_session_ident() const noexcept
@@ -1030,11 +1801,37 @@ public:
         return m_scratch_memory;
     }
 
-    Worker& get_worker() noexcept
+    // Assign a worker to a new server file (round-robin). May be called by
+    // any network shard.
+    Worker& assign_worker() noexcept
+    {
+        std::size_t i = m_next_worker++;
+        return *m_workers[i % m_workers.size()];
+    }
+
+    // The network shard that a connection was assigned to when it was
+    // accepted.
+    NetworkShard& get_connection_shard(std::int_fast64_t conn_id) noexcept
     {
-        return m_worker;
+        std::size_t i = std::size_t(conn_id - 1);
+        return *m_network_shards[i % m_network_shards.size()];
     }
 
+    // The network shard that the specified server file is pinned to.
+    NetworkShard& get_file_shard(const std::string& virt_path) noexcept
+    {
+        std::size_t i = std::hash<std::string>{}(virt_path);
+        return *m_network_shards[i % m_network_shards.size()];
+    }
+
+    // Execute the specified handler on the network shard of the specified
+    // connection, but only if the connection still exists by then. These may
+    // be called by any thread.
+    template <class H>
+    void post_to_http_connection(std::int_fast64_t conn_id, H handler);
+    template <class H>
+    void post_to_sync_connection(std::int_fast64_t conn_id, H handler);
+
     void get_workunit_timers(milliseconds_type& parallel_section, milliseconds_type& sequential_section)
     {
         parallel_section = m_par_time;
@@ -1065,80 +1862,25 @@ public:
 
     void report_event_loop_metrics(std::function<EventLoopMetricsHandler>);
 
-    HTTPConnection* get_http_connection(std::int_fast64_t conn_id) noexcept;
-
-    void remove_http_connection(std::int_fast64_t conn_id) noexcept;
-
-    void add_sync_connection(int_fast64_t connection_id, std::unique_ptr<SyncConnection>&& sync_conn);
-    void remove_sync_connection(int_fast64_t connection_id);
-
-    size_t get_number_of_http_connections()
-    {
-        return m_http_connections.size();
-    }
-
-    size_t get_number_of_sync_connections()
-    {
-        return m_sync_connections.size();
-    }
+    std::size_t get_number_of_http_connections() const noexcept;
+    std::size_t get_number_of_sync_connections() const noexcept;
 
-    bool is_sync_stopped()
+    bool is_sync_stopped() const noexcept
     {
         return m_sync_stopped;
     }
 
-    const std::set<std::string>& get_realm_names() const noexcept
-    {
-        return m_realm_names;
-    }
-
-    // virt_path must be valid when get_or_create_file() is called.
-    util::bind_ptr<ServerFile> get_or_create_file(const std::string& virt_path)
-    {
-        util::bind_ptr<ServerFile> file = get_file(virt_path);
-        if (REALM_LIKELY(file))
-            return file;
-
-        _impl::VirtualPathComponents virt_path_components =
-            _impl::parse_virtual_path(m_root_dir, virt_path); // Throws
-        REALM_ASSERT(virt_path_components.is_valid);
-
-        _impl::make_dirs(m_root_dir, virt_path);  // Throws
-        auto p = m_realm_names.insert(virt_path); // Throws
-        bool was_inserted = p.second;
-        if (was_inserted)
-            metrics().gauge("realms.all", double(m_realm_names.size())); // Throws
-        {
-            bool disable_sync_to_disk = m_config.disable_sync_to_disk;
-            // Set metrics scope when constructing the ServerFile object to
-            // ensure that all metered members of ServerFile get initialized
-            // with the correct metric name.
-            AllocationMetricNameScope scope{g_worker_queue_metric};
-            file.reset(new ServerFile(*this, m_file_access_cache, virt_path, virt_path_components.real_realm_path,
-                                      disable_sync_to_disk)); // Throws
-        }
-
-        file->initialize();
-        m_files[virt_path] = file; // Throws
-        file->activate();          // Throws
-        return file;
-    }
+    // These may be called by any thread.
+    std::set<std::string> get_realm_names() const;
+    bool has_realm_name(const std::string& virt_path) const;
+    void add_realm_name(const std::string& virt_path);
+    void remove_realm_name(const std::string& virt_path);
 
     std::unique_ptr<ServerHistory> make_history_for_path(std::string path, CompactionControl& cc)
     {
         return std::make_unique<ServerHistory>(path, *this, cc);
     }
 
-    util::bind_ptr<ServerFile> get_file(const std::string& virt_path) noexcept
-    {
-        auto i = m_files.find(virt_path);
-        if (REALM_LIKELY(i != m_files.end()))
-            return i->second;
-        return {};
-    }
-
-    void remove_file(const std::string& virt_path);
-
     // Returns the number of seconds since the Epoch of
     // std::chrono::system_clock.
     std::chrono::system_clock::time_point token_expiration_clock_now() const noexcept
@@ -1150,6 +1892,11 @@ public:
 
     void set_connection_reaper_timeout(milliseconds_type);
 
+    milliseconds_type get_connection_reaper_timeout() const noexcept
+    {
+        return m_connection_reaper_timeout;
+    }
+
     void close_connections();
     bool map_virtual_to_real_path(const std::string& virt_path, std::string& real_path);
 
@@ -1160,14 +1907,6 @@ public:
 
     void initiate_compact_realm(std::int_fast64_t conn_id, StringData virt_path);
 
-    // Server global outputbuffers that can be reused.
-    // The server is single threaded, so there are no
-    // synchronization issues.
-    // output_buffers_count is equal to the
-    // maximum number of buffers needed at any point.
-    static constexpr int output_buffers_count = 1;
-    OutputBuffer output_buffers[output_buffers_count];
-
     bool is_load_balancing_allowed() const
     {
         return m_allow_load_balancing;
@@ -1185,11 +1924,12 @@ public:
     // `upload.pending.bytes`) of the total byte size of pending changesets from
     // downstream clients.
     //
-    // These functions must be called on the network thread.
+    // These functions may be called by any network shard.
     void inc_byte_size_for_pending_downstream_changesets(std::size_t byte_size);
     void dec_byte_size_for_pending_downstream_changesets(std::size_t byte_size);
 
-    void inc_num_outstanding_compaction_processes() noexcept;
+    // Must be called by a network shard when it has completed the compaction
+    // of a server file, that was initiated by initiate_compact_realm().
     void dec_num_outstanding_compaction_processes();
 
     // Overriding member functions in _impl::ServerHistory::Context
@@ -1214,6 +1954,8 @@ private:
     // runs out of file descriptors.
     std::unique_ptr<File> m_reserved_files[5];
 
+    mutable util::Mutex m_realm_names_mutex;
+
     // The set of all Realm files known to this server, represented by their
     // virtual path.
     //
@@ -1221,22 +1963,21 @@ private:
     // reported by an invocation of _impl::get_realm_names()), then the
     // corresponding virtual path is in `m_realm_names`, assuming no external
     // file-system level intervention.
-    std::set<std::string> m_realm_names;
+    std::set<std::string> m_realm_names; // Protected by `m_realm_names_mutex`
 
     std::unique_ptr<util::network::ssl::Context> m_ssl_context;
-    ServerFileAccessCache m_file_access_cache;
     Metrics& m_metrics;
-    Worker m_worker;
-    std::map<std::string, util::bind_ptr<ServerFile>> m_files; // Key is virtual path
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<std::size_t> m_next_worker{0};
     util::network::Acceptor m_acceptor;
+
+    // Never empty (see NetworkShard).
+    std::vector<std::unique_ptr<NetworkShard>> m_network_shards;
+
     std::int_fast64_t m_next_conn_id = 0;
     std::unique_ptr<HTTPConnection> m_next_http_conn;
     util::network::Endpoint m_next_http_conn_endpoint;
-    std::map<std::int_fast64_t, std::unique_ptr<HTTPConnection>> m_http_connections;
-    std::map<std::int_fast64_t, std::unique_ptr<SyncConnection>> m_sync_connections;
-    ServerProtocol m_server_protocol;
-    _impl::compression::CompressMemoryArena m_compress_memory_arena;
-    MiscBuffers m_misc_buffers;
+    Formatter m_formatter;
     std::unique_ptr<Transformer> m_transformer;
     util::Buffer<char> m_transform_buffer;
     IntegrationReporterImpl m_integration_reporter;
@@ -1250,13 +1991,19 @@ private:
 
     // m_sync_stopped is used by stop_sync_and_wait_for_backup_completion().
     // When m_sync_stopped is true, the server does not perform any sync.
-    bool m_sync_stopped = false;
+    std::atomic<bool> m_sync_stopped{false};
 
     std::atomic<bool> m_running{false}; // Debugging facility
 
-    std::size_t m_pending_changesets_from_downstream_byte_size = 0;
+    // A copy of `m_config.connection_reaper_timeout`, which may be modified
+    // while the server is running (set_connection_reaper_timeout()).
+    std::atomic<milliseconds_type> m_connection_reaper_timeout;
+
+    std::atomic<std::size_t> m_pending_changesets_from_downstream_byte_size{0};
 
-    std::size_t m_num_outstanding_compaction_processes = 0;
+    util::Mutex m_compaction_mutex;
+
+    std::size_t m_num_outstanding_compaction_processes = 0; // Protected by `m_compaction_mutex`
 
     util::CondVar m_wait_or_service_stopped_cond; // Protected by `m_mutex`
 
@@ -1266,7 +2013,7 @@ private:
 
     util::network::DeadlineTimer m_allocation_metrics_timer;
 
-    std::int_fast64_t m_compacting_connection = 0;
+    std::int_fast64_t m_compacting_connection = 0; // Protected by `m_compaction_mutex`
 
     void listen();
     void initiate_accept();
@@ -1274,7 +2021,6 @@ private:
 
     void reap_connections();
     void initiate_connection_reaper_timer(milliseconds_type timeout);
-    void do_close_connections();
 
     static std::size_t determine_max_upload_backlog(Server::Config& config) noexcept
     {
@@ -1298,8 +2044,6 @@ private:
         return {min, max};
     }
 
-    void do_recognize_external_change(const std::string& virt_path);
-
     void initiate_allocation_metrics_wait();
     void handle_allocation_metrics_wait();
 
@@ -1312,9 +2056,26 @@ private:
                                                      milliseconds_type timeout);
 };
 
-inline void ServerImpl::inc_num_outstanding_compaction_processes() noexcept
+template <class H>
+inline void ServerImpl::post_to_http_connection(std::int_fast64_t conn_id, H handler)
+{
+    NetworkShard& shard = get_connection_shard(conn_id);
+    auto handler_2 = [&shard, conn_id, handler = std::move(handler)]() mutable {
+        if (HTTPConnection* conn = shard.get_http_connection(conn_id))
+            handler(*conn); // Throws
+    };
+    shard.post(std::move(handler_2)); // Throws
+}
+
+template <class H>
+inline void ServerImpl::post_to_sync_connection(std::int_fast64_t conn_id, H handler)
 {
-    ++m_num_outstanding_compaction_processes;
+    NetworkShard& shard = get_connection_shard(conn_id);
+    auto handler_2 = [&shard, conn_id, handler = std::move(handler)]() mutable {
+        if (SyncConnection* conn = shard.get_sync_connection(conn_id))
+            handler(*conn); // Throws
+    };
+    shard.post(std::move(handler_2)); // Throws
 }
 
 
@@ -1407,28 +2168,31 @@ class SyncConnection : public util::websocket::Config {
 public:
     util::PrefixLogger logger;
 
-    SyncConnection(ServerImpl& serv, std::int_fast64_t id, std::unique_ptr<util::network::Socket>&& socket,
+    SyncConnection(NetworkShard& shard, std::int_fast64_t id, std::unique_ptr<util::network::Socket>&& socket,
                    std::unique_ptr<util::network::ssl::Stream>&& ssl_stream,
                    std::unique_ptr<util::network::ReadAheadBuffer>&& read_ahead_buffer, int client_protocol_version,
-                   std::string client_user_agent, std::string remote_endpoint)
-        : logger{make_logger_prefix(id), serv.logger} // Throws
-        , m_server{serv}
+                   _impl::compression::Codec compression_codec, std::string client_user_agent,
+                   std::string remote_endpoint)
+        : logger{make_logger_prefix(id), shard.get_server().logger} // Throws
+        , m_server{shard.get_server()}
+        , m_shard{shard}
         , m_id{id}
         , m_socket{std::move(socket)}
         , m_ssl_stream{std::move(ssl_stream)}
         , m_read_ahead_buffer{std::move(read_ahead_buffer)}
         , m_websocket{*this}
-        , m_client_protocol_version{client_protocol_version}
-        , m_client_user_agent{std::move(client_user_agent)}
-        , m_remote_endpoint{std::move(remote_endpoint)}
+        , m_info{std::make_shared<SyncConnectionInfo>(
+              SyncConnectionInfo{id, client_protocol_version, compression_codec, std::move(client_user_agent),
+                                 std::move(remote_endpoint), util::PrefixLogger{make_logger_prefix(id),
+                                                                                shard.get_server().logger}})} // Throws
     {
         // Make the output buffer stream throw std::bad_alloc if it fails to
         // expand the buffer
         m_output_buffer.exceptions(std::ios_base::badbit | std::ios_base::failbit);
 
-        util::network::Service& service = m_server.get_service();
+        util::network::Service& service = m_shard.get_service();
         auto handler = [this] {
-            if (!m_is_sending)
+            if (!m_is_sending && !m_awaiting_session_message)
                 send_next_message(); // Throws
         };
         m_send_trigger = util::network::Trigger{service, std::move(handler)}; // Throws
@@ -1443,22 +2207,22 @@ public:
 
     ServerProtocol& get_server_protocol() noexcept
     {
-        return m_server.get_server_protocol();
+        return m_shard.get_server_protocol();
     }
 
     int get_client_protocol_version()
     {
-        return m_client_protocol_version;
+        return m_info->client_protocol_version;
     }
 
     const std::string& get_client_user_agent() const noexcept
     {
-        return m_client_user_agent;
+        return m_info->client_user_agent;
     }
 
     const std::string& get_remote_endpoint() const noexcept
     {
-        return m_remote_endpoint;
+        return m_info->remote_endpoint;
     }
 
     util::Logger& websocket_get_logger() noexcept final override
@@ -1468,7 +2232,7 @@ public:
 
     std::mt19937_64& websocket_get_random() noexcept final override
     {
-        return m_server.get_random();
+        return m_shard.get_random();
     }
 
     bool websocket_binary_message_received(const char* data, size_t size) final override
@@ -1585,6 +2349,11 @@ public:
         return get_server().gauges();
     }
 
+    bool is_closing() const noexcept
+    {
+        return m_is_closing;
+    }
+
     void initiate();
 
     // Commits suicide
@@ -1594,24 +2363,18 @@ public:
     // Commits suicide
     void terminate_if_dead(SteadyTimePoint now);
 
-    void enlist_to_send(Session*) noexcept;
-
-    // Sessions should get the output_buffer and insert a message, after which
-    // they call initiate_write_output_buffer().
-    OutputBuffer& get_output_buffer()
-    {
-        m_output_buffer.reset();
-        return m_output_buffer;
-    }
-
-    // More advanced memory strategies can be implemented if needed.
-    void release_output_buffer() {}
+    // Called on behalf of a session that wants an opportunity to send a
+    // message. Ignored if the session no longer exists, or if the connection
+    // is closing.
+    void enlist_to_send(session_ident_type);
 
-    // When this function is called, the connection will initiate a write with
-    // its output_buffer. Sessions use this method.
-    void initiate_write_output_buffer();
+    // Called when a session has been granted an opportunity to send a message
+    // (see NetworkShard::send_session_message()).
+    void receive_session_message(session_ident_type, OutgoingMessage);
 
-    void initiate_pong_output_buffer();
+    // Called when a session has been destroyed by the network shard that owns
+    // it.
+    void session_discarded(session_ident_type) noexcept;
 
     void handle_protocol_error(ServerProtocol::Error error);
 
@@ -1646,14 +2409,24 @@ public:
 
     void receive_ping(milliseconds_type timestamp, milliseconds_type rtt);
 
-    void protocol_error(ProtocolError, Session* = nullptr);
+    // Must only be used for connection level errors. Session level errors are
+    // handled by Session::protocol_error().
+    void protocol_error(ProtocolError);
 
     void initiate_soft_close();
 
-    void discard_session(session_ident_type) noexcept;
-
 private:
+    // A session that is associated with this connection. The session object
+    // itself is owned by `shard`, which is the network shard of the server
+    // file that the session is bound to.
+    struct SessionEntry {
+        NetworkShard* shard;
+        bool unbind_message_received = false;
+        bool error_message_sent = false;
+    };
+
     ServerImpl& m_server;
+    NetworkShard& m_shard;
     const int_fast64_t m_id;
     std::unique_ptr<util::network::Socket> m_socket;
     std::unique_ptr<util::network::ssl::Stream> m_ssl_stream;
@@ -1662,31 +2435,33 @@ private:
     util::websocket::Socket m_websocket;
     std::unique_ptr<char[]> m_input_body_buffer;
     OutputBuffer m_output_buffer;
-    std::map<session_ident_type, std::unique_ptr<Session>> m_sessions;
+    std::shared_ptr<const void> m_output_body_owner;
 
-    // The protocol version in use by the connected client.
-    const int m_client_protocol_version;
+    // Messages that have been produced by sessions, but not yet written to the
+    // socket. The batch is always empty, or being written, when
+    // send_next_message() returns without awaiting a session message.
+    static constexpr std::size_t s_max_write_batch_size = 0x10000; // 64 KiB
+    std::vector<char> m_batch_buffer;
+    std::vector<std::size_t> m_batch_message_sizes;
 
-    // The user agent description passed by the client.
-    const std::string m_client_user_agent;
+    std::shared_ptr<SyncConnectionInfo> m_info;
 
-    const std::string m_remote_endpoint;
+    std::map<session_ident_type, SessionEntry> m_sessions;
 
     // A queue of sessions that have enlisted for an opportunity to send a
     // message. Sessions will be served in the order that they enlist. A session
-    // can only occur once in this queue (linked list). If the queue is not
-    // empty, and no message is currently being written to the socket, the first
-    // session is taken out of the queue, and then granted an opportunity to
-    // send a message.
+    // can only occur once in this queue. If the queue is not empty, and no
+    // message is currently being written to the socket, the first session is
+    // taken out of the queue, and then granted an opportunity to send a
+    // message. Since the session may be owned by a different network shard,
+    // the connection awaits the resulting message (receive_session_message())
+    // before it serves the next session.
     //
-    // Sessions will never be destroyed while in this queue. This is ensured
-    // because the connection owns the sessions that are associated with it, and
-    // the connection only removes a session from m_sessions at points in time
-    // where that session is guaranteed to not be in m_sessions_enlisted_to_send
-    // (Connection::send_next_message() and Connection::~Connection()).
-    SessionQueue m_sessions_enlisted_to_send;
+    // Sessions may be destroyed while in this queue, in which case they are
+    // skipped.
+    util::CircularBuffer<session_ident_type> m_sessions_enlisted_to_send;
 
-    Session* m_receiving_session = nullptr;
+    bool m_awaiting_session_message = false;
 
     bool m_is_sending = false;
     bool m_is_closing = false;
@@ -1721,6 +2496,22 @@ private:
         return out.str();                         // Throws
     }
 
+    // Sessions should get the output_buffer and insert a message, after which
+    // they call initiate_write_output_buffer().
+    OutputBuffer& get_output_buffer()
+    {
+        m_output_buffer.reset();
+        return m_output_buffer;
+    }
+
+    // More advanced memory strategies can be implemented if needed.
+    void release_output_buffer()
+    {
+        m_output_body_owner.reset();
+        m_batch_buffer.clear();
+        m_batch_message_sizes.clear();
+    }
+
     // The return value of handle_message_received() designates whether
     // message processing should continue. If the connection object is
     // destroyed during execution of handle_message_received(), the return
@@ -1732,6 +2523,26 @@ private:
     void send_next_message();
     void send_pong(milliseconds_type timestamp);
 
+    // When this function is called, the connection will initiate a write with
+    // its output_buffer.
+    //
+    // Small messages are not written immediately, but are appended to the
+    // current batch, and the remaining enlisted sessions are given a chance to
+    // contribute more messages to it. The batch is written, using a single
+    // write operation on the socket, when it is full, or when no more sessions
+    // are enlisted to send (see send_next_message()).
+    void initiate_write_output_buffer();
+
+    // Same as initiate_write_output_buffer(), except that the message is
+    // completed by the specified body. The body is not copied, but sent
+    // directly from the specified memory as a continuation frame of the
+    // WebSocket message. `body_owner` keeps the memory alive until the write
+    // has completed.
+    void initiate_write_output_buffer(const char* body, std::size_t body_size, std::shared_ptr<const void> body_owner);
+
+    void initiate_pong_output_buffer();
+
+    void initiate_write_batch();
     void handle_write_output_buffer();
     void handle_pong_output_buffer();
 
@@ -1747,9 +2558,19 @@ private:
 
     void terminate_sessions();
 
+    // Returns null, after having initiated a soft close of the connection, if
+    // the specified session does not exist, or if an UNBIND message was
+    // already received for it.
+    SessionEntry* get_session_entry(const char* message_type, session_ident_type);
+
+    // Execute the specified handler on the session, on the network shard that
+    // owns the session. If the handler fails with a session level error, the
+    // session is deactivated.
+    template <class H>
+    void post_to_session(SessionEntry&, session_ident_type, H handler);
+
     void bad_session_ident(const char* message_type, session_ident_type);
     void message_after_unbind(const char* message_type, session_ident_type);
-    void message_before_ident(const char* message_type, session_ident_type);
 };
 
 
@@ -1796,11 +2617,12 @@ class HTTPConnection {
 public:
     util::PrefixLogger logger;
 
-    HTTPConnection(ServerImpl& serv, int_fast64_t id, bool is_ssl)
-        : logger{make_logger_prefix(id), serv.logger} // Throws
-        , m_server{serv}
+    HTTPConnection(NetworkShard& shard, int_fast64_t id, bool is_ssl)
+        : logger{make_logger_prefix(id), shard.get_server().logger} // Throws
+        , m_server{shard.get_server()}
+        , m_shard{shard}
         , m_id{id}
-        , m_socket{new util::network::Socket{serv.get_service()}} // Throws
+        , m_socket{new util::network::Socket{shard.get_service()}} // Throws
         , m_read_ahead_buffer{new util::network::ReadAheadBuffer} // Throws
         , m_http_server{*this, logger}
     {
@@ -1810,7 +2632,7 @@ public:
 
         if (is_ssl) {
             using namespace util::network::ssl;
-            Context& ssl_context = serv.get_ssl_context();
+            Context& ssl_context = m_server.get_ssl_context();
             m_ssl_stream = std::make_unique<Stream>(*m_socket, ssl_context,
                                                     Stream::server); // Throws
         }
@@ -1912,7 +2734,7 @@ public:
         metrics().gauge("connection.online", --gauges().connection_online); // Throws
         m_ssl_stream.reset();
         m_socket.reset();
-        m_server.remove_http_connection(m_id); // Suicide
+        m_shard.remove_http_connection(m_id); // Suicide
     }
 
     // Commits suicide
@@ -1939,6 +2761,7 @@ public:
 
 private:
     ServerImpl& m_server;
+    NetworkShard& m_shard;
     const int_fast64_t m_id;
     std::unique_ptr<util::network::Socket> m_socket;
     std::unique_ptr<util::network::ssl::Stream> m_ssl_stream;
@@ -2034,7 +2857,7 @@ private:
 
         // Figure out whether there are any protocol versions supported by both
         // the client and the server, and if so, choose the newest one of them.
-        MiscBuffers& misc_buffers = m_server.get_misc_buffers();
+        MiscBuffers& misc_buffers = m_shard.get_misc_buffers();
         using ProtocolVersionRanges = MiscBuffers::ProtocolVersionRanges;
         ProtocolVersionRanges& protocol_version_ranges = misc_buffers.protocol_version_ranges;
         {
@@ -2197,6 +3020,23 @@ private:
             sec_websocket_protocol_2 = std::move(out).str();
         }
 
+        // Choose the first of the codecs offered by the client that is also
+        // available here. Otherwise, message bodies are compressed with zlib.
+        auto compression_codec = _impl::compression::Codec::zlib;
+        if (!m_server.get_config().disable_fast_compression) {
+            auto i = request.headers.find(get_compression_http_header_name());
+            if (i != request.headers.end()) {
+                HttpListHeaderValueParser parser{i->second};
+                util::StringView elem;
+                while (parser.next(elem)) {
+                    if (auto codec = _impl::compression::find_codec(elem)) {
+                        compression_codec = *codec;
+                        break;
+                    }
+                }
+            }
+        }
+
         std::error_code ec;
         util::Optional<HTTPResponse> response =
             websocket::make_http_response(request, sec_websocket_protocol_2, ec); // Throws
@@ -2223,6 +3063,11 @@ private:
         }
         REALM_ASSERT(response);
         add_common_http_response_headers(*response);
+        if (compression_codec != _impl::compression::Codec::zlib) {
+            const char* codec_name = _impl::compression::get_codec_name(compression_codec);
+            response->headers[get_compression_http_header_name()] = codec_name; // Throws
+            logger.debug("Negotiated compression codec: %1", codec_name);      // Throws
+        }
 
         std::string user_agent;
         {
@@ -2231,7 +3076,8 @@ private:
                 user_agent = i->second; // Throws (copy)
         }
 
-        auto handler = [negotiated_protocol_version, user_agent = std::move(user_agent), this](std::error_code ec) {
+        auto handler = [negotiated_protocol_version, compression_codec, user_agent = std::move(user_agent),
+                        this](std::error_code ec) {
             // If the operation is aborted, the socket object may have been destroyed.
             if (ec != util::error::operation_aborted) {
                 if (ec) {
@@ -2240,12 +3086,12 @@ private:
                 }
 
                 std::unique_ptr<SyncConnection> sync_conn = std::make_unique<SyncConnection>(
-                    m_server, m_id, std::move(m_socket), std::move(m_ssl_stream), std::move(m_read_ahead_buffer),
-                    negotiated_protocol_version, std::move(user_agent),
+                    m_shard, m_id, std::move(m_socket), std::move(m_ssl_stream), std::move(m_read_ahead_buffer),
+                    negotiated_protocol_version, compression_codec, std::move(user_agent),
                     std::move(m_remote_endpoint)); // Throws
                 SyncConnection& sync_conn_ref = *sync_conn;
-                m_server.add_sync_connection(m_id, std::move(sync_conn));
-                m_server.remove_http_connection(m_id);
+                m_shard.add_sync_connection(std::move(sync_conn)); // Throws
+                m_shard.remove_http_connection(m_id);
                 sync_conn_ref.initiate();
             }
         };
@@ -2284,7 +3130,7 @@ private:
         logger.detail("Request for /api/info");
         size_t number_of_http_connections = m_server.get_number_of_http_connections();
         size_t number_of_sync_connections = m_server.get_number_of_sync_connections();
-        const std::set<std::string>& realm_names = m_server.get_realm_names();
+        std::set<std::string> realm_names = m_server.get_realm_names(); // Throws
 
         std::string body = "Realm sync server\n\n";
         body += "Number of open HTTP connections: " + util::to_string(number_of_http_connections) + "\n";
@@ -2376,10 +3222,16 @@ private:
                                          "access token has no delete rights"); // Throws
                     return;
                 }
-                const std::set<std::string>& realm_names = m_server.get_realm_names();
-                if (realm_names.find(realm_path) != realm_names.end()) {
-                    util::bind_ptr<ServerFile> file = m_server.get_or_create_file(realm_path);
-                    file->initiate_deletion(m_id); // Throws
+                if (m_server.has_realm_name(realm_path)) {
+                    // The server file is pinned to a network shard, which
+                    // need not be the one of this connection.
+                    NetworkShard& shard = m_server.get_file_shard(realm_path);
+                    std::int_fast64_t conn_id = m_id;
+                    auto handler = [&shard, realm_path = std::move(realm_path), conn_id] {
+                        util::bind_ptr<ServerFile> file = shard.get_or_create_file(realm_path); // Throws
+                        file->initiate_deletion(conn_id);                                       // Throws
+                    };
+                    shard.post(std::move(handler)); // Throws
                     return;
                 }
                 handle_text_response(HTTPStatus::NotFound, "Realm not found"); // Throws
@@ -2563,37 +3415,42 @@ class Session final : private FileIdentReceiver {
 public:
     util::PrefixLogger logger;
 
-    Session(SyncConnection& conn, session_ident_type session_ident)
-        : logger{make_logger_prefix(session_ident), conn.logger} // Throws
-        , m_connection{conn}
+    Session(NetworkShard& shard, std::shared_ptr<SyncConnectionInfo> conn, session_ident_type session_ident)
+        : logger{make_logger_prefix(session_ident), conn->logger} // Throws
+        , m_shard{shard}
+        , m_connection{std::move(conn)}
         , m_session_ident{session_ident}
     {
     }
 
     ~Session() noexcept
     {
-        REALM_ASSERT(!is_enlisted_to_send());
         detach_from_server_file();
     }
 
-    SyncConnection& get_connection() noexcept
+    ServerImpl& get_server() noexcept
+    {
+        return m_shard.get_server();
+    }
+
+    std::int_fast64_t get_connection_id() const noexcept
     {
-        return m_connection;
+        return m_connection->id;
     }
 
     const Optional<std::array<char, 64>>& get_encryption_key()
     {
-        return m_connection.get_server().get_config().encryption_key;
+        return get_server().get_config().encryption_key;
     }
 
     Metrics& metrics() noexcept
     {
-        return m_connection.metrics();
+        return get_server().metrics();
     }
 
     Gauges& gauges() noexcept
     {
-        return m_connection.gauges();
+        return get_server().gauges();
     }
 
     session_ident_type get_session_ident() const noexcept
@@ -2603,7 +3460,7 @@ public:
 
     ServerProtocol& get_server_protocol() noexcept
     {
-        return m_connection.get_server_protocol();
+        return m_shard.get_server_protocol();
     }
 
     bool need_client_file_ident() const noexcept
@@ -2641,6 +3498,11 @@ public:
         return m_unbind_message_received;
     }
 
+    bool error_message_sent() const noexcept
+    {
+        return m_error_message_sent;
+    }
+
     bool error_occurred() const noexcept
     {
         return int(m_error_code) != 0;
@@ -2705,33 +3567,75 @@ public:
 
     bool expired()
     {
-        const ServerImpl& server = m_connection.get_server();
+        const ServerImpl& server = get_server();
         return (m_access_token && m_access_token->expired(server.token_expiration_clock_now()));
     }
 
     bool is_enlisted_to_send() const noexcept
     {
-        return m_next != nullptr;
+        return m_is_enlisted_to_send;
     }
 
-    void ensure_enlisted_to_send() noexcept
+    void ensure_enlisted_to_send()
     {
         if (!is_enlisted_to_send())
-            enlist_to_send();
+            enlist_to_send(); // Throws
     }
 
-    void enlist_to_send() noexcept
+    // If the session is currently sending (see
+    // NetworkShard::send_session_message()), the connection is told to
+    // enlist it again when the message is passed back.
+    void enlist_to_send()
     {
-        m_connection.enlist_to_send(this);
+        REALM_ASSERT(!m_is_enlisted_to_send);
+        m_is_enlisted_to_send = true;
+        if (m_shard.is_sending_session(this))
+            return;
+        session_ident_type session_ident = m_session_ident;
+        auto handler = [session_ident](SyncConnection& conn) {
+            conn.enlist_to_send(session_ident); // Throws
+        };
+        get_server().post_to_sync_connection(get_connection_id(), std::move(handler)); // Throws
     }
 
-    // Overriding memeber function in FileIdentReceiver
-    void receive_file_ident(SaltedFileIdent file_ident) override final
+    // Handle a protocol error that was detected while processing a message
+    // received on behalf of this session. If the error is session level, the
+    // session is deactivated. Otherwise a soft close of the connection is
+    // initiated.
+    void protocol_error(ProtocolError error_code)
     {
-        // Protocol state must be AllocatingIdent or WaitForUnbind
-        if (!ident_message_received()) {
-            REALM_ASSERT(need_client_file_ident());
-            REALM_ASSERT(m_send_ident_message);
+        if (is_session_level_error(error_code)) {
+            if (logger.would_log(util::Logger::Level::debug)) {
+                const char* message = get_protocol_error_message(int(error_code));
+                logger.debug("Protocol error: %1 (error_code=%2)", message, int(error_code)); // Throws
+            }
+            metrics().increment("session.failed"); // Throws
+            initiate_deactivation(error_code);     // Throws
+            return;
+        }
+        auto handler = [error_code](SyncConnection& conn) {
+            if (!conn.is_closing())
+                conn.protocol_error(error_code); // Throws
+        };
+        get_server().post_to_sync_connection(get_connection_id(), std::move(handler)); // Throws
+    }
+
+    // Report a message that arrived out of order for this session.
+    template <class... Params>
+    void message_order_violation(const char* message, Params... params)
+    {
+        m_connection->logger.error(message, params...); // Throws
+        protocol_error(ProtocolError::bad_message_order);  // Throws
+        metrics().increment("protocol.violated");          // Throws
+    }
+
+    // Overriding memeber function in FileIdentReceiver
+    void receive_file_ident(SaltedFileIdent file_ident) override final
+    {
+        // Protocol state must be AllocatingIdent or WaitForUnbind
+        if (!ident_message_received()) {
+            REALM_ASSERT(need_client_file_ident());
+            REALM_ASSERT(m_send_ident_message);
         }
         else {
             REALM_ASSERT(!m_send_ident_message);
@@ -2752,13 +3656,15 @@ public:
         ensure_enlisted_to_send();
     }
 
-    // Called by the associated connection object when this session is granted
-    // an opportunity to initiate the sending of a message.
+    // Called by the network shard that owns this session, when the associated
+    // connection grants this session an opportunity to initiate the sending of
+    // a message (see NetworkShard::send_session_message()).
     //
     // This function may lead to the destruction of the session object
     // (suicide).
     void send_message()
     {
+        m_is_enlisted_to_send = false;
         if (REALM_LIKELY(!unbind_message_received())) {
             if (REALM_LIKELY(!error_occurred())) {
                 if (REALM_LIKELY(!must_send_client_version_message())) {
@@ -2795,7 +3701,7 @@ public:
         // State is SendUnbound
         send_unbound_message(); // Throws
         terminate();            // Throws
-        m_connection.discard_session(m_session_ident);
+        m_shard.discard_session(get_connection_id(), m_session_ident);
         // This session is now destroyed!
     }
 
@@ -2803,7 +3709,7 @@ public:
     {
         AccessToken::ParseError error;
         Optional<AccessToken> access_token =
-            m_connection.get_server().get_access_control().verify_access_token(signed_user_token, &error);
+            get_server().get_access_control().verify_access_token(signed_user_token, &error);
         switch (error) {
             case AccessToken::ParseError::invalid_base64: {
                 logger.error("Invalid Base64 (signed_user_token='%1', is_refresh=%2)",
@@ -2860,7 +3766,7 @@ public:
                     return false;
                 }
 
-                const ServerImpl& server = m_connection.get_server();
+                const ServerImpl& server = get_server();
                 if (access_token->expired(server.token_expiration_clock_now())) {
                     logger.detail("Token expired (signed_user_token='%1', is_refresh=%2)",
                                   short_token_fmt(signed_user_token), is_refresh); // Throws
@@ -2871,7 +3777,7 @@ public:
 
                 if (access_token->sync_label) {
                     if (*access_token->sync_label != "default") {
-                        const ServerImpl& server = m_connection.get_server();
+                        const ServerImpl& server = get_server();
                         if (!server.is_load_balancing_allowed()) {
                             logger.error("Load balancing is not allowed by the feature token "
                                          "(signed_user_token='%1', is_refresh=%2)",
@@ -2905,7 +3811,7 @@ public:
 
         modify_user_sessions_metric(+1); // Throws
 
-        ServerImpl& server = m_connection.get_server();
+        ServerImpl& server = get_server();
         _impl::VirtualPathComponents virt_path_components =
             _impl::parse_virtual_path(server.get_root_dir(), path); // Throws
 
@@ -2950,7 +3856,7 @@ public:
 
         // The user has proper permissions at this stage.
 
-        m_server_file = server.get_or_create_file(path); // Throws
+        m_server_file = m_shard.get_or_create_file(path); // Throws
 
         {
             bool realm_deletion_is_ongoing = false;
@@ -2968,8 +3874,8 @@ public:
         m_server_file->add_unidentified_session(this); // Throws
 
         logger.info("Client info: (path='%1', user='%2', from=%3, protocol=%4) %5", path, m_access_token->identity,
-                    m_connection.get_remote_endpoint(), m_connection.get_client_protocol_version(),
-                    m_connection.get_client_user_agent()); // Throws
+                    m_connection->remote_endpoint, m_connection->client_protocol_version,
+                    m_connection->client_user_agent); // Throws
 
         m_is_subserver = is_subserver;
         if (REALM_LIKELY(!need_client_file_ident)) {
@@ -3002,7 +3908,7 @@ public:
             return false;
 
         const std::string& virt_path = m_server_file->get_virt_path();
-        const AccessControl& access_control = m_connection.get_server().get_access_control();
+        const AccessControl& access_control = get_server().get_access_control();
         if (!access_control.can(*m_access_token, Privilege::Download, virt_path)) {
             logger.error("Permission denied "
                          "(message_type='bind', permission='download', path='%1', "
@@ -3050,7 +3956,7 @@ public:
             return false;
         }
 
-        ServerImpl& server = m_connection.get_server();
+        ServerImpl& server = get_server();
         const std::string& virt_path = m_server_file->get_virt_path();
         const AccessControl& access_control = server.get_access_control();
         if (!access_control.can(*m_access_token, Privilege::Download, virt_path)) {
@@ -3132,10 +4038,10 @@ public:
         // Make sure there is no other session currently associcated with the
         // same client-side file
         if (Session* other_sess = m_server_file->get_identified_session(client_file_ident)) {
-            SyncConnection& other_conn = other_sess->get_connection();
+            std::int_fast64_t other_conn_id = other_sess->get_connection_id();
             // It is a protocol violation if the other session is associated
             // with the same connection
-            if (&other_conn == &m_connection) {
+            if (other_conn_id == get_connection_id()) {
                 logger.error("Client file already bound in other session associated with "
                              "the same connection");      // Throws
                 metrics().increment("protocol.violated"); // Throws
@@ -3151,10 +4057,18 @@ public:
             // connection is always due to that other connection being a
             // zombie. And when such a situation is detected, we want to close
             // the zombie connection immediately.
-            auto termination_reason = ConnectionTerminationReason::superseded_session;
-            auto log_level = Logger::Level::detail;
-            other_conn.terminate(termination_reason, log_level,
-                                 "Sync connection closed (superseded session)"); // Throws
+            //
+            // The sessions of the other connection that are bound to files
+            // pinned to this network shard are terminated right away, such
+            // that the client file is no longer bound in the other session.
+            m_shard.terminate_sessions(other_conn_id); // Throws
+            auto handler = [](SyncConnection& other_conn) {
+                auto termination_reason = ConnectionTerminationReason::superseded_session;
+                auto log_level = Logger::Level::detail;
+                other_conn.terminate(termination_reason, log_level,
+                                     "Sync connection closed (superseded session)"); // Throws
+            };
+            get_server().post_to_sync_connection(other_conn_id, std::move(handler)); // Throws
         }
 
         logger.info("Bound to client file (client_file_ident=%1)", client_file_ident); // Throws
@@ -3164,6 +4078,7 @@ public:
         m_client_file_ident = client_file_ident;
         m_download_progress = download_progress;
         m_upload_threshold = upload_threshold;
+        m_upload_progress_sent = upload_threshold;
         m_locked_server_version = locked_server_version;
 
         const Server::Config& config = server.get_config();
@@ -3278,11 +4193,42 @@ public:
             return true;
         }
 
-        logger.debug("Realm state transfer not supported on server, sending full history");
-        enlist_to_send();
+        const Server::Config& config = get_server().get_config();
+        if (config.disable_state_realms || m_server_file->get_sync_version() == 0) {
+            logger.debug("No state Realm to transfer, sending full history"); // Throws
+            enlist_to_send();
+            return true;
+        }
+
+        m_state_message_info->offset = offset;
+        m_state_message_info->server_version = partial_transferred_server_version;
+        std::shared_ptr<StateRealm> state_realm = m_server_file->get_state_realm(need_recent); // Throws
+        if (!state_realm) {
+            logger.debug("Waiting for state Realm to be produced"); // Throws
+            m_state_message_info->awaiting_state_realm = true;
+            return true;
+        }
+        begin_state_transfer(std::move(state_realm)); // Throws
         return true;
     }
 
+    // Called by the associated server file when it has produced a state Realm
+    // (see ServerFile::get_state_realm()). `state_realm` is null if none could
+    // be produced.
+    void receive_state_realm(const std::shared_ptr<StateRealm>& state_realm)
+    {
+        if (!must_send_state_message() || !m_state_message_info->awaiting_state_realm)
+            return;
+        m_state_message_info->awaiting_state_realm = false;
+        if (REALM_UNLIKELY(!state_realm)) {
+            m_state_message_info->offset = 0;
+            m_state_message_info->server_version = {0, 0};
+            ensure_enlisted_to_send();
+            return;
+        }
+        begin_state_transfer(state_realm); // Throws
+    }
+
     bool receive_upload_message(version_type progress_client_version, version_type progress_server_version,
                                 version_type locked_server_version, const UploadChangesets& upload_changesets,
                                 ProtocolError& error)
@@ -3321,7 +4267,7 @@ public:
                 return false;
             }
 
-            const AccessControl& access_control = m_connection.get_server().get_access_control();
+            const AccessControl& access_control = get_server().get_access_control();
             const std::string& virt_path = m_server_file->get_virt_path();
             if (REALM_UNLIKELY(!access_control.can(*m_access_token, Privilege::Upload, virt_path))) {
                 logger.error("Permission denied (message_type='upload', path='%1')",
@@ -3377,7 +4323,7 @@ public:
         // integrated until the next session. Therefore, we know that T = V + N
         // is less than, or qual to W. So, in all cases, B will not skipped
         // during the next session.
-        int protocol_version = m_connection.get_client_protocol_version();
+        int protocol_version = m_connection->client_protocol_version;
         static_cast<void>(protocol_version); // No protocol diversion (yet)
 
         UploadCursor upload_progress;
@@ -3639,12 +4585,14 @@ public:
         return true;
     }
 
-    // Returns true if the deactivation process has been completed, at which
-    // point the caller (SyncConnection::receive_unbind_message()) should
-    // terminate the session.
+    // If the deactivation process is completed by the UNBIND message, the
+    // session destroys itself. `forgotten_by_connection` must be true if the
+    // connection already knew that the ERROR message was sent, and has
+    // therefore forgotten this session (see
+    // SyncConnection::receive_unbind_message()).
     //
     // CAUTION: This function may commit suicide!
-    void receive_unbind_message()
+    void receive_unbind_message(bool forgotten_by_connection)
     {
         // Protocol state may be anything but SendUnbound
         REALM_ASSERT(!m_unbind_message_received);
@@ -3658,23 +4606,26 @@ public:
         if (m_error_message_sent) {
             // Deactivation process completed
             terminate(); // Throws
-            m_connection.discard_session(m_session_ident);
+            bool notify_connection = !forgotten_by_connection;
+            m_shard.discard_session(get_connection_id(), m_session_ident, notify_connection); // Throws
             // This session is now destroyed!
             return;
         }
+        REALM_ASSERT(!forgotten_by_connection);
 
         // Protocol state is now SendUnbound
         ensure_enlisted_to_send();
     }
 
 private:
-    SyncConnection& m_connection;
+    NetworkShard& m_shard;
+    const std::shared_ptr<SyncConnectionInfo> m_connection;
 
     const session_ident_type m_session_ident;
 
-    // Not null if, and only if this session is in
-    // m_connection.m_sessions_enlisted_to_send.
-    Session* m_next = nullptr;
+    // True if, and only if this session has enlisted to send, and has not yet
+    // been granted the opportunity to do so (see send_message()).
+    bool m_is_enlisted_to_send = false;
 
     // Becomes nonnull when the BIND message is received, if no error occurs. Is
     // reset to null when the deactivation process is initiated, either when the
@@ -3704,12 +4655,18 @@ private:
     bool m_state_request_message_received = false;
 
     struct StateMessageInfo {
-        // unused
-        Optional<uint_fast64_t> descriptor;
-        // unused
-        std::string path;
-
-        // dummy values to produce an empty state message
+        // True while the associated server file is producing a state Realm
+        // for this session.
+        bool awaiting_state_realm = false;
+
+        // Null when an empty state is sent, in which case the client will
+        // download the entire history instead.
+        std::shared_ptr<StateRealm> state_realm;
+
+        // The offset into the state Realm of the next STATE message. On
+        // receipt of the STATE_REQUEST message, this is the offset at which
+        // the client wants to resume the transfer of the state Realm at
+        // `server_version`.
         uint_fast64_t offset = 0;
         SaltedVersion server_version = {0, 0};
     };
@@ -3746,6 +4703,10 @@ private:
     // synchronous backup).
     UploadCursor m_upload_threshold = {0, 0};
 
+    // The upload cursor that was reported in the last DOWNLOAD message sent in
+    // this session, or `m_upload_threshold` if none was sent yet.
+    UploadCursor m_upload_progress_sent = {0, 0};
+
     // Works partially as a cache of the persisted value, and partially as a way
     // of checking that the client respects that it can never decrease.
     version_type m_locked_server_version = 0;
@@ -3791,7 +4752,7 @@ private:
         SaltedVersion last_server_version = m_server_file->get_salted_sync_version();
         REALM_ASSERT(last_server_version.version >= m_download_progress.server_version);
 
-        ServerImpl& server = m_connection.get_server();
+        ServerImpl& server = get_server();
         const Server::Config& config = server.get_config();
         if (REALM_UNLIKELY(m_disable_download))
             return;
@@ -3802,6 +4763,8 @@ private:
             m_server_file->register_client_access(m_client_file_ident);     // Throws
             const ServerHistory& history = m_server_file->access().history; // Throws
             const char* body;
+            // Keeps the body alive until it has been written to the socket.
+            std::shared_ptr<const void> body_owner;
             std::size_t uncompressed_body_size;
             std::size_t compressed_body_size = 0;
             bool body_is_compressed = false;
@@ -3814,111 +4777,141 @@ private:
             std::size_t accum_compacted_size;
             ServerProtocol& protocol = get_server_protocol();
             bool disable_download_compaction = config.disable_download_compaction;
-            bool enable_cache = (config.enable_download_bootstrap_cache && m_download_progress.server_version == 0 &&
-                                 m_upload_progress.client_version == 0 && m_upload_threshold.client_version == 0);
-            DownloadCache& cache = m_server_file->get_download_cache();
-            bool fetch_from_cache = (enable_cache && cache.body && end_version == cache.end_version);
-            if (fetch_from_cache) {
-                body = cache.body.get();
-                uncompressed_body_size = cache.uncompressed_body_size;
-                compressed_body_size = cache.compressed_body_size;
-                body_is_compressed = cache.body_is_compressed;
-                download_progress = cache.download_progress;
-                downloadable_bytes = cache.downloadable_bytes;
-                num_changesets = cache.num_changesets;
-                accum_original_size = cache.accum_original_size;
-                accum_compacted_size = cache.accum_compacted_size;
+            // Apart from the last integrated client version, a DOWNLOAD
+            // message body is independent of the receiving client when none
+            // of the changesets in the range that it covers originate from
+            // the client, because then no changesets are filtered out on its
+            // behalf. See DownloadCache. A bootstrap body covers the entire
+            // history.
+            bool bootstrap =
+                (config.enable_download_bootstrap_cache && m_download_progress.server_version == 0 &&
+                 !history.has_changesets_from(m_client_file_ident, 0, last_server_version.version)); // Throws
+            std::size_t max_download_size =
+                (bootstrap ? std::numeric_limits<size_t>::max() : config.max_download_size);
+            bool enable_cache = (bootstrap || config.download_cache_max_size > 0);
+            DownloadCache& cache = m_shard.get_download_cache();
+            DownloadCache::Key cache_key;
+            const DownloadCacheEntry* cache_entry = nullptr;
+            if (enable_cache) {
+                cache_key = DownloadCache::Key{m_server_file->get_virt_path(), m_download_progress.server_version,
+                                               m_download_progress.last_integrated_client_version,
+                                               last_server_version.version, last_server_version.salt,
+                                               max_download_size, m_connection->compression_codec}; // Throws
+                cache_entry = cache.find(cache_key);
+                // The cached body is not valid for a client that has
+                // changesets of its own in the range that the body covers
+                if (cache_entry && !bootstrap &&
+                    history.has_changesets_from(m_client_file_ident, m_download_progress.server_version,
+                                                cache_entry->download_progress.server_version)) // Throws
+                    cache_entry = nullptr;
+                metrics().increment(cache_entry ? "download.cache.hit" : "download.cache.miss"); // Throws
+            }
+            if (cache_entry) {
+                body = cache_entry->body.get();
+                body_owner = cache_entry->body;
+                uncompressed_body_size = cache_entry->uncompressed_body_size;
+                compressed_body_size = cache_entry->compressed_body_size;
+                body_is_compressed = cache_entry->body_is_compressed;
+                download_progress = cache_entry->download_progress;
+                downloadable_bytes = cache_entry->downloadable_bytes;
+                num_changesets = cache_entry->num_changesets;
+                accum_original_size = cache_entry->accum_original_size;
+                accum_compacted_size = cache_entry->accum_compacted_size;
+                // The upload cursor is specific to the client, so it is not
+                // cached. Report the one that was reported last, as it is
+                // known to be valid, and the client must never see it
+                // decrease.
+                upload_progress = m_upload_progress_sent;
+                logger.debug("Download cache hit (server_version=%1, end_version=%2)",
+                             m_download_progress.server_version, end_version); // Throws
             }
             else {
-                // Discard the old cached DOWNLOAD body before generating a new
-                // one to be cached. This can make a big difference because the
-                // size of that body can be very large (10GiB has been seen in a
-                // real-world case).
-                if (enable_cache)
-                    cache.body = {};
-
-                OutputBuffer& out = server.get_misc_buffers().download_message;
+                // Discard the old cached bootstrap DOWNLOAD body before
+                // generating a new one to be cached. This can make a big
+                // difference because the size of that body can be very large
+                // (10GiB has been seen in a real-world case). Entries cached
+                // for incremental downloads from the same file are retained.
+                if (bootstrap)
+                    cache.erase_pinned(m_server_file->get_virt_path(), m_connection->compression_codec);
+
+                OutputBuffer& out = m_shard.get_misc_buffers().download_message;
                 out.reset();
                 download_progress = m_download_progress;
-                auto fetch_and_compress = [&](std::size_t max_download_size) {
-                    DownloadHistoryEntryHandler handler{protocol, out, logger};
-                    std::uint_fast64_t cumulative_byte_size_current;
-                    std::uint_fast64_t cumulative_byte_size_total;
-                    bool not_expired = history.fetch_download_info(
-                        m_client_file_ident, download_progress, end_version, upload_progress, handler,
-                        cumulative_byte_size_current, cumulative_byte_size_total, disable_download_compaction,
-                        max_download_size); // Throws
-                    REALM_ASSERT(upload_progress.client_version >= download_progress.last_integrated_client_version);
-                    SyncConnection& conn = get_connection();
-                    if (REALM_UNLIKELY(!not_expired)) {
-                        logger.debug("History scanning failed: Client file entry "
-                                     "expired during session"); // Throws
-                        conn.protocol_error(ProtocolError::client_file_expired, this);
-                        // Session object may have been destroyed at this point
-                        // (suicide).
-                        return false;
-                    }
+                DownloadHistoryEntryHandler handler{protocol, out, logger};
+                std::uint_fast64_t cumulative_byte_size_current;
+                std::uint_fast64_t cumulative_byte_size_total;
+                bool not_expired = history.fetch_download_info(
+                    m_client_file_ident, download_progress, end_version, upload_progress, handler,
+                    cumulative_byte_size_current, cumulative_byte_size_total, disable_download_compaction,
+                    max_download_size); // Throws
+                REALM_ASSERT(upload_progress.client_version >= download_progress.last_integrated_client_version);
+                if (REALM_UNLIKELY(!not_expired)) {
+                    logger.debug("History scanning failed: Client file entry "
+                                 "expired during session"); // Throws
+                    protocol_error(ProtocolError::client_file_expired);
+                    return;
+                }
 
-                    downloadable_bytes = cumulative_byte_size_total - cumulative_byte_size_current;
-                    uncompressed_body_size = out.size();
-                    BinaryData uncompressed = {out.data(), uncompressed_body_size};
-                    body = uncompressed.data();
-                    std::size_t max_uncompressed = 1024;
-                    if (uncompressed.size() > max_uncompressed) {
-                        _impl::compression::CompressMemoryArena& arena = server.get_compress_memory_arena();
-                        std::vector<char>& buffer = server.get_misc_buffers().compress;
-                        std::size_t size = _impl::compression::allocate_and_compress(arena, uncompressed,
-                                                                                     buffer); // Throws
-                        if (size < uncompressed.size()) {
-                            body = buffer.data();
-                            compressed_body_size = size;
-                            body_is_compressed = true;
-                        }
-                    }
-                    num_changesets = handler.num_changesets;
-                    accum_original_size = handler.accum_original_size;
-                    accum_compacted_size = handler.accum_compacted_size;
-                    return true;
-                };
-                if (enable_cache) {
-                    std::size_t max_download_size = std::numeric_limits<size_t>::max();
-                    if (!fetch_and_compress(max_download_size)) { // Throws
-                        // Session object may have been destroyed at this point
-                        // (suicide).
-                        return;
+                downloadable_bytes = cumulative_byte_size_total - cumulative_byte_size_current;
+                uncompressed_body_size = out.size();
+                BinaryData uncompressed = {out.data(), uncompressed_body_size};
+                body = uncompressed.data();
+                std::size_t max_uncompressed = 1024;
+                if (uncompressed.size() > max_uncompressed) {
+                    _impl::compression::CompressMemoryArena& arena = m_shard.get_compress_memory_arena();
+                    std::vector<char>& buffer = m_shard.get_misc_buffers().compress;
+                    std::size_t size = _impl::compression::allocate_and_compress(
+                        arena, uncompressed, buffer, m_connection->compression_codec); // Throws
+                    if (size < uncompressed.size()) {
+                        body = buffer.data();
+                        compressed_body_size = size;
+                        body_is_compressed = true;
                     }
-                    REALM_ASSERT(upload_progress.client_version == 0);
-                    std::size_t body_size = (body_is_compressed ? compressed_body_size : uncompressed_body_size);
-                    cache.body = std::make_unique<char[]>(body_size); // Throws
-                    std::copy(body, body + body_size, cache.body.get());
-                    cache.uncompressed_body_size = uncompressed_body_size;
-                    cache.compressed_body_size = compressed_body_size;
-                    cache.body_is_compressed = body_is_compressed;
-                    cache.end_version = end_version;
-                    cache.download_progress = download_progress;
-                    cache.downloadable_bytes = downloadable_bytes;
-                    cache.num_changesets = num_changesets;
-                    cache.accum_original_size = accum_original_size;
-                    cache.accum_compacted_size = accum_compacted_size;
                 }
-                else {
-                    std::size_t max_download_size = config.max_download_size;
-                    if (!fetch_and_compress(max_download_size)) { // Throws
-                        // Session object may have been destroyed at this point
-                        // (suicide).
-                        return;
-                    }
+                // The body is moved to a buffer of its own, of exactly the
+                // right size, such that it can be written to the socket
+                // directly from there, and be adopted by the download cache,
+                // while the misc buffers are reused by other sessions.
+                std::size_t body_size = (body_is_compressed ? compressed_body_size : uncompressed_body_size);
+                std::shared_ptr<char[]> body_buffer{new char[body_size]}; // Throws
+                std::copy_n(body, body_size, body_buffer.get());
+                body = body_buffer.get();
+                num_changesets = handler.num_changesets;
+                accum_original_size = handler.accum_original_size;
+                accum_compacted_size = handler.accum_compacted_size;
+
+                // Client versions only increase, so the last integrated client
+                // version has advanced if, and only if changesets from the
+                // client were filtered out
+                bool body_is_shareable = (download_progress.last_integrated_client_version ==
+                                          m_download_progress.last_integrated_client_version);
+                if (enable_cache && body_is_shareable) {
+                    DownloadCacheEntry entry;
+                    entry.uncompressed_body_size = uncompressed_body_size;
+                    entry.compressed_body_size = compressed_body_size;
+                    entry.body_is_compressed = body_is_compressed;
+                    entry.download_progress = download_progress;
+                    entry.downloadable_bytes = downloadable_bytes;
+                    entry.num_changesets = num_changesets;
+                    entry.accum_original_size = accum_original_size;
+                    entry.accum_compacted_size = accum_compacted_size;
+                    cache.insert(std::move(cache_key), body_buffer, entry, bootstrap); // Throws
+                    double cache_size = double(cache.size() + cache.pinned_size());
+                    metrics().gauge("download.cache.size", cache_size); // Throws
                 }
+                body_owner = std::move(body_buffer);
             }
 
-            OutputBuffer& out = m_connection.get_output_buffer();
+            OutputBuffer& out = m_shard.get_output_buffer();
             SteadyTimePoint start_time = steady_clock_now();
-            protocol.make_download_message(
-                m_connection.get_client_protocol_version(), out, m_session_ident, download_progress.server_version,
+            protocol.make_download_message_header(
+                m_connection->client_protocol_version, out, m_session_ident, download_progress.server_version,
                 download_progress.last_integrated_client_version, last_server_version.version,
                 last_server_version.salt, upload_progress.client_version,
-                upload_progress.last_integrated_server_version, downloadable_bytes, num_changesets, body,
-                uncompressed_body_size, compressed_body_size, body_is_compressed, logger); // Throws
+                upload_progress.last_integrated_server_version, downloadable_bytes, num_changesets,
+                uncompressed_body_size, compressed_body_size,
+                (body_is_compressed ? m_connection->compression_codec : _impl::compression::Codec::none),
+                logger); // Throws
             milliseconds_type elapsed = steady_duration(start_time);
             metrics().increment("download.constructed");                                   // Throws
             metrics().timing("download.constructed", double(elapsed));                     // Throws
@@ -3931,9 +4924,11 @@ private:
             }
 
             m_download_progress = download_progress;
+            m_upload_progress_sent = upload_progress;
             logger.debug("Setting of m_download_progress.server_version = %1",
                          m_download_progress.server_version); // Throws
-            send_download_message();
+            std::size_t body_size = (body_is_compressed ? compressed_body_size : uncompressed_body_size);
+            send_download_message(body, body_size, std::move(body_owner)); // Throws
             m_one_download_message_sent = true;
 
             enlist_to_send();
@@ -3966,11 +4961,11 @@ private:
                      client_file_ident_salt); // Throws
 
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
-        int protocol_version = m_connection.get_client_protocol_version();
+        OutputBuffer& out = m_shard.get_output_buffer();
+        int protocol_version = m_connection->client_protocol_version;
         protocol.make_ident_message(protocol_version, out, m_session_ident, client_file_ident,
                                     client_file_ident_salt); // Throws
-        m_connection.initiate_write_output_buffer();         // Throws
+        m_shard.initiate_write_output_buffer();         // Throws
 
         m_allocated_file_ident.ident = 0; // Consumed
         m_send_ident_message = false;
@@ -3987,11 +4982,11 @@ private:
                      client_version); // Throws
 
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
+        OutputBuffer& out = m_shard.get_output_buffer();
         protocol.make_client_version_message(out, m_session_ident,
                                              client_version); // Throws
 
-        m_connection.initiate_write_output_buffer(); // Throws
+        m_shard.initiate_write_output_buffer(); // Throws
         // Protocol state is now WaitForStateRequest or WaitForIdent
     }
 
@@ -4005,34 +5000,87 @@ private:
         REALM_ASSERT(!error_occurred());
         REALM_ASSERT(!m_error_message_sent);
 
+        StateMessageInfo& info = *m_state_message_info;
+        if (REALM_UNLIKELY(info.awaiting_state_realm))
+            return;
+
         std::unique_ptr<char[]> buf{};
         uint_fast64_t next_offset = 0;
         uint_fast64_t max_offset = 0;
         size_t blocks_size = 0;
+        if (info.state_realm) {
+            const Server::Config& config = get_server().get_config();
+            // compression::extract_blocks_from_file() needs room for at least
+            // one block.
+            std::size_t buf_size = std::max(config.max_download_size, std::size_t(1) << 19);
+            buf.reset(new char[buf_size]); // Throws
+            const std::string& path = info.state_realm->path;
+            std::error_code ec = _impl::compression::extract_blocks_from_file(
+                path, config.encryption_key, info.offset, next_offset, max_offset, buf.get(), buf_size,
+                blocks_size); // Throws
+            if (REALM_UNLIKELY(ec && info.offset != 0)) {
+                logger.debug("Cannot resume transfer of state Realm at offset %1 (%2), starting over",
+                             info.offset, ec.message()); // Throws
+                info.offset = 0;
+                ec = _impl::compression::extract_blocks_from_file(path, config.encryption_key, info.offset,
+                                                                  next_offset, max_offset, buf.get(), buf_size,
+                                                                  blocks_size); // Throws
+            }
+            if (REALM_UNLIKELY(ec)) {
+                logger.error("Failed to read state Realm '%1': %2", path, ec.message()); // Throws
+                info.state_realm.reset();
+                info.server_version = {0, 0};
+                next_offset = 0;
+                max_offset = 0;
+                blocks_size = 0;
+            }
+        }
 
         logger.debug("Sending: STATE(server_version=%1, server_version_salt=%2 "
                      "begin_offset=%3, end_offset=%4, max_offset=%5, "
                      " blocks_size=%6)",
-                     m_state_message_info->server_version.version, m_state_message_info->server_version.salt,
-                     m_state_message_info->offset, next_offset, max_offset, blocks_size); // Throws
+                     info.server_version.version, info.server_version.salt, info.offset, next_offset, max_offset,
+                     blocks_size); // Throws
 
         BinaryData blocks{buf.get(), blocks_size};
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
-        protocol.make_state_message(out, m_session_ident, m_state_message_info->server_version,
-                                    m_state_message_info->offset, next_offset, max_offset, blocks); // Throws
+        OutputBuffer& out = m_shard.get_output_buffer();
+        protocol.make_state_message(out, m_session_ident, info.server_version, info.offset, next_offset, max_offset,
+                                    blocks); // Throws
 
-        // Send an empty state message to the client.
-        m_connection.initiate_write_output_buffer(); // Throws
+        m_shard.initiate_write_output_buffer(); // Throws
 
-        m_state_message_info->offset = next_offset;
+        if (next_offset < max_offset) {
+            // Protocol state is still SendState
+            info.offset = next_offset;
+            enlist_to_send();
+            return;
+        }
         m_state_message_info.reset();
+        // Protocol state is now WaitForIdent
+    }
+
+    void begin_state_transfer(std::shared_ptr<StateRealm> state_realm)
+    {
+        StateMessageInfo& info = *m_state_message_info;
+        // Resume the transfer if the client has already received part of this
+        // state Realm.
+        const SaltedVersion& server_version = state_realm->server_version;
+        bool resume = (info.server_version.version == server_version.version &&
+                       info.server_version.salt == server_version.salt);
+        if (!resume)
+            info.offset = 0;
+        info.server_version = server_version;
+        info.state_realm = std::move(state_realm);
+        logger.debug("Sending state Realm at server version %1, starting at offset %2", server_version.version,
+                     info.offset); // Throws
+        ensure_enlisted_to_send();
     }
 
-    void send_download_message()
+    void send_download_message(const char* body, std::size_t body_size, std::shared_ptr<const void> body_owner)
     {
         REALM_ASSERT(!must_send_state_message());
-        m_connection.initiate_write_output_buffer(); // Throws
+        m_shard.initiate_write_output_buffer(body, body_size, std::move(body_owner)); // Throws
     }
 
     void send_mark_message(request_ident_type request_ident)
@@ -4040,9 +5088,9 @@ private:
         logger.debug("Sending: MARK(request_ident=%1)", request_ident); // Throws
 
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
+        OutputBuffer& out = m_shard.get_output_buffer();
         protocol.make_mark_message(out, m_session_ident, request_ident); // Throws
-        m_connection.initiate_write_output_buffer();                     // Throws
+        m_shard.initiate_write_output_buffer();                     // Throws
     }
 
     void send_alloc_message()
@@ -4064,9 +5112,9 @@ private:
         logger.debug("Sending: ALLOC(file_ident=%1)", file_ident); // Throws
 
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
+        OutputBuffer& out = m_shard.get_output_buffer();
         protocol.make_alloc_message(out, m_session_ident, file_ident); // Throws
-        m_connection.initiate_write_output_buffer();                   // Throws
+        m_shard.initiate_write_output_buffer();                   // Throws
 
         m_allocated_file_ident.ident = 0; // Consumed
 
@@ -4083,9 +5131,9 @@ private:
         logger.debug("Sending: UNBOUND"); // Throws
 
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
+        OutputBuffer& out = m_shard.get_output_buffer();
         protocol.make_unbound_message(out, m_session_ident); // Throws
-        m_connection.initiate_write_output_buffer();         // Throws
+        m_shard.initiate_write_output_buffer();         // Throws
     }
 
     void send_error_message()
@@ -4106,11 +5154,11 @@ private:
                       try_again); // Throws
 
         ServerProtocol& protocol = get_server_protocol();
-        OutputBuffer& out = m_connection.get_output_buffer();
-        int protocol_version = m_connection.get_client_protocol_version();
+        OutputBuffer& out = m_shard.get_output_buffer();
+        int protocol_version = m_connection->client_protocol_version;
         protocol.make_error_message(protocol_version, out, error_code, message, message_size, try_again,
                                     m_session_ident); // Throws
-        m_connection.initiate_write_output_buffer();  // Throws
+        m_shard.initiate_write_output_buffer();  // Throws
 
         m_error_message_sent = true;
         // Protocol state is now WaitForUnbindErr
@@ -4138,12 +5186,11 @@ private:
         if (m_access_token) {
             std::string key =
                 ("user_sessions,identity=" + Metrics::percent_encode(m_access_token->identity)); // Throws
-            double val = (gauges().user_sessions[m_access_token->identity] += diff);             // Throws
-            metrics().gauge(key.c_str(), val);                                                   // Throws
+            util::LockGuard lock{gauges().user_sessions_mutex};
+            double val = (gauges().user_sessions[m_access_token->identity] += diff); // Throws
+            metrics().gauge(key.c_str(), val);                                       // Throws
         }
     }
-
-    friend class SessionQueue;
 };
 
 
@@ -4165,65 +5212,18 @@ void IntegrationReporterImpl::on_integration_session_begin()
 void IntegrationReporterImpl::on_changeset_integrated(std::size_t) {}
 
 
-// ============================ SessionQueue implementation ============================
-
-void SessionQueue::push_back(Session* sess) noexcept
-{
-    REALM_ASSERT(!sess->m_next);
-    if (m_back) {
-        sess->m_next = m_back->m_next;
-        m_back->m_next = sess;
-    }
-    else {
-        sess->m_next = sess;
-    }
-    m_back = sess;
-}
-
-
-Session* SessionQueue::pop_front() noexcept
-{
-    Session* sess = nullptr;
-    if (m_back) {
-        sess = m_back->m_next;
-        if (sess != m_back) {
-            m_back->m_next = sess->m_next;
-        }
-        else {
-            m_back = nullptr;
-        }
-        sess->m_next = nullptr;
-    }
-    return sess;
-}
-
-
-void SessionQueue::clear() noexcept
-{
-    if (m_back) {
-        Session* sess = m_back;
-        for (;;) {
-            Session* next = sess->m_next;
-            sess->m_next = nullptr;
-            if (next == m_back)
-                break;
-            sess = next;
-        }
-        m_back = nullptr;
-    }
-}
-
-
 // ============================ ServerFile implementation ============================
 
-ServerFile::ServerFile(ServerImpl& server, ServerFileAccessCache& cache, const std::string& virt_path,
-                       std::string real_path, bool disable_sync_to_disk)
-    : logger{"ServerFile[" + virt_path + "]: ", server.logger}               // Throws
-    , wlogger{"ServerFile[" + virt_path + "]: ", server.get_worker().logger} // Throws
-    , m_server{server}
-    , m_file{cache, real_path, virt_path, *this, disable_sync_to_disk}       // Throws
-    , m_client_file_blacklist{make_client_file_blacklist(server, virt_path)} // Throws
-    , m_worker_file{server.get_worker().get_file_access_cache(), real_path, virt_path, *this, disable_sync_to_disk}
+ServerFile::ServerFile(NetworkShard& shard, Worker& worker, const std::string& virt_path, std::string real_path,
+                       bool disable_sync_to_disk)
+    : logger{"ServerFile[" + virt_path + "]: ", shard.get_server().logger} // Throws
+    , wlogger{"ServerFile[" + virt_path + "]: ", worker.logger}            // Throws
+    , m_server{shard.get_server()}
+    , m_shard{shard}
+    , m_worker{worker}
+    , m_file{shard.get_file_access_cache(), real_path, virt_path, *this, disable_sync_to_disk} // Throws
+    , m_client_file_blacklist{make_client_file_blacklist(m_server, virt_path)}               // Throws
+    , m_worker_file{worker.get_file_access_cache(), real_path, virt_path, *this, disable_sync_to_disk}
 {
     m_server.metrics().gauge("realms.open", ++m_server.gauges().realms_open); // Throws
 }
@@ -4240,6 +5240,8 @@ ServerFile::~ServerFile() noexcept
     // the metrics operation out of the destructor.
     try {
         m_server.metrics().gauge("realms.open", --m_server.gauges().realms_open); // Throws
+        if (!m_produced_state_realms.empty())
+            util::try_remove_dir_recursive(get_state_realm_dir()); // Throws
     }
     catch (...) {
         // Throwing in destructor is not allowed, so we catch here
@@ -4257,6 +5259,9 @@ void ServerFile::initialize()
                        partial_progress_reference_version); // Throws
     REALM_ASSERT(!has_upstream_sync_status);
     REALM_ASSERT(partial_file_ident == 0);
+
+    // Discard state Realms left behind by a previous server process
+    util::try_remove_dir_recursive(get_state_realm_dir()); // Throws
 }
 
 
@@ -4270,7 +5275,7 @@ void ServerFile::register_client_access(file_ident_type client_file_ident)
 {
     const Server::Config& config = m_server.get_config();
     if (!config.disable_history_compaction) {
-        Clock::time_point now = m_server.get_worker().get_compaction_clock_now();
+        Clock::time_point now = m_worker.get_compaction_clock_now();
         std::time_t now_2 = Clock::clock::to_time_t(now);
         util::LockGuard lock{m_server.last_client_accesses_mutex};
         m_last_client_accesses[client_file_ident] = {now_2}; // Throws
@@ -4443,7 +5448,11 @@ void ServerFile::worker_process_work_unit(WorkerState& state)
     milliseconds_type parallel_time = 0;
 
     Work& work = m_work;
-    wlogger.debug("Work unit execution started"); // Throws
+    milliseconds_type queue_time = steady_duration(work.enqueue_time, start_time);
+    wlogger.debug("Work unit execution started (queue time: %1 ms, queue length: %2)", queue_time,
+                  state.queue_length); // Throws
+    m_server.metrics().timing(state.queue_time_metric.c_str(), double(queue_time));          // Throws
+    m_server.metrics().gauge(state.queue_length_metric.c_str(), double(state.queue_length)); // Throws
 
     if (work.has_primary_work) {
         if (REALM_UNLIKELY(work.request_deletion)) {
@@ -4458,6 +5467,12 @@ void ServerFile::worker_process_work_unit(WorkerState& state)
             worker_integrate_changes_from_downstream(state); // Throws
     }
 
+    if (REALM_UNLIKELY(work.request_state_realm))
+        worker_produce_state_realm(); // Throws
+
+    for (const std::string& path : work.obsolete_state_realm_paths)
+        _impl::remove_realm_file(path); // Throws
+
     // Compaction
     if (REALM_UNLIKELY(work.group_has_compaction_requests)) {
         if (work.request_compaction)
@@ -4481,7 +5496,7 @@ done:
         group_postprocess_stage_1(); // Throws
         // Suicide may have happened at this point
     };
-    util::network::Service& service = m_server.get_service();
+    util::network::Service& service = m_shard.get_service();
     service.post(std::move(handler)); // Throws
 }
 
@@ -4532,14 +5547,16 @@ void ServerFile::group_unblock_work()
     if (REALM_LIKELY(!m_server.is_sync_stopped())) {
         unblock_work(); // Throws
         const Work& work = m_work;
-        bool pass_to_worker = (work.has_primary_work || work.group_has_compaction_requests);
+        bool pass_to_worker =
+            (work.has_primary_work || work.group_has_compaction_requests || work.request_state_realm);
         bool work_was_unblocked = pass_to_worker;
         if (REALM_LIKELY(work_was_unblocked)) {
             logger.trace("Work unit unblocked"); // Throws
             m_has_work_in_progress = true;
             if (pass_to_worker) {
-                Worker& worker = m_server.get_worker();
-                worker.enqueue(this); // Throws
+                collect_obsolete_state_realms(); // Throws
+                m_work.enqueue_time = steady_clock_now();
+                m_worker.enqueue(this); // Throws
             }
             else {
                 // Note: Suicide is not possible here, because if
@@ -4619,12 +5636,17 @@ void ServerFile::unblock_work()
         m_work.group_has_compaction_requests = true;
     }
 
+    if (REALM_UNLIKELY(m_request_state_realm)) {
+        m_request_state_realm = false;
+        m_work.request_state_realm = true;
+    }
+
     m_num_changesets_from_downstream = 0;
     m_has_blocked_work = false;
 }
 
 
-void ServerFile::resume_download() noexcept
+void ServerFile::resume_download()
 {
     for (const auto& entry : m_identified_sessions) {
         Session& sess = *entry.second;
@@ -4660,6 +5682,42 @@ void ServerFile::initiate_compaction()
 }
 
 
+std::shared_ptr<StateRealm> ServerFile::get_state_realm(bool need_recent)
+{
+    if (m_state_realm) {
+        bool is_recent = (m_state_realm->server_version.version == get_sync_version());
+        if (is_recent || !need_recent)
+            return m_state_realm;
+    }
+    if (!m_request_state_realm) {
+        m_request_state_realm = true;
+        on_work_added(); // Throws
+    }
+    return nullptr;
+}
+
+
+void ServerFile::collect_obsolete_state_realms()
+{
+    auto i = m_produced_state_realms.begin();
+    while (i != m_produced_state_realms.end()) {
+        if (i->first.expired()) {
+            m_work.obsolete_state_realm_paths.push_back(std::move(i->second)); // Throws
+            i = m_produced_state_realms.erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
+}
+
+
+std::string ServerFile::get_state_realm_dir() const
+{
+    return m_file.realm_path + ".state"; // Throws
+}
+
+
 void ServerFile::initiate_deletion(std::int_fast64_t conn_id)
 {
     // Note: Actual deletion takes place in
@@ -4685,6 +5743,74 @@ void ServerFile::worker_allocate_file_identifiers()
 }
 
 
+// The state Realm is produced by copying the contents of the latest snapshot
+// into a new client-side Realm file with no local history, and whose download
+// progress is the server version of the snapshot. The copying is not recorded
+// in the client-side history, so the client has nothing to upload when it has
+// installed the file.
+//
+// NOTE: This function is executed by the worker thread
+void ServerFile::worker_produce_state_realm()
+{
+    SteadyTimePoint start_time = steady_clock_now();
+    SaltedVersion server_version;
+    TransactionRef rt = worker_access().history.start_read(server_version); // Throws
+
+    const Optional<std::array<char, 64>>& encryption_key = m_server.get_config().encryption_key;
+    std::string dir = get_state_realm_dir();                                             // Throws
+    std::string path = util::File::resolve(std::to_string(server_version.version), dir); // Throws
+    std::string realm_path = (encryption_key ? path : path + ".realm");                  // Throws
+    std::uint_fast64_t realm_size = 0;
+    try {
+        util::try_make_dir(dir);              // Throws
+        _impl::remove_realm_file(realm_path); // Throws
+        {
+            _impl::ClientHistoryImpl history{realm_path};                         // Throws
+            DBOptions options{encryption_key ? encryption_key->data() : nullptr}; // Throws
+            DBRef sg = DB::create(history, options);                              // Throws
+            {
+                TransactionRef wt = sg->start_write(); // Throws
+                sync::TempShortCircuitReplication tscr{history};
+                StateRealmCopier{*rt, *wt}.copy(); // Throws
+                wt->commit();                      // Throws
+            }
+            {
+                TransactionRef wt = sg->start_write();                                              // Throws
+                history.set_initial_state_realm_history_numbers(wt->get_version(), server_version); // Throws
+                wt->commit();                                                                       // Throws
+            }
+            sg->compact();                                  // Throws
+            realm_size = util::File{realm_path}.get_size(); // Throws
+        }
+        if (!encryption_key) {
+            std::size_t src_size = 0, dst_size = 0;
+            std::error_code ec = _impl::compression::compress_file_in_blocks(realm_path.c_str(), path.c_str(),
+                                                                             src_size, dst_size); // Throws
+            _impl::remove_realm_file(realm_path);                                                 // Throws
+            if (ec) {
+                wlogger.error("Failed to compress state Realm '%1': %2", realm_path, ec.message()); // Throws
+                util::File::try_remove(path);                                                       // Throws
+                return;
+            }
+        }
+    }
+    catch (std::exception& e) {
+        // Sessions waiting for the state Realm fall back to a regular download
+        wlogger.error("Failed to produce state Realm '%1': %2", realm_path, e.what()); // Throws
+        _impl::remove_realm_file(realm_path);                                          // Throws
+        util::File::try_remove(path);                                                  // Throws
+        return;
+    }
+
+    auto state_realm = std::make_shared<StateRealm>(); // Throws
+    state_realm->server_version = server_version;
+    state_realm->path = std::move(path);
+    m_work.state_realm = std::move(state_realm);
+    wlogger.detail("State Realm produced at server version %1 (%2 bytes, %3 ms)", server_version.version,
+                   realm_size, steady_duration(start_time)); // Throws
+}
+
+
 // Returns true when, and only when this function produces a new sync version
 // (adds a new entry to the sync history).
 //
@@ -4714,8 +5840,7 @@ bool ServerFile::worker_integrate_changes_from_downstream(WorkerState& state)
     if (produced_new_sync_version) {
         std::size_t num_changesets = m_work.integration_result.integrated_changesets.size();
         std::size_t num_parts = num_changesets;
-        const Worker& worker = m_server.get_worker();
-        m_work.integration_duration = steady_duration(worker.get_integration_session_start_time());
+        m_work.integration_duration = steady_duration(m_worker.get_integration_session_start_time());
         const milliseconds_type duration_limit = 10000; // 10 seconds
         if (m_work.integration_duration < duration_limit) {
             // Normal case
@@ -4868,9 +5993,8 @@ void ServerFile::finalize_work_stage_1()
         auto i = m_identified_sessions.find(client_file_ident);
         if (i != m_identified_sessions.end()) {
             Session& sess = *i->second;
-            SyncConnection& conn = sess.get_connection();
-            conn.metrics().increment("protocol.violated"); // Throws
-            conn.protocol_error(error_2, &sess);           // Throws
+            sess.metrics().increment("protocol.violated"); // Throws
+            sess.protocol_error(error_2);                  // Throws
         }
         const IntegratableChangesetList& list = m_changesets_from_downstream[client_file_ident];
         std::size_t num_changesets = list.changesets.size();
@@ -4916,6 +6040,20 @@ void ServerFile::finalize_work_stage_2()
 
     bool resume_download_and_upload = m_work.produced_new_sync_version;
 
+    // Deliver the new state Realm to the sessions waiting for it. If
+    // production failed, they get the previous one, if any.
+    if (REALM_UNLIKELY(m_work.request_state_realm)) {
+        if (m_work.state_realm) {
+            m_state_realm = std::move(m_work.state_realm);
+            m_produced_state_realms.emplace_back(m_state_realm, m_state_realm->path); // Throws
+        }
+        // The sessions that requested another state Realm while this one was
+        // being produced are served too.
+        m_request_state_realm = false;
+        for (Session* sess : m_unidentified_sessions)
+            sess->receive_state_realm(m_state_realm); // Throws
+    }
+
     // Deliver allocated file identifiers to requesters
     REALM_ASSERT(m_file_ident_requests.size() >= m_work.file_ident_alloc_slots.size());
     auto begin = m_file_ident_requests.begin();
@@ -5017,23 +6155,21 @@ void ServerFile::perform_file_deletion()
     // on the client side when the server-side file is deleted.
     while (!m_unidentified_sessions.empty()) {
         Session* sess = *m_unidentified_sessions.begin();
-        SyncConnection& conn = sess->get_connection();
         ProtocolError error = ProtocolError::server_file_deleted;
         // Calling protocol_error() is guaranteed to detatch the session object
         // from this ServerFile object, and therefore remove it from
         // m_unidentified_sessions.
-        conn.protocol_error(error, sess);
+        sess->protocol_error(error);
         REALM_ASSERT(m_unidentified_sessions.count(sess) == 0);
     }
     while (!m_identified_sessions.empty()) {
         const auto& entry = *m_identified_sessions.begin();
         Session* sess = entry.second;
-        SyncConnection& conn = sess->get_connection();
         ProtocolError error = ProtocolError::server_file_deleted;
         // Calling protocol_error() is guaranteed to detatch the session object
         // from this ServerFile object, and therefore remove it from
         // m_identified_sessions.
-        conn.protocol_error(error, sess);
+        sess->protocol_error(error);
         REALM_ASSERT(m_identified_sessions.count(sess->get_client_file_ident()) == 0);
     }
 
@@ -5048,7 +6184,9 @@ void ServerFile::perform_file_deletion_after_state_realm_deletion()
     REALM_ASSERT(m_realm_deletion_is_ongoing);
 
     // Remove the Realm file and its associates
-    _impl::remove_realm_file(m_file.realm_path); // Throws
+    m_state_realm.reset();
+    util::try_remove_dir_recursive(get_state_realm_dir()); // Throws
+    _impl::remove_realm_file(m_file.realm_path);           // Throws
     logger.info("Realm file deleted");           // Throws
 
     // Remove the directories that would otherwise be left empty
@@ -5062,7 +6200,7 @@ void ServerFile::perform_file_deletion_after_state_realm_deletion()
                 break;
             bool nonempty_dir = false;
             StringData vpath_prefix{&vpath.front(), i + 1};
-            for (const std::string& x : m_server.get_realm_names()) {
+            for (const std::string& x : m_server.get_realm_names()) { // Throws
                 if (REALM_UNLIKELY(StringData{x}.begins_with(vpath_prefix) && x != m_file.virt_path)) {
                     nonempty_dir = true;
                     break;
@@ -5084,8 +6222,10 @@ void ServerFile::perform_file_deletion_after_state_realm_deletion()
         using std::swap;
         swap(connections, m_deleting_connections);
         for (std::int_fast64_t conn_id : connections) {
-            if (HTTPConnection* conn = m_server.get_http_connection(conn_id))
-                conn->respond_200_ok(); // Throws
+            auto handler = [](HTTPConnection& conn) {
+                conn.respond_200_ok(); // Throws
+            };
+            m_server.post_to_http_connection(conn_id, std::move(handler)); // Throws
         }
     }
 
@@ -5093,7 +6233,7 @@ void ServerFile::perform_file_deletion_after_state_realm_deletion()
         m_server.dec_num_outstanding_compaction_processes(); // Throws
 
     std::string virt_path = get_virt_path(); // Throws (copy)
-    m_server.remove_file(virt_path);         // Throws
+    m_shard.remove_file(virt_path);          // Throws
     // Suicide may have happened at this point
 }
 
@@ -5134,16 +6274,19 @@ bool ServerFile::realm_deletion_is_ongoing() const
 
 // ============================ Worker implementation ============================
 
-Worker::Worker(ServerImpl& server)
-    : logger{"Worker: ", server.logger} // Throws
+Worker::Worker(ServerImpl& server, int worker_ndx, const std::string& logger_prefix, long max_open_files)
+    : logger{logger_prefix, server.logger} // Throws
     , m_server{server}
     , m_transformer{make_transformer()} // Throws
     , m_integration_reporter{server}
-    , m_file_access_cache{server.get_config().max_open_files, logger, *this, server.get_config().encryption_key,
+    , m_file_access_cache{max_open_files, logger, *this, server.get_config().encryption_key,
                           server.get_config().metrics}
     , m_allocation_metrics_context{AllocationMetricsContext::get_current()}
 {
     util::seed_prng_nondeterministically(m_random); // Throws
+    std::string tag = ",worker=" + std::to_string(worker_ndx + 1); // Throws
+    m_state.queue_time_metric = "workunit.queue.time" + tag;       // Throws
+    m_state.queue_length_metric = "workunit.queue.length" + tag;   // Throws
 }
 
 
@@ -5226,6 +6369,7 @@ void Worker::run()
                 if (!m_queue.empty()) {
                     file = m_queue.front();
                     m_queue.pop_front();
+                    m_state.queue_length = m_queue.size();
                     break;
                 }
                 m_cond.wait(lock);
@@ -5244,77 +6388,407 @@ void Worker::stop() noexcept
 }
 
 
-// ============================ ServerImpl implementation ============================
+// ============================ NetworkShard implementation ============================
 
+NetworkShard::NetworkShard(ServerImpl& server, util::network::Service* service, long max_open_files,
+                           std::size_t download_cache_max_size)
+    : m_server{server}
+    , m_own_service{service ? nullptr : new util::network::Service} // Throws
+    , m_service{service ? *service : *m_own_service}
+    , m_allocation_metrics_context{AllocationMetricsContext::get_current()} // Throws
+    , m_file_access_cache{max_open_files, server.logger, *this, server.get_config().encryption_key,
+                          server.get_config().metrics} // Throws
+    , m_server_protocol{}                              // Throws
+    , m_compress_memory_arena{}                        // Throws
+    , m_download_cache{download_cache_max_size}
+{
+    if (m_own_service)
+        m_keep_running_timer.emplace(m_service); // Throws
+    util::seed_prng_nondeterministically(m_random); // Throws
 
-ServerImpl::ServerImpl(const std::string& root_dir, util::Optional<sync::PKey> pkey, Server::Config config)
-    : logger{config.logger ? *config.logger : g_fallback_logger}
-    , m_config{std::move(config)}
-    , m_max_upload_backlog{determine_max_upload_backlog(config)}
-    , m_root_dir{root_dir} // Throws
-    , m_access_control{std::move(pkey)}
-    , m_protocol_version_range{determine_protocol_version_range(config)}                                   // Throws
-    , m_file_access_cache{m_config.max_open_files, logger, *this, config.encryption_key, m_config.metrics} // Throws
-    , m_metrics{m_config.metrics ? *m_config.metrics : g_null_metrics}
-    , m_worker{*this} // Throws
-    , m_acceptor{get_service()}
-    , m_server_protocol{}       // Throws
-    , m_compress_memory_arena{} // Throws
-    , m_integration_reporter{*this}
-    , m_allocation_metrics_timer{get_service()}
+    // Make the output buffer stream throw std::bad_alloc if it fails to
+    // expand the buffer
+    m_output_buffer.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+}
+
+
+NetworkShard::~NetworkShard() noexcept
 {
-    if (m_config.ssl) {
-        m_ssl_context = std::make_unique<util::network::ssl::Context>();          // Throws
-        m_ssl_context->use_certificate_chain_file(m_config.ssl_certificate_path); // Throws
-        m_ssl_context->use_private_key_file(m_config.ssl_certificate_key_path);   // Throws
-    }
+    // Sessions must be destroyed before the server files that they are bound
+    // to.
+    m_sessions.clear();
 }
 
 
-ServerImpl::~ServerImpl() noexcept
+HTTPConnection* NetworkShard::get_http_connection(std::int_fast64_t conn_id) noexcept
 {
-    bool server_destroyed_while_still_running = m_running;
-    REALM_ASSERT_RELEASE(!server_destroyed_while_still_running);
+    auto i = m_http_connections.find(conn_id);
+    if (i == m_http_connections.end())
+        return nullptr;
+    return i->second.get();
 }
 
 
-void ServerImpl::start()
+void NetworkShard::add_http_connection(std::unique_ptr<HTTPConnection> conn)
 {
-    logger.info("Realm sync server started (%1, %2)", REALM_VER_CHUNK,
-                REALM_SYNC_VER_CHUNK); // Throws
-    logger.info("Supported protocol versions: %1-%2 (%3-%4 configured)",
-                ServerImplBase::get_oldest_supported_protocol_version(), get_current_protocol_version(),
-                m_protocol_version_range.first,
-                m_protocol_version_range.second); // Throws
-    logger.info("Platform: %1", util::get_platform_info());
-    bool is_debug_build = false;
-#if REALM_DEBUG
-    is_debug_build = true;
-#endif
-    {
-        const char* lead_text = "Build mode";
-        if (is_debug_build) {
-            logger.info("%1: Debug", lead_text); // Throws
-        }
-        else {
-            logger.info("%1: Release", lead_text); // Throws
-        }
+    std::int_fast64_t conn_id = conn->get_id();
+    m_http_connections.emplace(conn_id, std::move(conn)); // Throws
+    m_num_http_connections = m_http_connections.size();
+}
+
+
+void NetworkShard::remove_http_connection(std::int_fast64_t conn_id) noexcept
+{
+    m_http_connections.erase(conn_id);
+    m_num_http_connections = m_http_connections.size();
+}
+
+
+SyncConnection* NetworkShard::get_sync_connection(std::int_fast64_t conn_id) noexcept
+{
+    auto i = m_sync_connections.find(conn_id);
+    if (i == m_sync_connections.end())
+        return nullptr;
+    return i->second.get();
+}
+
+
+void NetworkShard::add_sync_connection(std::unique_ptr<SyncConnection> conn)
+{
+    std::int_fast64_t conn_id = conn->get_id();
+    m_sync_connections.emplace(conn_id, std::move(conn)); // Throws
+    m_num_sync_connections = m_sync_connections.size();
+}
+
+
+void NetworkShard::remove_sync_connection(std::int_fast64_t conn_id) noexcept
+{
+    m_sync_connections.erase(conn_id);
+    m_num_sync_connections = m_sync_connections.size();
+}
+
+
+Session* NetworkShard::get_session(std::int_fast64_t conn_id, session_ident_type session_ident) noexcept
+{
+    auto i = m_sessions.find(conn_id);
+    if (i == m_sessions.end())
+        return nullptr;
+    auto j = i->second.find(session_ident);
+    if (j == i->second.end())
+        return nullptr;
+    return j->second.get();
+}
+
+
+Session& NetworkShard::create_session(std::shared_ptr<SyncConnectionInfo> conn, session_ident_type session_ident)
+{
+    std::int_fast64_t conn_id = conn->id;
+    std::unique_ptr<Session> sess = std::make_unique<Session>(*this, std::move(conn), session_ident); // Throws
+    Session& sess_ref = *sess;
+    auto p = m_sessions[conn_id].emplace(session_ident, std::move(sess)); // Throws
+    REALM_ASSERT(p.second);
+    return sess_ref;
+}
+
+
+void NetworkShard::discard_session(std::int_fast64_t conn_id, session_ident_type session_ident,
+                                   bool notify_connection)
+{
+    auto i = m_sessions.find(conn_id);
+    REALM_ASSERT(i != m_sessions.end());
+    i->second.erase(session_ident);
+    if (i->second.empty())
+        m_sessions.erase(i);
+    if (!notify_connection)
+        return;
+
+    auto handler = [session_ident](SyncConnection& conn) {
+        conn.session_discarded(session_ident);
+    };
+    m_server.post_to_sync_connection(conn_id, std::move(handler)); // Throws
+}
+
+
+void NetworkShard::terminate_sessions(std::int_fast64_t conn_id)
+{
+    auto i = m_sessions.find(conn_id);
+    if (i == m_sessions.end())
+        return;
+    for (auto& entry : i->second) {
+        Session& sess = *entry.second;
+        sess.terminate(); // Throws
     }
-    if (is_debug_build) {
-        logger.warn("Build mode is Debug! CAN SEVERELY IMPACT PERFORMANCE - "
-                    "NOT RECOMMENDED FOR PRODUCTION"); // Throws
+    m_sessions.erase(i);
+}
+
+
+void NetworkShard::send_session_message(std::int_fast64_t conn_id, session_ident_type session_ident)
+{
+    OutgoingMessage message;
+    Session* sess = get_session(conn_id, session_ident);
+    if (sess && sess->is_enlisted_to_send()) {
+        REALM_ASSERT(!m_sending_session);
+        m_sending_session = sess;
+        m_outgoing_message = &message;
+        auto reset = util::make_scope_exit([this]() noexcept {
+            m_sending_session = nullptr;
+            m_outgoing_message = nullptr;
+        });
+        sess->send_message(); // Throws
+        // Session object may have been destroyed at this point (suicide)
+        sess = get_session(conn_id, session_ident);
+        if (sess) {
+            message.enlist = sess->is_enlisted_to_send();
+            message.error_message_sent = sess->error_message_sent();
+        }
     }
-    logger.info("Directory holding persistent state: %1", m_root_dir);        // Throws
-    logger.info("Maximum number of open files: %1", m_config.max_open_files); // Throws
+
+    auto handler = [session_ident, message = std::move(message)](SyncConnection& conn) mutable {
+        conn.receive_session_message(session_ident, std::move(message)); // Throws
+    };
+    m_server.post_to_sync_connection(conn_id, std::move(handler)); // Throws
+}
+
+
+OutputBuffer& NetworkShard::get_output_buffer()
+{
+    m_output_buffer.reset();
+    return m_output_buffer;
+}
+
+
+void NetworkShard::initiate_write_output_buffer(const char* body, std::size_t body_size,
+                                                std::shared_ptr<const void> body_owner)
+{
+    REALM_ASSERT(m_outgoing_message);
+    OutgoingMessage& message = *m_outgoing_message;
+    REALM_ASSERT(message.head.empty());
+    message.head.assign(m_output_buffer.data(), m_output_buffer.data() + m_output_buffer.size()); // Throws
+    message.body = body;
+    message.body_size = body_size;
+    message.body_owner = std::move(body_owner);
+}
+
+
+util::bind_ptr<ServerFile> NetworkShard::get_or_create_file(const std::string& virt_path)
+{
+    util::bind_ptr<ServerFile> file = get_file(virt_path);
+    if (REALM_LIKELY(file))
+        return file;
+
+    REALM_ASSERT(&m_server.get_file_shard(virt_path) == this);
+    const std::string& root_dir = m_server.get_root_dir();
+    _impl::VirtualPathComponents virt_path_components = _impl::parse_virtual_path(root_dir, virt_path); // Throws
+    REALM_ASSERT(virt_path_components.is_valid);
+
+    _impl::make_dirs(root_dir, virt_path); // Throws
+    m_server.add_realm_name(virt_path);    // Throws
     {
-        const char* lead_text = "Encryption";
-        if (m_config.encryption_key) {
-            std::string fingerprint = encrypt::calculate_fingerprint(m_config.encryption_key); // Throws
-            logger.info("%1: Yes (fingerprint = %2)", lead_text, fingerprint);                 // Throws
-        }
-        else {
-            logger.info("%1: No", lead_text); // Throws
-        }
+        bool disable_sync_to_disk = m_server.get_config().disable_sync_to_disk;
+        // Set metrics scope when constructing the ServerFile object to
+        // ensure that all metered members of ServerFile get initialized
+        // with the correct metric name.
+        AllocationMetricNameScope scope{g_worker_queue_metric};
+        file.reset(new ServerFile(*this, m_server.assign_worker(), virt_path, virt_path_components.real_realm_path,
+                                  disable_sync_to_disk)); // Throws
+    }
+
+    file->initialize();
+    m_files[virt_path] = file; // Throws
+    file->activate();          // Throws
+    return file;
+}
+
+
+util::bind_ptr<ServerFile> NetworkShard::get_file(const std::string& virt_path) noexcept
+{
+    auto i = m_files.find(virt_path);
+    if (REALM_LIKELY(i != m_files.end()))
+        return i->second;
+    return {};
+}
+
+
+void NetworkShard::remove_file(const std::string& virt_path)
+{
+    m_files.erase(virt_path);
+    m_download_cache.erase_file(virt_path);
+    m_server.remove_realm_name(virt_path); // Throws
+}
+
+
+void NetworkShard::reap_connections(SteadyTimePoint now)
+{
+    {
+        auto end = m_http_connections.end();
+        auto i = m_http_connections.begin();
+        while (i != end) {
+            HTTPConnection& conn = *i->second;
+            ++i;
+            // Suicide
+            conn.terminate_if_dead(now); // Throws
+        }
+    }
+    {
+        auto end = m_sync_connections.end();
+        auto i = m_sync_connections.begin();
+        while (i != end) {
+            SyncConnection& conn = *i->second;
+            ++i;
+            // Suicide
+            conn.terminate_if_dead(now); // Throws
+        }
+    }
+}
+
+
+void NetworkShard::close_connections()
+{
+    for (auto& entry : m_sync_connections) {
+        SyncConnection& conn = *entry.second;
+        conn.initiate_soft_close(); // Throws
+    }
+}
+
+
+bool NetworkShard::owner_is_sync_server() const noexcept
+{
+    // The worker thread is considered to be the sync agent (sync server) from
+    // the point of view of the server history class, not the network event loop
+    // thread.
+    return false;
+}
+
+
+std::mt19937_64& NetworkShard::server_history_get_random() noexcept
+{
+    return m_random;
+}
+
+
+bool NetworkShard::get_compaction_params(bool& ignore_clients, std::chrono::seconds& time_to_live,
+                                         std::chrono::seconds& compaction_interval) noexcept
+{
+    return m_server.get_compaction_params(ignore_clients, time_to_live, compaction_interval);
+}
+
+
+Clock::time_point NetworkShard::get_compaction_clock_now() const noexcept
+{
+    return m_server.get_compaction_clock_now();
+}
+
+
+void NetworkShard::start_keep_running_timer()
+{
+    auto handler = [this](std::error_code ec) {
+        if (ec != util::error::operation_aborted)
+            start_keep_running_timer();
+    };
+    m_keep_running_timer->async_wait(std::chrono::hours(1000), handler); // Throws
+}
+
+
+void NetworkShard::run()
+{
+    REALM_ASSERT(m_own_service);
+    AllocationMetricsContextScope tenant_scope{m_allocation_metrics_context};
+    start_keep_running_timer(); // Throws
+    m_service.run();            // Throws
+}
+
+
+void NetworkShard::stop() noexcept
+{
+    m_service.stop();
+}
+
+
+// ============================ ServerImpl implementation ============================
+
+
+ServerImpl::ServerImpl(const std::string& root_dir, util::Optional<sync::PKey> pkey, Server::Config config)
+    : logger{config.logger ? *config.logger : g_fallback_logger}
+    , m_config{std::move(config)}
+    , m_max_upload_backlog{determine_max_upload_backlog(config)}
+    , m_root_dir{root_dir} // Throws
+    , m_access_control{std::move(pkey)}
+    , m_protocol_version_range{determine_protocol_version_range(config)} // Throws
+    , m_metrics{m_config.metrics ? *m_config.metrics : g_null_metrics}
+    , m_acceptor{get_service()}
+    , m_integration_reporter{*this}
+    , m_connection_reaper_timeout{m_config.connection_reaper_timeout}
+    , m_allocation_metrics_timer{get_service()}
+{
+    if (m_config.ssl) {
+        m_ssl_context = std::make_unique<util::network::ssl::Context>();          // Throws
+        m_ssl_context->use_certificate_chain_file(m_config.ssl_certificate_path); // Throws
+        m_ssl_context->use_private_key_file(m_config.ssl_certificate_key_path);   // Throws
+    }
+    int num_workers = std::max(m_config.num_integration_workers, 1);
+    long max_open_files = std::max(m_config.max_open_files / num_workers, 1L);
+    for (int i = 0; i < num_workers; ++i) {
+        std::string logger_prefix = (num_workers == 1 ? "Worker: " : util::format("Worker[%1]: ", i + 1)); // Throws
+        m_workers.push_back(std::make_unique<Worker>(*this, i, logger_prefix, max_open_files));           // Throws
+    }
+    // When no network shards are configured, a single network shard uses the
+    // main event loop.
+    bool use_main_service = (m_config.num_network_shards == 0);
+    int num_shards = std::max(m_config.num_network_shards, 1);
+    long max_open_files_per_shard = std::max(m_config.max_open_files / num_shards, 1L);
+    std::size_t download_cache_max_size_per_shard = m_config.download_cache_max_size / std::size_t(num_shards);
+    for (int i = 0; i < num_shards; ++i) {
+        util::network::Service* service = (use_main_service ? &m_service : nullptr);
+        m_network_shards.push_back(std::make_unique<NetworkShard>(*this, service, max_open_files_per_shard,
+                                                                  download_cache_max_size_per_shard)); // Throws
+    }
+}
+
+
+ServerImpl::~ServerImpl() noexcept
+{
+    bool server_destroyed_while_still_running = m_running;
+    REALM_ASSERT_RELEASE(!server_destroyed_while_still_running);
+}
+
+
+void ServerImpl::start()
+{
+    logger.info("Realm sync server started (%1, %2)", REALM_VER_CHUNK,
+                REALM_SYNC_VER_CHUNK); // Throws
+    logger.info("Supported protocol versions: %1-%2 (%3-%4 configured)",
+                ServerImplBase::get_oldest_supported_protocol_version(), get_current_protocol_version(),
+                m_protocol_version_range.first,
+                m_protocol_version_range.second); // Throws
+    logger.info("Platform: %1", util::get_platform_info());
+    bool is_debug_build = false;
+#if REALM_DEBUG
+    is_debug_build = true;
+#endif
+    {
+        const char* lead_text = "Build mode";
+        if (is_debug_build) {
+            logger.info("%1: Debug", lead_text); // Throws
+        }
+        else {
+            logger.info("%1: Release", lead_text); // Throws
+        }
+    }
+    if (is_debug_build) {
+        logger.warn("Build mode is Debug! CAN SEVERELY IMPACT PERFORMANCE - "
+                    "NOT RECOMMENDED FOR PRODUCTION"); // Throws
+    }
+    logger.info("Directory holding persistent state: %1", m_root_dir);        // Throws
+    logger.info("Maximum number of open files: %1", m_config.max_open_files); // Throws
+    {
+        const char* lead_text = "Encryption";
+        if (m_config.encryption_key) {
+            std::string fingerprint = encrypt::calculate_fingerprint(m_config.encryption_key); // Throws
+            logger.info("%1: Yes (fingerprint = %2)", lead_text, fingerprint);                 // Throws
+        }
+        else {
+            logger.info("%1: No", lead_text); // Throws
+        }
     }
     logger.info("Log level: %1", logger.level_threshold.get()); // Throws
     {
@@ -5335,12 +6809,16 @@ void ServerImpl::start()
     logger.info("Download bootstrap caching: %1",
                 (m_config.enable_download_bootstrap_cache ? "Yes" : "No"));                // Throws
     logger.info("Max download size: %1 bytes", m_config.max_download_size);                // Throws
+    logger.info("Download cache size: %1 bytes", m_config.download_cache_max_size);        // Throws
+    logger.info("State Realms: %1", (m_config.disable_state_realms ? "No" : "Yes"));       // Throws
     logger.info("Max upload backlog: %1 bytes", m_max_upload_backlog);                     // Throws
     logger.info("HTTP request timeout: %1 ms", m_config.http_request_timeout);             // Throws
     logger.info("HTTP response timeout: %1 ms", m_config.http_response_timeout);           // Throws
     logger.info("Connection reaper timeout: %1 ms", m_config.connection_reaper_timeout);   // Throws
     logger.info("Connection reaper interval: %1 ms", m_config.connection_reaper_interval); // Throws
     logger.info("Connection soft close timeout: %1 ms", m_config.soft_close_timeout);      // Throws
+    logger.info("Network shards: %1", m_config.num_network_shards);                        // Throws
+    logger.info("Integration workers: %1", m_workers.size());                              // Throws
     {
         const char* lead_text = "In-place history compaction";
         if (m_config.disable_history_compaction) {
@@ -5381,15 +6859,20 @@ void ServerImpl::start()
 
     m_transformer = make_transformer(); // Throws
 
-    m_realm_names = _impl::find_realm_files(m_root_dir); // Throws
+    std::size_t num_realms;
+    {
+        util::LockGuard lock{m_realm_names_mutex};
+        m_realm_names = _impl::find_realm_files(m_root_dir); // Throws
+        num_realms = m_realm_names.size();
+    }
 
     // set the initial gauge values so we can use relative values against them
-    metrics().gauge("connection.online", 0);                     // Throws
-    metrics().gauge("connection.total", 0);                      // Throws
-    metrics().gauge("session.online", 0);                        // Throws
-    metrics().gauge("session.total", 0);                         // Throws
-    metrics().gauge("realms.all", double(m_realm_names.size())); // Throws
-    metrics().gauge("realms.open", 0);                           // Throws
+    metrics().gauge("connection.online", 0);            // Throws
+    metrics().gauge("connection.total", 0);             // Throws
+    metrics().gauge("session.online", 0);               // Throws
+    metrics().gauge("session.total", 0);                // Throws
+    metrics().gauge("realms.all", double(num_realms));  // Throws
+    metrics().gauge("realms.open", 0);                  // Throws
 
     // FIXME: `upload.pending.bytes` is currently undocumented
     metrics().gauge("upload.pending.bytes", 0); // Throws
@@ -5437,19 +6920,47 @@ void ServerImpl::run()
     auto ta = util::make_temp_assign(m_running, true);
 
     {
-        auto worker_thread = util::make_thread_exec_guard(m_worker, *this); // Throws
         std::string name;
-        if (util::Thread::get_name(name)) {
-            name += "-worker";
-            worker_thread.start_with_signals_blocked(name); // Throws
+        bool have_name = util::Thread::get_name(name);
+
+        using WorkerThreadExecGuard = util::ThreadExecGuardWithParent<Worker, ServerImpl>;
+        std::vector<WorkerThreadExecGuard> worker_threads;
+        worker_threads.reserve(m_workers.size()); // Throws
+        for (std::size_t i = 0; i < m_workers.size(); ++i) {
+            worker_threads.push_back(util::make_thread_exec_guard(*m_workers[i], *this)); // Throws
+            if (have_name) {
+                std::string worker_name = name + "-worker";
+                if (m_workers.size() > 1)
+                    worker_name += "-" + std::to_string(i + 1);
+                worker_threads.back().start_with_signals_blocked(worker_name); // Throws
+            }
+            else {
+                worker_threads.back().start_with_signals_blocked(); // Throws
+            }
         }
-        else {
-            worker_thread.start_with_signals_blocked(); // Throws
+
+        using ShardThreadExecGuard = util::ThreadExecGuardWithParent<NetworkShard, ServerImpl>;
+        std::vector<ShardThreadExecGuard> shard_threads;
+        shard_threads.reserve(m_network_shards.size()); // Throws
+        for (std::size_t i = 0; i < m_network_shards.size(); ++i) {
+            NetworkShard& shard = *m_network_shards[i];
+            if (!shard.is_threaded())
+                continue;
+            shard_threads.push_back(util::make_thread_exec_guard(shard, *this)); // Throws
+            if (have_name) {
+                shard_threads.back().start_with_signals_blocked(name + "-net-" + std::to_string(i + 1)); // Throws
+            }
+            else {
+                shard_threads.back().start_with_signals_blocked(); // Throws
+            }
         }
 
         m_service.run(); // Throws
 
-        worker_thread.stop_and_rethrow(); // Throws
+        for (ShardThreadExecGuard& shard_thread : shard_threads)
+            shard_thread.stop_and_rethrow(); // Throws
+        for (WorkerThreadExecGuard& worker_thread : worker_threads)
+            worker_thread.stop_and_rethrow(); // Throws
     }
 
     logger.info("Realm sync server stopped");
@@ -5474,36 +6985,42 @@ void ServerImpl::report_event_loop_metrics(std::function<EventLoopMetricsHandler
 
 void ServerImpl::dec_num_outstanding_compaction_processes()
 {
-    REALM_ASSERT(m_num_outstanding_compaction_processes > 0);
-    if (REALM_LIKELY(--m_num_outstanding_compaction_processes > 0))
-        return;
-    if (HTTPConnection* conn = get_http_connection(m_compacting_connection))
-        conn->respond_200_ok(); // Throws
+    std::int_fast64_t conn_id;
+    {
+        util::LockGuard lock{m_compaction_mutex};
+        REALM_ASSERT(m_num_outstanding_compaction_processes > 0);
+        if (REALM_LIKELY(--m_num_outstanding_compaction_processes > 0))
+            return;
+        conn_id = m_compacting_connection;
+    }
+    auto handler = [](HTTPConnection& conn) {
+        conn.respond_200_ok(); // Throws
+    };
+    post_to_http_connection(conn_id, std::move(handler)); // Throws
 }
 
 
 void ServerImpl::inc_byte_size_for_pending_downstream_changesets(std::size_t byte_size)
 {
-    m_pending_changesets_from_downstream_byte_size += byte_size;
+    std::size_t total = m_pending_changesets_from_downstream_byte_size.fetch_add(byte_size) + byte_size;
     logger.debug("Byte size for pending downstream changesets incremented by "
                  "%1 to reach a total of %2",
                  byte_size,
-                 m_pending_changesets_from_downstream_byte_size); // Throws
-    metrics().gauge("upload.pending.bytes",
-                    double(m_pending_changesets_from_downstream_byte_size)); // Throws
+                 total);                                        // Throws
+    metrics().gauge("upload.pending.bytes", double(total)); // Throws
 }
 
 
 void ServerImpl::dec_byte_size_for_pending_downstream_changesets(std::size_t byte_size)
 {
-    REALM_ASSERT(byte_size <= m_pending_changesets_from_downstream_byte_size);
-    m_pending_changesets_from_downstream_byte_size -= byte_size;
+    std::size_t prev_total = m_pending_changesets_from_downstream_byte_size.fetch_sub(byte_size);
+    REALM_ASSERT(byte_size <= prev_total);
+    std::size_t total = prev_total - byte_size;
     logger.debug("Byte size for pending downstream changesets decremented by "
                  "%1 to reach a total of %2",
                  byte_size,
-                 m_pending_changesets_from_downstream_byte_size); // Throws
-    metrics().gauge("upload.pending.bytes",
-                    double(m_pending_changesets_from_downstream_byte_size)); // Throws
+                 total);                                        // Throws
+    metrics().gauge("upload.pending.bytes", double(total)); // Throws
 }
 
 
@@ -5615,7 +7132,11 @@ void ServerImpl::initiate_accept()
             handle_accept(ec);
     };
     bool is_ssl = bool(m_ssl_context);
-    m_next_http_conn.reset(new HTTPConnection(*this, ++m_next_conn_id, is_ssl));                 // Throws
+    std::int_fast64_t conn_id = ++m_next_conn_id;
+    // The socket is created on the event loop of the network shard that will
+    // own the connection.
+    NetworkShard& shard = get_connection_shard(conn_id);
+    m_next_http_conn.reset(new HTTPConnection(shard, conn_id, is_ssl));                          // Throws
     m_acceptor.async_accept(m_next_http_conn->get_socket(), m_next_http_conn_endpoint, handler); // Throws
 }
 
@@ -5649,70 +7170,102 @@ void ServerImpl::handle_accept(std::error_code ec)
         metrics().increment("connection.failed");    // Throws
     }
     else {
-        HTTPConnection& conn = *m_next_http_conn;
+        std::unique_ptr<HTTPConnection> conn = std::move(m_next_http_conn);
         if (m_config.tcp_no_delay)
-            conn.get_socket().set_option(util::network::SocketBase::no_delay(true)); // Throws
-        m_http_connections.emplace(conn.get_id(), std::move(m_next_http_conn));      // Throws
-        Formatter& formatter = m_misc_buffers.formatter;
+            conn->get_socket().set_option(util::network::SocketBase::no_delay(true)); // Throws
+        Formatter& formatter = m_formatter;
         formatter.reset();
         formatter << "[" << m_next_http_conn_endpoint.address() << "]:" << m_next_http_conn_endpoint.port(); // Throws
         std::string remote_endpoint = {formatter.data(), formatter.size()};                                  // Throws
-        conn.initiate(std::move(remote_endpoint));                                                           // Throws
+
+        // Connections are handed out to the network shards in round-robin
+        // order (see get_connection_shard()).
+        NetworkShard& shard = get_connection_shard(conn->get_id());
+        auto handler = [&shard, conn = std::move(conn), remote_endpoint = std::move(remote_endpoint)]() mutable {
+            HTTPConnection& conn_ref = *conn;
+            shard.add_http_connection(std::move(conn));   // Throws
+            conn_ref.initiate(std::move(remote_endpoint)); // Throws
+        };
+        shard.post(std::move(handler)); // Throws
     }
     initiate_accept(); // Throws
 }
 
 
-HTTPConnection* ServerImpl::get_http_connection(std::int_fast64_t conn_id) noexcept
+std::size_t ServerImpl::get_number_of_http_connections() const noexcept
 {
-    auto i = m_http_connections.find(conn_id);
-    if (i == m_http_connections.end())
-        return nullptr;
-    return i->second.get();
+    std::size_t n = 0;
+    for (const auto& shard : m_network_shards)
+        n += shard->get_number_of_http_connections();
+    return n;
 }
 
 
-void ServerImpl::remove_http_connection(std::int_fast64_t conn_id) noexcept
+std::size_t ServerImpl::get_number_of_sync_connections() const noexcept
 {
-    m_http_connections.erase(conn_id);
+    std::size_t n = 0;
+    for (const auto& shard : m_network_shards)
+        n += shard->get_number_of_sync_connections();
+    return n;
 }
 
 
-void ServerImpl::add_sync_connection(int_fast64_t connection_id, std::unique_ptr<SyncConnection>&& sync_conn)
+std::set<std::string> ServerImpl::get_realm_names() const
 {
-    m_sync_connections.emplace(connection_id, std::move(sync_conn));
+    util::LockGuard lock{m_realm_names_mutex};
+    return m_realm_names; // Throws (copy)
 }
 
 
-void ServerImpl::remove_sync_connection(int_fast64_t connection_id)
+bool ServerImpl::has_realm_name(const std::string& virt_path) const
 {
-    m_sync_connections.erase(connection_id);
+    util::LockGuard lock{m_realm_names_mutex};
+    return (m_realm_names.count(virt_path) != 0);
 }
 
 
-void ServerImpl::remove_file(const std::string& virt_path)
+void ServerImpl::add_realm_name(const std::string& virt_path)
 {
-    m_files.erase(virt_path);
-    m_realm_names.erase(virt_path);
-    metrics().gauge("realms.all", double(m_realm_names.size())); // Throws
+    std::size_t num_realms;
+    {
+        util::LockGuard lock{m_realm_names_mutex};
+        auto p = m_realm_names.insert(virt_path); // Throws
+        bool was_inserted = p.second;
+        if (!was_inserted)
+            return;
+        num_realms = m_realm_names.size();
+    }
+    metrics().gauge("realms.all", double(num_realms)); // Throws
+}
+
+
+void ServerImpl::remove_realm_name(const std::string& virt_path)
+{
+    std::size_t num_realms;
+    {
+        util::LockGuard lock{m_realm_names_mutex};
+        m_realm_names.erase(virt_path);
+        num_realms = m_realm_names.size();
+    }
+    metrics().gauge("realms.all", double(num_realms)); // Throws
 }
 
 
 void ServerImpl::set_connection_reaper_timeout(milliseconds_type timeout)
 {
-    auto handler = [this, timeout] {
-        m_config.connection_reaper_timeout = timeout;
-    };
-    get_service().post(std::move(handler));
+    m_connection_reaper_timeout = timeout;
 }
 
 
 void ServerImpl::close_connections()
 {
-    auto handler = [this] {
-        do_close_connections(); // Throws
-    };
-    get_service().post(std::move(handler));
+    for (const auto& shard : m_network_shards) {
+        NetworkShard& shard_2 = *shard;
+        auto handler = [&shard_2] {
+            shard_2.close_connections(); // Throws
+        };
+        shard_2.post(std::move(handler)); // Throws
+    }
 }
 
 
@@ -5724,11 +7277,13 @@ bool ServerImpl::map_virtual_to_real_path(const std::string& virt_path, std::str
 
 void ServerImpl::recognize_external_change(const std::string& virt_path)
 {
+    NetworkShard& shard = get_file_shard(virt_path);
     std::string virt_path_2 = virt_path; // Throws (copy)
-    auto handler = [this, virt_path = std::move(virt_path_2)] {
-        do_recognize_external_change(virt_path); // Throws
+    auto handler = [&shard, virt_path = std::move(virt_path_2)] {
+        if (util::bind_ptr<ServerFile> file = shard.get_file(virt_path))
+            file->recognize_external_change(); // Throws
     };
-    get_service().post(std::move(handler)); // Throws
+    shard.post(std::move(handler)); // Throws
 }
 
 
@@ -5765,34 +7320,12 @@ void ServerImpl::reap_connections()
 {
     logger.debug("Discarding dead connections"); // Throws
     SteadyTimePoint now = steady_clock_now();
-    {
-        auto end = m_http_connections.end();
-        auto i = m_http_connections.begin();
-        while (i != end) {
-            HTTPConnection& conn = *i->second;
-            ++i;
-            // Suicide
-            conn.terminate_if_dead(now); // Throws
-        }
-    }
-    {
-        auto end = m_sync_connections.end();
-        auto i = m_sync_connections.begin();
-        while (i != end) {
-            SyncConnection& conn = *i->second;
-            ++i;
-            // Suicide
-            conn.terminate_if_dead(now); // Throws
-        }
-    }
-}
-
-
-void ServerImpl::do_close_connections()
-{
-    for (auto& entry : m_sync_connections) {
-        SyncConnection& conn = *entry.second;
-        conn.initiate_soft_close(); // Throws
+    for (const auto& shard : m_network_shards) {
+        NetworkShard& shard_2 = *shard;
+        auto handler = [&shard_2, now] {
+            shard_2.reap_connections(now); // Throws
+        };
+        shard_2.post(std::move(handler)); // Throws
     }
 }
 
@@ -5821,44 +7354,67 @@ void ServerImpl::periodic_log_lsof(uint_fast64_t period)
 
 void ServerImpl::initiate_compact_realm(std::int_fast64_t conn_id, StringData virt_path)
 {
-    if (m_num_outstanding_compaction_processes == 0) {
-        m_compacting_connection = conn_id;
-        if (virt_path.size() > 0) {
-            auto i = m_realm_names.find(virt_path);
-            if (i != m_realm_names.end()) {
-                logger.detail("Scheduling compaction of '%1'", virt_path); // Throws
-                inc_num_outstanding_compaction_processes();
-                util::bind_ptr<ServerFile> file = get_or_create_file(virt_path); // Throws
-                file->initiate_compaction();                                     // Throws
-                return;
+    bool busy = false;
+    bool not_found = false;
+    std::vector<std::string> virt_paths;
+    {
+        util::LockGuard lock{m_compaction_mutex};
+        if (m_num_outstanding_compaction_processes == 0) {
+            if (virt_path.size() > 0) {
+                std::string virt_path_2 = virt_path; // Throws (copy)
+                if (has_realm_name(virt_path_2)) {
+                    virt_paths.push_back(std::move(virt_path_2)); // Throws
+                }
+                else {
+                    not_found = true;
+                }
             }
-            if (HTTPConnection* conn = get_http_connection(conn_id))
-                conn->respond_404_not_found(); // Throws
-            return;
+            else {
+                std::set<std::string> realm_names = get_realm_names(); // Throws
+                virt_paths.assign(realm_names.begin(), realm_names.end()); // Throws
+                logger.detail("Scheduling compaction of all %1 Realm files",
+                              virt_paths.size()); // Throws
+            }
+            m_num_outstanding_compaction_processes = virt_paths.size();
+            m_compacting_connection = conn_id;
         }
-        logger.detail("Scheduling compaction of all %1 Realm files",
-                      m_realm_names.size()); // Throws
-        inc_num_outstanding_compaction_processes();
-        for (const std::string& virt_path : m_realm_names) {
-            inc_num_outstanding_compaction_processes();
-            util::bind_ptr<ServerFile> file = get_or_create_file(virt_path); // Throws
-            file->initiate_compaction();                                     // Throws
+        else {
+            busy = true;
         }
-        dec_num_outstanding_compaction_processes(); // Throws
+    }
+    if (busy || not_found || virt_paths.empty()) {
+        auto handler = [busy, not_found](HTTPConnection& conn) {
+            if (busy) {
+                conn.respond_503_service_unavailable(); // Throws
+            }
+            else if (not_found) {
+                conn.respond_404_not_found(); // Throws
+            }
+            else {
+                conn.respond_200_ok(); // Throws
+            }
+        };
+        post_to_http_connection(conn_id, std::move(handler)); // Throws
         return;
     }
-    if (HTTPConnection* conn = get_http_connection(conn_id))
-        conn->respond_503_service_unavailable(); // Throws
-}
 
-
-void ServerImpl::do_recognize_external_change(const std::string& virt_path)
-{
-    auto i = m_files.find(virt_path);
-    if (i == m_files.end())
-        return;
-    ServerFile& file = *i->second;
-    file.recognize_external_change();
+    // Each server file is compacted by the network shard that it is pinned
+    // to.
+    for (std::string& virt_path_2 : virt_paths) {
+        if (virt_path.size() > 0)
+            logger.detail("Scheduling compaction of '%1'", virt_path_2); // Throws
+        NetworkShard& shard = get_file_shard(virt_path_2);
+        auto handler = [this, &shard, virt_path = std::move(virt_path_2)] {
+            // The file may have been deleted in the meantime
+            if (REALM_UNLIKELY(!has_realm_name(virt_path))) {
+                dec_num_outstanding_compaction_processes(); // Throws
+                return;
+            }
+            util::bind_ptr<ServerFile> file = shard.get_or_create_file(virt_path); // Throws
+            file->initiate_compaction();                                           // Throws
+        };
+        shard.post(std::move(handler)); // Throws
+    }
 }
 
 
@@ -5888,6 +7444,8 @@ void ServerImpl::handle_allocation_metrics_wait()
     reporter.gauge("memory,subsystem=decrypted", double(decr_mem.memory_size));
     reporter.gauge("memory,subsystem=reclaimer_workload", double(decr_mem.reclaimer_workload));
     reporter.gauge("memory,subsystem=reclaimer_target", double(decr_mem.reclaimer_target));
+    reporter.gauge("memory,subsystem=decrypted_page_hits", double(decr_mem.page_hits));
+    reporter.gauge("memory,subsystem=decrypted_page_misses", double(decr_mem.page_misses));
     reporter.gauge("memory,subsystem=core-slab", double(SlabAlloc::get_total_slab_size()));
     initiate_allocation_metrics_wait();
 }
@@ -5898,7 +7456,7 @@ void ServerImpl::do_stop_sync_and_wait_for_backup_completion(
     static_cast<void>(timeout);
     if (m_sync_stopped)
         return;
-    do_close_connections(); // Throws
+    close_connections(); // Throws
     m_sync_stopped = true;
     bool completion_reached = false;
     completion_handler(completion_reached); // Throws
@@ -5935,7 +7493,7 @@ void SyncConnection::terminate(ConnectionTerminationReason reason, Logger::Level
     m_ssl_stream.reset();
     m_socket.reset();
     // Suicide
-    m_server.remove_sync_connection(m_id);
+    m_shard.remove_sync_connection(m_id);
 }
 
 
@@ -5952,7 +7510,7 @@ void SyncConnection::terminate_if_dead(SteadyTimePoint now)
         }
     }
     else {
-        if (time >= config.connection_reaper_timeout) {
+        if (time >= m_server.get_connection_reaper_timeout()) {
             // Suicide
             terminate(termination_reason, Logger::Level::detail,
                       "Sync connection closed (no heartbeat)"); // Throws
@@ -5961,15 +7519,65 @@ void SyncConnection::terminate_if_dead(SteadyTimePoint now)
 }
 
 
-void SyncConnection::enlist_to_send(Session* sess) noexcept
+void SyncConnection::enlist_to_send(session_ident_type session_ident)
 {
-    REALM_ASSERT(!m_is_closing);
-    REALM_ASSERT(!sess->is_enlisted_to_send());
-    m_sessions_enlisted_to_send.push_back(sess);
+    if (REALM_UNLIKELY(m_is_closing))
+        return;
+    if (REALM_UNLIKELY(m_sessions.count(session_ident) == 0))
+        return;
+    m_sessions_enlisted_to_send.push_back(session_ident); // Throws
     m_send_trigger.trigger();
 }
 
 
+void SyncConnection::receive_session_message(session_ident_type session_ident, OutgoingMessage message)
+{
+    REALM_ASSERT(m_awaiting_session_message);
+    REALM_ASSERT(!m_is_sending);
+    m_awaiting_session_message = false;
+
+    if (REALM_UNLIKELY(m_is_closing)) {
+        // Don't waste time and effort sending the message
+        send_next_message(); // Throws
+        return;
+    }
+
+    auto i = m_sessions.find(session_ident);
+    if (i != m_sessions.end()) {
+        SessionEntry& entry = i->second;
+        if (message.error_message_sent)
+            entry.error_message_sent = true;
+        if (message.enlist)
+            m_sessions_enlisted_to_send.push_back(session_ident); // Throws
+    }
+
+    if (!message.head.empty()) {
+        OutputBuffer& out = get_output_buffer();
+        out.write(message.head.data(), std::streamsize(message.head.size())); // Throws
+        if (message.body_size == 0) {
+            initiate_write_output_buffer(); // Throws
+        }
+        else {
+            initiate_write_output_buffer(message.body, message.body_size,
+                                         std::move(message.body_owner)); // Throws
+        }
+    }
+
+    // At this point, `m_is_sending` is true if, and only if the session chose
+    // to send a message that could not be added to the current batch, or
+    // caused the batch to be written. Otherwise, the next session in
+    // `m_sessions_enlisted_to_send` must be given a chance.
+    if (!m_is_sending)
+        send_next_message(); // Throws
+}
+
+
+void SyncConnection::session_discarded(session_ident_type session_ident) noexcept
+{
+    m_sessions.erase(session_ident);
+}
+
+
 void SyncConnection::handle_protocol_error(ServerProtocol::Error error)
 {
     switch (error) {
@@ -6005,7 +7613,7 @@ void SyncConnection::receive_bind_message(session_ident_type session_ident, std:
                                           std::string signed_user_token, bool need_client_file_ident,
                                           bool is_subserver)
 {
-    auto p = m_sessions.emplace(session_ident, nullptr); // Throws
+    auto p = m_sessions.emplace(session_ident, SessionEntry{}); // Throws
     bool was_inserted = p.second;
     if (REALM_UNLIKELY(!was_inserted)) {
         logger.error("Overlapping reuse of session identifier %1 in BIND message",
@@ -6014,22 +7622,29 @@ void SyncConnection::receive_bind_message(session_ident_type session_ident, std:
         protocol_error(ProtocolError::reuse_of_session_ident); // Throws
         return;
     }
+
+    // The session is owned by the network shard that the server file is
+    // pinned to.
+    NetworkShard& shard = m_server.get_file_shard(path);
+    p.first->second.shard = &shard;
+    auto handler = [&shard, info = m_info, session_ident, path = std::move(path),
+                    signed_user_token = std::move(signed_user_token), need_client_file_ident,
+                    is_subserver]() mutable {
+        Session& sess = shard.create_session(std::move(info), session_ident); // Throws
+        sess.initiate();                                                      // Throws
+        ProtocolError error;
+        bool success = sess.receive_bind_message(std::move(path), std::move(signed_user_token),
+                                                 need_client_file_ident, is_subserver, error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
     try {
-        p.first->second.reset(new Session(*this, session_ident)); // Throws
+        shard.post(std::move(handler)); // Throws
     }
     catch (...) {
         m_sessions.erase(p.first);
         throw;
     }
-
-    Session& sess = *p.first->second;
-    sess.initiate(); // Throws
-    ProtocolError error;
-    bool success =
-        sess.receive_bind_message(std::move(path), std::move(signed_user_token), need_client_file_ident, is_subserver,
-                                  error); // Throws
-    if (REALM_UNLIKELY(!success))         // Throws
-        protocol_error(error, &sess);     // Throws
 }
 
 
@@ -6038,78 +7653,66 @@ void SyncConnection::receive_ident_message(session_ident_type session_ident, fil
                                            version_type scan_client_version, version_type latest_server_version,
                                            salt_type latest_server_version_salt)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("IDENT", session_ident); // Throws
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("IDENT", session_ident); // Throws
-        return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
-    if (REALM_UNLIKELY(sess.must_send_ident_message())) {
-        logger.error("Received IDENT message before IDENT message was sent"); // Throws
-        protocol_error(ProtocolError::bad_message_order);                     // Throws
-        metrics().increment("protocol.violated");                             // Throws
-        return;
-    }
-    if (REALM_UNLIKELY(sess.ident_message_received())) {
-        logger.error("Received second IDENT message for session"); // Throws
-        protocol_error(ProtocolError::bad_message_order);          // Throws
-        metrics().increment("protocol.violated");                  // Throws
-        return;
-    }
-    if (REALM_UNLIKELY(sess.must_send_state_message())) {
-        logger.error("Received IDENT message before all STATE messages were sent"); // Throws
-        protocol_error(ProtocolError::bad_message_order);                           // Throws
-        metrics().increment("protocol.violated");                                   // Throws
+    SessionEntry* entry = get_session_entry("IDENT", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
 
-    ProtocolError error = {};
-    bool success = sess.receive_ident_message(client_file_ident, client_file_ident_salt, scan_server_version,
-                                              scan_client_version, latest_server_version, latest_server_version_salt,
-                                              error); // Throws
-    if (REALM_UNLIKELY(!success))                     // Throws
-        protocol_error(error, &sess);                 // Throws
+    auto handler = [=](Session& sess) {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+        if (REALM_UNLIKELY(sess.must_send_ident_message())) {
+            sess.message_order_violation("Received IDENT message before IDENT message was sent"); // Throws
+            return;
+        }
+        if (REALM_UNLIKELY(sess.ident_message_received())) {
+            sess.message_order_violation("Received second IDENT message for session"); // Throws
+            return;
+        }
+        if (REALM_UNLIKELY(sess.must_send_state_message())) {
+            sess.message_order_violation("Received IDENT message before all STATE messages were sent"); // Throws
+            return;
+        }
+
+        ProtocolError error = {};
+        bool success =
+            sess.receive_ident_message(client_file_ident, client_file_ident_salt, scan_server_version,
+                                       scan_client_version, latest_server_version, latest_server_version_salt,
+                                       error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 void SyncConnection::receive_client_version_request_message(session_ident_type session_ident,
                                                             SaltedFileIdent client_file_ident)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("CLIENT_VERSION_REQUEST", session_ident); // Throws
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("CLIENT_VERSION_REQUEST", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("CLIENT_VERSION_REQUEST", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
-    if (REALM_UNLIKELY(sess.ident_message_received())) {
-        logger.error("Received CLIENT_VERSION_REQUEST message after IDENT message for session"); // Throws
-        protocol_error(ProtocolError::bad_message_order);                                        // Throws
-        metrics().increment("protocol.violated");                                                // Throws
-        return;
-    }
 
-    ProtocolError error = {};
-    bool success = sess.receive_client_version_request_message(client_file_ident,
-                                                               error); // Throws
-    if (REALM_UNLIKELY(!success))
-        protocol_error(error, &sess); // Throws
+    auto handler = [=](Session& sess) {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+        if (REALM_UNLIKELY(sess.ident_message_received())) {
+            sess.message_order_violation(
+                "Received CLIENT_VERSION_REQUEST message after IDENT message for session"); // Throws
+            return;
+        }
+
+        ProtocolError error = {};
+        bool success = sess.receive_client_version_request_message(client_file_ident,
+                                                                   error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 void SyncConnection::receive_state_request_message(
@@ -6117,185 +7720,186 @@ void SyncConnection::receive_state_request_message(
     bool need_recent, std::int_fast32_t min_file_format_version, std::int_fast32_t max_file_format_version,
     std::int_fast32_t min_history_schema_version, std::int_fast32_t max_history_schema_version)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("STATE_REQUEST", session_ident); // Throws
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("STATE_REQUEST", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("STATE_REQUEST", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
-    if (REALM_UNLIKELY(sess.must_send_ident_message())) {
-        logger.error("Received STATE_REQUEST message before IDENT message was sent"); // Throws
-        protocol_error(ProtocolError::bad_message_order);                             // Throws
-        metrics().increment("protocol.violated");                                     // Throws
-        return;
-    }
-    if (REALM_UNLIKELY(sess.state_request_message_received())) {
-        logger.error("Received second STATE_REQUEST message for session"); // Throws
-        protocol_error(ProtocolError::bad_message_order);                  // Throws
-        metrics().increment("protocol.violated");                          // Throws
-        return;
-    }
-    if (REALM_UNLIKELY(sess.ident_message_received())) {
-        logger.error("Received STATE_REQUEST message after IDENT message for session"); // Throws
-        protocol_error(ProtocolError::bad_message_order);                               // Throws
-        metrics().increment("protocol.violated");                                       // Throws
-        return;
-    }
 
-    ProtocolError error = {};
-    bool success = sess.receive_state_request_message(
-        partial_transferred_server_version, offset, need_recent, min_file_format_version, max_file_format_version,
-        min_history_schema_version, max_history_schema_version, error); // Throws
-    if (REALM_UNLIKELY(!success))
-        protocol_error(error, &sess); // Throws
+    auto handler = [=](Session& sess) {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+        if (REALM_UNLIKELY(sess.must_send_ident_message())) {
+            sess.message_order_violation("Received STATE_REQUEST message before IDENT message was sent"); // Throws
+            return;
+        }
+        if (REALM_UNLIKELY(sess.state_request_message_received())) {
+            sess.message_order_violation("Received second STATE_REQUEST message for session"); // Throws
+            return;
+        }
+        if (REALM_UNLIKELY(sess.ident_message_received())) {
+            sess.message_order_violation("Received STATE_REQUEST message after IDENT message for session"); // Throws
+            return;
+        }
+
+        ProtocolError error = {};
+        bool success = sess.receive_state_request_message(
+            partial_transferred_server_version, offset, need_recent, min_file_format_version,
+            max_file_format_version, min_history_schema_version, max_history_schema_version, error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 void SyncConnection::receive_upload_message(session_ident_type session_ident, version_type progress_client_version,
                                             version_type progress_server_version, version_type locked_server_version,
                                             const UploadChangesets& upload_changesets)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("UPLOAD", session_ident); // Throws
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("UPLOAD", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("UPLOAD", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
-    if (REALM_UNLIKELY(!sess.ident_message_received())) {
-        message_before_ident("UPLOAD", session_ident); // Throws
-        return;
-    }
 
-    ProtocolError error = {};
-    bool success = sess.receive_upload_message(progress_client_version, progress_server_version,
-                                               locked_server_version, upload_changesets, error); // Throws
-    if (REALM_UNLIKELY(!success))                                                                // Throws
-        protocol_error(error, &sess);                                                            // Throws
+    // The changesets refer to the input buffer of this connection, so they
+    // must be copied before they are passed to another thread.
+    std::size_t size = 0;
+    for (const UploadChangeset& uc : upload_changesets)
+        size += uc.changeset.size();
+    std::vector<char> buffer;
+    buffer.reserve(size); // Throws
+    UploadChangesets upload_changesets_2;
+    upload_changesets_2.reserve(upload_changesets.size()); // Throws
+    for (const UploadChangeset& uc : upload_changesets) {
+        const char* data = buffer.data() + buffer.size();
+        buffer.insert(buffer.end(), uc.changeset.data(), uc.changeset.data() + uc.changeset.size()); // Throws
+        UploadChangeset uc_2 = uc;
+        uc_2.changeset = BinaryData{data, uc.changeset.size()};
+        upload_changesets_2.push_back(uc_2); // Throws
+    }
+
+    auto handler = [=, buffer = std::move(buffer),
+                    upload_changesets = std::move(upload_changesets_2)](Session& sess) {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+        if (REALM_UNLIKELY(!sess.ident_message_received())) {
+            sess.message_order_violation("Received UPLOAD message before IDENT message, session_ident = %1",
+                                         session_ident); // Throws
+            return;
+        }
+
+        ProtocolError error = {};
+        bool success = sess.receive_upload_message(progress_client_version, progress_server_version,
+                                                   locked_server_version, upload_changesets, error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 
 void SyncConnection::receive_mark_message(session_ident_type session_ident, request_ident_type request_ident)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("MARK", session_ident);
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("MARK", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("MARK", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
-    if (REALM_UNLIKELY(!sess.ident_message_received())) {
-        message_before_ident("MARK", session_ident); // Throws
-        return;
-    }
 
-    ProtocolError error;
-    bool success = sess.receive_mark_message(request_ident, error); // Throws
-    if (REALM_UNLIKELY(!success))                                   // Throws
-        protocol_error(error, &sess);                               // Throws
+    auto handler = [=](Session& sess) {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+        if (REALM_UNLIKELY(!sess.ident_message_received())) {
+            sess.message_order_violation("Received MARK message before IDENT message, session_ident = %1",
+                                         session_ident); // Throws
+            return;
+        }
+
+        ProtocolError error;
+        bool success = sess.receive_mark_message(request_ident, error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 
 void SyncConnection::receive_alloc_message(session_ident_type session_ident)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("ALLOC", session_ident);
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("ALLOC", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("ALLOC", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
-    if (REALM_UNLIKELY(!sess.ident_message_received())) {
-        message_before_ident("ALLOC", session_ident); // Throws
-        return;
-    }
-    if (REALM_UNLIKELY(sess.relayed_alloc_request_in_progress())) {
-        logger.error("Received ALLOC message before response to previously received ALLOC message "
-                     "was sent");                         // Throws
-        protocol_error(ProtocolError::bad_message_order); // Throws
-        metrics().increment("protocol.violated");         // Throws
-        return;
-    }
 
-    ProtocolError error;
-    bool success = sess.receive_alloc_message(error); // Throws
-    if (REALM_UNLIKELY(!success))                     // Throws
-        protocol_error(error, &sess);                 // Throws
+    auto handler = [=](Session& sess) {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+        if (REALM_UNLIKELY(!sess.ident_message_received())) {
+            sess.message_order_violation("Received ALLOC message before IDENT message, session_ident = %1",
+                                         session_ident); // Throws
+            return;
+        }
+        if (REALM_UNLIKELY(sess.relayed_alloc_request_in_progress())) {
+            sess.message_order_violation("Received ALLOC message before response to previously received "
+                                         "ALLOC message was sent"); // Throws
+            return;
+        }
+
+        ProtocolError error;
+        bool success = sess.receive_alloc_message(error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 
 void SyncConnection::receive_refresh_message(session_ident_type session_ident, std::string signed_user_token)
 {
-    auto i = m_sessions.find(session_ident);
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("REFRESH", session_ident); // Throws
-        return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("REFRESH", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("REFRESH", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    if (REALM_UNLIKELY(sess.error_occurred())) {
-        // Protocol state is SendError or WaitForUnbindErr. In these states, all
-        // messages, other than UNBIND, must be ignored.
-        return;
-    }
 
-    ProtocolError error;
-    bool success = sess.receive_refresh_message(std::move(signed_user_token), error); // Throws
-    if (REALM_UNLIKELY(!success))                                                     // Throws
-        protocol_error(error, &sess);                                                 // Throws
+    auto handler = [signed_user_token = std::move(signed_user_token)](Session& sess) mutable {
+        if (REALM_UNLIKELY(sess.error_occurred())) {
+            // Protocol state is SendError or WaitForUnbindErr. In these states, all
+            // messages, other than UNBIND, must be ignored.
+            return;
+        }
+
+        ProtocolError error;
+        bool success = sess.receive_refresh_message(std::move(signed_user_token), error); // Throws
+        if (REALM_UNLIKELY(!success))
+            sess.protocol_error(error); // Throws
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
 }
 
 
 void SyncConnection::receive_unbind_message(session_ident_type session_ident)
 {
-    auto i = m_sessions.find(session_ident); // Throws
-    if (REALM_UNLIKELY(i == m_sessions.end())) {
-        bad_session_ident("UNBIND", session_ident); // Throws
+    SessionEntry* entry = get_session_entry("UNBIND", session_ident); // Throws
+    if (REALM_UNLIKELY(!entry))
         return;
-    }
-    Session& sess = *i->second;
-    if (REALM_UNLIKELY(sess.unbind_message_received())) {
-        message_after_unbind("UNBIND", session_ident); // Throws
-        return;
-    }
 
-    sess.receive_unbind_message(); // Throws
-    // NOTE: The session might have gotten destroyed at this time!
+    // If the ERROR message was sent, the UNBIND message completes the
+    // deactivation process, so the session identifier can be forgotten right
+    // away. This allows the client to reuse it immediately.
+    bool forgotten = entry->error_message_sent;
+    entry->unbind_message_received = true;
+    auto handler = [forgotten](Session& sess) {
+        sess.receive_unbind_message(forgotten); // Throws
+        // NOTE: The session might have gotten destroyed at this time!
+    };
+    post_to_session(*entry, session_ident, std::move(handler)); // Throws
+    if (forgotten)
+        m_sessions.erase(session_ident);
 }
 
 
@@ -6310,11 +7914,43 @@ void SyncConnection::receive_ping(milliseconds_type timestamp, milliseconds_type
     }
     m_send_pong = true;
     m_last_ping_timestamp = timestamp;
-    if (!m_is_sending)
+    if (!m_is_sending && !m_awaiting_session_message)
         send_next_message();
 }
 
 
+auto SyncConnection::get_session_entry(const char* message_type, session_ident_type session_ident)
+    -> SessionEntry*
+{
+    auto i = m_sessions.find(session_ident);
+    if (REALM_UNLIKELY(i == m_sessions.end())) {
+        bad_session_ident(message_type, session_ident); // Throws
+        return nullptr;
+    }
+    SessionEntry& entry = i->second;
+    if (REALM_UNLIKELY(entry.unbind_message_received)) {
+        message_after_unbind(message_type, session_ident); // Throws
+        return nullptr;
+    }
+    return &entry;
+}
+
+
+template <class H>
+void SyncConnection::post_to_session(SessionEntry& entry, session_ident_type session_ident, H handler)
+{
+    NetworkShard& shard = *entry.shard;
+    std::int_fast64_t conn_id = m_id;
+    auto handler_2 = [&shard, conn_id, session_ident, handler = std::move(handler)]() mutable {
+        // The session no longer exists if it was terminated in the meantime
+        // (superseded session).
+        if (Session* sess = shard.get_session(conn_id, session_ident))
+            handler(*sess); // Throws
+    };
+    shard.post(std::move(handler_2)); // Throws
+}
+
+
 void SyncConnection::bad_session_ident(const char* message_type, session_ident_type session_ident)
 {
     logger.error("Bad session identifier in %1 message, session_ident = %2", message_type, session_ident); // Throws
@@ -6332,15 +7968,6 @@ void SyncConnection::message_after_unbind(const char* message_type, session_iden
 }
 
 
-void SyncConnection::message_before_ident(const char* message_type, session_ident_type session_ident)
-{
-    logger.error("Received %1 message before IDENT message, session_ident = %2", message_type,
-                 session_ident);                      // Throws
-    protocol_error(ProtocolError::bad_message_order); // Throws
-    metrics().increment("protocol.violated");         // Throws
-}
-
-
 void SyncConnection::handle_message_received(const char* data, size_t size)
 {
     // parse_message_received() parses the message and calls the
@@ -6365,44 +7992,115 @@ void SyncConnection::send_next_message()
 {
     REALM_ASSERT(!m_is_sending);
     REALM_ASSERT(!m_sending_pong);
+    REALM_ASSERT(!m_awaiting_session_message);
     if (m_send_pong) {
         send_pong(m_last_ping_timestamp);
         if (m_sending_pong)
             return;
     }
-    for (;;) {
-        Session* sess = m_sessions_enlisted_to_send.pop_front();
-        if (!sess) {
-            // No sessions were enlisted to send
-            if (REALM_LIKELY(!m_is_closing))
-                return; // Nothing more to do right now
-            // Send a connection level ERROR
-            REALM_ASSERT(!is_session_level_error(m_error_code));
-            initiate_write_error(m_error_code, m_error_session_ident); // Throws
-            return;
-        }
-        sess->send_message(); // Throws
-        // NOTE: The session might have gotten destroyed at this time!
+    while (!m_sessions_enlisted_to_send.empty()) {
+        session_ident_type session_ident = m_sessions_enlisted_to_send.front();
+        m_sessions_enlisted_to_send.pop_front();
+        auto i = m_sessions.find(session_ident);
+        if (REALM_UNLIKELY(i == m_sessions.end()))
+            continue; // Session was discarded after it enlisted
+
+        // Grant the session an opportunity to send a message. The network
+        // shard that owns the session passes the message back to this
+        // connection (receive_session_message()).
+        NetworkShard& shard = *i->second.shard;
+        std::int_fast64_t conn_id = m_id;
+        auto handler = [&shard, conn_id, session_ident] {
+            shard.send_session_message(conn_id, session_ident); // Throws
+        };
+        shard.post(std::move(handler)); // Throws
+        m_awaiting_session_message = true;
+        return;
+    }
 
-        // At this point, `m_is_sending` is true if, and only if the session
-        // chose to send a message. If it chose to not send a message, we must
-        // loop back and give the next session in `m_sessions_enlisted_to_send`
-        // a chance.
-        if (m_is_sending)
-            return;
+    // No more sessions were enlisted to send
+    if (!m_batch_message_sizes.empty()) {
+        initiate_write_batch(); // Throws
+        return;
     }
+    if (REALM_LIKELY(!m_is_closing))
+        return; // Nothing more to do right now
+    // Send a connection level ERROR
+    REALM_ASSERT(!is_session_level_error(m_error_code));
+    initiate_write_error(m_error_code, m_error_session_ident); // Throws
 }
 
 
 void SyncConnection::initiate_write_output_buffer()
 {
+    REALM_ASSERT(!m_is_sending);
+    metrics().increment("protocol.bytes.sent", int(m_output_buffer.size())); // Throws
+
+    // A large message is written directly from the output buffer, unless it
+    // has to go after messages that are already in the batch.
+    if (m_batch_message_sizes.empty() && m_output_buffer.size() >= s_max_write_batch_size) {
+        auto handler = [=]() {
+            handle_write_output_buffer();
+        };
+        m_websocket.async_write_binary(m_output_buffer.data(), m_output_buffer.size(),
+                                       std::move(handler)); // Throws
+        m_is_sending = true;
+        return;
+    }
+
+    m_batch_buffer.insert(m_batch_buffer.end(), m_output_buffer.data(),
+                          m_output_buffer.data() + m_output_buffer.size()); // Throws
+    m_batch_message_sizes.push_back(m_output_buffer.size());                // Throws
+    if (m_batch_buffer.size() >= s_max_write_batch_size)
+        initiate_write_batch(); // Throws
+}
+
+
+void SyncConnection::initiate_write_batch()
+{
+    REALM_ASSERT(!m_batch_message_sizes.empty());
     auto handler = [=]() {
         handle_write_output_buffer();
     };
+    m_websocket.async_write_binary_batch(m_batch_buffer.data(), m_batch_message_sizes.data(),
+                                         m_batch_message_sizes.size(), std::move(handler)); // Throws
+    metrics().increment("protocol.batches.sent");                                           // Throws
+    m_is_sending = true;
+}
 
-    m_websocket.async_write_binary(m_output_buffer.data(), m_output_buffer.size(),
-                                   std::move(handler));                      // Throws
-    metrics().increment("protocol.bytes.sent", int(m_output_buffer.size())); // Throws
+
+void SyncConnection::initiate_write_output_buffer(const char* body, std::size_t body_size,
+                                                  std::shared_ptr<const void> body_owner)
+{
+    if (body_size == 0) {
+        initiate_write_output_buffer(); // Throws
+        return;
+    }
+
+    REALM_ASSERT(!m_is_sending);
+    m_output_body_owner = std::move(body_owner);
+    auto handler = [=]() {
+        auto handler_2 = [=]() {
+            handle_write_output_buffer();
+        };
+        m_websocket.async_write_frame(true, util::websocket::Opcode::continuation, body, body_size,
+                                      std::move(handler_2)); // Throws
+    };
+    auto write_header = [=]() {
+        m_websocket.async_write_frame(false, util::websocket::Opcode::binary, m_output_buffer.data(),
+                                      m_output_buffer.size(), std::move(handler)); // Throws
+    };
+
+    // Messages already in the batch must go first.
+    if (m_batch_message_sizes.empty()) {
+        write_header(); // Throws
+    }
+    else {
+        m_websocket.async_write_binary_batch(m_batch_buffer.data(), m_batch_message_sizes.data(),
+                                             m_batch_message_sizes.size(), std::move(write_header)); // Throws
+        metrics().increment("protocol.batches.sent");                                                // Throws
+    }
+    metrics().increment("protocol.bytes.sent", int(m_output_buffer.size() + body_size)); // Throws
     m_is_sending = true;
 }
 
@@ -6492,38 +8190,17 @@ void SyncConnection::handle_write_error()
 }
 
 
-// For connection level errors, `sess` is ignored. For session level errors, a
-// session must be specified.
-//
-// If a session is specified, that session object will have been detached from
-// the ServerFile object (and possibly destroyed) upon return from
-// protocol_error().
-//
-// If a session is specified for a protocol level error, that session object
-// will have been destroyed upon return from protocol_error(). For session level
-// errors, the specified session will have been destroyed upon return from
-// protocol_error() if, and only if the negotiated protocol version is less than
-// 23.
-void SyncConnection::protocol_error(ProtocolError error_code, Session* sess)
+// Session level errors are handled by Session::protocol_error().
+void SyncConnection::protocol_error(ProtocolError error_code)
 {
     REALM_ASSERT(!m_is_closing);
-    bool session_level = is_session_level_error(error_code);
-    REALM_ASSERT(!session_level || sess);
-    REALM_ASSERT(!sess || m_sessions.count(sess->get_session_ident()) == 1);
+    REALM_ASSERT(!is_session_level_error(error_code));
     if (logger.would_log(util::Logger::Level::debug)) {
         const char* message = get_protocol_error_message(int(error_code));
-        Logger& logger_2 = (session_level ? sess->logger : logger);
-        logger_2.debug("Protocol error: %1 (error_code=%2)", message, int(error_code)); // Throws
-    }
-    session_ident_type session_ident = (session_level ? sess->get_session_ident() : 0);
-    if (session_level) {
-        metrics().increment("session.failed");   // Throws
-        sess->initiate_deactivation(error_code); // Throws
-        return;
-    }
-    else {
-        metrics().increment("connection.failed"); // Throws
+        logger.debug("Protocol error: %1 (error_code=%2)", message, int(error_code)); // Throws
     }
+    metrics().increment("connection.failed");          // Throws
+    session_ident_type session_ident = 0;              // Not session specific
     do_initiate_soft_close(error_code, session_ident); // Throws
 }
 
@@ -6550,8 +8227,6 @@ void SyncConnection::do_initiate_soft_close(ProtocolError error_code, session_id
     m_send_pong = false;
     m_sessions_enlisted_to_send.clear();
 
-    m_receiving_session = nullptr;
-
     terminate_sessions(); // Throws
 
     m_send_trigger.trigger();
@@ -6578,9 +8253,17 @@ void SyncConnection::close_due_to_error(std::error_code ec)
 
 void SyncConnection::terminate_sessions()
 {
-    for (auto& entry : m_sessions) {
-        Session& sess = *entry.second;
-        sess.terminate(); // Throws
+    // Each network shard that owns one or more of the sessions must be told
+    // only once.
+    std::set<NetworkShard*> shards;
+    for (const auto& entry : m_sessions)
+        shards.insert(entry.second.shard); // Throws
+    std::int_fast64_t conn_id = m_id;
+    for (NetworkShard* shard : shards) {
+        auto handler = [shard, conn_id] {
+            shard->terminate_sessions(conn_id); // Throws
+        };
+        shard->post(std::move(handler)); // Throws
     }
     m_sessions_enlisted_to_send.clear();
     m_sessions.clear();
@@ -6595,12 +8278,6 @@ void SyncConnection::initiate_soft_close()
     }
 }
 
-
-void SyncConnection::discard_session(session_ident_type session_ident) noexcept
-{
-    m_sessions.erase(session_ident);
-}
-
 } // anonymous namespace
 
 
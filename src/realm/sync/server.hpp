@@ -183,10 +183,28 @@ public:
         /// minimizing download sizes at the expense of server CPU usage.
         bool disable_download_compaction = false;
 
+        /// Unless disabled, the server compresses UPLOAD and DOWNLOAD message
+        /// bodies with Zstd or LZ4 instead of zlib on connections where the
+        /// client has offered one of them, and Realm is built with it
+        /// (`REALM_USE_ZSTD`, `REALM_USE_LZ4`). Both use a fraction of the CPU
+        /// time of zlib. When disabled, zlib is used on all connections.
+        bool disable_fast_compression = false;
+
         /// If set to true, the server will cache the contents of the DOWNLOAD
         /// message(s) used for client bootstrapping.
         bool enable_download_bootstrap_cache = false;
 
+        /// Unless disabled, a client that asks for the state of a Realm (async
+        /// open, see sync::Session::Config::client_reset_config) is sent a
+        /// client-side Realm file produced from a snapshot of the server-side
+        /// file, and goes on synchronizing from the version of that
+        /// snapshot. The most recently produced state Realm is kept on disk
+        /// until it is superseded, and is reused for clients that do not
+        /// require a recent one. The STATE messages carrying it are limited in
+        /// size by `max_download_size`. When disabled, such clients get an
+        /// empty state, and download the entire history instead.
+        bool disable_state_realms = false;
+
         /// The accumulated size of changesets that are included in download
         /// messages. The size of the changesets is calculated before log
         /// compaction (if enabled). A larger value leads to more efficient
@@ -195,6 +213,20 @@ public:
         /// for the need to resend the same changes after network disconnects.
         std::size_t max_download_size = 0x1000000; // 16 MiB
 
+        /// The maximum accumulated size of the DOWNLOAD message bodies kept in
+        /// the download cache. The cache is shared by all sessions, and holds
+        /// the (compressed) bodies produced for clients that have not
+        /// uploaded anything, so that clients bootstrapping from the same
+        /// server file can be served without scanning and compacting the
+        /// history again. When the limit is exceeded, the least recently used
+        /// bodies are discarded.
+        ///
+        /// The cached bootstrap bodies (`enable_download_bootstrap_cache`)
+        /// are not subject to this limit.
+        ///
+        /// If zero, only the bootstrap bodies are cached.
+        std::size_t download_cache_max_size = 0x4000000; // 64 MiB
+
         /// The maximum number of connections that can be queued up waiting to
         /// be accepted by the server. This corresponds to the `backlog`
         /// argument of the `listen()` function as described by POSIX.
@@ -212,6 +244,39 @@ public:
         /// sure to research the subject before you enable this option.
         bool tcp_no_delay = false;
 
+        /// The number of network shards. A network shard is an extra event
+        /// loop, executed by a dedicated thread, that owns a set of client
+        /// connections and a set of server files. Accepted connections are
+        /// assigned to shards in a round-robin fashion, and the shard carries
+        /// out socket I/O, SSL/TLS processing, and the parsing and framing of
+        /// protocol messages for them.
+        ///
+        /// Each server file is pinned to one shard, chosen from its virtual
+        /// path, and its sessions, and the assembly and compression of their
+        /// DOWNLOAD messages, are processed there, so server file state is
+        /// only ever accessed by one thread. Messages for a session bound on a
+        /// connection owned by another shard are passed between the two
+        /// shards.
+        ///
+        /// The open files limit (`max_open_files`) and the download cache
+        /// limit (`download_cache_max_size`) are divided evenly between the
+        /// shards.
+        ///
+        /// If zero, all connections and files are handled by the thread that
+        /// executes run().
+        int num_network_shards = 0;
+
+        /// The number of worker threads that integrate changesets uploaded by
+        /// clients, and otherwise modify server-side Realm files. Each Realm
+        /// file is assigned to one of the workers when it is first accessed,
+        /// so changes to a particular file are integrated in order, while
+        /// changes to files assigned to different workers are integrated
+        /// concurrently. The open files limit (`max_open_files`) is divided
+        /// evenly between the workers.
+        ///
+        /// Values less than one are treated as one.
+        int num_integration_workers = 1;
+
         /// The sync server will log the output of the lsof command for its own
         /// process periodically with period 'log_lsof_period' seconds. A value
         /// of zero for log_lsof_period, which is default, denotes no logging.
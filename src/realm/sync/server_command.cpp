@@ -106,10 +106,15 @@ int main(int argc, char* argv[])
         config_2.ssl_certificate_path = config.ssl_certificate_path;
         config_2.ssl_certificate_key_path = config.ssl_certificate_key_path;
         config_2.disable_download_compaction = config.disable_download_compaction;
+        config_2.disable_fast_compression = config.disable_fast_compression;
         config_2.enable_download_bootstrap_cache = config.enable_download_bootstrap_cache;
+        config_2.disable_state_realms = config.disable_state_realms;
         config_2.max_download_size = config.max_download_size;
+        config_2.download_cache_max_size = config.download_cache_max_size;
         config_2.listen_backlog = config.listen_backlog;
         config_2.tcp_no_delay = config.tcp_no_delay;
+        config_2.num_network_shards = config.num_network_shards;
+        config_2.num_integration_workers = config.num_integration_workers;
         config_2.log_lsof_period = config.log_lsof_period;
         config_2.disable_history_compaction = config.disable_history_compaction;
         config_2.history_ttl = config.history_ttl;
@@ -50,6 +50,8 @@ void parse_arguments(int argc, char* argv[], Configuration& configuration)
         {"ssl-private-key",                      required_argument, nullptr, 'K'},
         {"listen-backlog",                       required_argument, nullptr, 'b'},
         {"tcp-no-delay",                         no_argument,       nullptr, 'D'},
+        {"network-shards",                       required_argument, nullptr, 'T'},
+        {"integration-workers",                  required_argument, nullptr, 'W'},
         {"log-lsof-period",                      required_argument, nullptr, 'f'},
         {"history-ttl",                          required_argument, nullptr, 'H'},
         {"compaction-interval",                  required_argument, nullptr, 'I'},
@@ -57,17 +59,20 @@ void parse_arguments(int argc, char* argv[], Configuration& configuration)
         {"encryption-key",                       required_argument, nullptr, 'e'},
         {"max-upload-backlog",                   required_argument, nullptr, 'U'},
         {"enable-download-bootstrap-cache",      no_argument,       nullptr, 'B'},
+        {"disable-state-realms",                 no_argument,       nullptr, 'y'},
         {"disable-sync-to-disk",                 no_argument,       nullptr, 'A'},
         {"max-protocol-version",                 required_argument, nullptr, 'o'},
         {"disable-serial-transacts",             no_argument,       nullptr, 'c'},
         {"disable-history-compaction",           no_argument,       nullptr, 'O'},
         {"disable-download-compaction",          no_argument,       nullptr, 'Q'},
+        {"disable-fast-compression",             no_argument,       nullptr, 'z'},
         {"max-download-size",                    required_argument, nullptr, 'F'},
+        {"download-cache-size",                  required_argument, nullptr, 'Z'},
         {nullptr,                                0,                 nullptr, 0}
         // clang-format on
     };
 
-    static const char* opt_desc = "r:L:p:J:M:i:d:N:l:YPk:m:hnsC:K:b:DSu:t:f:H:I:qe:jRGEa:g:U:BA12:v:x:o:cOQF:";
+    static const char* opt_desc = "r:L:p:J:M:i:d:N:l:YPk:m:hnsC:K:b:DT:W:Su:t:f:H:I:qe:jRGEa:g:U:ByA12:v:x:o:cOQzF:Z:";
 
     int opt_index = 0;
     int opt;
@@ -227,6 +232,34 @@ void parse_arguments(int argc, char* argv[], Configuration& configuration)
             case 'D':
                 configuration.tcp_no_delay = true;
                 break;
+            case 'T': {
+                std::istringstream in(optarg);
+                in.unsetf(std::ios_base::skipws);
+                int v = 0;
+                in >> v;
+                if (in && in.eof() && v >= 0) {
+                    configuration.num_network_shards = v;
+                }
+                else {
+                    std::cerr << "Error: Invalid number of network shards `" << optarg << "'.\n\n";
+                    show_help(argv[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+            } break;
+            case 'W': {
+                std::istringstream in(optarg);
+                in.unsetf(std::ios_base::skipws);
+                int v = 0;
+                in >> v;
+                if (in && in.eof() && v >= 1) {
+                    configuration.num_integration_workers = v;
+                }
+                else {
+                    std::cerr << "Error: Invalid number of integration workers `" << optarg << "'.\n\n";
+                    show_help(argv[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+            } break;
             case 'f': {
                 std::istringstream in(optarg);
                 in.unsetf(std::ios_base::skipws);
@@ -308,6 +341,9 @@ void parse_arguments(int argc, char* argv[], Configuration& configuration)
             case 'B':
                 configuration.enable_download_bootstrap_cache = true;
                 break;
+            case 'y':
+                configuration.disable_state_realms = true;
+                break;
             case 'A':
                 configuration.disable_sync_to_disk = true;
                 break;
@@ -331,6 +367,9 @@ void parse_arguments(int argc, char* argv[], Configuration& configuration)
             case 'Q':
                 configuration.disable_download_compaction = true;
                 break;
+            case 'z':
+                configuration.disable_fast_compression = true;
+                break;
             case 'F': {
                 std::istringstream in(optarg);
                 in.unsetf(std::ios_base::skipws);
@@ -345,6 +384,20 @@ void parse_arguments(int argc, char* argv[], Configuration& configuration)
                     std::exit(EXIT_FAILURE);
                 }
             } break;
+            case 'Z': {
+                std::istringstream in(optarg);
+                in.unsetf(std::ios_base::skipws);
+                std::size_t v = 0;
+                in >> v;
+                if (in && in.eof()) {
+                    configuration.download_cache_max_size = v;
+                }
+                else {
+                    std::cerr << "Error: Invalid download cache size `" << optarg << "'.\n\n";
+                    show_help(argv[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+            } break;
             default:
                 std::cerr << '\n';
                 show_help(argv[0]);
@@ -690,6 +743,14 @@ void show_help(const std::string& program_name)
         "                                 up waiting to be accepted by this server.\n"
         "  -D, --tcp-no-delay             Disables the Nagle algorithm on all sockets accepted\n"
         "                                 by this server.\n"
+        "  -T, --network-shards NUM       The number of extra threads that serve client\n"
+        "                                 connections and Realm files. Connections are\n"
+        "                                 assigned round-robin, files by path. Default is\n"
+        "                                 0 (everything is served by the main event loop\n"
+        "                                 thread).\n"
+        "  -W, --integration-workers NUM  The number of threads that integrate uploaded\n"
+        "                                 changesets. Each Realm file is assigned to one\n"
+        "                                 of them. Default is 1.\n"
         "  -f, --log-lsof-period NUM      The period in seconds of lsof output logging for\n"
         "                                 the server process.\n"
         "  -H, --history-ttl SECONDS      The time in seconds that clients can be offline\n"
@@ -711,6 +772,9 @@ void show_help(const std::string& program_name)
         "                                 default value will be chosen.\n"
         "  -B, --enable-download-bootstrap-cache  Makes the server cache the contents of the\n"
         "                                 DOWNLOAD message(s) used for client bootstrapping.\n"
+        "  -y, --disable-state-realms     Send an empty state to clients asking for the state\n"
+        "                                 of a Realm (async open), such that they download the\n"
+        "                                 entire history instead.\n"
         "  -A, --disable-sync-to-disk     Disable sync to disk (msync(), fsync()).\n"
         "  -o, --max-protocol-version     Maximum protocol version to allow during negotiation\n"
         "                                 with clients. Zero means unspecified. Default is zero.\n"
@@ -718,7 +782,14 @@ void show_help(const std::string& program_name)
         "                                 history.\n"
         "  -Q, --disable-download-compaction\n"
         "                                 Disable compaction during download.\n"
+        "  -z, --disable-fast-compression Compress message bodies with zlib, even when the\n"
+        "                                 client supports Zstd or LZ4.\n"
         "  -F, --max-download-size        See `sync::Server::Config::max_download_size`.\n"
+        "  -Z, --download-cache-size NUM  The maximum accumulated size in bytes of the\n"
+        "                                 DOWNLOAD message bodies cached for sharing between\n"
+        "                                 sessions. Zero disables the cache (except for\n"
+        "                                 `--enable-download-bootstrap-cache`). Default is\n"
+        "                                 64 MiB.\n"
         "\n";
     // clang-format on
 }
@@ -43,10 +43,15 @@ struct Configuration {
     std::chrono::seconds history_compaction_interval = std::chrono::seconds{3600};
     bool history_compaction_ignore_clients = false;
     bool disable_download_compaction = false;
+    bool disable_fast_compression = false;
     bool enable_download_bootstrap_cache = false;
-    std::size_t max_download_size = 0x1000000; // 16 MB
+    bool disable_state_realms = false;
+    std::size_t max_download_size = 0x1000000;       // 16 MB
+    std::size_t download_cache_max_size = 0x4000000; // 64 MB
     int listen_backlog = util::network::Acceptor::max_connections;
     bool tcp_no_delay = false;
+    int num_network_shards = 0;
+    int num_integration_workers = 1;
     bool is_subtier_server = false;
     std::string upstream_url;
     std::string upstream_access_token;
@@ -2399,6 +2399,8 @@ TransformerImpl::TransformerImpl()
 {
 }
 
+TransformerImpl::~TransformerImpl() noexcept {}
+
 void TransformerImpl::merge_changesets(file_ident_type local_file_ident, Changeset* their_changesets,
                                        size_t their_size, Changeset** our_changesets, size_t our_size,
                                        Reporter* reporter, util::Logger* logger)
@@ -2437,10 +2439,23 @@ void TransformerImpl::merge_changesets(file_ident_type local_file_ident, Changes
 
         their_index.scan_changeset(their_changesets[i]);
     }
+
+    // Local changesets that cannot conflict with any incoming changeset
+    // (directly, or through other local changesets) are left out of both the
+    // index and the transformation, as neither would modify them.
+    auto nonconflicting = std::make_unique<bool[]>(our_size); // Throws
+    size_t num_nonconflicting = 0;
+    if (!their_index.contains_destructive_schema_changes()) {
+        num_nonconflicting = find_nonconflicting_changesets(their_changesets, their_size, our_changesets, our_size,
+                                                            nonconflicting.get()); // Throws
+    }
+
     for (size_t i = 0; i < our_size; ++i) {
         Changeset& our_changeset = *our_changesets[i];
         size_t num_instructions = our_changeset.size();
         our_num_instructions += num_instructions;
+        if (nonconflicting[i])
+            continue;
         if (logger) {
             logger->trace("Scanning local changeset [%1/%2] (%3 instructions)", i + 1, our_size, num_instructions);
         }
@@ -2459,9 +2474,10 @@ void TransformerImpl::merge_changesets(file_ident_type local_file_ident, Changes
 
     if (logger) {
         logger->debug("Finished changeset indexing (incoming: %1 changeset(s) / %2 instructions, local: %3 "
-                      "changeset(s) / %4 instructions, conflict group(s): %5)",
+                      "changeset(s) / %4 instructions, conflict group(s): %5, nonconflicting local "
+                      "changeset(s): %6)",
                       their_size, their_num_instructions, our_size, our_num_instructions,
-                      their_index.get_num_conflict_groups());
+                      their_index.get_num_conflict_groups(), num_nonconflicting);
     }
 
 #if REALM_DEBUG // LCOV_EXCL_START
@@ -2505,6 +2521,8 @@ void TransformerImpl::merge_changesets(file_ident_type local_file_ident, Changes
 #endif // REALM_DEBUG LCOV_EXCL_STOP
 
     for (size_t i = 0; i < our_size; ++i) {
+        if (nonconflicting[i])
+            continue;
         if (logger) {
             logger->trace(
                 "Transforming local changeset [%1/%2] through %3 incoming changeset(s) with %4 conflict group(s)",
@@ -2512,6 +2530,9 @@ void TransformerImpl::merge_changesets(file_ident_type local_file_ident, Changes
         }
         Changeset* our_changeset = our_changesets[i];
 
+        // The transformation may modify the set of referenced objects.
+        m_changeset_objects_cache.erase(our_changeset->version);
+
         transformer.m_major_side.set_next_changeset(our_changeset);
         // MinorSide uses the index to find the Changeset.
         transformer.m_minor_side.m_changeset_index = &their_index;
@@ -2601,7 +2622,7 @@ void TransformerImpl::transform_remote_changesets(TransformHistory& history, fil
         //
         // Note that some valid changesets can still cause exceptions to be
         // thrown by the merge algorithm, namely incompatible schema changes.
-        m_reciprocal_transform_cache.clear();
+        clear_reciprocal_transform_cache();
         throw;
     }
 
@@ -2647,15 +2668,106 @@ void TransformerImpl::flush_reciprocal_transform_cache(TransformHistory& history
                 history.set_reciprocal_transform(version, data); // Throws
             }
         }
-        m_reciprocal_transform_cache.clear();
+        clear_reciprocal_transform_cache();
     }
     catch (...) {
-        m_reciprocal_transform_cache.clear();
+        clear_reciprocal_transform_cache();
         throw;
     }
 }
 
 
+void TransformerImpl::clear_reciprocal_transform_cache() noexcept
+{
+    m_reciprocal_transform_cache.clear();
+    m_changeset_objects_cache.clear();
+}
+
+
+auto TransformerImpl::get_changeset_objects(const Changeset& changeset) -> const ChangesetObjects&
+{
+    auto p = m_changeset_objects_cache.emplace(changeset.version, nullptr); // Throws
+    auto i = p.first;
+    if (p.second) {
+        try {
+            i->second = std::make_unique<ChangesetObjects>(); // Throws
+            i->second->reset(changeset);                      // Throws
+        }
+        catch (...) {
+            m_changeset_objects_cache.erase(i);
+            throw;
+        }
+    }
+    return *i->second;
+}
+
+
+size_t TransformerImpl::find_nonconflicting_changesets(const Changeset* their_changesets, size_t their_size,
+                                                       Changeset** our_changesets, size_t our_size,
+                                                       bool* nonconflicting)
+{
+    // Two changesets can only conflict if they reference a common object, or
+    // if one of them contains schema changes. Since conflict groups are joined
+    // transitively through local changesets, a local changeset is
+    // nonconflicting only if it shares no objects with any incoming changeset
+    // nor with any conflicting local changeset. This is resolved by growing the
+    // set of objects until no more local changesets are found to conflict.
+    // Since the filter admits false positives, some nonconflicting changesets
+    // may be treated as conflicting, but never the other way around.
+    util::metered::vector<const ChangesetObjects*> our_objects;
+    our_objects.reserve(our_size); // Throws
+    size_t num_objects = 0;
+    for (size_t i = 0; i < our_size; ++i) {
+        const ChangesetObjects& objects = get_changeset_objects(*our_changesets[i]); // Throws
+        if (objects.has_destructive_schema_changes) {
+            std::fill(nonconflicting, nonconflicting + our_size, false);
+            return 0;
+        }
+        nonconflicting[i] = !objects.has_schema_changes;
+        our_objects.push_back(&objects);
+        num_objects += objects.hashes.size();
+    }
+
+    util::metered::vector<ChangesetObjects> their_objects(their_size); // Throws
+    for (size_t i = 0; i < their_size; ++i) {
+        their_objects[i].reset(their_changesets[i]); // Throws
+        num_objects += their_objects[i].hashes.size();
+    }
+
+    ObjectFilter filter;
+    filter.reset(num_objects); // Throws
+    for (const ChangesetObjects& objects : their_objects)
+        filter.add(objects);
+    for (size_t i = 0; i < our_size; ++i) {
+        if (!nonconflicting[i])
+            filter.add(*our_objects[i]);
+    }
+
+    // Each pass that finds a new conflicting changeset may cause others to
+    // conflict. Give up after a bounded number of passes, as the changesets
+    // are then likely to be densely connected anyway.
+    const int max_passes = 8;
+    for (int pass = 0;; ++pass) {
+        bool changed = false;
+        for (size_t i = 0; i < our_size; ++i) {
+            if (nonconflicting[i] && filter.may_intersect(*our_objects[i])) {
+                nonconflicting[i] = false;
+                filter.add(*our_objects[i]);
+                changed = true;
+            }
+        }
+        if (!changed)
+            break;
+        if (pass + 1 == max_passes) {
+            std::fill(nonconflicting, nonconflicting + our_size, false);
+            return 0;
+        }
+    }
+
+    return size_t(std::count(nonconflicting, nonconflicting + our_size, true));
+}
+
+
 size_t TransformerImpl::emit_changesets(const Changeset* changesets, size_t num_changesets,
                                         util::Buffer<char>& out_buffer)
 {
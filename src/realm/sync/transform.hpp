@@ -185,6 +185,8 @@ std::unique_ptr<Transformer> make_transformer();
 
 namespace _impl {
 
+struct ChangesetObjects;
+
 class TransformerImpl : public sync::Transformer {
 public:
     using Changeset = sync::Changeset;
@@ -195,6 +197,7 @@ public:
     using version_type = sync::version_type;
 
     TransformerImpl();
+    ~TransformerImpl() noexcept override;
 
     void transform_remote_changesets(TransformHistory&, file_ident_type, version_type, Changeset*, std::size_t,
                                      Reporter*, util::Logger*) override;
@@ -214,11 +217,22 @@ protected:
 private:
     util::metered::map<version_type, std::unique_ptr<Changeset>> m_reciprocal_transform_cache;
 
+    // Summaries of the objects referenced by the changesets in
+    // `m_reciprocal_transform_cache`. A summary is discarded when the
+    // changeset is transformed.
+    util::metered::map<version_type, std::unique_ptr<ChangesetObjects>> m_changeset_objects_cache;
+
     TransactLogParser m_changeset_parser;
 
     Changeset& get_reciprocal_transform(TransformHistory&, file_ident_type local_file_ident, version_type version,
                                         const HistoryEntry&);
     void flush_reciprocal_transform_cache(TransformHistory&);
+    void clear_reciprocal_transform_cache() noexcept;
+
+    const ChangesetObjects& get_changeset_objects(const Changeset&);
+    std::size_t find_nonconflicting_changesets(const Changeset* their_changesets, std::size_t their_size,
+                                               Changeset** our_changesets, std::size_t our_size,
+                                               bool* nonconflicting);
 
     static size_t emit_changesets(const Changeset*, size_t num_changesets, util::Buffer<char>& output_buffer);
 
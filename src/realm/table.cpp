@@ -538,6 +538,75 @@ TableKey Table::get_key_direct(Allocator& alloc, ref_type top_ref)
 }
 
 
+namespace {
+// 64-bit FNV-1a
+struct SchemaHasher {
+    uint64_t hash;
+
+    void add_bytes(const char* data, size_t size) noexcept
+    {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= uint8_t(data[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+    void add(uint64_t value) noexcept
+    {
+        for (int i = 0; i < 8; ++i) {
+            hash ^= uint8_t(value >> (i * 8));
+            hash *= 1099511628211ULL;
+        }
+    }
+    void add(StringData str) noexcept
+    {
+        add(str.size());
+        add_bytes(str.data(), str.size());
+    }
+    void add_array(Allocator& alloc, ref_type ref)
+    {
+        if (!ref) {
+            add(0);
+            return;
+        }
+        Array arr(alloc);
+        arr.init_from_ref(ref);
+        add(arr.size());
+        for (size_t i = 0; i < arr.size(); ++i)
+            add(arr.get(i));
+    }
+};
+} // anonymous namespace
+
+uint64_t Table::get_schema_hash_direct(Allocator& alloc, ref_type top_ref, StringData name, uint64_t hash)
+{
+    SchemaHasher hasher{hash};
+    hasher.add(name);
+
+    Array table_top(alloc);
+    table_top.init_from_ref(top_ref);
+    // The key, primary key and flags slots hold tagged integers, so the raw
+    // values can be hashed directly
+    for (size_t ndx : {top_position_for_key, top_position_for_pk_col, top_position_for_flags})
+        hasher.add(ndx < table_top.size() ? table_top.get(ndx) : 0);
+    // Link targets are stored per column outside of the spec
+    for (size_t ndx : {top_position_for_opposite_table, top_position_for_opposite_column})
+        hasher.add_array(alloc, ndx < table_top.size() ? table_top.get_as_ref(ndx) : 0);
+
+    // The spec is read directly as `Spec::init()` may modify it. The names
+    // array holds only the public columns, while the types, attributes and
+    // keys arrays include the backlink columns as well.
+    Array spec_top(alloc);
+    spec_top.init_from_ref(table_top.get_as_ref(top_position_for_spec));
+    for (size_t ndx : {0, 2, 5})
+        hasher.add_array(alloc, ndx < spec_top.size() ? spec_top.get_as_ref(ndx) : 0);
+    ArrayStringShort names(alloc, false);
+    names.init_from_ref(spec_top.get_as_ref(1));
+    hasher.add(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+        hasher.add(names.get(i));
+    return hasher.hash;
+}
+
 void Table::init(ref_type top_ref, ArrayParent* parent, size_t ndx_in_parent, bool is_writable, bool is_frzn)
 {
     REALM_ASSERT(!(is_writable && is_frzn));
@@ -896,6 +965,56 @@ bool Table::is_enumerated(ColKey col_key) const noexcept
     return m_spec.is_string_enum_type(col_ndx);
 }
 
+void Table::prefetch(const std::vector<ColKey>& columns) const
+{
+    std::vector<ColKey> col_keys = columns;
+    if (col_keys.empty()) {
+        for_each_and_every_column([&](ColKey col_key) {
+            col_keys.push_back(col_key);
+            return false;
+        });
+    }
+    for (auto col_key : col_keys)
+        report_invalid_key(col_key);
+
+    // The clusters have to be read to find the leaves, which is not
+    // worthwhile if the advice has no effect
+    Allocator& alloc = get_alloc();
+    if (!alloc.prefetch(m_top.get_ref(), 0))
+        return;
+
+    traverse_clusters([&](const Cluster* cluster) {
+        for (auto col_key : col_keys) {
+            // Slot 0 of a cluster holds the object keys, the columns follow
+            ref_type ref = cluster->get_as_ref(col_key.get_index().val + 1);
+            if (!ref)
+                continue;
+            switch (col_key.get_type()) {
+                case col_type_Int:
+                case col_type_Bool:
+                case col_type_Float:
+                case col_type_Double:
+                case col_type_Decimal:
+                case col_type_Link:
+                case col_type_ObjectId:
+                case col_type_UUID:
+                    if (!col_key.is_collection()) {
+                        // These leaves have no subarrays, and hold at most
+                        // 16 bytes per object, so they need not be read to
+                        // find out what to advise
+                        alloc.prefetch(ref, NodeHeader::header_size + 16 * cluster->node_size());
+                        break;
+                    }
+                    REALM_FALLTHROUGH;
+                default:
+                    Array::prefetch_deep(ref, alloc);
+                    break;
+            }
+        }
+        return false; // Continue
+    });
+}
+
 size_t Table::get_num_unique_values(ColKey col_key) const
 {
     if (!is_enumerated(col_key))
@@ -286,6 +286,17 @@ public:
         return m_clusters.traverse(func);
     }
 
+    /// Advise the operating system that the specified columns of all objects
+    /// will be read soon, as by a query which scans the table, so that their
+    /// leaves can be read from the file in the background instead of one page
+    /// fault at a time. If no columns are specified, all columns are
+    /// prefetched. This is only worthwhile if the data is not already in
+    /// memory, e.g. on the first access after the file was opened. The
+    /// clusters and other nodes which refer to leaves are read in order to
+    /// find the leaves, but the leaves themselves are not accessed. Nothing
+    /// is done for encrypted files. See also DBOptions::access_advice.
+    void prefetch(const std::vector<ColKey>& columns = {}) const;
+
     /// remove_object() removes the specified object from the table.
     /// Any links from the specified object into objects residing in an embedded
     /// table will cause those objects to be deleted as well, and so on recursively.
@@ -346,6 +357,10 @@ public:
 
     // Get the key of this table directly, without needing a Table accessor.
     static TableKey get_key_direct(Allocator& alloc, ref_type top_ref);
+    // Extend `hash` with the structure of the table (its name, key, type,
+    // primary key and the name, type, attributes, key and link target of each
+    // column) directly, without needing a Table accessor.
+    static uint64_t get_schema_hash_direct(Allocator& alloc, ref_type top_ref, StringData name, uint64_t hash);
 
     // Aggregate functions
     size_t count_int(ColKey col_key, int64_t value) const;
@@ -21,10 +21,91 @@
 #include <realm/index_string.hpp>
 #include <realm/db.hpp>
 
+#include <mutex>
 #include <unordered_set>
 
 using namespace realm;
 
+struct ConstTableView::SharedKeyValues {
+    SharedKeyValues(ref_type r) noexcept
+        : ref(r)
+    {
+    }
+    ~SharedKeyValues()
+    {
+        Array::destroy_deep(ref, Allocator::get_default());
+    }
+    const ref_type ref;
+};
+
+namespace {
+// Guards the conversion of a view's keys to shared keys, as this modifies the
+// source of a copy and frozen views may be copied from multiple threads
+std::mutex s_shared_key_values_mutex;
+
+// Release the accessor for a tree without freeing the tree itself
+void detach_accessor(KeyColumn& keys) noexcept
+{
+    KeyColumn accessor(std::move(keys));
+}
+} // anonymous namespace
+
+void ConstTableView::release_key_values() noexcept
+{
+    if (m_shared_key_values) {
+        detach_accessor(m_key_values);
+        m_shared_key_values.reset();
+    }
+    else {
+        m_key_values.destroy();
+    }
+}
+
+void ConstTableView::copy_key_values(const ConstTableView& source)
+{
+    if (!source.m_key_values.is_attached() || !source.m_table || !source.m_table->is_frozen()) {
+        if (m_shared_key_values) {
+            detach_accessor(m_key_values);
+            m_shared_key_values.reset();
+        }
+        m_key_values = source.m_key_values; // Throws
+        return;
+    }
+
+    std::shared_ptr<const SharedKeyValues> shared;
+    {
+        std::lock_guard<std::mutex> lock(s_shared_key_values_mutex);
+        if (!source.m_shared_key_values)
+            source.m_shared_key_values = std::make_shared<SharedKeyValues>(source.m_key_values.get_ref()); // Throws
+        shared = source.m_shared_key_values;
+    }
+    release_key_values();
+    m_key_values.init_from_ref(shared->ref);
+    m_shared_key_values = std::move(shared);
+}
+
+void ConstTableView::move_key_values(ConstTableView& source) noexcept
+{
+    release_key_values();
+    m_key_values = std::move(source.m_key_values);
+    m_shared_key_values = std::move(source.m_shared_key_values);
+}
+
+void ConstTableView::make_key_values_unique(bool preserve_contents)
+{
+    if (!m_shared_key_values)
+        return;
+
+    KeyColumn copy(Allocator::get_default());
+    if (preserve_contents)
+        copy = m_key_values; // Throws
+    else
+        copy.create(); // Throws
+    detach_accessor(m_key_values);
+    m_key_values = std::move(copy);
+    m_shared_key_values.reset();
+}
+
 ConstTableView::ConstTableView(ConstTableView& src, Transaction*, PayloadPolicy)
     : m_source_column_key(src.m_source_column_key)
     , m_key_values(Allocator::get_default())
@@ -61,11 +142,11 @@ ConstTableView::ConstTableView(const ConstTableView& src, Transaction* tr, Paylo
         m_linked_table = tr->import_copy_of(src.m_linked_table);
     }
     // don't use methods which throw after this point...or m_table_view_key_values will leak
-    if (mode == PayloadPolicy::Copy && src.m_key_values.is_attached()) {
-        m_key_values = src.m_key_values;
+    if (mode != PayloadPolicy::Stay && src.m_key_values.is_attached()) {
+        // src is const, so even PayloadPolicy::Move has to copy the keys. Keys
+        // of frozen views are shared rather than copied.
+        copy_key_values(src);
     }
-    else if (mode == PayloadPolicy::Move && src.m_key_values.is_attached())
-        m_key_values = std::move(src.m_key_values);
     else {
         m_key_values.create();
     }
@@ -477,6 +558,7 @@ void TableView::remove(size_t row_ndx)
     ObjKey key = get_key(row_ndx);
 
     // Update refs
+    make_key_values_unique();
     m_key_values.erase(row_ndx);
 
     // Delete row in origin table
@@ -501,6 +583,7 @@ void TableView::clear()
 
     _impl::TableFriend::batch_erase_rows(*get_parent(), m_key_values); // Throws
 
+    make_key_values_unique(false);
     m_key_values.clear();
 
     // It is important to not accidentally bring us in sync, if we were
@@ -580,6 +663,7 @@ void ConstTableView::do_sync()
     // - Table::get_backlink_view()
     // Here we sync with the respective source.
     m_last_seen_versions.clear();
+    make_key_values_unique(false);
 
     if (m_linklist_source) {
         m_key_values.clear();
@@ -661,6 +745,7 @@ void ConstTableView::do_sort(const DescriptorOrdering& ordering)
     }
     // Apply the results
     m_limit_count = index_pairs.m_removed_by_limit;
+    make_key_values_unique(false);
     m_key_values.clear();
     for (auto& pair : index_pairs) {
         m_key_values.add(pair.key_for_object);
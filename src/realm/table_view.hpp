@@ -186,7 +186,7 @@ public:
 
     ~ConstTableView()
     {
-        m_key_values.destroy(); // Shallow
+        release_key_values();
     }
 
     TableRef get_target_table() const override
@@ -409,6 +409,23 @@ protected:
     mutable TableVersions m_last_seen_versions;
     KeyColumn m_key_values;
 
+    // The keys of a view of a frozen table can never change, so rather than
+    // being deep-copied when the view is copied or imported into another
+    // transaction they are moved into an immutable ref-counted buffer which all
+    // of the copies read from. While this is set m_key_values is a read-only
+    // accessor for the shared keys, and make_key_values_unique() must be called
+    // before modifying them.
+    struct SharedKeyValues;
+    mutable std::shared_ptr<const SharedKeyValues> m_shared_key_values;
+
+    void copy_key_values(const ConstTableView& source);
+    void move_key_values(ConstTableView& source) noexcept;
+    void release_key_values() noexcept;
+    // Give this view its own copy of the keys if they are currently shared.
+    // Callers which are about to replace all of the keys can pass false to
+    // get an empty tree instead of a copy.
+    void make_key_values_unique(bool preserve_contents = true);
+
 private:
     ObjKey find_first_integer(ColKey column_key, int64_t value) const;
     template <class oper>
@@ -552,9 +569,10 @@ inline ConstTableView::ConstTableView(const ConstTableView& tv)
     , m_end(tv.m_end)
     , m_limit(tv.m_limit)
     , m_last_seen_versions(tv.m_last_seen_versions)
-    , m_key_values(tv.m_key_values)
+    , m_key_values(Allocator::get_default())
 {
     m_limit_count = tv.m_limit_count;
+    copy_key_values(tv);
 }
 
 inline ConstTableView::ConstTableView(ConstTableView&& tv) noexcept
@@ -571,16 +589,17 @@ inline ConstTableView::ConstTableView(ConstTableView&& tv) noexcept
     // if we are created from a table view which is outdated, take care to use the outdated
     // version number so that we can later trigger a sync if needed.
     , m_last_seen_versions(std::move(tv.m_last_seen_versions))
-    , m_key_values(std::move(tv.m_key_values))
+    , m_key_values(Allocator::get_default())
 {
     m_limit_count = tv.m_limit_count;
+    move_key_values(tv);
 }
 
 inline ConstTableView& ConstTableView::operator=(ConstTableView&& tv) noexcept
 {
     m_table = std::move(tv.m_table);
 
-    m_key_values = std::move(tv.m_key_values);
+    move_key_values(tv);
     m_query = std::move(tv.m_query);
     m_last_seen_versions = tv.m_last_seen_versions;
     m_start = tv.m_start;
@@ -601,7 +620,8 @@ inline ConstTableView& ConstTableView::operator=(const ConstTableView& tv)
     if (this == &tv)
         return *this;
 
-    m_key_values = tv.m_key_values;
+    m_table = tv.m_table;
+    copy_key_values(tv);
 
     m_query = tv.m_query;
     m_last_seen_versions = tv.m_last_seen_versions;
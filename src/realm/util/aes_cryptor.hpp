@@ -45,11 +45,15 @@ class EncryptedFileMapping;
 
 class AESCryptor {
 public:
-    AESCryptor(const uint8_t* key);
+    AESCryptor(const uint8_t* key, File::EncryptionFormat format = File::encryption_AesCbcHmac);
     ~AESCryptor() noexcept;
 
     void set_file_size(off_t new_size);
 
+    // Blocks which are adjacent in the file are read and written with a single
+    // system call, and large writes are encrypted with the help of a set of
+    // worker threads shared by all files. Blocks which have never been
+    // written are skipped by read(), which then returns false.
     bool read(FileDesc fd, off_t pos, char* dst, size_t size);
     void write(FileDesc fd, off_t pos, const char* src, size_t size) noexcept;
 
@@ -73,18 +77,31 @@ private:
 #elif defined(_WIN32)
     BCRYPT_KEY_HANDLE m_aes_key_handle;
 #else
-    uint8_t m_aesKey[32];
-    EVP_CIPHER_CTX* m_ctx;
+    // Both contexts are initialized with the key once, so that only the IV
+    // has to be set for each block.
+    EVP_CIPHER_CTX* m_encr_ctx;
+    EVP_CIPHER_CTX* m_decr_ctx;
+    // Used by the threads encrypting the parts of a large write. The first
+    // one is m_encr_ctx.
+    std::vector<EVP_CIPHER_CTX*> m_worker_ctxs;
 #endif
 
+    File::EncryptionFormat m_format;
     uint8_t m_hmacKey[32];
     std::vector<iv_table> m_iv_buffer;
     std::unique_ptr<char[]> m_rw_buffer;
     std::unique_ptr<char[]> m_dst_buffer;
+    std::unique_ptr<char[]> m_metadata_buffer; // for converting metadata of the AES-GCM format
 
     void calc_hmac(const void* src, size_t len, uint8_t* dst, const uint8_t* key) const;
     bool check_hmac(const void* data, size_t len, const uint8_t* hmac) const;
+    bool read_block(FileDesc fd, off_t pos, const char* src, size_t src_size, char* dst);
     void crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv) noexcept;
+    bool gcm_crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, uint64_t counter,
+                   uint8_t* tag) noexcept;
+    template <class Crypt>
+    void encrypt_block(Crypt&& crypt_block, off_t pos, const char* src, char* dst, iv_table& iv) const noexcept;
+    void encrypt_blocks(off_t pos, const char* src, char* dst, iv_table* ivs, size_t num_blocks) noexcept;
     iv_table& get_iv_table(FileDesc fd, off_t data_pos) noexcept;
     void handle_error();
 };
@@ -25,6 +25,10 @@
 #include <algorithm>
 #include <stdexcept>
 #include <system_error>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <cstdio>
@@ -53,7 +57,7 @@ namespace util {
 
 SharedFileInfo::SharedFileInfo(const uint8_t* key, FileDesc file_descriptor)
     : fd(file_descriptor)
-    , cryptor(key)
+    , cryptor(key, init_encryption_format(file_descriptor, File::encryption_AesCbcHmac))
 {
 }
 
@@ -86,41 +90,201 @@ struct iv_table {
     uint8_t hmac2[28];
 };
 
+// In the AES-GCM format, each block is encrypted and authenticated in a single
+// pass, and the authentication tag takes the place of the hmac. The double-IV
+// scheme described above is unchanged, but as a tag only matches the
+// ciphertext under the IV it was computed with, no separate hash is needed.
+// The smaller entries also let each metadata block cover more data blocks.
+//
+// GCM must never see the same nonce twice under one key, so rather than
+// wrapping around, the IV is a 44-bit counter split into a low and a high
+// part (see init_gcm_iv()). In memory, these entries are kept in an iv_table
+// with the tags stored in the first bytes of the hmacs, followed by the high
+// parts of the counters.
+struct gcm_iv_table {
+    uint32_t iv1;
+    uint32_t iv1_high;
+    uint8_t tag1[12];
+    uint32_t iv2;
+    uint32_t iv2_high;
+    uint8_t tag2[12];
+};
+
 namespace {
 const int aes_block_size = 16;
 const size_t block_size = 4096;
+const size_t gcm_tag_size = sizeof(gcm_iv_table::tag1);
+// The high 12 bits of the counter take the place of the low bits of the
+// block's position in the nonce, which are always zero
+const uint64_t max_gcm_counter = (uint64_t(1) << 44) - 1;
+
+// A file in the AES-GCM format starts with a block holding this magic followed
+// by zeroes. Older versions cannot read the format, and will fail to decrypt
+// this block rather than misinterpret the file.
+const char gcm_file_magic[] = "Realm AES-GCM v1";
+const size_t gcm_file_magic_size = sizeof gcm_file_magic - 1;
+
+// The data blocks described by one metadata block are stored contiguously
+// after it, so a transfer never spans more than that many blocks. This also
+// bounds the number of blocks transferred by a single read or write.
+const size_t max_blocks_per_transfer = 64;
+
+// Encryption of a write is split across worker threads only if each of them
+// gets at least this many blocks, as otherwise the cost of handing the work
+// over outweighs the gain.
+const size_t min_blocks_per_encryption_worker = 16;
+const size_t max_encryption_workers = 4;
+
+#if !REALM_PLATFORM_APPLE && !defined(_WIN32)
+// A process wide set of threads which help encrypting large writes. The
+// threads are started on first use and then kept around, and they are shared
+// by all encrypted files. Each task is expected to use its own cipher context.
+class EncryptionWorkers {
+public:
+    static EncryptionWorkers& get()
+    {
+        // Intentionally leaked, as the threads may still be waiting for work
+        // during static destruction
+        static EncryptionWorkers* workers = new EncryptionWorkers;
+        return *workers;
+    }
 
-const size_t metadata_size = sizeof(iv_table);
-const size_t blocks_per_metadata_block = block_size / metadata_size;
+    // Call task(i) for every i below num_tasks, using the worker threads as
+    // well as the calling thread, and return once all calls have completed.
+    // Returns false without calling task if the workers are busy with the
+    // tasks of another thread.
+    template <class F>
+    bool run(size_t num_tasks, F&& task)
+    {
+        std::unique_lock<std::mutex> run_lock(m_run_mutex, std::try_to_lock);
+        if (!run_lock)
+            return false;
+        while (m_threads.size() < max_encryption_workers - 1) {
+            try {
+                m_threads.emplace_back([this] {
+                    thread_main();
+                });
+            }
+            catch (...) {
+                // Run with the threads we have
+                break;
+            }
+        }
 
-// map an offset in the data to the actual location in the file
-template <typename Int>
-Int real_offset(Int pos)
-{
-    REALM_ASSERT(pos >= 0);
-    const size_t index = static_cast<size_t>(pos) / block_size;
-    const size_t metadata_page_count = index / blocks_per_metadata_block + 1;
-    return Int(pos + metadata_page_count * block_size);
-}
+        std::function<void(size_t)> func = std::forward<F>(task);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &func;
+            m_num_tasks = num_tasks;
+            m_next_task = 0;
+            m_pending_tasks = num_tasks;
+        }
+        m_work_cv.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_cv.wait(lock, [&] {
+            return m_pending_tasks == 0;
+        });
+        m_task = nullptr;
+        return true;
+    }
 
-// map a location in the file to the offset in the data
-template <typename Int>
-Int fake_offset(Int pos)
-{
-    REALM_ASSERT(pos >= 0);
-    const size_t index = static_cast<size_t>(pos) / block_size;
-    const size_t metadata_page_count = (index + blocks_per_metadata_block) / (blocks_per_metadata_block + 1);
-    return pos - metadata_page_count * block_size;
-}
+private:
+    std::mutex m_run_mutex; // Held by the thread whose tasks are being run
+    std::mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    std::vector<std::thread> m_threads;
+    const std::function<void(size_t)>* m_task = nullptr;
+    size_t m_num_tasks = 0;
+    size_t m_next_task = 0;
+    size_t m_pending_tasks = 0;
+
+    void thread_main()
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work_cv.wait(lock, [&] {
+                    return m_next_task < m_num_tasks;
+                });
+            }
+            work();
+        }
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_next_task < m_num_tasks) {
+            size_t i = m_next_task++;
+            const std::function<void(size_t)>& task = *m_task;
+            lock.unlock();
+            task(i);
+            lock.lock();
+            if (--m_pending_tasks == 0)
+                m_done_cv.notify_all();
+        }
+    }
+};
+#endif
+
+// Where the data blocks and their metadata are located in a file of a
+// particular format
+struct Layout {
+    size_t header_size;
+    size_t metadata_size;
+    size_t blocks_per_metadata_block;
+
+    // map an offset in the data to the actual location in the file
+    template <typename Int>
+    Int real_offset(Int pos) const
+    {
+        REALM_ASSERT(pos >= 0);
+        const size_t index = static_cast<size_t>(pos) / block_size;
+        const size_t metadata_page_count = index / blocks_per_metadata_block + 1;
+        return Int(pos + metadata_page_count * block_size + header_size);
+    }
+
+    // map a location in the file to the offset in the data
+    template <typename Int>
+    Int fake_offset(Int pos) const
+    {
+        REALM_ASSERT(pos >= 0);
+        if (static_cast<size_t>(pos) < header_size)
+            return 0;
+        pos -= Int(header_size);
+        const size_t index = static_cast<size_t>(pos) / block_size;
+        const size_t metadata_page_count =
+            (index + blocks_per_metadata_block) / (blocks_per_metadata_block + 1);
+        return pos - metadata_page_count * block_size;
+    }
+
+    // get the location of the iv_table for the given data (not file) position
+    off_t iv_table_pos(off_t pos) const
+    {
+        REALM_ASSERT(pos >= 0);
+        const size_t index = static_cast<size_t>(pos) / block_size;
+        const size_t metadata_block = index / blocks_per_metadata_block;
+        const size_t metadata_index = index % blocks_per_metadata_block;
+        return off_t(header_size + metadata_block * (blocks_per_metadata_block + 1) * block_size +
+                     metadata_index * metadata_size);
+    }
+
+    // number of blocks from the given data position up to the next metadata block
+    size_t blocks_until_metadata_block(off_t pos) const
+    {
+        const size_t index = static_cast<size_t>(pos) / block_size;
+        return blocks_per_metadata_block - index % blocks_per_metadata_block;
+    }
+};
+
+const Layout cbc_hmac_layout = {0, sizeof(iv_table), block_size / sizeof(iv_table)};
+const Layout gcm_layout = {block_size, sizeof(gcm_iv_table), block_size / sizeof(gcm_iv_table)};
 
-// get the location of the iv_table for the given data (not file) position
-off_t iv_table_pos(off_t pos)
+const Layout& get_layout(File::EncryptionFormat format) noexcept
 {
-    REALM_ASSERT(pos >= 0);
-    const size_t index = static_cast<size_t>(pos) / block_size;
-    const size_t metadata_block = index / blocks_per_metadata_block;
-    const size_t metadata_index = index & (blocks_per_metadata_block - 1);
-    return off_t(metadata_block * (blocks_per_metadata_block + 1) * block_size + metadata_index * metadata_size);
+    return format == File::encryption_AesGcm ? gcm_layout : cbc_hmac_layout;
 }
 
 void check_write(FileDesc fd, off_t pos, const void* data, size_t len)
@@ -140,12 +304,115 @@ size_t check_read(FileDesc fd, off_t pos, void* dst, size_t len)
     return ret;
 }
 
+void init_iv(uint8_t (&iv)[aes_block_size], const char* stored_iv, off_t pos)
+{
+    memset(iv, 0, aes_block_size);
+    memcpy(iv, stored_iv, 4);
+    memcpy(iv + 4, &pos, sizeof(pos));
+}
+
+// The same as init_iv() as long as the counter fits in 32 bits
+void init_gcm_iv(uint8_t (&iv)[aes_block_size], uint64_t counter, off_t pos)
+{
+    REALM_ASSERT(counter <= max_gcm_counter && pos % block_size == 0);
+    memset(iv, 0, aes_block_size);
+    uint32_t low = uint32_t(counter);
+    memcpy(iv, &low, sizeof(low));
+    uint64_t high_and_pos = uint64_t(pos) | counter >> 32;
+    memcpy(iv + 4, &high_and_pos, sizeof(high_and_pos));
+}
+
+uint64_t gcm_counter(uint32_t iv, const uint8_t* hmac)
+{
+    uint32_t high;
+    memcpy(&high, hmac + gcm_tag_size, sizeof(high));
+    return iv | uint64_t(high) << 32;
+}
+
+void set_gcm_counter(uint32_t& iv, uint8_t* hmac, uint64_t counter)
+{
+    iv = uint32_t(counter);
+    uint32_t high = uint32_t(counter >> 32);
+    memcpy(hmac + gcm_tag_size, &high, sizeof(high));
+}
+
+#if !REALM_PLATFORM_APPLE && !defined(_WIN32)
+bool evp_crypt(EVP_CIPHER_CTX* ctx, const uint8_t* iv, char* dst, const char* src)
+{
+    // The cipher and key were set up front, so only the IV is changed here
+    if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1))
+        return false;
+
+    int len;
+    if (!EVP_CipherUpdate(ctx, reinterpret_cast<uint8_t*>(dst), &len, reinterpret_cast<const uint8_t*>(src),
+                          block_size))
+        return false;
+
+    // Finalize the encryption. Should not output further data.
+    return EVP_CipherFinal_ex(ctx, reinterpret_cast<uint8_t*>(dst) + len, &len);
+}
+
+// When decrypting, the tag is checked and false returned if it does not match
+bool evp_gcm_crypt(EVP_CIPHER_CTX* ctx, bool encrypt, const uint8_t* iv, char* dst, const char* src, uint8_t* tag)
+{
+    // The nonce is the first 12 bytes of the IV, which is the GCM default
+    if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1))
+        return false;
+
+    int len;
+    if (!EVP_CipherUpdate(ctx, reinterpret_cast<uint8_t*>(dst), &len, reinterpret_cast<const uint8_t*>(src),
+                          block_size))
+        return false;
+
+    if (!encrypt && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, int(gcm_tag_size), tag))
+        return false;
+    if (EVP_CipherFinal_ex(ctx, reinterpret_cast<uint8_t*>(dst) + len, &len) <= 0)
+        return false;
+    return !encrypt || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, int(gcm_tag_size), tag);
+}
+
+const bool gcm_supported = true;
+#else
+const bool gcm_supported = false;
+#endif
+
+void throw_gcm_not_supported()
+{
+    throw std::runtime_error("The AES-GCM encryption format is not supported on this platform");
+}
+
 } // anonymous namespace
 
-AESCryptor::AESCryptor(const uint8_t* key)
-    : m_rw_buffer(new char[block_size]),
-      m_dst_buffer(new char[block_size])
+File::EncryptionFormat init_encryption_format(FileDesc fd, File::EncryptionFormat format_if_empty)
 {
+    if (File::get_size_static(fd) == 0) {
+        if (format_if_empty == File::encryption_AesGcm) {
+            if (!gcm_supported)
+                throw_gcm_not_supported();
+            std::unique_ptr<char[]> header(new char[block_size]()); // Throws
+            memcpy(header.get(), gcm_file_magic, gcm_file_magic_size);
+            check_write(fd, 0, header.get(), block_size); // Throws
+        }
+        return format_if_empty;
+    }
+
+    char magic[gcm_file_magic_size];
+    size_t bytes_read = check_read(fd, 0, magic, sizeof magic); // Throws
+    if (bytes_read == sizeof magic && memcmp(magic, gcm_file_magic, sizeof magic) == 0)
+        return File::encryption_AesGcm;
+    return File::encryption_AesCbcHmac;
+}
+
+AESCryptor::AESCryptor(const uint8_t* key, File::EncryptionFormat format)
+    : m_format(format)
+    , m_rw_buffer(new char[max_blocks_per_transfer * block_size])
+    , m_dst_buffer(new char[block_size])
+{
+    if (format == File::encryption_AesGcm) {
+        if (!gcm_supported)
+            throw_gcm_not_supported();
+        m_metadata_buffer.reset(new char[block_size]);
+    }
 #if REALM_PLATFORM_APPLE
     // A random iv is passed to CCCryptorReset. This iv is *not used* by Realm; we set it manually prior to
     // each call to BCryptEncrypt() and BCryptDecrypt(). We pass this random iv as an attempt to 
@@ -168,12 +435,41 @@ AESCryptor::AESCryptor(const uint8_t* key)
     ret = BCryptGenerateSymmetricKey(hAesAlg, &m_aes_key_handle, nullptr, 0, (PBYTE)key, 32, 0);
     REALM_ASSERT_RELEASE_EX(ret == 0 && "BCryptGenerateSymmetricKey()", ret);
 #else
-    m_ctx = EVP_CIPHER_CTX_new();
+    m_encr_ctx = EVP_CIPHER_CTX_new();
+    m_decr_ctx = EVP_CIPHER_CTX_new();
 
-    if (!m_ctx)
+    if (!m_encr_ctx || !m_decr_ctx) {
+        EVP_CIPHER_CTX_free(m_encr_ctx);
+        EVP_CIPHER_CTX_free(m_decr_ctx);
         handle_error();
+    }
 
-    memcpy(m_aesKey, key, 32);
+    // Use zero padding - we always write a whole page
+    const EVP_CIPHER* cipher = format == File::encryption_AesGcm ? EVP_aes_256_gcm() : EVP_aes_256_cbc();
+    if (!EVP_CipherInit_ex(m_encr_ctx, cipher, NULL, key, NULL, mode_Encrypt) ||
+        !EVP_CipherInit_ex(m_decr_ctx, cipher, NULL, key, NULL, mode_Decrypt) ||
+        !EVP_CIPHER_CTX_set_padding(m_encr_ctx, 0) || !EVP_CIPHER_CTX_set_padding(m_decr_ctx, 0)) {
+        EVP_CIPHER_CTX_free(m_encr_ctx);
+        EVP_CIPHER_CTX_free(m_decr_ctx);
+        handle_error();
+    }
+
+    // Large writes are encrypted by several threads, which each need a
+    // context of their own. They are copied here, before any of them can be
+    // in use.
+    m_worker_ctxs.push_back(m_encr_ctx);
+    for (size_t i = 1; i < max_encryption_workers; ++i) {
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        if (!ctx || !EVP_CIPHER_CTX_copy(ctx, m_encr_ctx)) {
+            EVP_CIPHER_CTX_free(ctx);
+            for (size_t j = 1; j < m_worker_ctxs.size(); ++j)
+                EVP_CIPHER_CTX_free(m_worker_ctxs[j]);
+            EVP_CIPHER_CTX_free(m_encr_ctx);
+            EVP_CIPHER_CTX_free(m_decr_ctx);
+            handle_error();
+        }
+        m_worker_ctxs.push_back(ctx);
+    }
 #endif
     memcpy(m_hmacKey, key + 32, 32);
 }
@@ -185,8 +481,10 @@ AESCryptor::~AESCryptor() noexcept
     CCCryptorRelease(m_decr);
 #elif defined(_WIN32)
 #else
-    EVP_CIPHER_CTX_cleanup(m_ctx);
-    EVP_CIPHER_CTX_free(m_ctx);
+    for (size_t i = 1; i < m_worker_ctxs.size(); ++i)
+        EVP_CIPHER_CTX_free(m_worker_ctxs[i]);
+    EVP_CIPHER_CTX_free(m_encr_ctx);
+    EVP_CIPHER_CTX_free(m_decr_ctx);
 #endif
 }
 
@@ -198,9 +496,11 @@ void AESCryptor::handle_error()
 void AESCryptor::set_file_size(off_t new_size)
 {
     REALM_ASSERT(new_size >= 0 && !int_cast_has_overflow<size_t>(new_size));
+    const size_t blocks_per_metadata_block = get_layout(m_format).blocks_per_metadata_block;
     size_t new_size_casted = size_t(new_size);
     size_t block_count = (new_size_casted + block_size - 1) / block_size;
-    m_iv_buffer.reserve((block_count + blocks_per_metadata_block - 1) & ~(blocks_per_metadata_block - 1));
+    m_iv_buffer.reserve((block_count + blocks_per_metadata_block - 1) / blocks_per_metadata_block *
+                        blocks_per_metadata_block);
 }
 
 iv_table& AESCryptor::get_iv_table(FileDesc fd, off_t data_pos) noexcept
@@ -211,13 +511,30 @@ iv_table& AESCryptor::get_iv_table(FileDesc fd, off_t data_pos) noexcept
     if (idx < m_iv_buffer.size())
         return m_iv_buffer[idx];
 
+    const Layout& layout = get_layout(m_format);
+    const size_t blocks_per_metadata_block = layout.blocks_per_metadata_block;
     size_t old_size = m_iv_buffer.size();
     size_t new_block_count = 1 + idx / blocks_per_metadata_block;
     REALM_ASSERT(new_block_count * blocks_per_metadata_block <= m_iv_buffer.capacity()); // not safe to allocate here
     m_iv_buffer.resize(new_block_count * blocks_per_metadata_block);
 
     for (size_t i = old_size; i < new_block_count * blocks_per_metadata_block; i += blocks_per_metadata_block) {
-        size_t bytes = check_read(fd, iv_table_pos(off_t(i * block_size)), &m_iv_buffer[i], block_size);
+        off_t pos = layout.iv_table_pos(off_t(i * block_size));
+        if (m_format == File::encryption_AesGcm) {
+            size_t bytes = check_read(fd, pos, m_metadata_buffer.get(), block_size);
+            const gcm_iv_table* entries = reinterpret_cast<const gcm_iv_table*>(m_metadata_buffer.get());
+            for (size_t j = 0; j < bytes / sizeof(gcm_iv_table); ++j) {
+                iv_table& iv = m_iv_buffer[i + j];
+                memcpy(iv.hmac1, entries[j].tag1, gcm_tag_size);
+                set_gcm_counter(iv.iv1, iv.hmac1, entries[j].iv1 | uint64_t(entries[j].iv1_high) << 32);
+                memcpy(iv.hmac2, entries[j].tag2, gcm_tag_size);
+                set_gcm_counter(iv.iv2, iv.hmac2, entries[j].iv2 | uint64_t(entries[j].iv2_high) << 32);
+            }
+            if (bytes < block_size)
+                break; // rest is zero-filled by resize()
+            continue;
+        }
+        size_t bytes = check_read(fd, pos, &m_iv_buffer[i], block_size);
         if (bytes < block_size)
             break; // rest is zero-filled by resize()
     }
@@ -240,103 +557,244 @@ bool AESCryptor::check_hmac(const void* src, size_t len, const uint8_t* hmac) co
 bool AESCryptor::read(FileDesc fd, off_t pos, char* dst, size_t size)
 {
     REALM_ASSERT(size % block_size == 0);
+    const Layout& layout = get_layout(m_format);
+    bool all_blocks_read = true;
     while (size > 0) {
-        ssize_t bytes_read = check_read(fd, real_offset(pos), m_rw_buffer.get(), block_size);
+        size_t num_blocks =
+            std::min({size / block_size, layout.blocks_until_metadata_block(pos), max_blocks_per_transfer});
+        size_t bytes_read = check_read(fd, layout.real_offset(pos), m_rw_buffer.get(), num_blocks * block_size);
+
+        for (size_t i = 0; i < num_blocks; ++i) {
+            if (bytes_read <= i * block_size)
+                return false;
+            const char* src = m_rw_buffer.get() + i * block_size;
+            size_t src_size = std::min(bytes_read - i * block_size, block_size);
+
+            if (!read_block(fd, pos, src, src_size, dst))
+                all_blocks_read = false;
+            pos += block_size;
+            dst += block_size;
+        }
+        size -= num_blocks * block_size;
+    }
+    return all_blocks_read;
+}
 
-        if (bytes_read == 0)
+bool AESCryptor::read_block(FileDesc fd, off_t pos, const char* src, size_t src_size, char* dst)
+{
+    iv_table& iv = get_iv_table(fd, pos);
+    bool gcm = m_format == File::encryption_AesGcm;
+    if (gcm ? gcm_counter(iv.iv1, iv.hmac1) == 0 : iv.iv1 == 0) {
+        // This block has never been written to, so we've just read pre-allocated
+        // space. No memset() since the code using this doesn't rely on
+        // pre-allocated space being zeroed.
+        return false;
+    }
+
+    // We may expect some adress ranges of the destination buffer of
+    // AESCryptor::read() to stay unmodified, i.e. being overwritten with
+    // the same bytes as already present, and may have read-access to these
+    // from other threads while decryption is taking place.
+    //
+    // However, some implementations of AES_cbc_encrypt(), in particular
+    // OpenSSL, will put garbled bytes as an intermediate step during the
+    // operation which will lead to incorrect data being read by other
+    // readers concurrently accessing that page. Incorrect data leads to
+    // crashes.
+    //
+    // We therefore decrypt to a temporary buffer first and then copy the
+    // completely decrypted data after.
+    auto decrypt = [&](const uint32_t& stored_iv, const uint8_t* hmac) {
+        if (gcm)
+            return gcm_crypt(mode_Decrypt, pos, m_dst_buffer.get(), src, gcm_counter(stored_iv, hmac),
+                             const_cast<uint8_t*>(hmac));
+        if (!check_hmac(src, src_size, hmac))
             return false;
+        crypt(mode_Decrypt, pos, m_dst_buffer.get(), src, reinterpret_cast<const char*>(&stored_iv));
+        return true;
+    };
 
-        iv_table& iv = get_iv_table(fd, pos);
-        if (iv.iv1 == 0) {
-            // This block has never been written to, so we've just read pre-allocated
-            // space. No memset() since the code using this doesn't rely on
-            // pre-allocated space being zeroed.
+    if (!decrypt(iv.iv1, iv.hmac1)) {
+        // Either the DB is corrupted or we were interrupted between writing the
+        // new IV and writing the data
+        if (gcm ? gcm_counter(iv.iv2, iv.hmac2) == 0 : iv.iv2 == 0) {
+            // Very first write was interrupted
             return false;
         }
 
-        if (!check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac1)) {
-            // Either the DB is corrupted or we were interrupted between writing the
-            // new IV and writing the data
-            if (iv.iv2 == 0) {
-                // Very first write was interrupted
-                return false;
+        if (decrypt(iv.iv2, iv.hmac2)) {
+            if (gcm) {
+                // The interrupted write may still have put data encrypted
+                // with the bumped IV into the file, and GCM must never use
+                // the same IV for different data. Keep the bumped IV in the
+                // second slot, so that encrypt_block() continues past it.
+                std::swap(iv.iv1, iv.iv2);
+                std::swap_ranges(iv.hmac1, iv.hmac1 + gcm_tag_size + sizeof(uint32_t), iv.hmac2);
             }
-
-            if (check_hmac(m_rw_buffer.get(), bytes_read, iv.hmac2)) {
-                // Un-bump the IV since the write with the bumped IV never actually
-                // happened
+            else {
+                // Un-bump the IV since the write with the bumped IV never
+                // actually happened
                 memcpy(&iv.iv1, &iv.iv2, 32);
             }
-            else {
-                // If the file has been shrunk and then re-expanded, we may have
-                // old hmacs that don't go with this data. ftruncate() is
-                // required to fill any added space with zeroes, so assume that's
-                // what happened if the buffer is all zeroes
-                for (ssize_t i = 0; i < bytes_read; ++i) {
-                    if (m_rw_buffer[i] != 0)
-                        throw DecryptionFailed();
-                }
-                return false;
+        }
+        else {
+            // If the file has been shrunk and then re-expanded, we may have
+            // old hmacs that don't go with this data. ftruncate() is
+            // required to fill any added space with zeroes, so assume that's
+            // what happened if the buffer is all zeroes
+            for (size_t i = 0; i < src_size; ++i) {
+                if (src[i] != 0)
+                    throw DecryptionFailed();
             }
+            return false;
         }
-
-        // We may expect some adress ranges of the destination buffer of
-        // AESCryptor::read() to stay unmodified, i.e. being overwritten with
-        // the same bytes as already present, and may have read-access to these
-        // from other threads while decryption is taking place.
-        //
-        // However, some implementations of AES_cbc_encrypt(), in particular
-        // OpenSSL, will put garbled bytes as an intermediate step during the
-        // operation which will lead to incorrect data being read by other
-        // readers concurrently accessing that page. Incorrect data leads to
-        // crashes.
-        //
-        // We therefore decrypt to a temporary buffer first and then copy the
-        // completely decrypted data after.
-        crypt(mode_Decrypt, pos, m_dst_buffer.get(), m_rw_buffer.get(), reinterpret_cast<const char*>(&iv.iv1));
-        memcpy(dst, m_dst_buffer.get(), block_size);
-
-        pos += block_size;
-        dst += block_size;
-        size -= block_size;
     }
+
+    memcpy(dst, m_dst_buffer.get(), block_size);
     return true;
 }
 
 void AESCryptor::write(FileDesc fd, off_t pos, const char* src, size_t size) noexcept
 {
     REALM_ASSERT(size % block_size == 0);
+    const Layout& layout = get_layout(m_format);
     while (size > 0) {
-        iv_table& iv = get_iv_table(fd, pos);
+        size_t num_blocks =
+            std::min({size / block_size, layout.blocks_until_metadata_block(pos), max_blocks_per_transfer});
+
+        // The IV tables of all blocks up to the next metadata block are loaded
+        // together, so they are adjacent in m_iv_buffer as well as in the file.
+        iv_table* ivs = &get_iv_table(fd, pos);
+        encrypt_blocks(pos, src, m_rw_buffer.get(), ivs, num_blocks);
+
+        // All of the new IVs and hmacs are written before any of the data, so
+        // an interrupted write can still be recovered from block by block.
+        if (m_format == File::encryption_AesGcm) {
+            gcm_iv_table* entries = reinterpret_cast<gcm_iv_table*>(m_metadata_buffer.get());
+            for (size_t i = 0; i < num_blocks; ++i) {
+                uint64_t counter1 = gcm_counter(ivs[i].iv1, ivs[i].hmac1);
+                entries[i].iv1 = uint32_t(counter1);
+                entries[i].iv1_high = uint32_t(counter1 >> 32);
+                memcpy(entries[i].tag1, ivs[i].hmac1, gcm_tag_size);
+                uint64_t counter2 = gcm_counter(ivs[i].iv2, ivs[i].hmac2);
+                entries[i].iv2 = uint32_t(counter2);
+                entries[i].iv2_high = uint32_t(counter2 >> 32);
+                memcpy(entries[i].tag2, ivs[i].hmac2, gcm_tag_size);
+            }
+            check_write(fd, layout.iv_table_pos(pos), entries, num_blocks * sizeof(gcm_iv_table));
+        }
+        else {
+            check_write(fd, layout.iv_table_pos(pos), ivs, num_blocks * sizeof(iv_table));
+        }
+        check_write(fd, layout.real_offset(pos), m_rw_buffer.get(), num_blocks * block_size);
+
+        pos += num_blocks * block_size;
+        src += num_blocks * block_size;
+        size -= num_blocks * block_size;
+    }
+}
 
+template <class Crypt>
+void AESCryptor::encrypt_block(Crypt&& crypt_block, off_t pos, const char* src, char* dst, iv_table& iv) const
+    noexcept
+{
+    if (m_format == File::encryption_AesGcm) {
+        // After recovering from an interrupted write, the second slot holds
+        // an IV which is newer than the one in use (see read_block())
+        uint64_t last_counter = std::max(gcm_counter(iv.iv1, iv.hmac1), gcm_counter(iv.iv2, iv.hmac2));
+        // Even a block rewritten a million times per second takes more than
+        // half a year to get here, but a nonce must never be reused
+        if (REALM_UNLIKELY(last_counter == max_gcm_counter))
+            REALM_TERMINATE("The IVs of an encrypted block have been exhausted");
         memcpy(&iv.iv2, &iv.iv1, 32);
-        do {
+        set_gcm_counter(iv.iv1, iv.hmac1, last_counter + 1);
+        // This also stores the tag in hmac1
+        crypt_block(pos, dst, src, iv);
+        return;
+    }
+
+    memcpy(&iv.iv2, &iv.iv1, 32);
+    do {
+        ++iv.iv1;
+        // 0 is reserved for never-been-used, so bump if we just wrapped around
+        if (iv.iv1 == 0)
             ++iv.iv1;
-            // 0 is reserved for never-been-used, so bump if we just wrapped around
-            if (iv.iv1 == 0)
-                ++iv.iv1;
 
-            crypt(mode_Encrypt, pos, m_rw_buffer.get(), src, reinterpret_cast<const char*>(&iv.iv1));
-            calc_hmac(m_rw_buffer.get(), block_size, iv.hmac1, m_hmacKey);
-            // In the extremely unlikely case that both the old and new versions have
-            // the same hash we won't know which IV to use, so bump the IV until
-            // they're different.
-        } while (REALM_UNLIKELY(memcmp(iv.hmac1, iv.hmac2, 4) == 0));
+        crypt_block(pos, dst, src, iv);
+        calc_hmac(dst, block_size, iv.hmac1, m_hmacKey);
+        // In the extremely unlikely case that both the old and new versions have
+        // the same hash we won't know which IV to use, so bump the IV until
+        // they're different.
+    } while (REALM_UNLIKELY(memcmp(iv.hmac1, iv.hmac2, 4) == 0));
+}
 
-        check_write(fd, iv_table_pos(pos), &iv, sizeof(iv));
-        check_write(fd, real_offset(pos), m_rw_buffer.get(), block_size);
+void AESCryptor::encrypt_blocks(off_t pos, const char* src, char* dst, iv_table* ivs, size_t num_blocks) noexcept
+{
+    auto encrypt_range = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            encrypt_block(
+                [&](off_t block_pos, char* block_dst, const char* block_src, iv_table& iv) {
+                    if (m_format == File::encryption_AesGcm) {
+                        if (!gcm_crypt(mode_Encrypt, block_pos, block_dst, block_src, gcm_counter(iv.iv1, iv.hmac1),
+                                       iv.hmac1))
+                            handle_error();
+                    }
+                    else {
+                        crypt(mode_Encrypt, block_pos, block_dst, block_src, reinterpret_cast<const char*>(&iv.iv1));
+                    }
+                },
+                pos + off_t(i * block_size), src + i * block_size, dst + i * block_size, ivs[i]);
+        }
+    };
 
-        pos += block_size;
-        src += block_size;
-        size -= block_size;
+#if !REALM_PLATFORM_APPLE && !defined(_WIN32)
+    // Each block is encrypted independently, so a large write can be split
+    // into ranges which are encrypted by the shared worker threads, each using
+    // its own copy of the cipher context. All other state touched by
+    // encrypt_block() is specific to the block.
+    size_t num_ranges = std::min({size_t(std::thread::hardware_concurrency()), m_worker_ctxs.size(),
+                                  num_blocks / min_blocks_per_encryption_worker});
+    if (num_ranges > 1) {
+        size_t blocks_per_range = (num_blocks + num_ranges - 1) / num_ranges;
+        bool gcm = m_format == File::encryption_AesGcm;
+        auto encrypt_range_with_ctx = [&](size_t range) {
+            EVP_CIPHER_CTX* ctx = m_worker_ctxs[range];
+            size_t end = std::min(num_blocks, (range + 1) * blocks_per_range);
+            for (size_t i = range * blocks_per_range; i < end; ++i) {
+                encrypt_block(
+                    [&](off_t block_pos, char* block_dst, const char* block_src, iv_table& iv) {
+                        uint8_t iv_bytes[aes_block_size];
+                        if (gcm)
+                            init_gcm_iv(iv_bytes, gcm_counter(iv.iv1, iv.hmac1), block_pos);
+                        else
+                            init_iv(iv_bytes, reinterpret_cast<const char*>(&iv.iv1), block_pos);
+                        bool ok = gcm ? evp_gcm_crypt(ctx, true, iv_bytes, block_dst, block_src, iv.hmac1)
+                                      : evp_crypt(ctx, iv_bytes, block_dst, block_src);
+                        if (!ok)
+                            REALM_TERMINATE("Error occurred in encryption layer");
+                    },
+                    pos + off_t(i * block_size), src + i * block_size, dst + i * block_size, ivs[i]);
+            }
+        };
+        bool done = false;
+        try {
+            done = EncryptionWorkers::get().run(num_ranges, encrypt_range_with_ctx);
+        }
+        catch (...) {
+        }
+        if (done)
+            return;
+        // The workers are busy with another file (or could not be used at
+        // all), so just do it here
     }
+#endif
+    encrypt_range(0, num_blocks);
 }
 
 void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, const char* stored_iv) noexcept
 {
-    uint8_t iv[aes_block_size] = {0};
-    memcpy(iv, stored_iv, 4);
-    memcpy(iv + 4, &pos, sizeof(pos));
+    uint8_t iv[aes_block_size];
+    init_iv(iv, stored_iv, pos);
 
 #if REALM_PLATFORM_APPLE
     CCCryptorRef cryptor = mode == mode_Encrypt ? m_encr : m_decr;
@@ -367,20 +825,26 @@ void AESCryptor::crypt(EncryptionMode mode, off_t pos, char* dst, const char* sr
     }
 
 #else
-    if (!EVP_CipherInit_ex(m_ctx, EVP_aes_256_cbc(), NULL, m_aesKey, iv, mode))
-        handle_error();
-
-    int len;
-    // Use zero padding - we always write a whole page
-    EVP_CIPHER_CTX_set_padding(m_ctx, 0);
-
-    if (!EVP_CipherUpdate(m_ctx, reinterpret_cast<uint8_t*>(dst), &len, reinterpret_cast<const uint8_t*>(src),
-                          block_size))
+    if (!evp_crypt(mode == mode_Encrypt ? m_encr_ctx : m_decr_ctx, iv, dst, src))
         handle_error();
+#endif
+}
 
-    // Finalize the encryption. Should not output further data.
-    if (!EVP_CipherFinal_ex(m_ctx, reinterpret_cast<uint8_t*>(dst) + len, &len))
-        handle_error();
+bool AESCryptor::gcm_crypt(EncryptionMode mode, off_t pos, char* dst, const char* src, uint64_t counter,
+                           uint8_t* tag) noexcept
+{
+#if !REALM_PLATFORM_APPLE && !defined(_WIN32)
+    uint8_t iv[aes_block_size];
+    init_gcm_iv(iv, counter, pos);
+    return evp_gcm_crypt(mode == mode_Encrypt ? m_encr_ctx : m_decr_ctx, mode == mode_Encrypt, iv, dst, src, tag);
+#else
+    static_cast<void>(mode);
+    static_cast<void>(pos);
+    static_cast<void>(dst);
+    static_cast<void>(src);
+    static_cast<void>(counter);
+    static_cast<void>(tag);
+    REALM_UNREACHABLE(); // the constructor rejects the format on this platform
 #endif
 }
 
@@ -502,17 +966,45 @@ void EncryptedFileMapping::refresh_page(size_t local_page_ndx)
 {
     REALM_ASSERT_EX(local_page_ndx < m_page_state.size(), local_page_ndx, m_page_state.size());
 
-    char* addr = page_addr(local_page_ndx);
-
-    if (!copy_up_to_date_page(local_page_ndx)) {
-        size_t page_ndx_in_file = local_page_ndx + m_first_page;
-        m_file.cryptor.read(m_file.fd, off_t(page_ndx_in_file << m_page_shift),
-                            addr, static_cast<size_t>(1ULL << m_page_shift));
+    // When pages are decrypted in ascending order, as during a scan, the
+    // following pages are likely to be needed next, so they are decrypted
+    // along with this one while their blocks can be read in one go. Only pages
+    // which have never been decrypted are read ahead, and they are not marked
+    // as touched, so the reclaimer releases them again if they go unused.
+    size_t end_ndx = local_page_ndx + 1;
+    if (local_page_ndx > 0 && local_page_ndx - 1 == m_last_refreshed_page) {
+        size_t max_end_ndx = std::min(local_page_ndx + read_ahead_pages, m_page_state.size());
+        while (end_ndx < max_end_ndx && is_not(m_page_state[end_ndx], UpToDate | PartiallyUpToDate | Dirty))
+            ++end_ndx;
+    }
+    m_last_refreshed_page = end_ndx - 1;
+
+    size_t run_begin = local_page_ndx;
+    auto decrypt_run = [&](size_t run_end) {
+        if (run_begin < run_end) {
+            size_t page_ndx_in_file = run_begin + m_first_page;
+            m_file.cryptor.read(m_file.fd, off_t(page_ndx_in_file << m_page_shift), page_addr(run_begin),
+                                (run_end - run_begin) << m_page_shift);
+        }
+    };
+    for (size_t ndx = local_page_ndx; ndx < end_ndx; ++ndx) {
+        if (copy_up_to_date_page(ndx)) {
+            decrypt_run(ndx);
+            run_begin = ndx + 1;
+        }
+    }
+    decrypt_run(end_ndx);
+
+    for (size_t ndx = local_page_ndx; ndx < end_ndx; ++ndx) {
+        if (is_not(m_page_state[ndx], UpToDate | PartiallyUpToDate))
+            m_num_decrypted++;
+        clear(m_page_state[ndx], PartiallyUpToDate);
+        set(m_page_state[ndx], UpToDate);
+        // force the page reclaimer to look into pages read ahead
+        size_t chunk_ndx = ndx >> page_to_chunk_shift;
+        if (m_chunk_dont_scan[chunk_ndx])
+            m_chunk_dont_scan[chunk_ndx] = 0;
     }
-    if (is_not(m_page_state[local_page_ndx], UpToDate | PartiallyUpToDate))
-        m_num_decrypted++;
-    clear(m_page_state[local_page_ndx], PartiallyUpToDate);
-    set(m_page_state[local_page_ndx], UpToDate);
 }
 
 void EncryptedFileMapping::write_page(size_t local_page_ndx) noexcept
@@ -713,16 +1205,25 @@ void EncryptedFileMapping::reclaim_untouched(size_t& progress_index, size_t& wor
 void EncryptedFileMapping::flush() noexcept
 {
     const size_t num_dirty_pages = m_page_state.size();
-    for (size_t local_page_ndx = 0; local_page_ndx < num_dirty_pages; ++local_page_ndx) {
+    size_t local_page_ndx = 0;
+    while (local_page_ndx < num_dirty_pages) {
         if (is_not(m_page_state[local_page_ndx], Dirty)) {
             validate_page(local_page_ndx);
+            ++local_page_ndx;
             continue;
         }
 
+        // Adjacent dirty pages are handed to the cryptor together, so that
+        // they can be encrypted in parallel and written in larger chunks.
+        size_t end_ndx = local_page_ndx + 1;
+        while (end_ndx < num_dirty_pages && is(m_page_state[end_ndx], Dirty))
+            ++end_ndx;
+
         size_t page_ndx_in_file = local_page_ndx + m_first_page;
         m_file.cryptor.write(m_file.fd, off_t(page_ndx_in_file << m_page_shift), page_addr(local_page_ndx),
-                             static_cast<size_t>(1ULL << m_page_shift));
-        clear(m_page_state[local_page_ndx], Dirty);
+                             (end_ndx - local_page_ndx) << m_page_shift);
+        for (; local_page_ndx < end_ndx; ++local_page_ndx)
+            clear(m_page_state[local_page_ndx], Dirty);
     }
 
     validate();
@@ -797,8 +1298,13 @@ void EncryptedFileMapping::read_barrier(const void* addr, size_t size, Header_to
         PageState& ps = m_page_state[first_accessed_local_page];
         if (is_not(ps, Touched))
             set(ps, Touched);
-        if (is_not(ps, UpToDate))
+        if (is_not(ps, UpToDate)) {
+            ++decrypted_page_misses;
             refresh_page(first_accessed_local_page);
+        }
+        else {
+            ++decrypted_page_hits;
+        }
     }
 
     // force the page reclaimer to look into pages in this chunk:
@@ -828,8 +1334,13 @@ void EncryptedFileMapping::read_barrier(const void* addr, size_t size, Header_to
         PageState& ps = m_page_state[idx];
         if (is_not(ps, Touched))
             set(ps, Touched);
-        if (is_not(ps, UpToDate))
+        if (is_not(ps, UpToDate)) {
+            ++decrypted_page_misses;
             refresh_page(idx);
+        }
+        else {
+            ++decrypted_page_hits;
+        }
     }
 }
 
@@ -849,6 +1360,7 @@ void EncryptedFileMapping::set(void* new_addr, size_t new_size, size_t new_file_
     size_t num_pages = new_size >> m_page_shift;
 
     m_num_decrypted = 0;
+    m_last_refreshed_page = 0;
     m_page_state.clear();
     m_chunk_dont_scan.clear();
 
@@ -856,17 +1368,17 @@ void EncryptedFileMapping::set(void* new_addr, size_t new_size, size_t new_file_
     m_chunk_dont_scan.resize((num_pages + page_to_chunk_factor - 1) >> page_to_chunk_shift, false);
 }
 
-File::SizeType encrypted_size_to_data_size(File::SizeType size) noexcept
+File::SizeType encrypted_size_to_data_size(File::SizeType size, File::EncryptionFormat format) noexcept
 {
     if (size == 0)
         return 0;
-    return fake_offset(size);
+    return get_layout(format).fake_offset(size);
 }
 
-File::SizeType data_size_to_encrypted_size(File::SizeType size) noexcept
+File::SizeType data_size_to_encrypted_size(File::SizeType size, File::EncryptionFormat format) noexcept
 {
     size_t ps = page_size();
-    return real_offset((size + ps - 1) & ~(ps - 1));
+    return get_layout(format).real_offset((size + ps - 1) & ~(ps - 1));
 }
 
 #else
@@ -874,12 +1386,12 @@ File::SizeType data_size_to_encrypted_size(File::SizeType size) noexcept
 namespace realm {
 namespace util {
 
-File::SizeType encrypted_size_to_data_size(File::SizeType size) noexcept
+File::SizeType encrypted_size_to_data_size(File::SizeType size, File::EncryptionFormat) noexcept
 {
     return size;
 }
 
-File::SizeType data_size_to_encrypted_size(File::SizeType size) noexcept
+File::SizeType data_size_to_encrypted_size(File::SizeType size, File::EncryptionFormat) noexcept
 {
     return size;
 }
@@ -94,6 +94,7 @@ private:
 
     size_t m_first_page;
     size_t m_num_decrypted; // 1 for every page decrypted
+    size_t m_last_refreshed_page = 0;
 
     enum PageState {
         Touched = 1,           // a ref->ptr translation has taken place
@@ -123,6 +124,8 @@ private:
     std::vector<bool> m_chunk_dont_scan;
     static constexpr int page_to_chunk_shift = 10;
     static constexpr size_t page_to_chunk_factor = size_t(1) << page_to_chunk_shift;
+    // max number of pages decrypted ahead of a sequential read
+    static constexpr size_t read_ahead_pages = 16;
 
     File::AccessMode m_access;
 
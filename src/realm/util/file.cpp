@@ -642,7 +642,7 @@ File::SizeType File::get_size() const
     File::SizeType size = get_size_static(m_fd);
 
     if (m_encryption_key) {
-        File::SizeType ret_size = encrypted_size_to_data_size(size);
+        File::SizeType ret_size = encrypted_size_to_data_size(size, m_encryption_format);
         return ret_size;
     }
     else
@@ -660,7 +660,7 @@ void File::resize(SizeType size)
     SizeType p = get_file_pos(m_fd);
 
     if (m_encryption_key)
-        size = data_size_to_encrypted_size(size);
+        size = data_size_to_encrypted_size(size, m_encryption_format);
 
     // Windows docs say "it is not an error to set the file pointer to a position beyond the end of the file."
     // so seeking with SetFilePointerEx() will not error out even if there is no disk space left.
@@ -682,7 +682,7 @@ void File::resize(SizeType size)
 #else // POSIX version
 
     if (m_encryption_key)
-        size = data_size_to_encrypted_size(size);
+        size = data_size_to_encrypted_size(size, m_encryption_format);
 
     off_t size2;
     if (int_cast_with_overflow_detect(size, size2))
@@ -713,8 +713,8 @@ void File::prealloc(size_t size)
 
     size_t new_size = size;
     if (m_encryption_key) {
-        new_size = static_cast<size_t>(data_size_to_encrypted_size(size));
-        REALM_ASSERT(size == static_cast<size_t>(encrypted_size_to_data_size(new_size)));
+        new_size = static_cast<size_t>(data_size_to_encrypted_size(size, m_encryption_format));
+        REALM_ASSERT(size == static_cast<size_t>(encrypted_size_to_data_size(new_size, m_encryption_format)));
         if (new_size < size) {
             throw util::runtime_error("File size overflow: data_size_to_encrypted_size(" +
                                       realm::util::to_string(size) + ") == " + realm::util::to_string(new_size));
@@ -1248,6 +1248,12 @@ void File::sync_map(FileDesc fd, void* addr, size_t size)
 }
 
 
+void File::advise_map(void* addr, size_t size, MapAdvice advice) noexcept
+{
+    realm::util::madvise(addr, size, advice);
+}
+
+
 bool File::exists(const std::string& path)
 {
 #ifdef _WIN32
@@ -1546,18 +1552,24 @@ bool File::for_each(const std::string& dir_path, ForEachHandler handler)
 }
 
 
-void File::set_encryption_key(const char* key)
+void File::set_encryption_key(const char* key, EncryptionFormat format)
 {
 #if REALM_ENABLE_ENCRYPTION
     if (key) {
+        // An existing file determines its own format, while an empty one is
+        // initialized with the requested format
+        if (is_attached())
+            format = init_encryption_format(m_fd, format); // Throws
         char* buffer = new char[64];
         memcpy(buffer, key, 64);
         m_encryption_key.reset(static_cast<const char*>(buffer));
+        m_encryption_format = format;
     }
     else {
         m_encryption_key.reset();
     }
 #else
+    static_cast<void>(format);
     if (key) {
         throw util::runtime_error("Encryption not enabled");
     }
@@ -1569,6 +1581,11 @@ const char* File::get_encryption_key() const
     return m_encryption_key.get();
 }
 
+File::EncryptionFormat File::get_encryption_format() const noexcept
+{
+    return m_encryption_format;
+}
+
 void File::MapBase::map(const File& f, AccessMode a, size_t size, int map_flags, size_t offset)
 {
     REALM_ASSERT(!m_addr);
@@ -1610,6 +1627,16 @@ void File::MapBase::sync()
     File::sync_map(m_fd, m_addr, m_size);
 }
 
+void File::MapBase::advise(MapAdvice advice) noexcept
+{
+    REALM_ASSERT(m_addr);
+#if REALM_ENABLE_ENCRYPTION
+    if (m_encrypted_mapping)
+        return;
+#endif
+    File::advise_map(m_addr, m_size, advice);
+}
+
 
 
 #ifndef _WIN32
@@ -196,6 +196,12 @@ public:
         create_Must   ///< Fail if the file already exists.
     };
 
+    /// The on-disk layout of an encrypted file.
+    enum EncryptionFormat {
+        encryption_AesCbcHmac, ///< AES-256-CBC with a separate HMAC-SHA224 per 4KB block.
+        encryption_AesGcm      ///< AES-256-GCM, authenticating each 4KB block in the same pass.
+    };
+
     enum {
         flag_Trunc = 1, ///< Truncate the file if it already exists.
         flag_Append = 2 ///< Move to end of file before each write.
@@ -362,13 +368,22 @@ public:
     /// Set the encryption key used for this file. Must be called before any
     /// mappings are created or any data is read from or written to the file.
     ///
+    /// A non-empty file keeps the format it was written in. If the file is
+    /// attached and empty, it is initialized with the specified format.
+    ///
     /// \param key A 64-byte encryption key, or null to disable encryption.
-    void set_encryption_key(const char* key);
+    ///
+    /// \param format The encryption format to use if the file is empty.
+    void set_encryption_key(const char* key, EncryptionFormat format = encryption_AesCbcHmac);
 
     /// Get the encryption key set by set_encryption_key(),
     /// null_ptr if no key set.
     const char* get_encryption_key() const;
 
+    /// Get the encryption format of this file. Only meaningful if an encryption
+    /// key has been set.
+    EncryptionFormat get_encryption_format() const noexcept;
+
     /// Set the path used for emulating file locks. If not set explicitly,
     /// the emulation will use the path of the file itself suffixed by ".fifo"
     void set_fifo_path(const std::string& fifo_path);
@@ -382,6 +397,22 @@ public:
         map_NoSync = 1
     };
 
+    /// Hints about how a memory mapped range will be accessed, see
+    /// advise_map().
+    enum MapAdvice {
+        /// No particular access pattern. Undoes any previous advice.
+        advice_Normal,
+        /// Pages will be accessed in ascending order, so the kernel may read
+        /// aggressively ahead and release pages soon after they were used.
+        advice_Sequential,
+        /// Pages will be accessed in random order, so reading ahead is not
+        /// worthwhile.
+        advice_Random,
+        /// Pages will be accessed soon, so the kernel should start reading
+        /// them into memory in the background.
+        advice_WillNeed
+    };
+
     /// Map this file into memory. The file is mapped as shared
     /// memory. This allows two processes to interact under exatly the
     /// same rules as applies to the interaction via regular memory of
@@ -436,6 +467,13 @@ public:
     /// map().
     static void sync_map(FileDesc fd, void* addr, size_t size);
 
+    /// Advise the operating system about how the specified address range,
+    /// which must be (a subset of) one that was previously returned by map(),
+    /// will be accessed. The range does not need to be page aligned. This is
+    /// only a hint, so it has no effect on platforms which do not support it,
+    /// and failures are ignored.
+    static void advise_map(void* addr, size_t size, MapAdvice) noexcept;
+
     /// Check whether the specified file or directory exists. Note
     /// that a file or directory that resides in a directory that the
     /// calling process has no access to, will necessarily be reported
@@ -614,6 +652,7 @@ private:
 #endif
 #endif
     std::unique_ptr<const char[]> m_encryption_key = nullptr;
+    EncryptionFormat m_encryption_format = encryption_AesCbcHmac;
     std::string m_path;
 
     bool lock(bool exclusive, bool non_blocking);
@@ -645,6 +684,7 @@ private:
         void remap(const File&, AccessMode, size_t size, int map_flags);
         void unmap() noexcept;
         void sync();
+        void advise(MapAdvice) noexcept;
 #if REALM_ENABLE_ENCRYPTION
         mutable util::EncryptedFileMapping* m_encrypted_mapping = nullptr;
         inline util::EncryptedFileMapping* get_encrypted_mapping() const
@@ -785,6 +825,14 @@ public:
     /// attached to a memory mapped file, has undefined behavior.
     void sync();
 
+    /// See File::advise_map(). The advice applies to the entire mapped
+    /// region. It has no effect on encrypted mappings, since their pages are
+    /// filled in by decryption rather than being paged in from the file.
+    ///
+    /// Calling this function on an instance that is not currently
+    /// attached to a memory mapped file, has undefined behavior.
+    void advise(MapAdvice) noexcept;
+
     /// Check whether this Map instance is currently attached to a
     /// memory mapped file.
     bool is_attached() const noexcept;
@@ -1028,6 +1076,7 @@ inline File::File(File&& f) noexcept
     f.m_fd = -1;
 #endif
     m_encryption_key = std::move(f.m_encryption_key);
+    m_encryption_format = f.m_encryption_format;
 }
 
 inline File& File::operator=(File&& f) noexcept
@@ -1048,6 +1097,7 @@ inline File& File::operator=(File&& f) noexcept
 #endif
 #endif
     m_encryption_key = std::move(f.m_encryption_key);
+    m_encryption_format = f.m_encryption_format;
     return *this;
 }
 
@@ -1190,6 +1240,12 @@ inline void File::Map<T>::sync()
     MapBase::sync();
 }
 
+template <class T>
+inline void File::Map<T>::advise(MapAdvice advice) noexcept
+{
+    MapBase::advise(advice);
+}
+
 template <class T>
 inline bool File::Map<T>::is_attached() const noexcept
 {
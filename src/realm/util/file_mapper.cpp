@@ -32,6 +32,7 @@
 #include <realm/util/to_string.hpp>
 #include <realm/exceptions.hpp>
 #include <system_error>
+#include <vector>
 
 #if REALM_ENABLE_ENCRYPTION
 
@@ -88,6 +89,62 @@ size_t round_up_to_page_size(size_t size) noexcept
     return (size + page_size() - 1) & ~(page_size() - 1);
 }
 
+/* Compute the amount of work allowed in an attempt to reclaim pages.
+ * please refer to EncryptedFileMapping::reclaim_untouched() for more details.
+ *
+ * The function starts slowly when the load is 0.5 of target, then turns
+ * up the volume as the load nears 1.0 - where it sets a work limit of 10%.
+ * Since the work is expressed (roughly) in terms of pages released, this means
+ * that about 10 runs has to take place to reclaim all pages possible - though
+ * if successful the load will rapidly decrease, turning down the work limit.
+ */
+
+namespace {
+struct work_limit_desc {
+    float base;
+    float effort;
+};
+const std::vector<work_limit_desc> control_table = {{0.5f, 0.001f},  {0.75f, 0.002f}, {0.8f, 0.003f},
+                                                    {0.85f, 0.005f}, {0.9f, 0.01f},   {0.95f, 0.03f},
+                                                    {1.0f, 0.1f},    {1.5f, 0.2f},    {2.0f, 0.3f}};
+} // anonymous namespace
+
+size_t PageReclaimGovernor::get_work_limit(size_t decrypted_pages, size_t target)
+{
+    if (target == 0)
+        target = 1;
+    float load = 1.0f * decrypted_pages / target;
+    float akku = 0.0f;
+    for (const auto& e : control_table) {
+        if (load <= e.base)
+            break;
+        akku += (load - e.base) * e.effort;
+    }
+    size_t work_limit = size_t(target * akku);
+    return work_limit;
+}
+
+std::function<int64_t()> BudgetPageReclaimGovernor::current_target_getter(size_t)
+{
+    int64_t budget = int64_t(m_budget.load());
+    return [budget] {
+        return budget;
+    };
+}
+
+size_t BudgetPageReclaimGovernor::get_work_limit(size_t decrypted_pages, size_t target)
+{
+    size_t work_limit = PageReclaimGovernor::get_work_limit(decrypted_pages, target);
+    if (decrypted_pages > target) {
+        // Allow every page above the budget to be released in this run. The
+        // reclaimer also charges one unit of work for every 4K pages scanned,
+        // so add enough for one full sweep across the decrypted pages.
+        size_t excess = decrypted_pages - target;
+        work_limit = std::max(work_limit, excess + decrypted_pages / 4096 + 1);
+    }
+    return work_limit;
+}
+
 
 #if REALM_ENABLE_ENCRYPTION
 
@@ -112,6 +169,8 @@ struct mapping_and_addr {
 };
 
 util::Mutex& mapping_mutex = *(new util::Mutex);
+uint64_t decrypted_page_hits = 0;
+uint64_t decrypted_page_misses = 0;
 namespace {
 std::vector<mapping_and_addr>& mappings_by_addr = *new std::vector<mapping_and_addr>;
 std::vector<mappings_for_file>& mappings_by_file = *new std::vector<mappings_for_file>;
@@ -216,7 +275,7 @@ private:
 static DefaultGovernor default_governor;
 static PageReclaimGovernor* governor = &default_governor;
 
-void reclaim_pages();
+void reclaim_pages(PageReclaimGovernor* governor_override = nullptr);
 
 #if !REALM_PLATFORM_APPLE
 static std::atomic<bool> reclaimer_shutdown(false);
@@ -286,6 +345,11 @@ void set_page_reclaim_governor(PageReclaimGovernor* new_governor)
     ensure_reclaimer_thread_runs();
 }
 
+void reclaim_decrypted_pages(PageReclaimGovernor& governor)
+{
+    reclaim_pages(&governor);
+}
+
 size_t get_num_decrypted_pages()
 {
     return num_decrypted_pages.load();
@@ -297,6 +361,9 @@ decrypted_memory_stats_t get_decrypted_memory_stats()
     retval.memory_size = num_decrypted_pages.load() * page_size();
     retval.reclaimer_target = reclaimer_target.load() * page_size();
     retval.reclaimer_workload = reclaimer_workload.load() * page_size();
+    LockGuard lock(mapping_mutex);
+    retval.page_hits = decrypted_page_hits;
+    retval.page_misses = decrypted_page_misses;
     return retval;
 }
 
@@ -343,39 +410,6 @@ size_t collect_total_workload() // must be called under lock
     return total;
 }
 
-/* Compute the amount of work allowed in an attempt to reclaim pages.
- * please refer to EncryptedFileMapping::reclaim_untouched() for more details.
- *
- * The function starts slowly when the load is 0.5 of target, then turns
- * up the volume as the load nears 1.0 - where it sets a work limit of 10%.
- * Since the work is expressed (roughly) in terms of pages released, this means
- * that about 10 runs has to take place to reclaim all pages possible - though
- * if successful the load will rapidly decrease, turning down the work limit.
- */
-
-struct work_limit_desc {
-    float base;
-    float effort;
-};
-const std::vector<work_limit_desc> control_table = {{0.5f, 0.001f},  {0.75f, 0.002f}, {0.8f, 0.003f},
-                                                    {0.85f, 0.005f}, {0.9f, 0.01f},   {0.95f, 0.03f},
-                                                    {1.0f, 0.1f},    {1.5f, 0.2f},    {2.0f, 0.3f}};
-
-size_t get_work_limit(size_t decrypted_pages, size_t target)
-{
-    if (target == 0)
-        target = 1;
-    float load = 1.0f * decrypted_pages / target;
-    float akku = 0.0f;
-    for (const auto& e : control_table) {
-        if (load <= e.base)
-            break;
-        akku += (load - e.base) * e.effort;
-    }
-    size_t work_limit = size_t(target * akku);
-    return work_limit;
-}
-
 /* Find the oldest version that is still of interest to somebody */
 uint64_t get_oldest_version(SharedFileInfo& info) // must be called under lock
 {
@@ -416,15 +450,17 @@ void reclaim_pages_for_file(SharedFileInfo& info, size_t& work_limit)
 // Reclaim pages from all files, limited by a work limit that is derived
 // from a target for the amount of dirty (decrypted) pages. The target is
 // set by the governor function.
-void reclaim_pages()
+void reclaim_pages(PageReclaimGovernor* governor_override)
 {
     size_t load;
     std::function<int64_t()> runnable;
+    PageReclaimGovernor* active_governor;
     {
         UniqueLock lock(mapping_mutex);
+        active_governor = governor_override ? governor_override : governor;
         load = collect_total_workload();
         num_decrypted_pages = load;
-        runnable = governor->current_target_getter(load * page_size());
+        runnable = active_governor->current_target_getter(load * page_size());
     }
     // callback to governor defined function without mutex held
     int64_t target = PageReclaimGovernor::no_match;
@@ -437,7 +473,7 @@ void reclaim_pages()
         reclaimer_target = size_t(target / page_size());
         // Putting the target back into the govenor object will allow the govenor
         // to return a getter producing this value again next time it is called
-        governor->report_target_result(target);
+        active_governor->report_target_result(target);
 
         if (target == PageReclaimGovernor::no_match) // temporarily disabled by governor returning no_match
             return;
@@ -445,7 +481,7 @@ void reclaim_pages()
         if (mappings_by_file.size() == 0)
             return;
 
-        size_t work_limit = get_work_limit(load, reclaimer_target);
+        size_t work_limit = active_governor->get_work_limit(load, reclaimer_target);
         reclaimer_workload = work_limit;
         if (file_reclaim_index >= mappings_by_file.size())
             file_reclaim_index = 0;
@@ -970,5 +1006,35 @@ void msync(FileDesc fd, void* addr, size_t size)
     }
 #endif
 }
+
+void madvise(void* addr, size_t size, File::MapAdvice advice) noexcept
+{
+#ifdef _WIN32
+    static_cast<void>(addr);
+    static_cast<void>(size);
+    static_cast<void>(advice);
+#else
+    int native_advice = MADV_NORMAL;
+    switch (advice) {
+        case File::advice_Normal:
+            native_advice = MADV_NORMAL;
+            break;
+        case File::advice_Sequential:
+            native_advice = MADV_SEQUENTIAL;
+            break;
+        case File::advice_Random:
+            native_advice = MADV_RANDOM;
+            break;
+        case File::advice_WillNeed:
+            native_advice = MADV_WILLNEED;
+            break;
+    }
+    // madvise() requires the start of the range to be page aligned
+    uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~uintptr_t(page_size() - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(addr) + size;
+    // The advice is only a hint, so a failure is not worth reporting
+    ::madvise(reinterpret_cast<void*>(begin), end - begin, native_advice);
+#endif
+}
 }
 }
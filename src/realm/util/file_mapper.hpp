@@ -24,6 +24,7 @@
 #include <realm/util/thread.hpp>
 #include <realm/util/encrypted_file_mapping.hpp>
 
+#include <atomic>
 #include <functional>
 
 namespace realm {
@@ -37,6 +38,7 @@ void munmap(void* addr, size_t size);
 void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, File::AccessMode a, size_t new_size,
              const char* encryption_key);
 void msync(FileDesc fd, void* addr, size_t size);
+void madvise(void* addr, size_t size, File::MapAdvice advice) noexcept;
 void* mmap_anon(size_t size);
 
 // A function which may be given to encryption_read_barrier. If present, the read barrier is a
@@ -54,6 +56,45 @@ public:
     static constexpr int64_t no_match = -1;
     virtual std::function<int64_t()> current_target_getter(size_t load) = 0;
     virtual void report_target_result(int64_t) = 0;
+
+    // Called by the page reclaimer with the current load and target (both in
+    // pages) and must return the amount of work the reclaimer may do in this
+    // run. Roughly one unit of work is spent for each page released. The
+    // default starts reclaiming slowly when the load reaches half the target
+    // and gradually increases the effort as the target is exceeded.
+    virtual size_t get_work_limit(size_t load, size_t target);
+
+    virtual ~PageReclaimGovernor() = default;
+};
+
+// A governor which keeps the memory used for decrypted pages within a fixed
+// budget (in bytes). Decrypted pages are visited in a clock-like sweep across
+// all encrypted mappings in the process, and pages which have not been
+// accessed since the previous sweep are released first. Once the budget is
+// exceeded, the reclaimer is allowed to release everything above it in a
+// single run, rather than converging on the target over many runs.
+class BudgetPageReclaimGovernor : public PageReclaimGovernor {
+public:
+    explicit BudgetPageReclaimGovernor(size_t budget) noexcept
+        : m_budget(budget)
+    {
+    }
+
+    void set_budget(size_t budget) noexcept
+    {
+        m_budget = budget;
+    }
+    size_t get_budget() const noexcept
+    {
+        return m_budget;
+    }
+
+    std::function<int64_t()> current_target_getter(size_t load) override;
+    void report_target_result(int64_t) override {}
+    size_t get_work_limit(size_t load, size_t target) override;
+
+private:
+    std::atomic<size_t> m_budget;
 };
 
 // Set a page reclaim governor. The governor is an object with a method which will be called periodically
@@ -73,6 +114,11 @@ inline void set_page_reclaim_governor_to_default()
     set_page_reclaim_governor(nullptr);
 }
 
+// Run a single pass of the page reclaimer in the calling thread, using the
+// given governor rather than the installed one. Releasing a page takes two
+// passes, as the first one only clears its access bit.
+void reclaim_decrypted_pages(PageReclaimGovernor& governor);
+
 // Retrieves the number of in memory decrypted pages, across all open files.
 size_t get_num_decrypted_pages();
 
@@ -80,10 +126,14 @@ size_t get_num_decrypted_pages();
 // - amount of memory used for decrypted pages, across all open files.
 // - current target for the reclaimer (desired number of decrypted pages)
 // - current workload size for the reclaimer, across all open files.
+// - number of page accesses through read barriers which found the page
+//   decrypted (hits) or had to decrypt it (misses), since the process started.
 struct decrypted_memory_stats_t {
     size_t memory_size;
     size_t reclaimer_target;
     size_t reclaimer_workload;
+    uint64_t page_hits;
+    uint64_t page_misses;
 };
 
 decrypted_memory_stats_t get_decrypted_memory_stats();
@@ -126,6 +176,11 @@ void inline encryption_write_barrier(const void* addr, size_t size, EncryptedFil
 
 extern util::Mutex& mapping_mutex;
 
+// Hit and miss counters reported by get_decrypted_memory_stats(). May be
+// accessed only while holding mapping_mutex.
+extern uint64_t decrypted_page_hits;
+extern uint64_t decrypted_page_misses;
+
 inline void do_encryption_read_barrier(const void* addr, size_t size, HeaderToSize header_to_size,
                                        EncryptedFileMapping* mapping)
 {
@@ -145,6 +200,10 @@ void inline set_page_reclaim_governor(PageReclaimGovernor*)
 {
 }
 
+void inline reclaim_decrypted_pages(PageReclaimGovernor&)
+{
+}
+
 size_t inline get_num_decrypted_pages()
 {
     return 0;
@@ -179,8 +238,14 @@ void encryption_write_barrier(const File::Map<T>& map, size_t index, size_t num_
     encryption_write_barrier(addr + index, sizeof(T) * num_elements, map.get_encrypted_mapping());
 }
 
-File::SizeType encrypted_size_to_data_size(File::SizeType size) noexcept;
-File::SizeType data_size_to_encrypted_size(File::SizeType size) noexcept;
+File::SizeType encrypted_size_to_data_size(File::SizeType size, File::EncryptionFormat format) noexcept;
+File::SizeType data_size_to_encrypted_size(File::SizeType size, File::EncryptionFormat format) noexcept;
+
+#if REALM_ENABLE_ENCRYPTION
+// Determine the encryption format of the file from its first block. An empty
+// file is initialized to the given format and that format is returned.
+File::EncryptionFormat init_encryption_format(FileDesc fd, File::EncryptionFormat format_if_empty);
+#endif
 
 size_t round_up_to_page_size(size_t size) noexcept;
 }
@@ -48,6 +48,11 @@
 #if REALM_NETWORK_USE_EPOLL
 #include <linux/version.h>
 #include <sys/epoll.h>
+#if REALM_NETWORK_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
 #elif REALM_HAVE_KQUEUE
 #include <sys/types.h>
 #include <sys/event.h>
@@ -377,6 +382,240 @@ private:
 #endif // defined _WIN32
 
 
+#if REALM_NETWORK_USE_IO_URING
+
+// A minimal io_uring instance driven directly through the system calls, such
+// that there is no dependency on liburing. It requires Linux 5.13 or later
+// (multishot poll and extended wait arguments). An instance must only be
+// accessed by one thread at a time.
+class IoUring {
+public:
+    IoUring() noexcept = default;
+    ~IoUring() noexcept;
+
+    // Returns false if io_uring is unavailable, for example because the kernel
+    // is too old, or because io_uring has been disabled by a seccomp filter or
+    // by `kernel.io_uring_disabled`. The instance is left closed in that case.
+    bool open(unsigned sq_entries, unsigned cq_entries) noexcept;
+
+    bool is_open() const noexcept
+    {
+        return (m_fd != -1);
+    }
+
+    // Returns a cleared submission queue entry, which will be submitted by the
+    // next invocation of enter(). If the submission queue is full, the pending
+    // entries are submitted first.
+    io_uring_sqe& get_sqe() noexcept;
+
+    // Same as get_sqe(), except that null is returned if the submission queue
+    // is full, and no room could be made for another entry.
+    io_uring_sqe* try_get_sqe() noexcept;
+
+    bool has_unsubmitted() const noexcept
+    {
+        return (m_sq_local_tail != __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE));
+    }
+
+    // True if completions have been held back by the kernel due to lack of
+    // space in the completion queue. They are flushed by enter().
+    bool has_overflow() const noexcept
+    {
+        return ((__atomic_load_n(m_sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) != 0);
+    }
+
+    // Submit all pending submission queue entries, and, if `wait` is true, wait
+    // for at least one completion, or until the specified timeout expires. If
+    // `timeout` is null, there is no timeout. Returns zero on success,
+    // otherwise the `errno` value of the failed system call. In particular,
+    // EINTR is returned on interruption by a system signal, and ETIME on
+    // expiration of the timeout.
+    int enter(bool wait, const __kernel_timespec* timeout) noexcept;
+
+    // Pass each available completion queue entry to the specified handler, and
+    // then release them to the kernel. Returns the number of entries.
+    template <class H>
+    unsigned reap(H handler) noexcept;
+
+private:
+    int m_fd = -1;
+    void* m_sq_ring = MAP_FAILED;
+    void* m_cq_ring = MAP_FAILED;
+    void* m_sqes = MAP_FAILED;
+    std::size_t m_sq_ring_size = 0, m_cq_ring_size = 0, m_sqes_size = 0;
+
+    unsigned* m_sq_head = nullptr;
+    unsigned* m_sq_tail = nullptr;
+    unsigned* m_sq_flags = nullptr;
+    unsigned m_sq_mask = 0;
+    unsigned m_sq_entries = 0;
+    unsigned m_sq_local_tail = 0;
+
+    unsigned* m_cq_head = nullptr;
+    unsigned* m_cq_tail = nullptr;
+    unsigned m_cq_mask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+
+    void close() noexcept;
+};
+
+
+IoUring::~IoUring() noexcept
+{
+    close();
+}
+
+
+bool IoUring::open(unsigned sq_entries, unsigned cq_entries) noexcept
+{
+    REALM_ASSERT(!is_open());
+    io_uring_params params = io_uring_params(); // Clear
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = cq_entries;
+    int ret = int(::syscall(__NR_io_uring_setup, sq_entries, &params));
+    if (ret == -1)
+        return false;
+    m_fd = ret;
+    // IORING_FEAT_RSRC_TAGS was introduced in the same kernel version (5.13)
+    // as multishot poll (IORING_POLL_ADD_MULTI), which cannot be probed for
+    // directly.
+    unsigned required_features = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+    if ((params.features & required_features) != required_features) {
+        close();
+        return false;
+    }
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+    if (single_mmap)
+        m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+    m_sq_ring = ::mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+                       IORING_OFF_SQ_RING);
+    if (m_sq_ring == MAP_FAILED) {
+        close();
+        return false;
+    }
+    if (!single_mmap) {
+        m_cq_ring = ::mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+                           IORING_OFF_CQ_RING);
+        if (m_cq_ring == MAP_FAILED) {
+            close();
+            return false;
+        }
+    }
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes =
+        ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (m_sqes == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    char* sq_ring = static_cast<char*>(m_sq_ring);
+    char* cq_ring = static_cast<char*>(single_mmap ? m_sq_ring : m_cq_ring);
+    m_sq_head = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+    m_sq_flags = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.flags);
+    m_sq_mask = *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sq_local_tail = *m_sq_tail;
+    m_cq_head = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+    m_cq_mask = *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+    // Submission queue entries are always used in ring order, so the
+    // indirection array can be set up once and for all.
+    unsigned* sq_array = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+    for (unsigned i = 0; i < m_sq_entries; ++i)
+        sq_array[i] = i;
+    return true;
+}
+
+
+void IoUring::close() noexcept
+{
+    if (m_sqes != MAP_FAILED)
+        ::munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring != MAP_FAILED)
+        ::munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring != MAP_FAILED)
+        ::munmap(m_sq_ring, m_sq_ring_size);
+    m_sqes = m_cq_ring = m_sq_ring = MAP_FAILED;
+    if (m_fd != -1)
+        ::close(m_fd);
+    m_fd = -1;
+}
+
+
+io_uring_sqe& IoUring::get_sqe() noexcept
+{
+    io_uring_sqe* sqe = try_get_sqe();
+    // Without IORING_SETUP_SQPOLL, the kernel consumes submission queue
+    // entries during io_uring_enter(), so if none were consumed, we are out of
+    // resources.
+    REALM_ASSERT_RELEASE(sqe);
+    return *sqe;
+}
+
+
+io_uring_sqe* IoUring::try_get_sqe() noexcept
+{
+    REALM_ASSERT(is_open());
+    if (REALM_UNLIKELY(m_sq_local_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE) == m_sq_entries)) {
+        // Any error is reflected in the number of consumed entries
+        enter(false, nullptr);
+        if (m_sq_local_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE) == m_sq_entries)
+            return nullptr;
+    }
+    io_uring_sqe& sqe = static_cast<io_uring_sqe*>(m_sqes)[m_sq_local_tail & m_sq_mask];
+    sqe = io_uring_sqe(); // Clear
+    ++m_sq_local_tail;
+    return &sqe;
+}
+
+
+int IoUring::enter(bool wait, const __kernel_timespec* timeout) noexcept
+{
+    __atomic_store_n(m_sq_tail, m_sq_local_tail, __ATOMIC_RELEASE);
+    unsigned to_submit = m_sq_local_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    unsigned min_complete = (wait ? 1 : 0);
+    unsigned flags = 0;
+    if (wait || has_overflow())
+        flags |= IORING_ENTER_GETEVENTS;
+    io_uring_getevents_arg arg = io_uring_getevents_arg(); // Clear
+    const void* argp = nullptr;
+    std::size_t argsz = 0;
+    if (timeout) {
+        arg.ts = reinterpret_cast<std::uint64_t>(timeout);
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argsz = sizeof arg;
+    }
+    if (to_submit == 0 && flags == 0)
+        return 0;
+    int ret = int(::syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, argp, argsz));
+    if (ret == -1)
+        return errno;
+    return 0;
+}
+
+
+template <class H>
+unsigned IoUring::reap(H handler) noexcept
+{
+    unsigned head = *m_cq_head;
+    unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+    for (unsigned i = head; i != tail; ++i)
+        handler(m_cqes[i & m_cq_mask]);
+    __atomic_store_n(m_cq_head, tail, __ATOMIC_RELEASE);
+    return tail - head;
+}
+
+#endif // REALM_NETWORK_USE_IO_URING
+
+
 std::error_code translate_addrinfo_error(int err) noexcept
 {
     switch (err) {
@@ -466,6 +705,43 @@ private:
     static std::unique_ptr<epoll_event[]> make_epoll_event_buffer();
     static CloseGuard make_epoll_fd();
 
+#if REALM_NETWORK_USE_IO_URING
+
+    // When io_uring is available at runtime, it is used instead of epoll. Each
+    // registered descriptor then has a multishot poll request, whose user data
+    // identifies the descriptor by its file descriptor number (low 32 bits),
+    // and by a registration generation (high 32 bits), such that completions
+    // that arrive after deregistration can be recognized and ignored. The
+    // generation is never zero, so user data values below 2^32 are free for
+    // other uses.
+    static constexpr unsigned s_io_uring_sq_entries = 1024;
+    static constexpr unsigned s_io_uring_cq_entries = 16384;
+    static constexpr std::uint_fast64_t s_io_uring_wakeup_user_data = 0;
+    static constexpr std::uint_fast64_t s_io_uring_ignored_user_data = 1;
+
+    struct PollSlot {
+        Descriptor* desc = nullptr;
+        std::uint_fast32_t generation = 0;
+    };
+
+    IoUring m_io_uring;
+    std::vector<PollSlot> m_poll_slots; // Indexed by file descriptor
+    std::uint_fast32_t m_poll_generation = 0;
+    std::size_t m_num_polls = 0; // Number of registered descriptors
+
+    // Removal requests (by user data) that could not be queued by
+    // deregister_desc() because the submission queue was full. They are
+    // queued by the next wait for completions. The capacity is kept at no
+    // less than the size plus `m_num_polls`, such that adding to it never
+    // allocates.
+    std::vector<std::uint_fast64_t> m_deferred_poll_removals;
+
+    void add_poll(int fd, std::uint_fast64_t user_data, unsigned events) noexcept;
+    bool remove_poll(std::uint_fast64_t user_data) noexcept;
+    bool wait_and_activate_io_uring(clock::time_point timeout, clock::time_point now);
+
+#endif // REALM_NETWORK_USE_IO_URING
+
 #elif REALM_HAVE_KQUEUE // !REALM_NETWORK_USE_EPOLL && REALM_HAVE_KQUEUE
 
     static constexpr int s_kevent_buffer_size = 256;
@@ -557,6 +833,10 @@ inline Service::IoReactor::IoReactor()
         std::error_code ec = make_basic_system_error_code(errno);
         throw std::system_error(ec);
     }
+#if REALM_NETWORK_USE_IO_URING
+    if (m_io_uring.open(s_io_uring_sq_entries, s_io_uring_cq_entries))
+        add_poll(m_wakeup_pipe.wait_fd(), s_io_uring_wakeup_user_data, POLLIN);
+#endif
 }
 
 
@@ -565,6 +845,24 @@ inline Service::IoReactor::~IoReactor() noexcept {}
 
 inline void Service::IoReactor::register_desc(Descriptor& desc)
 {
+#if REALM_NETWORK_USE_IO_URING
+    if (m_io_uring.is_open()) {
+        std::size_t fd = std::size_t(desc.m_fd);
+        if (fd >= m_poll_slots.size())
+            m_poll_slots.resize(fd + 1); // Throws
+        if (REALM_UNLIKELY(++m_poll_generation == 0))
+            ++m_poll_generation;
+        m_deferred_poll_removals.reserve(m_deferred_poll_removals.size() + m_num_polls + 1); // Throws
+        PollSlot& slot = m_poll_slots[fd];
+        slot.desc = &desc;
+        slot.generation = m_poll_generation;
+        ++m_num_polls;
+        // The request is submitted along with the next wait for completions.
+        std::uint_fast64_t user_data = (std::uint_fast64_t(slot.generation) << 32 | fd);
+        add_poll(desc.m_fd, user_data, POLLIN | POLLOUT | POLLRDHUP);
+        return;
+    }
+#endif
     epoll_event event = epoll_event();                        // Clear
     event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET; // Enable edge triggering
     event.data.ptr = &desc;
@@ -578,6 +876,27 @@ inline void Service::IoReactor::register_desc(Descriptor& desc)
 
 inline void Service::IoReactor::deregister_desc(Descriptor& desc) noexcept
 {
+#if REALM_NETWORK_USE_IO_URING
+    if (m_io_uring.is_open()) {
+        std::size_t fd = std::size_t(desc.m_fd);
+        REALM_ASSERT(fd < m_poll_slots.size());
+        PollSlot& slot = m_poll_slots[fd];
+        REALM_ASSERT(slot.desc == &desc);
+        std::uint_fast64_t user_data = (std::uint_fast64_t(slot.generation) << 32 | fd);
+        slot.desc = nullptr;
+        --m_num_polls;
+        if (REALM_UNLIKELY(!remove_poll(user_data))) {
+            m_deferred_poll_removals.push_back(user_data); // Capacity is reserved
+            return;
+        }
+        // Submit the removal immediately, because the poll request holds a
+        // reference to the file, and would otherwise prevent it from being
+        // closed until the next wait for completions. On failure, the removal
+        // is submitted along with that wait instead.
+        m_io_uring.enter(false, nullptr);
+        return;
+    }
+#endif
     epoll_event event = epoll_event(); // Clear
     int ret = epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, desc.m_fd, &event);
     REALM_ASSERT(ret != -1);
@@ -606,6 +925,10 @@ inline CloseGuard Service::IoReactor::make_epoll_fd()
 
 bool Service::IoReactor::wait_and_activate(clock::time_point timeout, clock::time_point now)
 {
+#if REALM_NETWORK_USE_IO_URING
+    if (m_io_uring.is_open())
+        return wait_and_activate_io_uring(timeout, now); // Throws
+#endif
     int max_wait_millis = 0;
     bool allow_blocking_wait = m_active_ops.empty();
     if (allow_blocking_wait) {
@@ -707,6 +1030,166 @@ bool Service::IoReactor::wait_and_activate(clock::time_point timeout, clock::tim
 }
 
 
+#if REALM_NETWORK_USE_IO_URING
+
+void Service::IoReactor::add_poll(int fd, std::uint_fast64_t user_data, unsigned events) noexcept
+{
+    io_uring_sqe& sqe = m_io_uring.get_sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    // Multishot poll requests are edge-triggered unless IORING_POLL_ADD_LEVEL
+    // is specified, which matches the use of EPOLLET above.
+    sqe.len = IORING_POLL_ADD_MULTI;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // The kernel expects the two 16-bit halves to be swapped on big-endian
+    // architectures.
+    events = (events << 16 | events >> 16);
+#endif
+    sqe.poll32_events = events;
+    sqe.user_data = user_data;
+}
+
+
+bool Service::IoReactor::remove_poll(std::uint_fast64_t user_data) noexcept
+{
+    io_uring_sqe* sqe = m_io_uring.try_get_sqe();
+    if (REALM_UNLIKELY(!sqe))
+        return false;
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = s_io_uring_ignored_user_data;
+    return true;
+}
+
+
+bool Service::IoReactor::wait_and_activate_io_uring(clock::time_point timeout, clock::time_point now)
+{
+    while (REALM_UNLIKELY(!m_deferred_poll_removals.empty())) {
+        if (!remove_poll(m_deferred_poll_removals.back()))
+            break;
+        m_deferred_poll_removals.pop_back();
+    }
+
+    bool got_wakeup_pipe_signal = false;
+    int wakeup_poll_error = 0;
+    auto handler = [&](const io_uring_cqe& cqe) {
+        std::uint_fast64_t user_data = cqe.user_data;
+        // A multishot poll request is terminated by the kernel under certain
+        // circumstances, such as overflow of the completion queue. This is
+        // indicated by the absence of IORING_CQE_F_MORE, and the request must
+        // then be resubmitted. If, on the other hand, the request was
+        // terminated due to a failure (negative result), resubmitting it would
+        // most likely fail in the same way, and do so again and again.
+        bool terminated = ((cqe.flags & IORING_CQE_F_MORE) == 0);
+        bool failed = (terminated && cqe.res < 0);
+        if (REALM_UNLIKELY(user_data == s_io_uring_wakeup_user_data)) {
+            if (cqe.res > 0) {
+                m_wakeup_pipe.acknowledge_signal();
+                got_wakeup_pipe_signal = true;
+            }
+            if (REALM_UNLIKELY(failed)) {
+                wakeup_poll_error = -cqe.res;
+                return;
+            }
+            if (terminated)
+                add_poll(m_wakeup_pipe.wait_fd(), user_data, POLLIN);
+            return;
+        }
+        if (user_data == s_io_uring_ignored_user_data)
+            return;
+        std::size_t fd = std::size_t(user_data & 0xFFFFFFFF);
+        std::uint_fast32_t generation = std::uint_fast32_t(user_data >> 32);
+        if (fd >= m_poll_slots.size())
+            return;
+        const PollSlot& slot = m_poll_slots[fd];
+        if (!slot.desc || slot.generation != generation)
+            return; // Descriptor was deregistered
+        Descriptor& desc = *slot.desc;
+        // On failure, let the I/O operations discover the cause. If they find
+        // nothing wrong with the descriptor itself, they fail with the error of
+        // the poll request instead of waiting for readiness (see
+        // Descriptor::would_block_error()), because no further readiness
+        // notifications will arrive.
+        if (REALM_UNLIKELY(failed))
+            desc.m_poll_error = -cqe.res;
+        unsigned events = (cqe.res >= 0 ? unsigned(cqe.res) : unsigned(POLLIN | POLLOUT | POLLERR));
+        if ((events & (POLLIN | POLLHUP | POLLERR)) != 0) {
+            if (!desc.m_read_ready) {
+                desc.m_read_ready = true;
+                m_active_ops.push_back(desc.m_suspended_read_ops);
+            }
+        }
+        if ((events & (POLLOUT | POLLHUP | POLLERR)) != 0) {
+            if (!desc.m_write_ready) {
+                desc.m_write_ready = true;
+                m_active_ops.push_back(desc.m_suspended_write_ops);
+            }
+        }
+        if ((events & POLLRDHUP) != 0)
+            desc.m_imminent_end_of_input = true;
+        if (terminated && !failed)
+            add_poll(desc.m_fd, user_data, POLLIN | POLLOUT | POLLRDHUP);
+    };
+    auto reap = [&] {
+        m_io_uring.reap(handler);
+        if (REALM_UNLIKELY(wakeup_poll_error != 0)) {
+            // Resubmit, such that a later wait can succeed, if the caller
+            // chooses to continue.
+            add_poll(m_wakeup_pipe.wait_fd(), s_io_uring_wakeup_user_data, POLLIN);
+            std::error_code ec = make_basic_system_error_code(wakeup_poll_error);
+            throw std::system_error(ec);
+        }
+    };
+
+    auto check_error = [](int err) {
+        // EINTR and ETIME (expiration of the timeout) are expected, and EAGAIN
+        // and EBUSY indicate a temporary shortage of resources in the kernel.
+        // In all these cases, an infrequent premature return is ok.
+        if (REALM_UNLIKELY(err != 0 && err != EINTR && err != ETIME && err != EAGAIN && err != EBUSY)) {
+            std::error_code ec = make_basic_system_error_code(err);
+            throw std::system_error(ec);
+        }
+    };
+
+    // Completions that are already available are taken directly from the
+    // completion queue, and only if that does not activate any operations, is
+    // it necessary to enter the kernel to wait for more.
+    reap(); // Throws
+    bool allow_blocking_wait = (m_active_ops.empty() && !got_wakeup_pipe_signal);
+    if (!allow_blocking_wait) {
+        if (m_io_uring.has_unsubmitted() || m_io_uring.has_overflow()) {
+            check_error(m_io_uring.enter(false, nullptr)); // Throws
+            reap();                                        // Throws
+        }
+        return got_wakeup_pipe_signal;
+    }
+
+    __kernel_timespec max_wait = __kernel_timespec(); // Clear
+    const __kernel_timespec* max_wait_ptr = nullptr;
+    if (timeout.time_since_epoch().count() > 0) {
+        if (now < timeout) {
+            auto diff = timeout - now;
+            auto diff_secs = std::chrono::duration_cast<std::chrono::seconds>(diff);
+            max_wait.tv_sec = diff_secs.count();
+            max_wait.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(diff - diff_secs).count();
+        }
+        max_wait_ptr = &max_wait;
+    }
+#ifdef REALM_UTIL_NETWORK_EVENT_LOOP_METRICS
+    clock::time_point sleep_start_time = clock::now();
+#endif
+    check_error(m_io_uring.enter(true, max_wait_ptr)); // Throws
+#ifdef REALM_UTIL_NETWORK_EVENT_LOOP_METRICS
+    m_sleep_time += clock::now() - sleep_start_time;
+#endif
+    reap(); // Throws
+    return got_wakeup_pipe_signal;
+}
+
+#endif // REALM_NETWORK_USE_IO_URING
+
+
 #elif REALM_HAVE_KQUEUE // !REALM_NETWORK_USE_EPOLL && REALM_HAVE_KQUEUE
 
 
@@ -1843,7 +2326,7 @@ void Service::Descriptor::accept(Descriptor& desc, StreamProtocol protocol, Endp
             if (err == EWOULDBLOCK)
                 err = EAGAIN;
             set_read_ready(err != EAGAIN);
-            ec = make_basic_system_error_code(err); // Failure
+            ec = (err == EAGAIN ? would_block_error() : make_basic_system_error_code(err)); // Failure
             return;
         }
 #endif
@@ -1909,7 +2392,7 @@ void Service::Descriptor::accept(Descriptor& desc, StreamProtocol protocol, Endp
 std::size_t Service::Descriptor::read_some(char* buffer, std::size_t size, std::error_code& ec) noexcept
 {
     if (REALM_UNLIKELY(assume_read_would_block())) {
-        ec = error::resource_unavailable_try_again; // Failure
+        ec = would_block_error(); // Failure
         return 0;
     }
     for (;;) {
@@ -1935,7 +2418,7 @@ std::size_t Service::Descriptor::read_some(char* buffer, std::size_t size, std::
             if (err == EWOULDBLOCK)
                 err = EAGAIN;
             set_read_ready(err != EAGAIN);
-            ec = make_basic_system_error_code(err); // Failure
+            ec = (err == EAGAIN ? would_block_error() : make_basic_system_error_code(err)); // Failure
             return 0;
         }
 #endif
@@ -1990,7 +2473,7 @@ std::size_t Service::Descriptor::read_some(char* buffer, std::size_t size, std::
 std::size_t Service::Descriptor::write_some(const char* data, std::size_t size, std::error_code& ec) noexcept
 {
     if (REALM_UNLIKELY(assume_write_would_block())) {
-        ec = error::resource_unavailable_try_again; // Failure
+        ec = would_block_error(); // Failure
         return 0;
     }
     for (;;) {
@@ -2028,7 +2511,7 @@ std::size_t Service::Descriptor::write_some(const char* data, std::size_t size,
             if (err == EWOULDBLOCK)
                 err = EAGAIN;
             set_write_ready(err != EAGAIN);
-            ec = make_basic_system_error_code(err); // Failure
+            ec = (err == EAGAIN ? would_block_error() : make_basic_system_error_code(err)); // Failure
             return 0;
         }
 #endif
@@ -30,8 +30,16 @@
 #include <realm/util/basic_system_errors.hpp>
 #include <realm/util/backtrace.hpp>
 
+// Linux io_uring. This is an extension of the epoll based implementation,
+// which remains in use when io_uring is unavailable at runtime.
+#if REALM_USE_IO_URING && defined(__linux__) && !REALM_ANDROID
+#define REALM_NETWORK_USE_IO_URING 1
+#else
+#define REALM_NETWORK_USE_IO_URING 0
+#endif
+
 // Linux epoll
-#if defined(REALM_USE_EPOLL) && !REALM_ANDROID
+#if (defined(REALM_USE_EPOLL) || REALM_NETWORK_USE_IO_URING) && !REALM_ANDROID
 #define REALM_NETWORK_USE_EPOLL 1
 #else
 #define REALM_NETWORK_USE_EPOLL 0
@@ -503,6 +511,9 @@ private:
     bool m_imminent_end_of_input; // Kernel has seen the end of input
     bool m_is_registered;
     OperQueue<IoOper> m_suspended_read_ops, m_suspended_write_ops;
+#if REALM_NETWORK_USE_IO_URING
+    int m_poll_error; // Nonzero if the io_uring poll request failed
+#endif
 
     void deregister_for_async() noexcept;
 #endif
@@ -510,6 +521,11 @@ private:
     bool assume_read_would_block() const noexcept;
     bool assume_write_would_block() const noexcept;
 
+    // The error to fail with when reading or writing would block. This is
+    // normally `error::resource_unavailable_try_again`, but if readiness can no
+    // longer be waited for, it is the error that prevents it.
+    std::error_code would_block_error() const noexcept;
+
     void set_read_ready(bool) noexcept;
     void set_write_ready(bool) noexcept;
 
@@ -1811,6 +1827,9 @@ inline void Service::Descriptor::assign(native_handle_type fd, bool in_blocking_
     m_write_ready = false;
     m_imminent_end_of_input = false;
     m_is_registered = false;
+#if REALM_NETWORK_USE_IO_URING
+    m_poll_error = 0;
+#endif
 #endif
 }
 
@@ -1898,6 +1917,15 @@ inline bool Service::Descriptor::assume_write_would_block() const noexcept
 #endif
 }
 
+inline std::error_code Service::Descriptor::would_block_error() const noexcept
+{
+#if REALM_NETWORK_USE_IO_URING
+    if (REALM_UNLIKELY(m_poll_error != 0))
+        return make_basic_system_error_code(m_poll_error);
+#endif
+    return error::resource_unavailable_try_again;
+}
+
 inline void Service::Descriptor::set_read_ready(bool value) noexcept
 {
 #if REALM_NETWORK_USE_EPOLL || REALM_HAVE_KQUEUE
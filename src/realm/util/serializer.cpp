@@ -20,6 +20,7 @@
 
 #include <realm/binary_data.hpp>
 #include <realm/keys.hpp>
+#include <realm/mixed.hpp>
 #include <realm/null.hpp>
 #include <realm/query_expression.hpp>
 #include <realm/string_data.hpp>
@@ -30,6 +31,8 @@
 
 #include <cctype>
 #include <cmath>
+#include <iomanip>
+#include <limits>
 
 namespace realm {
 namespace util {
@@ -82,6 +85,35 @@ std::string print_value<>(double val)
     return print_with_nan_check(val);
 }
 
+template <typename T>
+std::string print_exact(T val, const SerialisationState& state)
+{
+    if (!state.exact_floating_point || std::isnan(val))
+        return print_with_nan_check(val);
+    std::stringstream ss;
+    ss << std::setprecision(std::numeric_limits<T>::max_digits10) << val;
+    return ss.str();
+}
+
+std::string print_value(float val, const SerialisationState& state)
+{
+    return print_exact(val, state);
+}
+
+std::string print_value(double val, const SerialisationState& state)
+{
+    return print_exact(val, state);
+}
+
+std::string print_value(Mixed val, const SerialisationState& state)
+{
+    if (!val.is_null() && val.get_type() == type_Float)
+        return print_exact(val.get<float>(), state) + "f";
+    if (!val.is_null() && val.get_type() == type_Double)
+        return print_exact(val.get<double>(), state);
+    return print_value(val);
+}
+
 template <>
 std::string print_value<>(realm::null)
 {
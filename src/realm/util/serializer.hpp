@@ -36,6 +36,7 @@ struct ObjKey;
 class StringData;
 class Timestamp;
 class LinkMap;
+class Mixed;
 class UUID;
 enum class ExpressionComparisonType : unsigned char;
 
@@ -96,8 +97,22 @@ struct SerialisationState {
     std::string get_backlink_column_name(ConstTableRef from, ColKey col_key);
     std::string get_variable_name(ConstTableRef table);
     std::vector<std::string> subquery_prefix_list;
+    // Print floating point values with as many digits as are needed to read
+    // them back exactly, for descriptions which are compared rather than shown
+    bool exact_floating_point = false;
 };
 
+// As print_value(), but floating point values, including those in a Mixed, are
+// printed exactly if requested by `state`
+template <typename T>
+std::string print_value(T value, const SerialisationState&)
+{
+    return print_value(value);
+}
+std::string print_value(float value, const SerialisationState& state);
+std::string print_value(double value, const SerialisationState& state);
+std::string print_value(Mixed value, const SerialisationState& state);
+
 } // namespace serializer
 } // namespace util
 } // namespace realm
@@ -173,28 +173,10 @@ void mask_payload(char* masking_key, const char* payload, size_t payload_len, ch
     }
 }
 
-// make_frame() creates a WebSocket frame according to the WebSocket standard.
-// \param fin indicates whether the frame is the final fragment in a message.
-// Sync clients and servers will only send unfragmented messages, but they must be
-// prepared to receive fragmented messages.
-// \param opcode must be one of six values:
-// 0  = continuation frame
-// 1  = text frame
-// 2  = binary frame
-// 8  = ping frame
-// 9  = pong frame
-// 10 = close frame.
-// Sync clients and server will only send the last four, but must be prepared to
-// receive all.
-// \param mask indicates whether the payload of the frame should be masked. Frames
-// are masked if and only if they originate from the client.
-// The payload is located in the buffer \param payload, and has size \param payload_size.
-// \param output is the output buffer. It must be large enough to contain the frame.
-// The frame size can at most be payload_size + 14.
-// \param random is used to create a random masking key.
-// The return value is the size of the frame.
-size_t make_frame(bool fin, int opcode, bool mask, const char* payload, size_t payload_size, char* output,
-                  std::mt19937_64& random)
+// make_frame_header() creates the header of a WebSocket frame, excluding the
+// masking key, which must follow immediately if \param mask is true. The
+// header size is at most 10. The return value is the size of the header.
+size_t make_frame_header(bool fin, int opcode, bool mask, size_t payload_size, char* output)
 {
     int index = 0; // used to keep track of position within the header.
     using uchar = unsigned char;
@@ -226,6 +208,33 @@ size_t make_frame(bool fin, int opcode, bool mask, const char* payload, size_t p
         }
         index = 10;
     }
+    return size_t(index);
+}
+
+// make_frame() creates a WebSocket frame according to the WebSocket standard.
+// \param fin indicates whether the frame is the final fragment in a message.
+// Sync clients and servers must be prepared to receive fragmented messages. The
+// sync server sends large DOWNLOAD messages as two fragments.
+// \param opcode must be one of six values:
+// 0  = continuation frame
+// 1  = text frame
+// 2  = binary frame
+// 8  = ping frame
+// 9  = pong frame
+// 10 = close frame.
+// Sync clients and server will send the continuation frame and the last four,
+// but must be prepared to receive all.
+// \param mask indicates whether the payload of the frame should be masked. Frames
+// are masked if and only if they originate from the client.
+// The payload is located in the buffer \param payload, and has size \param payload_size.
+// \param output is the output buffer. It must be large enough to contain the frame.
+// The frame size can at most be payload_size + 14.
+// \param random is used to create a random masking key.
+// The return value is the size of the frame.
+size_t make_frame(bool fin, int opcode, bool mask, const char* payload, size_t payload_size, char* output,
+                  std::mt19937_64& random)
+{
+    int index = int(make_frame_header(fin, opcode, mask, payload_size, output));
     if (mask) {
         char masking_key[4];
         std::uniform_int_distribution<> dis(0, 255);
@@ -668,6 +677,31 @@ public:
 
         bool mask = m_is_client;
 
+        // The payload of a large unmasked frame is written directly from the
+        // caller's buffer, following a separate write of the header, rather
+        // than being copied into the write buffer along with the header.
+        if (!mask && size > s_write_buffer_stable_size) {
+            // 10 is the maximum header length of an unmasked Websocket frame.
+            if (m_write_buffer.size() < 10)
+                m_write_buffer.resize(10);
+            size_t header_size = make_frame_header(fin, opcode, mask, size, m_write_buffer.data());
+            auto handler = [=](std::error_code ec, size_t) {
+                // If the operation is aborted, the socket object may have been destroyed.
+                if (ec != util::error::operation_aborted) {
+                    if (ec) {
+                        stop();
+                        m_config.websocket_write_error_handler(ec);
+                        return;
+                    }
+                    if (m_stopped)
+                        return;
+                    async_write_payload(data, size); // Throws
+                }
+            };
+            m_config.async_write(m_write_buffer.data(), header_size, handler);
+            return;
+        }
+
         // 14 is the maximum header length of a Websocket frame.
         size_t required_size = size + 14;
         if (m_write_buffer.size() < required_size)
@@ -691,6 +725,61 @@ public:
         m_config.async_write(m_write_buffer.data(), message_size, handler);
     }
 
+    void async_write_binary_batch(const char* data, const size_t* sizes, size_t num_messages,
+                                  std::function<void()> write_completion_handler)
+    {
+        REALM_ASSERT(!m_stopped);
+
+        m_write_completion_handler = std::move(write_completion_handler);
+
+        bool mask = m_is_client;
+
+        // 14 is the maximum header length of a Websocket frame.
+        size_t required_size = 0;
+        for (size_t i = 0; i < num_messages; ++i)
+            required_size += sizes[i] + 14;
+        if (m_write_buffer.size() < required_size)
+            m_write_buffer.resize(required_size);
+
+        size_t batch_size = 0;
+        for (size_t i = 0; i < num_messages; ++i) {
+            batch_size += make_frame(true, int(websocket::Opcode::binary), mask, data, sizes[i],
+                                     m_write_buffer.data() + batch_size, m_config.websocket_get_random());
+            data += sizes[i];
+        }
+
+        auto handler = [=](std::error_code ec, size_t) {
+            // If the operation is aborted, the socket object may have been destroyed.
+            if (ec != util::error::operation_aborted) {
+                if (ec) {
+                    stop();
+                    m_config.websocket_write_error_handler(ec);
+                    return;
+                }
+                handle_write_message(); // Throws
+            }
+        };
+
+        m_config.async_write(m_write_buffer.data(), batch_size, handler);
+    }
+
+    void async_write_payload(const char* data, size_t size)
+    {
+        auto handler = [=](std::error_code ec, size_t) {
+            // If the operation is aborted, the socket object may have been destroyed.
+            if (ec != util::error::operation_aborted) {
+                if (ec) {
+                    stop();
+                    m_config.websocket_write_error_handler(ec);
+                    return;
+                }
+                handle_write_message(); // Throws
+            }
+        };
+
+        m_config.async_write(data, size, handler);
+    }
+
     void handle_write_message()
     {
         if (m_write_buffer.size() > s_write_buffer_stable_size) {
@@ -1124,6 +1213,12 @@ void websocket::Socket::async_write_frame(bool fin, Opcode opcode, const char* d
     m_impl->async_write_frame(fin, int(opcode), data, size, handler);
 }
 
+void websocket::Socket::async_write_binary_batch(const char* data, const size_t* sizes, size_t num_messages,
+                                                 std::function<void()> handler)
+{
+    m_impl->async_write_binary_batch(data, sizes, num_messages, std::move(handler));
+}
+
 void websocket::Socket::async_write_text(const char* data, size_t size, std::function<void()> handler)
 {
     async_write_frame(true, Opcode::text, data, size, handler);
@@ -131,6 +131,8 @@ public:
     /// meaning that the user must wait for the handler to be called before sending the next frame.
     /// The handler is type std::function<void()> and is called when the frame has been successfully
     /// sent. In case of errors, the Config::websocket_write_error_handler() is called.
+    /// The payload buffer must remain valid until the handler is called, since the payload of a
+    /// large unmasked frame is written directly from it.
 
     /// async_write_frame() sends a single frame with this content:
     /// \param fin The fin bit set to 0 or 1
@@ -164,6 +166,17 @@ public:
     void async_write_pong(const char* data, size_t size, std::function<void()> handler);
     //@}
 
+    /// async_write_binary_batch() sends a sequence of whole, unfragmented
+    /// binary messages using a single write operation on the underlying
+    /// stream. The payloads are taken consecutively from `data`, and the size
+    /// of the i'th payload is `sizes[i]`. The receiver sees `num_messages`
+    /// separate messages, exactly as if async_write_binary() had been called
+    /// for each of them, but the number of writes, and thereby system calls
+    /// and TLS records, is reduced to one. The handler is called once, when all
+    /// the messages have been sent.
+    void async_write_binary_batch(const char* data, const size_t* sizes, size_t num_messages,
+                                  std::function<void()> handler);
+
     /// stop() stops the socket. The socket will stop processing incoming data,
     /// sending data, and calling callbacks.  It is an error to attempt to send
     /// a message after stop() has been called. stop() will typically be called
@@ -23,6 +23,7 @@
 
 #include <realm.hpp>
 #include <realm/query_expression.hpp> // only needed to compile on v2.6.0
+#include <realm/object-store/impl/collection_change_builder.hpp>
 #include <realm/string_data.hpp>
 #include <realm/util/file.hpp>
 
@@ -1768,6 +1769,78 @@ struct IterateTableByIndexStringPrimaryKey : IterateTableByIndexNoPrimaryKey {
     }
 };
 
+/// Calculating the changes between two versions of a sorted Results with
+/// CollectionChangeBuilder::calculate(), which the notifiers do on every run.
+/// This does not use the Realm at all.
+struct BenchmarkCalculateChangesSorted : Benchmark {
+    const char* name() const
+    {
+        return "CalculateChangesSorted";
+    }
+    void before_all(DBRef)
+    {
+        m_prev.resize(BASE_SIZE);
+        for (size_t i = 0; i < BASE_SIZE; ++i)
+            m_prev[i] = int64_t(i);
+        m_next = m_prev;
+        change(m_next);
+    }
+    void after_all(DBRef) {}
+    void before_each(DBRef) {}
+    void after_each(DBRef) {}
+    // Removes a few rows and appends a few new ones
+    virtual void change(std::vector<int64_t>& rows)
+    {
+        for (size_t i = 0; i < 10; ++i) {
+            rows.erase(rows.begin() + i * (rows.size() / 10));
+            rows.push_back(int64_t(BASE_SIZE + i));
+        }
+    }
+    void operator()(DBRef)
+    {
+        auto changes = _impl::CollectionChangeBuilder::calculate(
+            m_prev, m_next,
+            [](int64_t) {
+                return false;
+            },
+            false);
+        static_cast<void>(changes);
+    }
+    std::vector<int64_t> m_prev;
+    std::vector<int64_t> m_next;
+};
+
+struct BenchmarkCalculateChangesSortedFewMoves : BenchmarkCalculateChangesSorted {
+    const char* name() const
+    {
+        return "CalculateChangesSortedFewMoves";
+    }
+    // Moves a few rows to random positions
+    void change(std::vector<int64_t>& rows)
+    {
+        Random r;
+        for (size_t i = 0; i < 10; ++i) {
+            size_t from = r.draw_int_mod(rows.size());
+            int64_t value = rows[from];
+            rows.erase(rows.begin() + from);
+            rows.insert(rows.begin() + r.draw_int_mod(rows.size()), value);
+        }
+    }
+};
+
+struct BenchmarkCalculateChangesSortedShuffle : BenchmarkCalculateChangesSorted {
+    const char* name() const
+    {
+        return "CalculateChangesSortedShuffle";
+    }
+    // Reorders every row
+    void change(std::vector<int64_t>& rows)
+    {
+        Random r;
+        r.shuffle(rows.begin(), rows.end());
+    }
+};
+
 const char* to_lead_cstr(RealmDurability level)
 {
     switch (level) {
@@ -1920,6 +1993,10 @@ int benchmark_common_tasks_main()
     BENCH(BenchmarkSort);
     BENCH(BenchmarkSortInt);
 
+    BENCH(BenchmarkCalculateChangesSorted);
+    BENCH(BenchmarkCalculateChangesSortedFewMoves);
+    BENCH(BenchmarkCalculateChangesSortedShuffle);
+
     BENCH(BenchmarkUnorderedTableViewClear);
     BENCH(BenchmarkUnorderedTableViewClearIndexed);
 
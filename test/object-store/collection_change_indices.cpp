@@ -23,6 +23,8 @@
 #include "util/index_helpers.hpp"
 
 #include <limits>
+#include <numeric>
+#include <random>
 
 using namespace realm;
 
@@ -673,6 +675,55 @@ TEST_CASE("collection_change: calculate() sorted") {
             }
         }
     }
+
+    SECTION("produces minimal diffs for large reorderings") {
+        std::mt19937 rng(12345);
+        for (size_t rows : {10, 100, 300}) {
+            for (size_t moved : {size_t(1), rows / 10, rows}) {
+                CAPTURE(rows);
+                CAPTURE(moved);
+                std::vector<int64_t> prev(rows);
+                std::iota(prev.begin(), prev.end(), 0);
+                // Shuffle the `moved` rows at random positions among themselves
+                std::vector<int64_t> next = prev;
+                std::vector<size_t> positions(rows);
+                std::iota(positions.begin(), positions.end(), 0);
+                std::shuffle(positions.begin(), positions.end(), rng);
+                positions.resize(moved);
+                std::vector<int64_t> values;
+                for (auto pos : positions)
+                    values.push_back(next[pos]);
+                std::shuffle(values.begin(), values.end(), rng);
+                for (size_t i = 0; i < moved; ++i)
+                    next[positions[i]] = values[i];
+                // And remove and append some
+                next.erase(next.begin() + rows / 2);
+                next.push_back(int64_t(rows));
+
+                c = _impl::CollectionChangeBuilder::calculate(prev, next, none_modified, false);
+
+                // Applying the changes to prev produces next
+                auto applied = prev;
+                std::vector<size_t> deletions(c.deletions.as_indexes().begin(), c.deletions.as_indexes().end());
+                for (auto it = deletions.rbegin(); it != deletions.rend(); ++it)
+                    applied.erase(applied.begin() + *it);
+                for (auto i : c.insertions.as_indexes())
+                    applied.insert(applied.begin() + i, next[i]);
+                REQUIRE(applied == next);
+
+                // And only the rows outside the longest common subsequence are moved
+                std::vector<std::vector<size_t>> lcs(prev.size() + 1, std::vector<size_t>(next.size() + 1));
+                for (size_t i = prev.size(); i-- > 0;) {
+                    for (size_t j = next.size(); j-- > 0;) {
+                        lcs[i][j] = prev[i] == next[j] ? lcs[i + 1][j + 1] + 1
+                                                       : std::max(lcs[i + 1][j], lcs[i][j + 1]);
+                    }
+                }
+                REQUIRE(c.deletions.count() == prev.size() - lcs[0][0]);
+                REQUIRE(c.insertions.count() == next.size() - lcs[0][0]);
+            }
+        }
+    }
 }
 
 TEST_CASE("collection_change: merge()") {
@@ -24,6 +24,7 @@
 
 #include <realm/object-store/binding_context.hpp>
 #include <realm/object-store/impl/realm_coordinator.hpp>
+#include <realm/object-store/impl/schema_cache_file.hpp>
 #include <realm/object-store/object_schema.hpp>
 #include <realm/object-store/object_store.hpp>
 #include <realm/object-store/property.hpp>
@@ -32,6 +33,10 @@
 #include <realm/object-store/thread_safe_reference.hpp>
 #include <realm/object-store/util/scheduler.hpp>
 
+#if REALM_HAVE_EPOLL
+#include <realm/object-store/util/epoll/event_loop.hpp>
+#endif
+
 #include <realm/db.hpp>
 
 #if REALM_ENABLE_SYNC
@@ -41,6 +46,8 @@
 #include <realm/util/fifo_helper.hpp>
 #include <realm/util/scope_exit.hpp>
 
+#include <future>
+
 namespace realm {
 class TestHelper {
 public:
@@ -1342,6 +1349,375 @@ TEST_CASE("SharedRealm: coordinator schema cache") {
     }
 }
 
+TEST_CASE("SharedRealm: persistent schema cache") {
+    TestFile config;
+    config.persist_schema_cache = true;
+    config.schema_version = 1;
+    config.schema = Schema{
+        {"object",
+         {
+             {"_id", PropertyType::Int, Property::IsPrimary{true}},
+             {"value", PropertyType::Int, Property::IsPrimary{false}, Property::IsIndexed{true}},
+             {"link", PropertyType::Object | PropertyType::Nullable, "target"},
+         }},
+        {"target", {{"value", PropertyType::Int}}},
+    };
+    auto cache_path = _impl::schema_cache_file::path_for(config.path);
+
+    // Creating the file does not write the cache as there's no schema to
+    // read from the file yet
+    auto r = Realm::get_shared_realm(config);
+    uint64_t schema_hash = r->read_group().compute_schema_hash();
+    r = nullptr;
+    REQUIRE_FALSE(util::File::exists(cache_path));
+
+    auto dynamic_config = config;
+    dynamic_config.schema = util::none;
+    dynamic_config.schema_version = -1;
+
+    auto require_schema_from_file = [&](SharedRealm const& realm) {
+        auto schema = ObjectStore::schema_from_group(realm->read_group());
+        REQUIRE(realm->schema() == schema);
+        for (auto& object_schema : schema) {
+            auto it = realm->schema().find(object_schema.name);
+            REQUIRE(it->table_key == object_schema.table_key);
+            for (auto& prop : object_schema.persisted_properties)
+                REQUIRE(it->property_for_name(prop.name)->column_key == prop.column_key);
+        }
+    };
+
+    SECTION("is written when an initialized file is opened") {
+        r = Realm::get_shared_realm(config);
+        REQUIRE(util::File::exists(cache_path));
+        auto cached = _impl::schema_cache_file::read(cache_path, 1, schema_hash);
+        REQUIRE(bool(cached));
+        REQUIRE(*cached == r->schema());
+        REQUIRE(cached->find("object")->primary_key_property()->name == "_id");
+        require_schema_from_file(r);
+    }
+
+    SECTION("is used when the file is opened again") {
+        Realm::get_shared_realm(config);
+        auto cached = _impl::schema_cache_file::read(cache_path, 1, schema_hash);
+        REQUIRE(bool(cached));
+        // Add a type which does not exist in the file to verify that the
+        // schema actually comes from the cache
+        std::vector<ObjectSchema> object_schemas(cached->begin(), cached->end());
+        object_schemas.push_back({"cached only", {{"value", PropertyType::Int}}});
+        _impl::schema_cache_file::write(cache_path, Schema(std::move(object_schemas)), 1, schema_hash);
+
+        r = Realm::get_shared_realm(dynamic_config);
+        REQUIRE(r->schema().find("cached only") != r->schema().end());
+    }
+
+    SECTION("is not used for a different schema version or schema hash") {
+        Realm::get_shared_realm(config);
+        REQUIRE(bool(_impl::schema_cache_file::read(cache_path, 1, schema_hash)));
+        REQUIRE_FALSE(bool(_impl::schema_cache_file::read(cache_path, 2, schema_hash)));
+        REQUIRE_FALSE(bool(_impl::schema_cache_file::read(cache_path, 1, schema_hash + 1)));
+    }
+
+    SECTION("is replaced after the schema is changed") {
+        Realm::get_shared_realm(config);
+        auto config2 = config;
+        config2.schema_version = 2;
+        std::vector<ObjectSchema> object_schemas(config.schema->begin(), config.schema->end());
+        object_schemas.push_back({"object 2", {{"value", PropertyType::Int}}});
+        config2.schema = Schema(std::move(object_schemas));
+        Realm::get_shared_realm(config2);
+
+        r = Realm::get_shared_realm(dynamic_config);
+        REQUIRE(r->schema_version() == 2);
+        REQUIRE(r->schema().find("object 2") != r->schema().end());
+        require_schema_from_file(r);
+        REQUIRE(bool(_impl::schema_cache_file::read(cache_path, 2, r->read_group().compute_schema_hash())));
+    }
+
+    SECTION("is rebuilt if the cache file is corrupted") {
+        Realm::get_shared_realm(config);
+        {
+            util::File file(cache_path, util::File::mode_Update);
+            file.resize(file.get_size() - 3);
+        }
+        REQUIRE_FALSE(bool(_impl::schema_cache_file::read(cache_path, 1, schema_hash)));
+
+        r = Realm::get_shared_realm(dynamic_config);
+        require_schema_from_file(r);
+        REQUIRE(bool(_impl::schema_cache_file::read(cache_path, 1, schema_hash)));
+    }
+
+    SECTION("is not written when disabled") {
+        config.persist_schema_cache = false;
+        Realm::get_shared_realm(config);
+        REQUIRE_FALSE(util::File::exists(cache_path));
+    }
+}
+
+#if REALM_HAVE_EPOLL
+TEST_CASE("SharedRealm: async writes") {
+    auto loop = std::make_shared<util::EpollEventLoop>();
+    TestFile config;
+    config.schema_version = 1;
+    config.schema = Schema{
+        {"object", {{"value", PropertyType::Int}}},
+    };
+    config.scheduler = util::Scheduler::make_epoll(loop);
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+    auto col = table->get_column_key("value");
+
+    // The number of objects in the file as seen by opening it directly, which
+    // only sees durable commits
+    auto durable_size = [&] {
+        Group g(config.path);
+        return g.get_table("class_object")->size();
+    };
+
+    SECTION("write functions are called on the scheduler inside a write transaction") {
+        bool called = false;
+        realm->async_begin_transaction([&] {
+            REQUIRE(realm->is_in_transaction());
+            REQUIRE(realm->is_in_async_transaction());
+            table->create_object().set(col, 1);
+            realm->async_commit_transaction();
+            REQUIRE(realm->is_in_transaction());
+            called = true;
+        });
+        REQUIRE_FALSE(called);
+        REQUIRE_FALSE(realm->is_in_transaction());
+        REQUIRE(loop->run_until([&] {
+            return called;
+        }));
+        REQUIRE_FALSE(realm->is_in_transaction());
+        REQUIRE_FALSE(realm->is_in_async_transaction());
+        REQUIRE(table->size() == 1);
+    }
+
+    SECTION("queued writes are committed as a batch which is durable before completions are called") {
+        std::vector<size_t> sizes_on_completion;
+        for (int i = 0; i < 3; ++i) {
+            realm->async_begin_transaction([&, i] {
+                table->create_object().set(col, i);
+                realm->async_commit_transaction([&](std::exception_ptr err) {
+                    REQUIRE_FALSE(err);
+                    REQUIRE_FALSE(realm->is_in_transaction());
+                    sizes_on_completion.push_back(durable_size());
+                });
+            });
+        }
+        auto version = realm->read_transaction_version().version;
+        REQUIRE(loop->run_until([&] {
+            return sizes_on_completion.size() == 3;
+        }));
+        REQUIRE(sizes_on_completion == std::vector<size_t>{3, 3, 3});
+        // Each write was still committed separately
+        REQUIRE(realm->read_transaction_version().version == version + 3);
+    }
+
+    SECTION("writes queued by a write are run by the next batch") {
+        std::vector<int> order;
+        realm->async_begin_transaction([&] {
+            order.push_back(1);
+            realm->async_begin_transaction([&] {
+                order.push_back(3);
+                realm->async_commit_transaction();
+            });
+            realm->async_commit_transaction();
+        });
+        realm->async_begin_transaction([&] {
+            order.push_back(2);
+            realm->async_commit_transaction();
+        });
+        REQUIRE(loop->run_until([&] {
+            return order.size() == 3;
+        }));
+        REQUIRE(order == std::vector<int>{1, 2, 3});
+    }
+
+    SECTION("write functions can end the transaction themselves") {
+        int calls = 0;
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 1);
+            realm->commit_transaction();
+            ++calls;
+        });
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 2);
+            realm->cancel_transaction();
+            ++calls;
+        });
+        realm->async_begin_transaction([&] {
+            REQUIRE(realm->is_in_transaction());
+            table->create_object().set(col, 3);
+            realm->async_commit_transaction();
+            ++calls;
+        });
+        REQUIRE(loop->run_until([&] {
+            return calls == 3 && !realm->is_in_transaction();
+        }));
+        REQUIRE(table->size() == 2);
+        REQUIRE(durable_size() == 2);
+    }
+
+    SECTION("a write which is not committed is left open and the queue resumes once it ends") {
+        int calls = 0;
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 1);
+            ++calls;
+        });
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 2);
+            realm->async_commit_transaction();
+            ++calls;
+        });
+        REQUIRE(loop->run_until([&] {
+            return calls == 1;
+        }));
+        loop->poll();
+        REQUIRE(calls == 1);
+        REQUIRE(realm->is_in_transaction());
+        REQUIRE_FALSE(realm->is_in_async_transaction());
+
+        realm->commit_transaction();
+        REQUIRE(loop->run_until([&] {
+            return calls == 2;
+        }));
+        REQUIRE(table->size() == 2);
+    }
+
+    SECTION("a write which throws is rolled back without losing the batch's previous commits") {
+        bool completed = false;
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 1);
+            realm->async_commit_transaction([&](std::exception_ptr err) {
+                REQUIRE_FALSE(err);
+                completed = true;
+            });
+        });
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 2);
+            throw std::runtime_error("error");
+        });
+        REQUIRE_THROWS_AS(loop->run(), std::runtime_error);
+        REQUIRE_FALSE(realm->is_in_transaction());
+        REQUIRE(loop->run_until([&] {
+            return completed;
+        }));
+        REQUIRE(table->size() == 1);
+        REQUIRE(durable_size() == 1);
+    }
+
+    SECTION("a batch which ends without a final commit still sends notifications for its commits") {
+        struct Context : BindingContext {
+            size_t* change_count;
+            Context(size_t* out)
+                : change_count(out)
+            {
+            }
+
+            void did_change(std::vector<ObserverState> const&, std::vector<void*> const&, bool) override
+            {
+                ++*change_count;
+            }
+        };
+        size_t change_count = 0;
+        realm->m_binding_context.reset(new Context{&change_count});
+        realm->m_binding_context->realm = realm;
+
+        realm->async_begin_transaction([&] {
+            table->create_object().set(col, 1);
+            realm->async_commit_transaction();
+        });
+        realm->async_begin_transaction([&] {
+            REQUIRE(change_count == 0);
+            table->create_object().set(col, 2);
+            realm->async_commit_transaction();
+        });
+        realm->async_begin_transaction([&] {
+            throw std::runtime_error("error");
+        });
+        REQUIRE_THROWS_AS(loop->run(), std::runtime_error);
+        REQUIRE_FALSE(realm->is_in_transaction());
+        REQUIRE(change_count == 1);
+        REQUIRE(durable_size() == 2);
+    }
+
+    SECTION("queued writes can be cancelled before they are run") {
+        std::vector<int> calls;
+        auto handle = realm->async_begin_transaction([&] {
+            calls.push_back(1);
+            realm->async_commit_transaction();
+        });
+        auto handle2 = realm->async_begin_transaction([&] {
+            calls.push_back(2);
+            realm->async_commit_transaction();
+        });
+        REQUIRE(realm->async_cancel_transaction(handle));
+        REQUIRE_FALSE(realm->async_cancel_transaction(handle));
+        REQUIRE(loop->run_until([&] {
+            return calls.size() == 1;
+        }));
+        REQUIRE(calls == std::vector<int>{2});
+        REQUIRE_FALSE(realm->async_cancel_transaction(handle2));
+    }
+
+    SECTION("async_commit_transaction() outside of an async write calls the completion asynchronously") {
+        bool completed = false;
+        realm->begin_transaction();
+        table->create_object().set(col, 1);
+        realm->async_commit_transaction([&](std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            completed = true;
+        });
+        REQUIRE_FALSE(realm->is_in_transaction());
+        REQUIRE_FALSE(completed);
+        REQUIRE(loop->run_until([&] {
+            return completed;
+        }));
+        REQUIRE(durable_size() == 1);
+    }
+
+    SECTION("waiting for the write lock does not block the scheduler") {
+        std::promise<void> locked, release;
+        auto release_future = release.get_future().share();
+        JoiningThread thread([&] {
+            auto tr = TestHelper::get_db(realm)->start_write();
+            locked.set_value();
+            release_future.wait();
+        });
+        locked.get_future().wait();
+
+        bool called = false;
+        realm->async_begin_transaction([&] {
+            realm->async_commit_transaction();
+            called = true;
+        });
+        for (int i = 0; i < 5; ++i) {
+            loop->poll();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE_FALSE(called);
+        REQUIRE_FALSE(realm->is_in_transaction());
+
+        release.set_value();
+        REQUIRE(loop->run_until([&] {
+            return called;
+        }));
+    }
+
+    SECTION("closing the Realm discards pending writes") {
+        bool called = false;
+        realm->async_begin_transaction([&] {
+            called = true;
+        });
+        realm->close();
+        loop->poll();
+        REQUIRE_FALSE(called);
+    }
+}
+#endif
+
 TEST_CASE("SharedRealm: dynamic schema mode doesn't invalidate object schema pointers when schema hasn't changed") {
     TestFile config;
 
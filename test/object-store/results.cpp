@@ -24,8 +24,10 @@
 
 #include <realm/object-store/impl/object_accessor_impl.hpp>
 #include <realm/object-store/impl/realm_coordinator.hpp>
+#include <realm/object-store/impl/results_notifier.hpp>
 #include <realm/object-store/binding_context.hpp>
 #include <realm/object-store/keypath_helpers.hpp>
+#include <realm/object-store/list.hpp>
 #include <realm/object-store/object_schema.hpp>
 #include <realm/object-store/property.hpp>
 #include <realm/object-store/results.hpp>
@@ -1028,6 +1030,678 @@ TEST_CASE("notifications: skip") {
     }
 }
 
+TEST_CASE("notifications: parallel notifiers") {
+    _impl::RealmCoordinator::assert_no_open_realms();
+
+    InMemoryTestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+    config.max_notifier_threads = 4;
+
+    auto r = Realm::get_shared_realm(config);
+    r->update_schema({
+        {"object", {{"value", PropertyType::Int}}},
+    });
+
+    auto table = r->read_group().get_table("class_object");
+    auto col = table->get_column_key("value");
+
+    r->begin_transaction();
+    for (int i = 0; i < 10; ++i)
+        table->create_object().set(col, i);
+    r->commit_transaction();
+
+    // More notifiers than threads, so that each thread runs several of them
+    const int count = 10;
+    std::vector<Results> results;
+    std::vector<NotificationToken> tokens;
+    results.reserve(count);
+    tokens.reserve(count);
+    std::vector<int> calls(count);
+    std::vector<CollectionChangeSet> changes(count);
+    for (int i = 0; i < count; ++i) {
+        results.push_back(Results(r, table->where().less(col, i + 1)));
+        tokens.push_back(results[i].add_notification_callback([&, i](CollectionChangeSet c, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            ++calls[i];
+            changes[i] = std::move(c);
+        }));
+    }
+
+    advance_and_notify(*r);
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(calls[i] == 1);
+        REQUIRE(results[i].size() == size_t(i + 1));
+    }
+
+    SECTION("each notifier reports the changes to its own query") {
+        r->begin_transaction();
+        table->get_object(5).set(col, 0);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        for (int i = 0; i < count; ++i) {
+            REQUIRE(calls[i] == 2);
+            REQUIRE(changes[i].deletions.empty());
+            if (i < 5) {
+                REQUIRE_INDICES(changes[i].insertions, i + 1);
+                REQUIRE(changes[i].modifications.empty());
+            }
+            else {
+                REQUIRE(changes[i].insertions.empty());
+                REQUIRE_INDICES(changes[i].modifications, 5);
+            }
+        }
+    }
+
+    SECTION("notifiers added later are run alongside the existing ones") {
+        Results results2(r, table->where().greater(col, 7));
+        int calls2 = 0;
+        CollectionChangeSet changes2;
+        auto token2 = results2.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            ++calls2;
+            changes2 = std::move(c);
+        });
+        advance_and_notify(*r);
+        REQUIRE(calls2 == 1);
+        REQUIRE(results2.size() == 2);
+        for (int i = 0; i < count; ++i)
+            REQUIRE(calls[i] == 1);
+
+        r->begin_transaction();
+        table->create_object().set(col, 0);
+        table->create_object().set(col, 11);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        REQUIRE(calls2 == 2);
+        REQUIRE_INDICES(changes2.insertions, 2);
+        for (int i = 0; i < count; ++i) {
+            REQUIRE(calls[i] == 2);
+            REQUIRE_INDICES(changes[i].insertions, i + 1);
+        }
+    }
+
+    SECTION("skipped notifications are skipped on every thread") {
+        r->begin_transaction();
+        table->create_object().set(col, 0);
+        for (auto& token : tokens)
+            token.suppress_next();
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        for (int i = 0; i < count; ++i)
+            REQUIRE(calls[i] == 1);
+
+        r->begin_transaction();
+        table->create_object().set(col, 0);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        for (int i = 0; i < count; ++i) {
+            REQUIRE(calls[i] == 2);
+            REQUIRE_INDICES(changes[i].insertions, i + 2);
+            REQUIRE(results[i].size() == size_t(i + 3));
+        }
+    }
+}
+
+TEST_CASE("notifications: incremental updates") {
+    _impl::RealmCoordinator::assert_no_open_realms();
+
+    InMemoryTestFile config;
+    config.automatic_change_notifications = false;
+
+    auto r = Realm::get_shared_realm(config);
+    r->update_schema({
+        {"object",
+         {{"value", PropertyType::Int}, {"link", PropertyType::Object | PropertyType::Nullable, "object"}}},
+    });
+
+    auto table = r->read_group().get_table("class_object");
+    auto col = table->get_column_key("value");
+    auto col_link = table->get_column_key("link");
+
+    r->begin_transaction();
+    std::vector<ObjKey> keys;
+    for (int i = 0; i < 100; ++i)
+        keys.push_back(table->create_object().set(col, i).get_key());
+    for (int i = 0; i < 100; ++i)
+        table->get_object(keys[i]).set(col_link, keys[(i + 1) % 100]);
+    r->commit_transaction();
+
+    // Check that the results match what rerunning the query produces
+    auto verify = [&](Results& results, Query query) {
+        auto tv = query.find_all();
+        REQUIRE(results.size() == tv.size());
+        for (size_t i = 0; i < tv.size(); ++i)
+            REQUIRE(results.get(i).get_key() == tv.get_key(i));
+    };
+
+    Results results(r, table->where().greater(col, 50));
+    CollectionChangeSet change;
+    auto token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr err) {
+        REQUIRE_FALSE(err);
+        change = std::move(c);
+    });
+    advance_and_notify(*r);
+    REQUIRE(results.size() == 49);
+
+    SECTION("modified objects move into and out of the results") {
+        r->begin_transaction();
+        table->get_object(keys[10]).set(col, 60);
+        table->get_object(keys[60]).set(col, 10);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        REQUIRE_INDICES(change.insertions, 0);
+        REQUIRE_INDICES(change.deletions, 9);
+        verify(results, table->where().greater(col, 50));
+    }
+
+    SECTION("modified objects which still match are reported as modifications") {
+        r->begin_transaction();
+        table->get_object(keys[60]).set(col, 70);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        REQUIRE(change.insertions.empty());
+        REQUIRE(change.deletions.empty());
+        REQUIRE_INDICES(change.modifications, 9);
+        verify(results, table->where().greater(col, 50));
+    }
+
+    SECTION("inserted and deleted objects") {
+        r->begin_transaction();
+        table->create_object().set(col, 100);
+        table->create_object().set(col, 0);
+        table->remove_object(keys[70]);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        REQUIRE_INDICES(change.insertions, 48);
+        REQUIRE_INDICES(change.deletions, 19);
+        verify(results, table->where().greater(col, 50));
+    }
+
+    SECTION("most of the table changing") {
+        r->begin_transaction();
+        for (int i = 0; i < 100; ++i)
+            table->get_object(keys[i]).set(col, 99 - i);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        verify(results, table->where().greater(col, 50));
+    }
+
+    SECTION("clearing the table") {
+        r->begin_transaction();
+        table->clear();
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        REQUIRE(change.deletions.count() == 49);
+        REQUIRE(results.size() == 0);
+    }
+
+    SECTION("changes made while the results are unused") {
+        token = {};
+        advance_and_notify(*r);
+
+        r->begin_transaction();
+        table->get_object(keys[60]).set(col, 10);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            change = std::move(c);
+        });
+        advance_and_notify(*r);
+
+        r->begin_transaction();
+        table->get_object(keys[10]).set(col, 60);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        verify(results, table->where().greater(col, 50));
+    }
+
+    SECTION("queries following links are rerun") {
+        auto query = table->link(col_link).column<Int>(col) > 50;
+        Results linked(r, query);
+        CollectionChangeSet linked_change;
+        auto linked_token = linked.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            linked_change = std::move(c);
+        });
+        advance_and_notify(*r);
+        REQUIRE(linked.size() == 49);
+
+        // Only the object linked to changes, but the one linking to it no
+        // longer matches
+        r->begin_transaction();
+        table->get_object(keys[80]).set(col, 10);
+        r->commit_transaction();
+        advance_and_notify(*r);
+
+        REQUIRE_INDICES(linked_change.deletions, 29);
+        verify(linked, table->link(col_link).column<Int>(col) > 50);
+    }
+}
+
+TEST_CASE("notifications: key path filtering") {
+    _impl::RealmCoordinator::assert_no_open_realms();
+
+    InMemoryTestFile config;
+    config.automatic_change_notifications = false;
+
+    auto r = Realm::get_shared_realm(config);
+    r->update_schema({
+        {"person",
+         {{"name", PropertyType::String},
+          {"age", PropertyType::Int},
+          {"dog", PropertyType::Object | PropertyType::Nullable, "dog"},
+          {"friends", PropertyType::Object | PropertyType::Array, "person"}}},
+        {"dog", {{"name", PropertyType::String}, {"age", PropertyType::Int}}},
+    });
+
+    auto people = r->read_group().get_table("class_person");
+    auto dogs = r->read_group().get_table("class_dog");
+    auto col_name = people->get_column_key("name");
+    auto col_age = people->get_column_key("age");
+    auto col_dog = people->get_column_key("dog");
+    auto col_friends = people->get_column_key("friends");
+    auto col_dog_name = dogs->get_column_key("name");
+    auto col_dog_age = dogs->get_column_key("age");
+
+    r->begin_transaction();
+    std::vector<Obj> dog_objs;
+    std::vector<Obj> person_objs;
+    for (int i = 0; i < 4; ++i) {
+        dog_objs.push_back(dogs->create_object().set(col_dog_name, "dog").set(col_dog_age, i));
+        person_objs.push_back(people->create_object().set(col_name, "person").set(col_age, i));
+        person_objs.back().set(col_dog, dog_objs.back().get_key());
+    }
+    person_objs[0].get_linklist(col_friends).add(person_objs[3].get_key());
+    r->commit_transaction();
+
+    auto write = [&](auto&& fn) {
+        r->begin_transaction();
+        fn();
+        r->commit_transaction();
+        advance_and_notify(*r);
+    };
+
+    Results results(r, people);
+    int notification_calls = 0;
+    CollectionChangeSet change;
+    auto callback = [&](CollectionChangeSet c, std::exception_ptr err) {
+        REQUIRE_FALSE(err);
+        change = std::move(c);
+        ++notification_calls;
+    };
+
+    SECTION("changes to unobserved properties are not reported") {
+        auto token = results.add_notification_callback(callback, {{{people->get_key(), col_name}}});
+        advance_and_notify(*r);
+        REQUIRE(notification_calls == 1);
+
+        write([&] {
+            person_objs[1].set(col_age, 10);
+        });
+        REQUIRE(notification_calls == 1);
+
+        write([&] {
+            person_objs[1].set(col_name, "renamed");
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.modifications, 1);
+    }
+
+    SECTION("insertions and deletions are reported regardless of key paths") {
+        auto token = results.add_notification_callback(callback, {{{people->get_key(), col_name}}});
+        advance_and_notify(*r);
+
+        write([&] {
+            people->create_object();
+            person_objs[2].remove();
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.insertions, 3);
+        REQUIRE_INDICES(change.deletions, 2);
+    }
+
+    SECTION("changes through a link are reported for the observed properties") {
+        auto token =
+            results.add_notification_callback(callback, {{{people->get_key(), col_dog}, {dogs->get_key(), col_dog_name}}});
+        advance_and_notify(*r);
+
+        write([&] {
+            dog_objs[2].set(col_dog_age, 10);
+        });
+        REQUIRE(notification_calls == 1);
+
+        write([&] {
+            dog_objs[2].set(col_dog_name, "renamed");
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.modifications, 2);
+
+        write([&] {
+            person_objs[1].set(col_dog, dog_objs[3].get_key());
+        });
+        REQUIRE(notification_calls == 3);
+        REQUIRE_INDICES(change.modifications, 1);
+
+        // Neither the name of the person nor of dog 1, which is no longer linked to, is observed
+        write([&] {
+            person_objs[1].set(col_name, "renamed");
+            dog_objs[1].set(col_dog_name, "renamed");
+        });
+        REQUIRE(notification_calls == 3);
+    }
+
+    SECTION("changes through a list of links are reported") {
+        auto token = results.add_notification_callback(
+            callback, {{{people->get_key(), col_friends}, {people->get_key(), col_dog}, {dogs->get_key(), col_dog_age}}});
+        advance_and_notify(*r);
+
+        write([&] {
+            dog_objs[3].set(col_dog_age, 10);
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.modifications, 0);
+
+        write([&] {
+            person_objs[3].set(col_age, 10);
+            dog_objs[0].set(col_dog_age, 10);
+        });
+        REQUIRE(notification_calls == 2);
+    }
+
+    SECTION("each callback is only told about modifications to its own key paths") {
+        auto token = results.add_notification_callback(callback, {{{people->get_key(), col_name}}});
+        int unfiltered_calls = 0;
+        auto token2 = results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+            ++unfiltered_calls;
+        });
+        int age_calls = 0;
+        CollectionChangeSet age_change;
+        auto token3 = results.add_notification_callback(
+            [&](CollectionChangeSet c, std::exception_ptr) {
+                age_change = std::move(c);
+                ++age_calls;
+            },
+            {{{people->get_key(), col_age}}});
+        advance_and_notify(*r);
+        REQUIRE(notification_calls == 1);
+        REQUIRE(unfiltered_calls == 1);
+        REQUIRE(age_calls == 1);
+
+        write([&] {
+            person_objs[1].set(col_age, 10);
+        });
+        REQUIRE(notification_calls == 1);
+        REQUIRE(unfiltered_calls == 2);
+        REQUIRE(age_calls == 2);
+        REQUIRE_INDICES(age_change.modifications, 1);
+
+        write([&] {
+            person_objs[2].set(col_name, "renamed");
+            person_objs[3].set(col_age, 10);
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.modifications, 2);
+        REQUIRE(unfiltered_calls == 3);
+        REQUIRE(age_calls == 3);
+        REQUIRE_INDICES(age_change.modifications, 3);
+
+        // Insertions are still reported to every callback
+        write([&] {
+            people->create_object();
+        });
+        REQUIRE(notification_calls == 3);
+        REQUIRE_INDICES(change.insertions, 4);
+        REQUIRE(change.modifications.empty());
+        REQUIRE(age_calls == 4);
+
+        // Removing the unfiltered callback keeps the filtering
+        token2 = {};
+        write([&] {
+            person_objs[1].set(col_age, 20);
+        });
+        REQUIRE(notification_calls == 3);
+        REQUIRE(age_calls == 5);
+    }
+
+    SECTION("list notifications are filtered per callback") {
+        List list(r, person_objs[0], col_friends);
+        auto token = list.add_notification_callback(callback, {{{people->get_key(), col_name}}});
+        int unfiltered_calls = 0;
+        auto token2 = list.add_notification_callback([&](CollectionChangeSet, std::exception_ptr) {
+            ++unfiltered_calls;
+        });
+        advance_and_notify(*r);
+
+        write([&] {
+            person_objs[3].set(col_age, 10);
+        });
+        REQUIRE(notification_calls == 1);
+        REQUIRE(unfiltered_calls == 2);
+
+        write([&] {
+            person_objs[3].set(col_name, "renamed");
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.modifications, 0);
+        REQUIRE(unfiltered_calls == 3);
+    }
+
+    SECTION("object notifications report the observed columns") {
+        Object object(r, person_objs[0]);
+        auto token =
+            object.add_notification_callback(callback, {{{people->get_key(), col_age}},
+                                                        {{people->get_key(), col_dog}, {dogs->get_key(), col_dog_name}}});
+        advance_and_notify(*r);
+
+        write([&] {
+            person_objs[0].set(col_name, "renamed");
+            dog_objs[0].set(col_dog_age, 10);
+        });
+        REQUIRE(notification_calls == 1);
+
+        write([&] {
+            person_objs[0].set(col_name, "renamed again");
+            dog_objs[0].set(col_dog_name, "renamed");
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE_INDICES(change.modifications, 0);
+        REQUIRE(change.columns.size() == 1);
+        REQUIRE_INDICES(change.columns[col_dog.value], 0);
+    }
+
+    SECTION("object notifications are filtered per callback") {
+        Object object(r, person_objs[0]);
+        auto token = object.add_notification_callback(callback, {{{people->get_key(), col_age}}});
+        int unfiltered_calls = 0;
+        CollectionChangeSet unfiltered_change;
+        auto token2 = object.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            unfiltered_change = std::move(c);
+            ++unfiltered_calls;
+        });
+        advance_and_notify(*r);
+
+        write([&] {
+            person_objs[0].set(col_name, "renamed");
+        });
+        REQUIRE(notification_calls == 1);
+        REQUIRE(unfiltered_calls == 2);
+        REQUIRE_INDICES(unfiltered_change.columns[col_name.value], 0);
+
+        write([&] {
+            person_objs[0].set(col_name, "renamed again");
+            person_objs[0].set(col_age, 10);
+        });
+        REQUIRE(notification_calls == 2);
+        REQUIRE(change.columns.size() == 1);
+        REQUIRE_INDICES(change.columns[col_age.value], 0);
+        REQUIRE(unfiltered_calls == 3);
+        REQUIRE(unfiltered_change.columns.size() == 2);
+
+        write([&] {
+            person_objs[0].remove();
+        });
+        REQUIRE(notification_calls == 3);
+        REQUIRE_INDICES(change.deletions, 0);
+        REQUIRE(unfiltered_calls == 4);
+    }
+
+    SECTION("invalid key paths are rejected") {
+        REQUIRE_THROWS_AS(results.add_notification_callback(callback, {{}}), std::invalid_argument);
+        REQUIRE_THROWS_AS(results.add_notification_callback(callback, {{{dogs->get_key(), col_dog_name}}}),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(results.add_notification_callback(
+                              callback, {{{people->get_key(), col_name}, {dogs->get_key(), col_dog_name}}}),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(results.add_notification_callback(
+                              callback, {{{people->get_key(), col_dog}, {people->get_key(), col_name}}}),
+                          std::invalid_argument);
+    }
+}
+
+TEST_CASE("notifications: shared query results") {
+    _impl::RealmCoordinator::assert_no_open_realms();
+
+    InMemoryTestFile config;
+    config.cache = false;
+    config.automatic_change_notifications = false;
+
+    auto r = Realm::get_shared_realm(config);
+    r->update_schema({
+        {"object", {{"value", PropertyType::Int}, {"double", PropertyType::Double}}},
+    });
+    auto r2 = Realm::get_shared_realm(config);
+
+    auto table = r->read_group().get_table("class_object");
+    auto table2 = r2->read_group().get_table("class_object");
+    auto col = table->get_column_key("value");
+    auto col_double = table->get_column_key("double");
+
+    r->begin_transaction();
+    std::vector<ObjKey> keys;
+    for (int i = 0; i < 10; ++i)
+        keys.push_back(table->create_object().set(col, i).set(col_double, i / 10.0).get_key());
+    r->commit_transaction();
+
+    auto key = [](Query query, DescriptorOrdering ordering = {}) {
+        return _impl::QueryResultCache::make_key(query.get_table(), query, ordering, true);
+    };
+    auto& cache = *_impl::RealmCoordinator::get_coordinator(config.path)->get_query_result_cache();
+
+    SECTION("equivalent queries have the same key") {
+        REQUIRE_FALSE(key(table->where().greater(col, 5)).empty());
+        REQUIRE(key(table->where().greater(col, 5)) == key(table2->where().greater(col, 5)));
+        REQUIRE(key(table->where().greater(col, 5)) != key(table->where().greater(col, 6)));
+        REQUIRE(key(table->where().greater(col_double, 1.0000001)) !=
+                key(table->where().greater(col_double, 1.0000002)));
+
+        DescriptorOrdering sorted;
+        sorted.append_sort(SortDescriptor({{col}}, {false}));
+        REQUIRE(key(table->where().greater(col, 5)) != key(table->where().greater(col, 5), sorted));
+
+        // The description of a query restricted by a view doesn't include the view
+        auto tv = table->where().less(col, 3).find_all();
+        REQUIRE(key(table->where(&tv)).empty());
+    }
+
+    SECTION("notifiers for equivalent queries report the same changes") {
+        Results results(r, table->where().greater(col, 5));
+        Results results2(r2, table2->where().greater(col, 5));
+        CollectionChangeSet change, change2;
+        auto token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            change = std::move(c);
+        });
+        auto token2 = results2.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            change2 = std::move(c);
+        });
+        advance_and_notify(*r);
+        advance_and_notify(*r2);
+        REQUIRE(results.size() == 4);
+        REQUIRE(results2.size() == 4);
+
+        r->begin_transaction();
+        table->get_object(keys[2]).set(col, 20);
+        table->get_object(keys[7]).set(col, 8);
+        table->get_object(keys[9]).set(col, 0);
+        r->commit_transaction();
+        advance_and_notify(*r);
+        advance_and_notify(*r2);
+
+        REQUIRE(results.size() == 4);
+        REQUIRE(results2.size() == 4);
+        for (auto& c : {change, change2}) {
+            REQUIRE_INDICES(c.insertions, 0);
+            REQUIRE_INDICES(c.deletions, 3);
+            REQUIRE_INDICES(c.modifications, 1);
+        }
+        for (size_t i = 0; i < 4; ++i)
+            REQUIRE(results.get(i).get_key() == results2.get(i).get_key());
+    }
+
+    SECTION("results stored by another notifier are used instead of running the query") {
+        Results results(r, table->where().greater(col, 5));
+        CollectionChangeSet change;
+        auto token = results.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr) {
+            change = std::move(c);
+        });
+        advance_and_notify(*r);
+        REQUIRE(results.size() == 4);
+
+        // Written on the other Realm, as the results delivered after a local
+        // write are discarded in favour of rerunning the query locally
+        r2->begin_transaction();
+        table2->get_object(keys[9]).set(col, 10);
+        r2->commit_transaction();
+        // Store different results for the new version as if they came from
+        // another notifier, which the notifier then reports
+        auto rows = std::make_shared<const std::vector<ObjKey>>(std::vector<ObjKey>{keys[8], keys[9]});
+        cache.set(key(table->where().greater(col, 5)), {r2->read_transaction_version(), rows, {}, nullptr});
+        advance_and_notify(*r);
+
+        REQUIRE(results.get(0).get_key() == keys[8]);
+        REQUIRE(results.size() == 2);
+        REQUIRE_INDICES(change.deletions, 0, 1);
+        REQUIRE_INDICES(change.modifications, 3);
+    }
+
+    SECTION("shared sorted results keep their sort order") {
+        Results results = Results(r, table->where().greater(col, 5)).sort({{{col}}, {false}});
+        Results results2 = Results(r2, table2->where().greater(col, 5)).sort({{{col}}, {false}});
+        auto token = results.add_notification_callback([](CollectionChangeSet, std::exception_ptr) {});
+        auto token2 = results2.add_notification_callback([](CollectionChangeSet, std::exception_ptr) {});
+        advance_and_notify(*r);
+        advance_and_notify(*r2);
+
+        r->begin_transaction();
+        table->get_object(keys[6]).set(col, 20);
+        r->commit_transaction();
+        advance_and_notify(*r);
+        advance_and_notify(*r2);
+        REQUIRE(results.get(0).get_key() == keys[6]);
+        REQUIRE(results2.get(0).get_key() == keys[6]);
+        REQUIRE(results2.get(1).get_key() == keys[9]);
+
+        // Changes made in a write transaction re-sort the delivered results
+        r2->begin_transaction();
+        table2->get_object(keys[7]).set(col, 30);
+        REQUIRE(results2.get(0).get_key() == keys[7]);
+        REQUIRE(results2.get(1).get_key() == keys[6]);
+        r2->cancel_transaction();
+    }
+}
+
 TEST_CASE("notifications: TableView delivery") {
     _impl::RealmCoordinator::assert_no_open_realms();
 
@@ -3485,6 +4159,166 @@ TEST_CASE("results: limit", "[limit]") {
     }
 }
 
+TEST_CASE("results: window", "[limit]") {
+    InMemoryTestFile config;
+    config.automatic_change_notifications = false;
+    config.schema = Schema{
+        {"object",
+         {
+             {"value", PropertyType::Int},
+         }},
+        {"list",
+         {
+             {"values", PropertyType::Array | PropertyType::Int},
+         }},
+    };
+
+    auto realm = Realm::get_shared_realm(config);
+    auto table = realm->read_group().get_table("class_object");
+    auto col = table->get_column_key("value");
+
+    // A permutation of 0-99 so that sorting moves every object
+    realm->begin_transaction();
+    for (int i = 0; i < 100; ++i) {
+        table->create_object().set(col, (i * 37) % 100);
+    }
+    realm->commit_transaction();
+    Results r(realm, table);
+
+    auto values = [&](Results results) {
+        std::vector<int64_t> ret;
+        for (size_t i = 0, size = results.size(); i < size; ++i)
+            ret.push_back(results.get(i).get<Int>(col));
+        return ret;
+    };
+
+    SECTION("unsorted") {
+        auto window = r.window(10);
+        REQUIRE(window.window_size() == 10);
+        REQUIRE(window.size() == 10);
+        for (size_t i = 0; i < 10; ++i)
+            REQUIRE(window.get(i).get_key() == r.get(i).get_key());
+        REQUIRE(window.total_count() == 100);
+
+        REQUIRE_FALSE(r.window_size());
+        REQUIRE(r.total_count() == 100);
+    }
+
+    SECTION("sorted") {
+        auto window = r.sort({{"value", false}}).window(5);
+        REQUIRE(values(window) == std::vector<int64_t>{99, 98, 97, 96, 95});
+        REQUIRE(window.total_count() == 100);
+    }
+
+    SECTION("filtered") {
+        auto window = Results(realm, table->where().greater(col, 49)).sort({{"value", true}}).window(10);
+        REQUIRE(values(window) == std::vector<int64_t>{50, 51, 52, 53, 54, 55, 56, 57, 58, 59});
+        REQUIRE(window.total_count() == 50);
+    }
+
+    SECTION("extending the window") {
+        auto window = r.sort({{"value", true}}).window(5);
+        auto extended = window.extend_window(5);
+        REQUIRE(extended.window_size() == 10);
+        REQUIRE(values(extended) == std::vector<int64_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+        REQUIRE(extended.total_count() == 100);
+        REQUIRE(window.size() == 5);
+
+        // Windowing again replaces the window rather than nesting it
+        REQUIRE(extended.window(3).size() == 3);
+        REQUIRE(window.window(20).size() == 20);
+        REQUIRE(r.window(200).size() == 100);
+
+        REQUIRE_THROWS_AS(r.extend_window(5), std::logic_error);
+    }
+
+    SECTION("notifications only report changes inside the window") {
+        auto window = r.sort({{"value", false}}).window(3);
+        int calls = 0;
+        CollectionChangeSet change;
+        size_t total_count = 0;
+        auto token = window.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            change = c;
+            total_count = window.total_count();
+            ++calls;
+        });
+        advance_and_notify(*realm);
+        REQUIRE(calls == 1);
+        REQUIRE(total_count == 100);
+
+        realm->begin_transaction();
+        table->create_object().set(col, 50);
+        realm->commit_transaction();
+        advance_and_notify(*realm);
+        REQUIRE(calls == 1);
+        REQUIRE(window.total_count() == 101);
+
+        realm->begin_transaction();
+        table->create_object().set(col, 1000);
+        realm->commit_transaction();
+        advance_and_notify(*realm);
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 0);
+        REQUIRE_INDICES(change.deletions, 2);
+        REQUIRE(total_count == 102);
+        REQUIRE(values(window) == std::vector<int64_t>{1000, 99, 98});
+    }
+
+    SECTION("lists") {
+        realm->begin_transaction();
+        auto list_table = realm->read_group().get_table("class_list");
+        auto list_col = list_table->get_column_key("values");
+        auto obj = list_table->create_object();
+        auto lst = obj.get_list<Int>(list_col);
+        for (int i = 0; i < 10; ++i)
+            lst.add((i * 3) % 10);
+        realm->commit_transaction();
+
+        auto list_results = List(realm, obj, list_col).as_results();
+        auto list_values = [&](Results results) {
+            std::vector<int64_t> ret;
+            for (size_t i = 0, size = results.size(); i < size; ++i)
+                ret.push_back(results.get<Int>(i));
+            return ret;
+        };
+
+        auto window = list_results.window(4);
+        REQUIRE(list_values(window) == std::vector<int64_t>{0, 3, 6, 9});
+        REQUIRE(window.total_count() == 10);
+
+        auto sorted = list_results.sort({{"self", false}}).window(3);
+        REQUIRE(list_values(sorted) == std::vector<int64_t>{9, 8, 7});
+        REQUIRE(sorted.total_count() == 10);
+        REQUIRE(list_values(sorted.extend_window(2)) == std::vector<int64_t>{9, 8, 7, 6, 5});
+
+        REQUIRE_THROWS_AS(window.sort({{"self", true}}), Results::UnimplementedOperationException);
+
+        int calls = 0;
+        CollectionChangeSet change;
+        size_t total_count = 0;
+        auto token = window.add_notification_callback([&](CollectionChangeSet c, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            change = c;
+            total_count = window.total_count();
+            ++calls;
+        });
+        advance_and_notify(*realm);
+        REQUIRE(calls == 1);
+        REQUIRE(total_count == 10);
+
+        realm->begin_transaction();
+        lst.insert(0, 100);
+        realm->commit_transaction();
+        advance_and_notify(*realm);
+        REQUIRE(calls == 2);
+        REQUIRE_INDICES(change.insertions, 0);
+        REQUIRE_INDICES(change.deletions, 3);
+        REQUIRE(total_count == 11);
+        REQUIRE(list_values(window) == std::vector<int64_t>{100, 0, 3, 6});
+    }
+}
+
 TEST_CASE("results: query helpers", "[include]") {
     InMemoryTestFile config;
     config.automatic_change_notifications = false;
@@ -0,0 +1,280 @@
+////////////////////////////////////////////////////////////////////////////
+//
+// Copyright 2020 Realm Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////
+
+#include <catch2/catch.hpp>
+
+#include "util/test_file.hpp"
+
+#include <realm/object-store/object_schema.hpp>
+#include <realm/object-store/property.hpp>
+#include <realm/object-store/results.hpp>
+#include <realm/object-store/schema.hpp>
+#include <realm/object-store/shared_realm.hpp>
+#include <realm/object-store/util/scheduler.hpp>
+
+#if REALM_HAVE_EPOLL
+#include <realm/object-store/util/epoll/event_loop.hpp>
+#include <poll.h>
+#endif
+
+#if REALM_ENABLE_SYNC
+#include <realm/util/network.hpp>
+#endif
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace realm;
+
+namespace {
+Realm::Config make_config(TestFile& config, std::shared_ptr<util::Scheduler> scheduler)
+{
+    config.schema_version = 1;
+    config.schema = Schema{
+        {"object", {{"value", PropertyType::Int}}},
+    };
+    config.scheduler = std::move(scheduler);
+    return config;
+}
+
+void write_on_background_thread(Realm::Config config)
+{
+    config.scheduler = nullptr;
+    JoiningThread([&] {
+        auto r = Realm::get_shared_realm(config);
+        r->begin_transaction();
+        r->read_group().get_table("class_object")->create_object().set("value", 1);
+        r->commit_transaction();
+    });
+}
+} // anonymous namespace
+
+#if REALM_HAVE_EPOLL
+TEST_CASE("EpollEventLoop") {
+    util::EpollEventLoop loop;
+
+    SECTION("runs posted work in submission order") {
+        std::vector<int> order;
+        loop.post([&] {
+            order.push_back(1);
+        });
+        loop.post([&] {
+            order.push_back(2);
+            loop.post([&] {
+                order.push_back(4);
+                loop.stop();
+            });
+        });
+        loop.post([&] {
+            order.push_back(3);
+        });
+        loop.run();
+        REQUIRE(order == std::vector<int>{1, 2, 3, 4});
+    }
+
+    SECTION("work posted from another thread wakes up the loop") {
+        bool done = false;
+        JoiningThread thread([&] {
+            loop.post([&] {
+                REQUIRE(loop.is_on_thread());
+                done = true;
+            });
+        });
+        REQUIRE(loop.run_until([&] {
+            return done;
+        }));
+    }
+
+    SECTION("stop() from another thread makes run() return") {
+        JoiningThread thread([&] {
+            REQUIRE_FALSE(loop.is_on_thread());
+            loop.stop();
+        });
+        loop.run();
+    }
+
+    SECTION("stop() before run() is not lost") {
+        loop.stop();
+        loop.poll();
+        loop.run();
+    }
+
+    SECTION("poll() runs pending work without waiting") {
+        REQUIRE(loop.poll() == 0);
+        int calls = 0;
+        loop.post([&] {
+            ++calls;
+        });
+        loop.post([&] {
+            ++calls;
+        });
+        REQUIRE(loop.poll() == 2);
+        REQUIRE(calls == 2);
+        REQUIRE(loop.poll() == 0);
+    }
+
+    SECTION("fd is readable only while there is pending work") {
+        auto is_readable = [&] {
+            pollfd fd{loop.get_fd(), POLLIN, 0};
+            return ::poll(&fd, 1, 0) == 1;
+        };
+        REQUIRE_FALSE(is_readable());
+        loop.post([] {});
+        REQUIRE(is_readable());
+        loop.poll();
+        REQUIRE_FALSE(is_readable());
+    }
+
+    SECTION("work remaining after an exception is run by the next call") {
+        bool ran = false;
+        loop.post([] {
+            throw std::runtime_error("error");
+        });
+        loop.post([&] {
+            ran = true;
+        });
+        REQUIRE_THROWS_AS(loop.run(), std::runtime_error);
+        REQUIRE_FALSE(ran);
+        REQUIRE(loop.run_until([&] {
+            return ran;
+        }));
+    }
+}
+
+TEST_CASE("Scheduler::make_epoll") {
+    auto loop = std::make_shared<util::EpollEventLoop>();
+    auto scheduler = util::Scheduler::make_epoll(loop);
+
+    SECTION("is bound to the loop's thread") {
+        REQUIRE(scheduler->can_deliver_notifications());
+        REQUIRE(scheduler->is_on_thread());
+        JoiningThread([&] {
+            REQUIRE_FALSE(scheduler->is_on_thread());
+        });
+        REQUIRE(scheduler->is_same_as(util::Scheduler::make_epoll(loop).get()));
+        auto other_loop = std::make_shared<util::EpollEventLoop>();
+        REQUIRE_FALSE(scheduler->is_same_as(util::Scheduler::make_epoll(other_loop).get()));
+        REQUIRE_FALSE(scheduler->is_same_as(util::Scheduler::make_default().get()));
+    }
+
+    SECTION("notify() before the callback runs is coalesced") {
+        int calls = 0;
+        scheduler->set_notify_callback([&] {
+            ++calls;
+        });
+        scheduler->notify();
+        scheduler->notify();
+        JoiningThread([&] {
+            scheduler->notify();
+        });
+        REQUIRE(loop->poll() == 1);
+        REQUIRE(calls == 1);
+
+        scheduler->notify();
+        REQUIRE(loop->poll() == 1);
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("pending notifications are dropped when the scheduler is destroyed") {
+        int calls = 0;
+        scheduler->set_notify_callback([&] {
+            ++calls;
+        });
+        scheduler->notify();
+        scheduler.reset();
+        REQUIRE(loop->poll() == 1);
+        REQUIRE(calls == 0);
+    }
+
+    SECTION("delivers notifications for commits made on other threads") {
+        TestFile file;
+        auto config = make_config(file, scheduler);
+        auto r = Realm::get_shared_realm(config);
+        Results results(r, r->read_group().get_table("class_object"));
+
+        int calls = 0;
+        auto token = results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            ++calls;
+        });
+        loop->run_until([&] {
+            return calls == 1;
+        });
+
+        write_on_background_thread(config);
+        loop->run_until([&] {
+            return calls == 2;
+        });
+        REQUIRE(results.size() == 1);
+    }
+}
+#endif
+
+#if REALM_ENABLE_SYNC
+TEST_CASE("Scheduler::make_network_service") {
+    util::network::Service service;
+    auto scheduler = util::Scheduler::make_network_service(service);
+
+    SECTION("is bound to the creating thread") {
+        REQUIRE(scheduler->can_deliver_notifications());
+        REQUIRE(scheduler->is_on_thread());
+        JoiningThread([&] {
+            REQUIRE_FALSE(scheduler->is_on_thread());
+        });
+        REQUIRE(scheduler->is_same_as(util::Scheduler::make_network_service(service).get()));
+        util::network::Service other_service;
+        REQUIRE_FALSE(scheduler->is_same_as(util::Scheduler::make_network_service(other_service).get()));
+    }
+
+    SECTION("notify() posts the callback to the service") {
+        int calls = 0;
+        scheduler->set_notify_callback([&] {
+            ++calls;
+        });
+        scheduler->notify();
+        scheduler->notify();
+        REQUIRE(calls == 0);
+        service.run();
+        REQUIRE(calls == 1);
+    }
+
+    SECTION("delivers notifications for commits made on other threads") {
+        TestFile file;
+        auto config = make_config(file, scheduler);
+        auto r = Realm::get_shared_realm(config);
+        Results results(r, r->read_group().get_table("class_object"));
+
+        // Keep the service's run() from returning due to running out of work
+        // while waiting for the notifier thread
+        util::network::DeadlineTimer timer(service);
+        timer.async_wait(std::chrono::hours(1), [](std::error_code) {});
+
+        std::atomic<int> calls{0};
+        auto token = results.add_notification_callback([&](CollectionChangeSet, std::exception_ptr err) {
+            REQUIRE_FALSE(err);
+            if (++calls == 1)
+                write_on_background_thread(config);
+            else
+                service.stop();
+        });
+        service.run();
+        REQUIRE(calls == 2);
+        REQUIRE(results.size() == 1);
+    }
+}
+#endif
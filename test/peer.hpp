@@ -454,8 +454,8 @@ private:
         m_protocol.make_download_message(sync::get_current_protocol_version(), m_download_message_buffer,
                                          file_ident_type(0), version_type(0), version_type(0), version_type(0), 0,
                                          version_type(0), version_type(0), 0, num_changesets,
-                                         m_history_entries_buffer.data(), m_history_entries_buffer.size(), 0, false,
-                                         *logger); // Throws
+                                         m_history_entries_buffer.data(), m_history_entries_buffer.size(), 0,
+                                         _impl::compression::Codec::none, *logger); // Throws
 
         m_history_entries_buffer.reset();
 
@@ -428,14 +428,21 @@ public:
         std::string server_ssl_certificate_key_path = get_test_resource_path() + "test_sync_key.pem";
 
         bool disable_download_compaction = false;
+        bool disable_fast_compression = false;
         bool disable_upload_compaction = false;
 
+        bool disable_state_realms = false;
+
         bool disable_history_compaction = false;
         std::chrono::seconds history_ttl = std::chrono::seconds::max();
         std::chrono::seconds history_compaction_interval = std::chrono::seconds{3600};
         const Clock* history_compaction_clock = nullptr;
 
-        size_t max_download_size = 0x1000000; // 16 MB as in Server::Config
+        size_t max_download_size = 0x1000000;       // 16 MB as in Server::Config
+        size_t download_cache_max_size = 0x4000000; // 64 MB as in Server::Config
+
+        int server_num_network_shards = 0;
+        int server_num_integration_workers = 1;
 
         bool one_connection_per_session = false;
 
@@ -520,12 +527,17 @@ public:
             config_2.connection_reaper_timeout = config.server_connection_reaper_timeout;
             config_2.connection_reaper_interval = config.server_connection_reaper_interval;
             config_2.max_download_size = config.max_download_size;
+            config_2.download_cache_max_size = config.download_cache_max_size;
             config_2.disable_download_compaction = config.disable_download_compaction;
+            config_2.disable_fast_compression = config.disable_fast_compression;
+            config_2.disable_state_realms = config.disable_state_realms;
             config_2.disable_history_compaction = config.disable_history_compaction;
             config_2.history_compaction_clock = config.history_compaction_clock;
             config_2.history_ttl = config.history_ttl;
             config_2.history_compaction_interval = config.history_compaction_interval;
             config_2.tcp_no_delay = true;
+            config_2.num_network_shards = config.server_num_network_shards;
+            config_2.num_integration_workers = config.server_num_integration_workers;
             config_2.authorization_header_name = config.authorization_header_name;
             config_2.encryption_key = make_crypt_key(config.server_encryption_key);
             config_2.client_file_blacklists = config.client_file_blacklists;
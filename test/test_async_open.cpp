@@ -3,6 +3,9 @@
 
 #include <realm/util/random.hpp>
 #include <realm/db.hpp>
+#include <realm/list.hpp>
+#include <realm/set.hpp>
+#include <realm/dictionary.hpp>
 
 #include "test.hpp"
 #include "sync_fixtures.hpp"
@@ -60,8 +63,6 @@ TEST(AsyncOpen_NonExistingRealm)
 }
 
 
-// Note: Since v10, state realms are always disabled on the internal sync server
-// implementation.
 TEST(AsyncOpen_DisableStateRealms)
 {
     TEST_DIR(dir);
@@ -74,6 +75,7 @@ TEST(AsyncOpen_DisableStateRealms)
     util::Logger& logger = test_context.logger;
 
     ClientServerFixture::Config config;
+    config.disable_state_realms = true;
     ClientServerFixture fixture(dir, test_context, config);
     fixture.start();
 
@@ -127,6 +129,271 @@ TEST(AsyncOpen_DisableStateRealms)
 }
 
 
+TEST(AsyncOpen_StateRealm)
+{
+    TEST_DIR(dir);
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+    TEST_DIR(metadata_dir_2);
+
+    const int number_of_rows = 100;
+
+    util::Logger& logger = test_context.logger;
+
+    ClientServerFixture fixture(dir, test_context);
+    fixture.start();
+
+    std::unique_ptr<ClientReplication> history_1 = make_client_replication(path_1);
+    DBRef sg_1 = DB::create(*history_1);
+    Session session_1 = fixture.make_session(path_1);
+    fixture.bind_session(session_1, "/data");
+
+    ColKey col_ndx;
+    {
+        WriteTransaction wt{sg_1};
+        TableRef table = create_table_with_primary_key(wt, "class_table", type_Int, "pk_int");
+        col_ndx = table->add_column(type_Int, "int");
+        for (int i = 0; i < number_of_rows; ++i) {
+            table->create_object_with_primary_key(i).set(col_ndx, i);
+        }
+        session_1.nonsync_transact_notify(wt.commit());
+    }
+    session_1.wait_for_upload_complete_or_client_stopped();
+
+    // The second client is bootstrapped from a state Realm produced by the
+    // server.
+    uint_fast64_t state_downloadable = 0;
+    auto progress_handler = [&](uint_fast64_t downloaded, uint_fast64_t downloadable, uint_fast64_t uploaded,
+                                uint_fast64_t uploadable, uint_fast64_t progress, uint_fast64_t snapshot) {
+        static_cast<void>(downloaded);
+        static_cast<void>(uploadable);
+        static_cast<void>(snapshot);
+        if (progress == 0) {
+            CHECK_EQUAL(uploaded, 0);
+            state_downloadable = downloadable;
+        }
+    };
+    Session::Config session_config;
+    {
+        Session::Config::ClientReset client_reset_config;
+        client_reset_config.metadata_dir = std::string(metadata_dir_2);
+        client_reset_config.require_recent_state_realm = true;
+        session_config.client_reset_config = client_reset_config;
+    }
+    Session session_2 = fixture.make_session(path_2, session_config);
+    session_2.set_progress_handler(progress_handler);
+    fixture.bind_session(session_2, "/data");
+    session_2.wait_for_download_complete_or_client_stopped();
+    CHECK_GREATER(state_downloadable, 0);
+
+    std::unique_ptr<ClientReplication> history_2 = make_client_replication(path_2);
+    DBRef sg_2 = DB::create(*history_2);
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        CHECK(compare_groups(rt_1, rt_2, logger));
+    }
+
+    // The bootstrapped client synchronizes normally afterwards
+    {
+        WriteTransaction wt{sg_2};
+        TableRef table = wt.get_table("class_table");
+        table->create_object_with_primary_key(number_of_rows).set(col_ndx, number_of_rows);
+        session_2.nonsync_transact_notify(wt.commit());
+    }
+    {
+        WriteTransaction wt{sg_1};
+        TableRef table = wt.get_table("class_table");
+        table->create_object_with_primary_key(number_of_rows + 1).set(col_ndx, number_of_rows + 1);
+        session_1.nonsync_transact_notify(wt.commit());
+    }
+    session_1.wait_for_upload_complete_or_client_stopped();
+    session_2.wait_for_upload_complete_or_client_stopped();
+    session_1.wait_for_download_complete_or_client_stopped();
+    session_2.wait_for_download_complete_or_client_stopped();
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        CHECK_EQUAL(rt_2.get_table("class_table")->size(), number_of_rows + 2);
+        CHECK(compare_groups(rt_1, rt_2, logger));
+    }
+}
+
+
+// Populates a Realm through one client using `populate`, and checks that a
+// second client can be bootstrapped from a state Realm with the same contents,
+// and synchronize normally afterwards.
+template <class F>
+void check_state_realm_bootstrap(unit_test::TestContext& test_context, F populate)
+{
+    TEST_DIR(dir);
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+    TEST_DIR(metadata_dir_2);
+
+    util::Logger& logger = test_context.logger;
+
+    ClientServerFixture fixture(dir, test_context);
+    fixture.start();
+
+    std::unique_ptr<ClientReplication> history_1 = make_client_replication(path_1);
+    DBRef sg_1 = DB::create(*history_1);
+    Session session_1 = fixture.make_session(path_1);
+    fixture.bind_session(session_1, "/data");
+    {
+        WriteTransaction wt{sg_1};
+        populate(wt);
+        session_1.nonsync_transact_notify(wt.commit());
+    }
+    session_1.wait_for_upload_complete_or_client_stopped();
+
+    uint_fast64_t state_downloadable = 0;
+    auto progress_handler = [&](uint_fast64_t, uint_fast64_t downloadable, uint_fast64_t, uint_fast64_t,
+                                uint_fast64_t progress, uint_fast64_t) {
+        if (progress == 0)
+            state_downloadable = downloadable;
+    };
+    Session::Config session_config;
+    {
+        Session::Config::ClientReset client_reset_config;
+        client_reset_config.metadata_dir = std::string(metadata_dir_2);
+        client_reset_config.require_recent_state_realm = true;
+        session_config.client_reset_config = client_reset_config;
+    }
+    Session session_2 = fixture.make_session(path_2, session_config);
+    session_2.set_progress_handler(progress_handler);
+    fixture.bind_session(session_2, "/data");
+    session_2.wait_for_download_complete_or_client_stopped();
+    CHECK_GREATER(state_downloadable, 0);
+
+    std::unique_ptr<ClientReplication> history_2 = make_client_replication(path_2);
+    DBRef sg_2 = DB::create(*history_2);
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        CHECK(compare_groups(rt_1, rt_2, logger));
+    }
+
+    {
+        WriteTransaction wt{sg_2};
+        TableRef table = create_table_with_primary_key(wt, "class_after", type_Int, "pk_int");
+        table->create_object_with_primary_key(1);
+        session_2.nonsync_transact_notify(wt.commit());
+    }
+    session_2.wait_for_upload_complete_or_client_stopped();
+    session_1.wait_for_download_complete_or_client_stopped();
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        CHECK(rt_1.has_table("class_after"));
+        CHECK(compare_groups(rt_1, rt_2, logger));
+    }
+}
+
+
+TEST(AsyncOpen_StateRealmEmbeddedObjects)
+{
+    check_state_realm_bootstrap(test_context, [](WriteTransaction& wt) {
+        Group& group = wt.get_group();
+        TableRef parent = group.add_table_with_primary_key("class_parent", type_Int, "pk_int");
+        TableRef child = group.add_embedded_table("class_child");
+        TableRef grandchild = group.add_embedded_table("class_grandchild");
+        ColKey col_child = parent->add_column(*child, "child");
+        ColKey col_children = parent->add_column_list(*child, "children");
+        ColKey col_value = child->add_column(type_String, "value");
+        ColKey col_grandchild = child->add_column(*grandchild, "grandchild");
+        ColKey col_parent = grandchild->add_column(*parent, "parent");
+        for (int i = 0; i < 10; ++i) {
+            Obj obj = parent->create_object_with_primary_key(i);
+            obj.create_and_set_linked_object(col_child).set(col_value, "single");
+            LnkLst children = obj.get_linklist(col_children);
+            for (int j = 0; j < i; ++j) {
+                Obj embedded = children.create_and_insert_linked_object(j);
+                embedded.set(col_value, util::to_string(j));
+                Obj embedded_2 = embedded.create_and_set_linked_object(col_grandchild);
+                embedded_2.set(col_parent, parent->get_object_with_primary_key(0).get_key());
+            }
+        }
+    });
+}
+
+
+TEST(AsyncOpen_StateRealmSets)
+{
+    check_state_realm_bootstrap(test_context, [](WriteTransaction& wt) {
+        Group& group = wt.get_group();
+        TableRef target = group.add_table_with_primary_key("class_target", type_String, "pk_string");
+        TableRef table = group.add_table_with_primary_key("class_table", type_Int, "pk_int");
+        ColKey col_ints = table->add_column_set(type_Int, "ints");
+        ColKey col_strings = table->add_column_set(type_String, "strings");
+        ColKey col_mixed = table->add_column_set(type_Mixed, "mixed");
+        for (int i = 0; i < 10; ++i)
+            target->create_object_with_primary_key(util::to_string(i));
+        for (int i = 0; i < 10; ++i) {
+            Obj obj = table->create_object_with_primary_key(i);
+            auto ints = obj.get_set<Int>(col_ints);
+            auto strings = obj.get_set<String>(col_strings);
+            auto mixed = obj.get_set<Mixed>(col_mixed);
+            for (int j = 0; j < i; ++j) {
+                ints.insert(j * i);
+                strings.insert(util::to_string(j));
+                mixed.insert(Mixed{j});
+            }
+            mixed.insert(Mixed{"string"});
+            mixed.insert(Mixed{ObjLink{target->get_key(), target->get_object_with_primary_key("0").get_key()}});
+        }
+    });
+}
+
+
+TEST(AsyncOpen_StateRealmDictionaries)
+{
+    check_state_realm_bootstrap(test_context, [](WriteTransaction& wt) {
+        Group& group = wt.get_group();
+        TableRef target = group.add_table_with_primary_key("class_target", type_Int, "pk_int");
+        TableRef table = group.add_table_with_primary_key("class_table", type_Int, "pk_int");
+        ColKey col_ints = table->add_column_dictionary(type_Int, "ints");
+        ColKey col_mixed = table->add_column_dictionary(type_Mixed, "mixed");
+        for (int i = 0; i < 10; ++i)
+            target->create_object_with_primary_key(i);
+        for (int i = 0; i < 10; ++i) {
+            Obj obj = table->create_object_with_primary_key(i);
+            Dictionary ints = obj.get_dictionary(col_ints);
+            Dictionary mixed = obj.get_dictionary(col_mixed);
+            for (int j = 0; j < i; ++j) {
+                std::string key = "key" + util::to_string(j);
+                ints.insert(key, j);
+                mixed.insert(key, Mixed{ObjLink{target->get_key(), target->get_object_with_primary_key(j).get_key()}});
+            }
+            mixed.insert("double", 1.5);
+        }
+    });
+}
+
+
+TEST(AsyncOpen_StateRealmMixed)
+{
+    check_state_realm_bootstrap(test_context, [](WriteTransaction& wt) {
+        Group& group = wt.get_group();
+        TableRef target = group.add_table_with_primary_key("class_target", type_Int, "pk_int");
+        TableRef table = group.add_table_with_primary_key("class_table", type_Int, "pk_int");
+        ColKey col_mixed = table->add_column(type_Mixed, "mixed", true);
+        ColKey col_list = table->add_column_list(type_Mixed, "list", true);
+        Obj target_obj = target->create_object_with_primary_key(0);
+        table->create_object_with_primary_key(0).set(col_mixed, Mixed{17});
+        table->create_object_with_primary_key(1).set(col_mixed, Mixed{"string"});
+        table->create_object_with_primary_key(2).set(col_mixed, Mixed{ObjLink{target->get_key(), target_obj.get_key()}});
+        table->create_object_with_primary_key(3);
+        Obj obj = table->create_object_with_primary_key(4);
+        auto list = obj.get_list<Mixed>(col_list);
+        list.add(Mixed{1.5});
+        list.add(Mixed{});
+        list.add(Mixed{ObjLink{target->get_key(), target_obj.get_key()}});
+        list.add(Mixed{BinaryData{"abc", 3}});
+    });
+}
+
+
 TEST(AsyncOpen_StateRealmManagement)
 {
     TEST_DIR(dir);
@@ -24,6 +24,7 @@
 
 #include <realm/util/aes_cryptor.hpp>
 #include <realm/util/encrypted_file_mapping.hpp>
+#include <realm/util/file_mapper.hpp>
 
 #include "test.hpp"
 
@@ -184,5 +185,254 @@ TEST(EncryptedFile_LargePages)
     close(fd);
 }
 
+TEST(EncryptedFile_GcmFormat)
+{
+    TEST_PATH(path);
+
+    char data[4096 * 4];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = static_cast<char>(i);
+    char buffer[sizeof(data)];
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    CHECK_EQUAL(init_encryption_format(fd, File::encryption_AesGcm), File::encryption_AesGcm);
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(sizeof(data));
+        cryptor.write(fd, 0, data, sizeof(data));
+        cryptor.write(fd, 0, data, sizeof(data));
+    }
+    // The format is detected from the file once it is no longer empty
+    CHECK_EQUAL(init_encryption_format(fd, File::encryption_AesCbcHmac), File::encryption_AesGcm);
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(sizeof(data));
+        CHECK(cryptor.read(fd, 0, buffer, sizeof(buffer)));
+        CHECK(memcmp(buffer, data, sizeof(data)) == 0);
+    }
+    close(fd);
+
+    TEST_PATH(path_2);
+    fd = open(path_2.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    CHECK_EQUAL(init_encryption_format(fd, File::encryption_AesCbcHmac), File::encryption_AesCbcHmac);
+    {
+        AESCryptor cryptor(test_key);
+        cryptor.set_file_size(sizeof(data));
+        cryptor.write(fd, 0, data, sizeof(data));
+    }
+    CHECK_EQUAL(init_encryption_format(fd, File::encryption_AesGcm), File::encryption_AesCbcHmac);
+    close(fd);
+}
+
+TEST(EncryptedFile_GcmInterruptedWrite)
+{
+    TEST_PATH(path);
+
+    const char data[4096] = "test data";
+
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    init_encryption_format(fd, File::encryption_AesGcm);
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        cryptor.write(fd, 0, data, sizeof(data));
+    }
+
+    // Fake an interrupted write which updates the IV table but not the data.
+    // The IV table follows the header block and is 40 bytes per block.
+    char buffer[4096];
+    ssize_t actual_pread = pread(fd, buffer, 40, 4096);
+    CHECK_EQUAL(actual_pread, 40);
+
+    memcpy(buffer + 20, buffer, 20);
+    buffer[8]++; // first byte of "tag1" field in iv table
+    ssize_t actual_pwrite = pwrite(fd, buffer, 40, 4096);
+    CHECK_EQUAL(actual_pwrite, 40);
+
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        cryptor.read(fd, 0, buffer, sizeof(buffer));
+        CHECK(memcmp(buffer, data, strlen(data)) == 0);
+    }
+
+    // Modified data fails authentication
+    actual_pread = pread(fd, buffer, 1, 8192);
+    CHECK_EQUAL(actual_pread, 1);
+    buffer[0]++;
+    actual_pwrite = pwrite(fd, buffer, 1, 8192);
+    CHECK_EQUAL(actual_pwrite, 1);
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        CHECK_THROW(cryptor.read(fd, 0, buffer, sizeof(buffer)), DecryptionFailed);
+    }
+
+    close(fd);
+}
+
+TEST(EncryptedFile_GcmNoIvReuseAfterInterruptedWrite)
+{
+    TEST_PATH(path);
+
+    char data[4096] = "first";
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    init_encryption_format(fd, File::encryption_AesGcm);
+    char old_block[4096];
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        cryptor.write(fd, 0, data, sizeof(data));
+        CHECK_EQUAL(pread(fd, old_block, sizeof(old_block), 8192), ssize_t(sizeof(old_block)));
+
+        // Fake an interrupted write which updated the IV table but not the data
+        strcpy(data, "second");
+        cryptor.write(fd, 0, data, sizeof(data));
+        CHECK_EQUAL(pwrite(fd, old_block, sizeof(old_block), 8192), ssize_t(sizeof(old_block)));
+    }
+    uint32_t interrupted_iv;
+    CHECK_EQUAL(pread(fd, &interrupted_iv, sizeof(interrupted_iv), 4096), ssize_t(sizeof(interrupted_iv)));
+
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        char buffer[4096];
+        CHECK(cryptor.read(fd, 0, buffer, sizeof(buffer)));
+        CHECK_EQUAL(std::string(buffer), "first");
+
+        // Writing the block again must not reuse the IV of the interrupted write
+        strcpy(data, "third");
+        cryptor.write(fd, 0, data, sizeof(data));
+        uint32_t new_iv;
+        CHECK_EQUAL(pread(fd, &new_iv, sizeof(new_iv), 4096), ssize_t(sizeof(new_iv)));
+        CHECK_GREATER(new_iv, interrupted_iv);
+        CHECK(cryptor.read(fd, 0, buffer, sizeof(buffer)));
+        CHECK_EQUAL(std::string(buffer), "third");
+    }
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        char buffer[4096];
+        CHECK(cryptor.read(fd, 0, buffer, sizeof(buffer)));
+        CHECK_EQUAL(std::string(buffer), "third");
+    }
+
+    close(fd);
+}
+
+TEST(EncryptedFile_GcmCounterDoesNotWrapAround)
+{
+    TEST_PATH(path);
+
+    char data[4096] = "same data";
+    int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    init_encryption_format(fd, File::encryption_AesGcm);
+    char first_block[4096];
+    {
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        cryptor.write(fd, 0, data, sizeof(data));
+        CHECK_EQUAL(pread(fd, first_block, sizeof(first_block), 8192), ssize_t(sizeof(first_block)));
+    }
+
+    // Pretend that the block has been rewritten almost 2^32 times
+    uint32_t counter[2] = {0xfffffffe, 0};
+    CHECK_EQUAL(pwrite(fd, counter, sizeof(counter), 4096), ssize_t(sizeof(counter)));
+
+    for (uint64_t expected : {uint64_t(0xffffffff), uint64_t(1) << 32, (uint64_t(1) << 32) + 1}) {
+        {
+            AESCryptor cryptor(test_key, File::encryption_AesGcm);
+            cryptor.set_file_size(16);
+            cryptor.write(fd, 0, data, sizeof(data));
+        }
+        CHECK_EQUAL(pread(fd, counter, sizeof(counter), 4096), ssize_t(sizeof(counter)));
+        CHECK_EQUAL(counter[0] | uint64_t(counter[1]) << 32, expected);
+
+        // The same data under the first IV of the block would give the same
+        // ciphertext if the nonce was reused
+        char block[4096];
+        CHECK_EQUAL(pread(fd, block, sizeof(block), 8192), ssize_t(sizeof(block)));
+        CHECK(memcmp(block, first_block, sizeof(block)) != 0);
+
+        AESCryptor cryptor(test_key, File::encryption_AesGcm);
+        cryptor.set_file_size(16);
+        char buffer[4096];
+        CHECK(cryptor.read(fd, 0, buffer, sizeof(buffer)));
+        CHECK_EQUAL(std::string(buffer), "same data");
+    }
+
+    close(fd);
+}
+
+TEST(EncryptedFile_BudgetGovernor)
+{
+    const size_t ps = page_size();
+    BudgetPageReclaimGovernor governor(100 * ps);
+    CHECK_EQUAL(governor.current_target_getter(0)(), int64_t(100 * ps));
+    // Below the budget the governor is as gentle as the default one
+    CHECK_EQUAL(governor.get_work_limit(40, 100), 0);
+    // Above the budget everything in excess may be reclaimed in one run
+    CHECK_GREATER_EQUAL(governor.get_work_limit(150, 100), 50);
+    governor.set_budget(10 * ps);
+    CHECK_EQUAL(governor.get_budget(), 10 * ps);
+
+    TEST_PATH(path);
+    const size_t num_pages = 64;
+    const size_t size = num_pages * ps;
+    const char* key = reinterpret_cast<const char*>(test_key);
+    {
+        File f(path, File::mode_Write);
+        f.set_encryption_key(key);
+        f.resize(size);
+        File::Map<char> map(f, File::access_ReadWrite, size);
+        encryption_read_barrier(map, 0, size);
+        for (size_t i = 0; i < size; ++i)
+            map.get_addr()[i] = char(i);
+        encryption_write_barrier(map, 0, size);
+    }
+
+    File f(path, File::mode_Read);
+    f.set_encryption_key(key);
+    File::Map<char> map(f, File::access_ReadOnly, size);
+    auto num_decrypted = [&] {
+        LockGuard lock(mapping_mutex);
+        return map.get_encrypted_mapping()->collect_decryption_count();
+    };
+
+    // Pages must be decrypted on first access, although pages decrypted
+    // ahead of a sequential read count as hits. Subsequent accesses are hits.
+    auto stats = get_decrypted_memory_stats();
+    encryption_read_barrier(map, 0, size);
+    auto stats_2 = get_decrypted_memory_stats();
+    CHECK_GREATER(stats_2.page_misses - stats.page_misses, 0);
+    CHECK_GREATER_EQUAL(stats_2.page_misses - stats.page_misses + stats_2.page_hits - stats.page_hits, num_pages);
+    encryption_read_barrier(map, 0, size);
+    auto stats_3 = get_decrypted_memory_stats();
+    CHECK_GREATER_EQUAL(stats_3.page_hits - stats_2.page_hits, num_pages);
+    CHECK_EQUAL(num_decrypted(), num_pages);
+
+    // A reader which starts and ends lets the reclaimer release pages
+    // decrypted before it started
+    SharedFileInfo* info = get_file_info_for_file(f);
+    encryption_note_reader_start(*info, this);
+    encryption_note_reader_end(*info, this);
+
+    // The first pass clears the access bits, and the next one can release
+    // the pages. Pages of other files count towards the budget as well, so
+    // allow for a few more passes.
+    for (int i = 0; i < 10 && num_decrypted() > 10; ++i)
+        reclaim_decrypted_pages(governor);
+    CHECK_LESS_EQUAL(num_decrypted(), 10);
+
+    // Pages which were released are decrypted again when accessed
+    encryption_read_barrier(map, 0, size);
+    for (size_t i = 0; i < size; ++i) {
+        if (map.get_addr()[i] != char(i)) {
+            CHECK_EQUAL(int(map.get_addr()[i]), int(char(i)));
+            break;
+        }
+    }
+}
+
 #endif // REALM_ENABLE_ENCRYPTION
 #endif // TEST_ENCRYPTED_FILE_MAPPING
@@ -148,6 +148,41 @@ TEST(File_Map)
 }
 
 
+TEST(File_MapAdvise)
+{
+    TEST_PATH(path);
+    const size_t count = 4096 / sizeof(size_t) * 16;
+    {
+        File f(path, File::mode_Write);
+        f.set_encryption_key(crypt_key());
+        f.resize(count * sizeof(size_t));
+
+        File::Map<size_t> map(f, File::access_ReadWrite, count * sizeof(size_t));
+        map.advise(File::advice_Sequential);
+        realm::util::encryption_read_barrier(map, 0, count);
+        for (size_t i = 0; i < count; ++i)
+            map.get_addr()[i] = i;
+        realm::util::encryption_write_barrier(map, 0, count);
+    }
+    {
+        File f(path, File::mode_Read);
+        f.set_encryption_key(crypt_key());
+        File::Map<size_t> map(f, File::access_ReadOnly, count * sizeof(size_t));
+        map.advise(File::advice_WillNeed);
+        // Ranges passed to advise_map() need not be page aligned
+        File::advise_map(map.get_addr() + 3, sizeof(size_t) * 1000, File::advice_WillNeed);
+        map.advise(File::advice_Random);
+        map.advise(File::advice_Normal);
+        realm::util::encryption_read_barrier(map, 0, count);
+        for (size_t i = 0; i < count; ++i) {
+            CHECK_EQUAL(map.get_addr()[i], i);
+            if (map.get_addr()[i] != i)
+                return;
+        }
+    }
+}
+
+
 TEST(File_MapMultiplePages)
 {
     // two blocks of IV tables
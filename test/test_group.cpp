@@ -2076,4 +2076,57 @@ TEST(Group_UniqueColumnKeys)
     CHECK_NOT_EQUAL(col_foo, col_bar);
 }
 
+TEST(Group_SchemaHash)
+{
+    Group g;
+    uint64_t empty_hash = g.compute_schema_hash();
+    CHECK_EQUAL(empty_hash, Group().compute_schema_hash());
+
+    auto foo = g.add_table("foo");
+    uint64_t hash = g.compute_schema_hash();
+    CHECK_NOT_EQUAL(hash, empty_hash);
+
+    auto col_int = foo->add_column(type_Int, "ints");
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+    hash = g.compute_schema_hash();
+
+    // Modifying data does not change the hash
+    auto obj = foo->create_object().set(col_int, 5);
+    foo->create_object().set(col_int, 7);
+    CHECK_EQUAL(g.compute_schema_hash(), hash);
+    obj.remove();
+    CHECK_EQUAL(g.compute_schema_hash(), hash);
+
+    foo->add_search_index(col_int);
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+    hash = g.compute_schema_hash();
+
+    foo->rename_column(col_int, "integers");
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+    hash = g.compute_schema_hash();
+
+    auto bar = g.add_table("bar");
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+    hash = g.compute_schema_hash();
+
+    auto col_link = foo->add_column_link(type_Link, "link", *bar);
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+    hash = g.compute_schema_hash();
+
+    // Tables with the same structure in a different group hash the same
+    Group g2;
+    auto foo2 = g2.add_table("foo");
+    auto bar2 = g2.add_table("bar");
+    auto col_int2 = foo2->add_column(type_Int, "integers");
+    foo2->add_search_index(col_int2);
+    foo2->add_column_link(type_Link, "link", *bar2);
+    CHECK_EQUAL(g2.compute_schema_hash(), hash);
+
+    foo->remove_column(col_link);
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+    hash = g.compute_schema_hash();
+    g.remove_table("bar");
+    CHECK_NOT_EQUAL(g.compute_schema_hash(), hash);
+}
+
 #endif // TEST_GROUP
@@ -353,6 +353,26 @@ TEST(Compression_Allocate_And_Compress_Small)
     allocate_and_compress_decompress_compare(test_context, uncompressed_size, content.get());
 }
 
+// This test checks that allocate_and_compress sizes the output buffer up front
+// for data that does not compress, rather than growing it by doubling (which
+// would entail compressing the data once per doubling).
+TEST(Compression_Allocate_And_Compress_Non_Compressible)
+{
+    size_t uncompressed_size = size_t(1) << 20;
+
+    const std::unique_ptr<char[]> content = generate_non_compressible_data(uncompressed_size);
+
+    BinaryData uncompressed_bd{content.get(), uncompressed_size};
+    std::vector<char> compressed_buf;
+    compression::CompressMemoryArena compress_memory_arena;
+    size_t compressed_size =
+        compression::allocate_and_compress(compress_memory_arena, uncompressed_bd, compressed_buf);
+    CHECK_GREATER(compressed_size, uncompressed_size);
+    CHECK_LESS(compressed_buf.size(), uncompressed_size + uncompressed_size / 100);
+
+    allocate_and_compress_decompress_compare(test_context, uncompressed_size, content.get());
+}
+
 // This test checks the allocate_and_compress wrapper around the compression
 // function for data of size larger than 4GB.
 TEST_IF(Compression_Allocate_And_Compress_Large, false)
@@ -364,6 +384,66 @@ TEST_IF(Compression_Allocate_And_Compress_Large, false)
     allocate_and_compress_decompress_compare(test_context, size_t(uncompressed_size), content.get());
 }
 
+// This test checks that each available codec compresses and decompresses
+// both compressible and non-compressible data, that compressible data gets
+// smaller, and that data compressed by one codec is rejected by another one.
+TEST(Compression_Codecs)
+{
+    using Codec = compression::Codec;
+    CHECK(compression::is_codec_available(Codec::zlib));
+    CHECK_NOT(compression::is_codec_available(Codec::none));
+    CHECK(compression::find_codec("zlib") == Codec::zlib);
+    CHECK_NOT(compression::find_codec("none"));
+    CHECK_NOT(compression::find_codec("brotli"));
+
+    size_t uncompressed_size = size_t(1) << 20;
+    const std::unique_ptr<char[]> compressible = generate_compressible_data(uncompressed_size);
+    const std::unique_ptr<char[]> non_compressible = generate_non_compressible_data(uncompressed_size);
+    auto decompressed_buf = std::make_unique<char[]>(uncompressed_size);
+
+    for (Codec codec : {Codec::zlib, Codec::lz4, Codec::zstd}) {
+        const char* name = compression::get_codec_name(codec);
+        if (!compression::is_codec_available(codec)) {
+            CHECK_NOT(compression::find_codec(name));
+            CHECK(compression::get_fast_codec_names().find(name) == std::string::npos);
+            continue;
+        }
+        CHECK(compression::find_codec(name) == codec);
+        if (codec != Codec::zlib)
+            CHECK(compression::get_fast_codec_names().find(name) != std::string::npos);
+
+        for (const char* uncompressed_buf : {compressible.get(), non_compressible.get()}) {
+            BinaryData uncompressed_bd{uncompressed_buf, uncompressed_size};
+            std::vector<char> compressed_buf;
+            compression::CompressMemoryArena compress_memory_arena;
+            size_t compressed_size =
+                compression::allocate_and_compress(compress_memory_arena, uncompressed_bd, compressed_buf, codec);
+            if (uncompressed_buf == compressible.get())
+                CHECK_LESS(compressed_size, uncompressed_size / 10);
+
+            std::error_code ec = compression::decompress(codec, compressed_buf.data(), compressed_size,
+                                                         decompressed_buf.get(), uncompressed_size);
+            CHECK_NOT(ec);
+            CHECK(std::equal(uncompressed_buf, uncompressed_buf + uncompressed_size, decompressed_buf.get()));
+
+            // The expected size is part of the message header, so it must be
+            // verified
+            ec = compression::decompress(codec, compressed_buf.data(), compressed_size, decompressed_buf.get(),
+                                         uncompressed_size - 1);
+            CHECK(ec);
+
+            Codec other_codec = (codec == Codec::zlib ? Codec::zstd : Codec::zlib);
+            ec = compression::decompress(other_codec, compressed_buf.data(), compressed_size,
+                                         decompressed_buf.get(), uncompressed_size);
+            CHECK(ec);
+        }
+    }
+
+    std::error_code ec =
+        compression::decompress(Codec(7), non_compressible.get(), 16, decompressed_buf.get(), uncompressed_size);
+    CHECK(ec == compression::error::unsupported_codec);
+}
+
 TEST(Compression_File_1)
 {
     TEST_DIR(dir);
@@ -30,6 +30,7 @@ TEST(ServerDir_InvalidVirtualPath)
         "/db.realm",
         "/abc/db.realm.lock",
         "/abc/db.realm.management",
+        "/abc/db.realm.state",
         " ",
         "/ abc",
         "/abc/*",
@@ -4374,6 +4374,39 @@ TEST(Query_FindWithDescriptorOrdering)
     }
 }
 
+TEST(Query_SortWithLimitMatchesFullSort)
+{
+    // A sort followed by a limit only sorts the entries which are kept. Check
+    // that it picks the same entries in the same order as sorting everything,
+    // including for entries which compare equal.
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    Table table;
+    auto col_int = table.add_column(type_Int, "int");
+    auto col_str = table.add_column(type_String, "str", true);
+    for (size_t i = 0; i < 1000; ++i) {
+        Obj obj = table.create_object().set(col_int, random.draw_int_mod(20));
+        if (random.draw_bool())
+            obj.set(col_str, util::to_string(random.draw_int_mod(5)));
+    }
+
+    for (bool ascending : {true, false}) {
+        DescriptorOrdering full;
+        full.append_sort(SortDescriptor({{col_str}, {col_int}}, {ascending, !ascending}));
+        TableView all = table.where().find_all(full);
+        CHECK_EQUAL(all.size(), 1000);
+
+        for (size_t limit : {0, 1, 7, 100, 999, 1000, 2000}) {
+            DescriptorOrdering limited;
+            limited.append_sort(SortDescriptor({{col_str}, {col_int}}, {ascending, !ascending}));
+            limited.append_limit({limit});
+            TableView tv = table.where().find_all(limited);
+            CHECK_EQUAL(tv.size(), std::min<size_t>(limit, 1000));
+            for (size_t i = 0; i < tv.size(); ++i)
+                CHECK_EQUAL(tv.get_key(i), all.get_key(i));
+        }
+    }
+}
+
 
 TEST(Query_FindWithDescriptorOrderingOverTableviewSync)
 {
@@ -5839,4 +5872,84 @@ TEST(Query_OptimalNode)
     // std::cout << "cnt: " << cnt << " dur3: " << dur3 << " us" << std::endl;
 }
 
+TEST(Query_FilterAndCreateView)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    auto col_int = table->add_column(type_Int, "int");
+    auto col_link = table->add_column_link(type_Link, "link", *table);
+
+    std::vector<ObjKey> keys;
+    table->create_objects(10, keys);
+    for (int i = 0; i < 10; ++i)
+        table->get_object(keys[i]).set(col_int, i).set(col_link, keys[(i + 1) % 10]);
+
+    Query q = table->where().greater(col_int, 4);
+    CHECK_NOT(q.follows_links());
+    CHECK_NOT((table->column<Int>(col_int) > 4).follows_links());
+    CHECK((table->link(col_link).column<Int>(col_int) > 4).follows_links());
+
+    std::vector<ObjKey> candidates = {keys[2], keys[5], keys[9], ObjKey(1000)};
+    q.filter(candidates);
+    CHECK_EQUAL(candidates.size(), 2);
+    CHECK_EQUAL(candidates[0], keys[5]);
+    CHECK_EQUAL(candidates[1], keys[9]);
+
+    std::vector<ObjKey> matches(keys.begin() + 5, keys.end());
+    TableView tv = q.create_view(matches);
+    CHECK(tv.is_in_sync());
+    CHECK_EQUAL(tv.size(), 5);
+    CHECK_EQUAL(tv.get_key(0), keys[5]);
+
+    // The view behaves like one produced by the query once the table changes
+    table->get_object(keys[0]).set(col_int, 10);
+    CHECK_NOT(tv.is_in_sync());
+    tv.sync_if_needed();
+    CHECK_EQUAL(tv.size(), 6);
+    CHECK_EQUAL(tv.get_key(0), keys[0]);
+
+    // A view created with an ordering applies it when synced
+    DescriptorOrdering ordering;
+    ordering.append_sort(SortDescriptor({{col_int}}, {false}));
+    std::vector<ObjKey> sorted = {keys[0], keys[9], keys[8], keys[7], keys[6], keys[5]};
+    tv = q.create_view(sorted, ordering);
+    CHECK(tv.is_in_sync());
+    CHECK_EQUAL(tv.get_key(0), keys[0]);
+    table->get_object(keys[0]).set(col_int, 0);
+    table->get_object(keys[1]).set(col_int, 20);
+    tv.sync_if_needed();
+    CHECK_EQUAL(tv.size(), 6);
+    CHECK_EQUAL(tv.get_key(0), keys[1]);
+    CHECK_EQUAL(tv.get_key(1), keys[9]);
+    CHECK_EQUAL(tv.get_key(5), keys[5]);
+}
+
+TEST(Query_DescriptionOfFloatingPointValues)
+{
+    Table table;
+    auto col_double = table.add_column(type_Double, "double");
+    auto col_float = table.add_column(type_Float, "float");
+    auto col_mixed = table.add_column(type_Mixed, "mixed");
+
+    // Values which need more than the default six digits are only told apart
+    // when exact floating point values are requested
+    auto describe_exactly = [](Query q) {
+        util::serializer::SerialisationState state;
+        state.exact_floating_point = true;
+        return q.get_description(state);
+    };
+    CHECK_EQUAL(table.where().equal(col_double, 1.0000001).get_description(),
+                table.where().equal(col_double, 1.0000002).get_description());
+    CHECK_NOT_EQUAL(describe_exactly(table.where().equal(col_double, 1.0000001)),
+                    describe_exactly(table.where().equal(col_double, 1.0000002)));
+    CHECK_NOT_EQUAL(describe_exactly(table.where().equal(col_float, 1.0000001f)),
+                    describe_exactly(table.where().equal(col_float, 1.0000002f)));
+    CHECK_NOT_EQUAL(describe_exactly(table.column<Mixed>(col_mixed) == 1.0000001),
+                    describe_exactly(table.column<Mixed>(col_mixed) == 1.0000002));
+    CHECK_NOT_EQUAL(describe_exactly(table.column<double>(col_double) == 1.0000001),
+                    describe_exactly(table.column<double>(col_double) == 1.0000002));
+    CHECK_EQUAL(table.where().equal(col_double, 0.5).get_description(), "double == 0.5");
+    CHECK_EQUAL(describe_exactly(table.where().equal(col_double, 0.5)), "double == 0.5");
+}
+
 #endif // TEST_QUERY
@@ -583,6 +583,136 @@ TEST(Shared_ReadOverReadAfterCompact)
 }
 
 
+TEST(Shared_CompactIncrementally)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef sg = DB::create(path);
+    ColKey col_int, col_str;
+    {
+        WriteTransaction wt(sg);
+        auto table = wt.add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_str = table->add_column(type_String, "str");
+        std::string str(200, 'x');
+        for (int i = 0; i < 10000; ++i)
+            table->create_object(ObjKey(i)).set(col_int, i).set(col_str, StringData(str));
+        wt.commit();
+    }
+    {
+        // Leave the file with plenty of free space
+        WriteTransaction wt(sg);
+        auto table = wt.get_table("table");
+        for (int i = 100; i < 10000; ++i)
+            table->remove_object(ObjKey(i));
+        wt.commit();
+    }
+    size_t size_before = size_t(File(path).get_size());
+
+    // Readers are not blocked by compaction, and keep seeing their snapshot
+    auto rt = sg->start_read();
+    sg->compact_step(16 * 1024);
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("table")->create_object(ObjKey(100)).set(col_int, 100);
+        wt.commit();
+    }
+    sg->compact_step(16 * 1024);
+    CHECK_EQUAL(rt->get_table("table")->size(), 100);
+    rt->verify();
+    rt = nullptr;
+
+    size_t num_steps = 0;
+    size_t released = 0;
+    bool incomplete = true;
+    DB::IncrementalCompactionConfig config;
+    config.max_relocation_size = 16 * 1024;
+    config.pause_between_steps = std::chrono::milliseconds(0);
+    config.progress_handler = [&](const DB::CompactionProgress& progress) {
+        ++num_steps;
+        released += progress.released_size;
+        incomplete = progress.incomplete;
+        return true;
+    };
+    sg->compact_incrementally(config);
+    CHECK_GREATER(num_steps, 0);
+    CHECK_NOT(incomplete);
+    CHECK_GREATER(released, 0);
+    CHECK_LESS(size_t(File(path).get_size()), size_before);
+
+    auto check = [&](DBRef db) {
+        ReadTransaction rt(db);
+        rt.get_group().verify();
+        auto table = rt.get_table("table");
+        CHECK_EQUAL(table->size(), 101);
+        for (int i = 0; i < 100; ++i) {
+            Obj obj = table->get_object(ObjKey(i));
+            CHECK_EQUAL(obj.get<Int>(col_int), i);
+            CHECK_EQUAL(obj.get<String>(col_str).size(), 200);
+        }
+    };
+    check(sg);
+    sg->close();
+    check(DB::create(path));
+}
+
+
+TEST(Shared_CompactStepInterleavedWithCommits)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBRef sg = DB::create(path);
+    ColKey col_int, col_str;
+    {
+        WriteTransaction wt(sg);
+        auto table = wt.add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_str = table->add_column(type_String, "str");
+        std::string str(200, 'x');
+        for (int i = 0; i < 10000; ++i)
+            table->create_object(ObjKey(i)).set(col_int, i).set(col_str, StringData(str));
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg);
+        auto table = wt.get_table("table");
+        for (int i = 100; i < 10000; ++i)
+            table->remove_object(ObjKey(i));
+        wt.commit();
+    }
+    size_t size_before = size_t(File(path).get_size());
+
+    // Ordinary commits between the steps free and reuse space which earlier
+    // steps may have found to be settled, which must not stop compaction from
+    // relocating what is placed there
+    for (int i = 0; i < 50; ++i) {
+        sg->compact_step(16 * 1024);
+        WriteTransaction wt(sg);
+        auto table = wt.get_table("table");
+        std::string str(200 + i, 'y');
+        for (int j = 0; j < 100; j += 7)
+            table->get_object(ObjKey(j)).set(col_str, StringData(str));
+        wt.commit();
+    }
+
+    int idle_steps = 0;
+    for (int i = 0; i < 1000 && idle_steps < 3; ++i) {
+        auto progress = sg->compact_step(16 * 1024);
+        if (progress.relocated_size == 0 && progress.released_size == 0 && !progress.incomplete)
+            ++idle_steps;
+        else
+            idle_steps = 0;
+    }
+    CHECK_EQUAL(idle_steps, 3);
+    CHECK_LESS(size_t(File(path).get_size()), size_before / 2);
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    auto table = rt.get_table("table");
+    CHECK_EQUAL(table->size(), 100);
+    for (int i = 0; i < 100; ++i)
+        CHECK_EQUAL(table->get_object(ObjKey(i)).get<Int>(col_int), i);
+}
+
+
 TEST(Shared_ReadOverRead2)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -3252,6 +3382,75 @@ TEST_IF(Shared_CompactEncrypt, REALM_ENABLE_ENCRYPTION)
         }
     }
 }
+
+TEST_IF(Shared_CompactEncryptionFormat, REALM_ENABLE_ENCRYPTION)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const char* key = "KdrL2ieWyspILXIPetpkLD6rQYKhYnS6lvGsgk4qsJAMr1adQnKsYo3oTEYJDIfa";
+    auto get_format = [&] {
+        util::File file(path, util::File::mode_Read);
+        file.set_encryption_key(key);
+        return file.get_encryption_format();
+    };
+    auto check_table = [&](DBRef db) {
+        auto rt = db->start_read();
+        ConstTableRef t = rt->get_table("table");
+        CHECK_EQUAL(t->size(), 10000);
+        auto col = t->get_column_key("Strings");
+        size_t i = 0;
+        for (auto& o : *t) {
+            std::string str = "Shared_CompactEncryptionFormat" + util::to_string(i++);
+            CHECK_EQUAL(o.get<String>(col), str);
+        }
+    };
+    {
+        auto db = DB::create(path, false, DBOptions(key));
+        auto tr = db->start_write();
+        TableRef t = tr->add_table("table");
+        auto col = t->add_column(type_String, "Strings");
+        for (size_t i = 0; i < 10000; i++) {
+            std::string str = "Shared_CompactEncryptionFormat" + util::to_string(i);
+            t->create_object().set(col, StringData(str));
+        }
+        tr->commit();
+    }
+    CHECK_EQUAL(get_format(), util::File::encryption_AesCbcHmac);
+
+    // Convert to the AES-GCM format
+    {
+        auto db = DB::create(path, false, DBOptions(key));
+        CHECK(db->compact(false, util::none, util::File::encryption_AesGcm));
+        check_table(db);
+    }
+    CHECK_EQUAL(get_format(), util::File::encryption_AesGcm);
+
+    // The format is kept by a plain compaction, and by modifications
+    {
+        auto db = DB::create(path, false, DBOptions(key));
+        check_table(db);
+        CHECK(db->compact());
+        auto tr = db->start_write();
+        tr->get_table("table")->create_object();
+        tr->commit();
+    }
+    CHECK_EQUAL(get_format(), util::File::encryption_AesGcm);
+
+    // New files can be created in the AES-GCM format directly
+    SHARED_GROUP_TEST_PATH(path_2);
+    {
+        DBOptions options(key);
+        options.encryption_format = util::File::encryption_AesGcm;
+        auto db = DB::create(path_2, false, options);
+        auto tr = db->start_write();
+        tr->add_table("table")->create_object();
+        tr->commit();
+    }
+    {
+        auto db = DB::create(path_2, false, DBOptions(key));
+        auto rt = db->start_read();
+        CHECK_EQUAL(rt->get_table("table")->size(), 1);
+    }
+}
 #endif
 
 // Repro case for: Assertion failed: top_size == 3 || top_size == 5 || top_size == 7 [0, 3, 0, 5, 0, 7]
@@ -999,6 +999,358 @@ TEST(Sync_Replication)
 }
 
 
+// Checks that the server operates correctly when connections and server files
+// are spread across multiple network shards, both with and without SSL. With a
+// single connection shared by all sessions, most sessions are bound to files
+// that are pinned to a different shard than the connection.
+TEST_TYPES(Sync_NetworkShards, std::false_type, std::true_type)
+{
+    constexpr bool with_ssl = TEST_TYPE::value;
+    constexpr int num_files = 3;
+    constexpr int num_objects = 50;
+
+    std::string ca_dir = get_test_resource_path() + "../certificate-authority";
+
+    for (bool one_connection_per_session : {true, false}) {
+        TEST_DIR(server_dir);
+        SHARED_GROUP_TEST_PATH(path_1);
+        SHARED_GROUP_TEST_PATH(path_2);
+        SHARED_GROUP_TEST_PATH(path_3);
+        SHARED_GROUP_TEST_PATH(path_4);
+        SHARED_GROUP_TEST_PATH(path_5);
+        SHARED_GROUP_TEST_PATH(path_6);
+        std::string upload_paths[num_files] = {path_1, path_2, path_3};
+        std::string download_paths[num_files] = {path_4, path_5, path_6};
+
+        ClientServerFixture::Config config;
+        config.server_num_network_shards = 2;
+        config.one_connection_per_session = one_connection_per_session;
+        Session::Config session_config;
+        ProtocolEnvelope envelope = ProtocolEnvelope::realm;
+        if (with_ssl) {
+            config.enable_server_ssl = true;
+            config.server_ssl_certificate_path = ca_dir + "/certs/localhost-chain.crt.pem";
+            config.server_ssl_certificate_key_path = ca_dir + "/certs/localhost-server.key.pem";
+            session_config.protocol_envelope = ProtocolEnvelope::realms;
+            session_config.verify_servers_ssl_certificate = true;
+            session_config.ssl_trust_certificate_path = ca_dir + "/root-ca/crt.pem";
+            envelope = ProtocolEnvelope::realms;
+        }
+        ClientServerFixture fixture{server_dir, test_context, config};
+        fixture.start();
+
+        for (int i = 0; i < num_files; ++i) {
+            std::string server_path = "/test_" + std::to_string(i);
+            std::unique_ptr<Replication> history_1 = make_client_replication(upload_paths[i]);
+            std::unique_ptr<Replication> history_2 = make_client_replication(download_paths[i]);
+            DBRef sg_1 = DB::create(*history_1);
+            DBRef sg_2 = DB::create(*history_2);
+
+            Session session_1 = fixture.make_session(upload_paths[i], session_config);
+            fixture.bind_session(session_1, server_path, g_signed_test_user_token, envelope);
+            Session session_2 = fixture.make_session(download_paths[i], session_config);
+            fixture.bind_session(session_2, server_path, g_signed_test_user_token, envelope);
+
+            {
+                WriteTransaction wt(sg_1);
+                TableRef table = sync::create_table(wt, "class_foo");
+                table->add_column(type_Int, "i");
+                version_type new_version = wt.commit();
+                session_1.nonsync_transact_notify(new_version);
+            }
+            for (int j = 0; j < num_objects; ++j) {
+                WriteTransaction wt(sg_1);
+                TableRef table = wt.get_table("class_foo");
+                table->create_object().set("i", j);
+                version_type new_version = wt.commit();
+                session_1.nonsync_transact_notify(new_version);
+            }
+            session_1.wait_for_upload_complete_or_client_stopped();
+            session_2.wait_for_download_complete_or_client_stopped();
+
+            ReadTransaction rt_1(sg_1);
+            ReadTransaction rt_2(sg_2);
+            CHECK(compare_groups(rt_1, rt_2));
+            ConstTableRef table = rt_2.get_table("class_foo");
+            CHECK(table);
+            if (table)
+                CHECK_EQUAL(num_objects, table->size());
+        }
+    }
+}
+
+
+// Checks that clients and servers agree on a codec for message bodies, and
+// that bodies compressed by it are synchronized correctly, both when the
+// server accepts the faster codecs offered by the client (if this build has
+// any), and when it falls back to zlib.
+TEST(Sync_CompressionCodecs)
+{
+    constexpr int num_objects = 200;
+
+    for (bool disable_fast_compression : {false, true}) {
+        TEST_DIR(server_dir);
+        SHARED_GROUP_TEST_PATH(path_1);
+        SHARED_GROUP_TEST_PATH(path_2);
+
+        ClientServerFixture::Config config;
+        config.disable_fast_compression = disable_fast_compression;
+        ClientServerFixture fixture{server_dir, test_context, config};
+        fixture.start();
+
+        std::unique_ptr<Replication> history_1 = make_client_replication(path_1);
+        std::unique_ptr<Replication> history_2 = make_client_replication(path_2);
+        DBRef sg_1 = DB::create(*history_1);
+        DBRef sg_2 = DB::create(*history_2);
+
+        Session session_1 = fixture.make_bound_session(path_1, "/test");
+        Session session_2 = fixture.make_bound_session(path_2, "/test");
+
+        // Large enough for the bodies of the UPLOAD and DOWNLOAD messages to
+        // be compressed
+        {
+            WriteTransaction wt(sg_1);
+            TableRef table = sync::create_table(wt, "class_foo");
+            auto col_i = table->add_column(type_Int, "i");
+            auto col_s = table->add_column(type_String, "s");
+            for (int i = 0; i < num_objects; ++i) {
+                std::string text = "Some text that compresses well " + std::to_string(i % 10);
+                table->create_object().set(col_i, i).set(col_s, StringData(text));
+            }
+            version_type new_version = wt.commit();
+            session_1.nonsync_transact_notify(new_version);
+        }
+        session_1.wait_for_upload_complete_or_client_stopped();
+        session_2.wait_for_download_complete_or_client_stopped();
+
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        CHECK(compare_groups(rt_1, rt_2));
+        ConstTableRef table = rt_2.get_table("class_foo");
+        CHECK(table);
+        if (table)
+            CHECK_EQUAL(num_objects, table->size());
+    }
+}
+
+
+// Checks that changesets uploaded to many server files are integrated
+// correctly when the files are spread across multiple integration workers.
+TEST(Sync_IntegrationWorkers)
+{
+    constexpr int num_files = 6;
+    constexpr int num_transactions = 20;
+    constexpr int num_workers = 3;
+
+    TEST_DIR(server_dir);
+    MockMetrics metrics;
+    ClientServerFixture::Config config;
+    config.server_metrics = &metrics;
+    config.server_num_integration_workers = num_workers;
+    ClientServerFixture fixture{server_dir, test_context, config};
+    fixture.start();
+
+    std::vector<std::unique_ptr<DBTestPathGuard>> upload_paths, download_paths;
+    std::vector<std::unique_ptr<Replication>> histories;
+    std::vector<DBRef> upload_dbs, download_dbs;
+    std::vector<Session> upload_sessions, download_sessions;
+    for (int i = 0; i < num_files; ++i) {
+        std::string server_path = "/test_" + std::to_string(i);
+        std::string suffix = "." + std::to_string(i);
+        upload_paths.push_back(std::make_unique<DBTestPathGuard>(
+            get_test_path(test_context.get_test_name(), ".upload" + suffix + ".realm")));
+        download_paths.push_back(std::make_unique<DBTestPathGuard>(
+            get_test_path(test_context.get_test_name(), ".download" + suffix + ".realm")));
+        histories.push_back(make_client_replication(*upload_paths.back()));
+        upload_dbs.push_back(DB::create(*histories.back()));
+        histories.push_back(make_client_replication(*download_paths.back()));
+        download_dbs.push_back(DB::create(*histories.back()));
+        upload_sessions.push_back(fixture.make_bound_session(*upload_paths.back(), server_path));
+        download_sessions.push_back(fixture.make_bound_session(*download_paths.back(), server_path));
+    }
+
+    // Interleave the transactions, such that all files have pending work at
+    // the same time.
+    for (int i = 0; i < num_files; ++i) {
+        WriteTransaction wt(upload_dbs[i]);
+        TableRef table = sync::create_table(wt, "class_foo");
+        table->add_column(type_Int, "i");
+        upload_sessions[i].nonsync_transact_notify(wt.commit());
+    }
+    for (int j = 0; j < num_transactions; ++j) {
+        for (int i = 0; i < num_files; ++i) {
+            WriteTransaction wt(upload_dbs[i]);
+            wt.get_table("class_foo")->create_object().set("i", j);
+            upload_sessions[i].nonsync_transact_notify(wt.commit());
+        }
+    }
+
+    for (int i = 0; i < num_files; ++i) {
+        upload_sessions[i].wait_for_upload_complete_or_client_stopped();
+        download_sessions[i].wait_for_download_complete_or_client_stopped();
+        ReadTransaction rt_1(upload_dbs[i]);
+        ReadTransaction rt_2(download_dbs[i]);
+        CHECK(compare_groups(rt_1, rt_2));
+        ConstTableRef table = rt_2.get_table("class_foo");
+        CHECK(table);
+        if (table)
+            CHECK_EQUAL(num_transactions, table->size());
+    }
+
+    // Work unit queue metrics are reported per worker, not per server file
+    std::size_t num_queue_time_metrics = 0;
+    for (int i = 0; i < num_workers; ++i) {
+        std::string tag = ",worker=" + std::to_string(i + 1);
+        num_queue_time_metrics += metrics.count_equal(("workunit.queue.time" + tag).c_str());
+        CHECK_EQUAL(metrics.count_equal(("workunit.queue.time" + tag).c_str()),
+                    metrics.count_equal(("workunit.queue.length" + tag).c_str()));
+    }
+    CHECK_GREATER(num_queue_time_metrics, 0);
+    CHECK_EQUAL(0, metrics.count_equal("workunit.queue.time"));
+    std::string file_tag = ",realm=" + sync::Metrics::percent_encode("/test_0");
+    CHECK_EQUAL(0, metrics.count_equal(("workunit.queue.length" + file_tag).c_str()));
+}
+
+
+// Checks that clients bootstrapping from the same server file in steps of
+// several DOWNLOAD messages are served from the shared download cache, and
+// that they end up with the right contents.
+TEST(Sync_DownloadCache)
+{
+    constexpr int num_transactions = 20;
+
+    TEST_DIR(server_dir);
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+    SHARED_GROUP_TEST_PATH(path_3);
+    MockMetrics metrics;
+    ClientServerFixture::Config config;
+    config.server_metrics = &metrics;
+    config.max_download_size = 4096;
+    ClientServerFixture fixture{server_dir, test_context, config};
+    fixture.start();
+
+    std::unique_ptr<Replication> history_1 = make_client_replication(path_1);
+    DBRef sg_1 = DB::create(*history_1);
+    {
+        Session session = fixture.make_bound_session(path_1, "/test");
+        {
+            WriteTransaction wt(sg_1);
+            TableRef table = sync::create_table(wt, "class_foo");
+            table->add_column(type_String, "s");
+            session.nonsync_transact_notify(wt.commit());
+        }
+        std::string str(1024, 'x');
+        for (int i = 0; i < num_transactions; ++i) {
+            WriteTransaction wt(sg_1);
+            wt.get_table("class_foo")->create_object().set("s", StringData(str));
+            session.nonsync_transact_notify(wt.commit());
+        }
+        session.wait_for_upload_complete_or_client_stopped();
+    }
+
+    auto bootstrap = [&](const std::string& path) {
+        std::unique_ptr<Replication> history = make_client_replication(path);
+        DBRef sg = DB::create(*history);
+        {
+            Session session = fixture.make_bound_session(path, "/test");
+            session.wait_for_download_complete_or_client_stopped();
+        }
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg);
+        CHECK(compare_groups(rt_1, rt_2));
+    };
+
+    double num_misses_1 = metrics.sum_equal("download.cache.miss");
+    bootstrap(path_2);
+    double num_misses_2 = metrics.sum_equal("download.cache.miss");
+    CHECK_GREATER(num_misses_2 - num_misses_1, 1);
+    CHECK_EQUAL(0, metrics.sum_equal("download.cache.hit"));
+
+    // The second client traverses the history in the same steps as the first
+    // one.
+    bootstrap(path_3);
+    CHECK_EQUAL(num_misses_2 - num_misses_1, metrics.sum_equal("download.cache.hit"));
+    CHECK_EQUAL(num_misses_2, metrics.sum_equal("download.cache.miss"));
+}
+
+
+// Checks that clients which have uploaded changesets before share the
+// download cache when they reconnect, as long as none of their own changesets
+// are in the downloaded range.
+TEST(Sync_DownloadCacheAfterUpload)
+{
+    constexpr int num_transactions = 20;
+
+    TEST_DIR(server_dir);
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+    SHARED_GROUP_TEST_PATH(path_3);
+    MockMetrics metrics;
+    ClientServerFixture::Config config;
+    config.server_metrics = &metrics;
+    config.max_download_size = 4096;
+    ClientServerFixture fixture{server_dir, test_context, config};
+    fixture.start();
+
+    std::unique_ptr<Replication> history_1 = make_client_replication(path_1);
+    std::unique_ptr<Replication> history_2 = make_client_replication(path_2);
+    std::unique_ptr<Replication> history_3 = make_client_replication(path_3);
+    DBRef sg_1 = DB::create(*history_1);
+    DBRef sg_2 = DB::create(*history_2);
+    DBRef sg_3 = DB::create(*history_3);
+
+    auto synchronize = [&](const std::string& path) {
+        Session session = fixture.make_bound_session(path, "/test");
+        session.wait_for_upload_complete_or_client_stopped();
+        session.wait_for_download_complete_or_client_stopped();
+    };
+
+    // Both clients upload a changeset produced at the same client version, and
+    // end up at the same download progress
+    for (DBRef sg : {sg_1, sg_2}) {
+        WriteTransaction wt(sg);
+        TableRef table = sync::create_table(wt, "class_foo");
+        table->add_column(type_String, "s");
+        wt.commit();
+    }
+    synchronize(path_1);
+    synchronize(path_2);
+    synchronize(path_1);
+
+    {
+        Session session = fixture.make_bound_session(path_3, "/test");
+        session.wait_for_download_complete_or_client_stopped();
+        std::string str(1024, 'x');
+        for (int i = 0; i < num_transactions; ++i) {
+            WriteTransaction wt(sg_3);
+            wt.get_table("class_foo")->create_object().set("s", StringData(str));
+            session.nonsync_transact_notify(wt.commit());
+        }
+        session.wait_for_upload_complete_or_client_stopped();
+    }
+
+    double num_hits_1 = metrics.sum_equal("download.cache.hit");
+    double num_misses_1 = metrics.sum_equal("download.cache.miss");
+    synchronize(path_1);
+    double num_misses_2 = metrics.sum_equal("download.cache.miss");
+    CHECK_GREATER(num_misses_2 - num_misses_1, 1);
+    CHECK_EQUAL(num_hits_1, metrics.sum_equal("download.cache.hit"));
+
+    // The second client traverses the new changesets in the same steps as the
+    // first one
+    synchronize(path_2);
+    CHECK_EQUAL(num_misses_2 - num_misses_1, metrics.sum_equal("download.cache.hit") - num_hits_1);
+
+    ReadTransaction rt_1(sg_1);
+    ReadTransaction rt_2(sg_2);
+    ReadTransaction rt_3(sg_3);
+    CHECK(compare_groups(rt_1, rt_3));
+    CHECK(compare_groups(rt_2, rt_3));
+    CHECK_EQUAL(num_transactions, rt_2.get_table("class_foo")->size());
+}
+
+
 TEST(Sync_Merge)
 {
 
@@ -5614,4 +5614,78 @@ TEST(Table_IndexOnMixed)
     CHECK_EQUAL(foos->find_first<Mixed>(col, UUID("3b241101-e2bb-4255-8caf-4136c566a962")), k10);
 }
 
+TEST(Table_Prefetch)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    options.prefetch_on_open = true;
+    ColKey col_int, col_str, col_list;
+    {
+        DBRef db = DB::create(path, false, options);
+        WriteTransaction wt(db);
+        auto table = wt.add_table("table");
+        col_int = table->add_column(type_Int, "int");
+        col_str = table->add_column(type_String, "str");
+        col_list = table->add_column_list(type_Int, "list");
+        for (int64_t i = 0; i < 10000; ++i) {
+            auto obj = table->create_object().set(col_int, i).set(col_str, std::string(i % 100, 'x'));
+            obj.get_list<Int>(col_list).add(i);
+        }
+        wt.commit();
+    }
+
+    DBRef db = DB::create(path, false, options);
+    auto rt = db->start_read();
+    ConstTableRef table = rt->get_table("table");
+
+    // Prefetching only affects when the data is read from the file
+    table->prefetch();
+    table->prefetch({col_str});
+    CHECK_THROW(table->prefetch({ColKey()}), LogicError);
+
+    Query q = table->where().greater(col_int, 4999).Or().equal(col_str, "xx");
+    q.prefetch();
+    CHECK_EQUAL(q.count(), 5050);
+    table->where().prefetch();
+    Query expr = table->column<Int>(col_int) > 4999 || table->column<Lst<Int>>(col_list).size() == 0;
+    expr.prefetch();
+    CHECK_EQUAL(expr.count(), 5000);
+
+    size_t list_size = 0;
+    for (auto& obj : *table)
+        list_size += obj.get_list<Int>(col_list).size();
+    CHECK_EQUAL(list_size, 10000);
+}
+
+TEST(Table_AccessAdvice)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    DBOptions options(crypt_key());
+    ColKey col_pk, col_str;
+    {
+        // The advice must also be given for the mappings added while the file grows
+        options.access_advice = util::File::advice_Sequential;
+        DBRef db = DB::create(path, false, options);
+        for (int64_t i = 0; i < 10; ++i) {
+            WriteTransaction wt(db);
+            auto table = i == 0 ? wt.get_group().add_table_with_primary_key("table", type_Int, "pk") : wt.get_table("table");
+            col_pk = table->get_primary_key_column();
+            if (i == 0)
+                col_str = table->add_column(type_String, "str");
+            for (int64_t j = 0; j < 1000; ++j)
+                table->create_object_with_primary_key(i * 1000 + j).set(col_str, std::string(j % 100, 'x'));
+            wt.commit();
+        }
+        auto rt = db->start_read();
+        CHECK_EQUAL(rt->get_table("table")->where().equal(col_str, "xx").count(), 100);
+    }
+
+    options.access_advice = util::File::advice_Random;
+    DBRef db = DB::create(path, false, options);
+    auto rt = db->start_read();
+    ConstTableRef table = rt->get_table("table");
+    for (int64_t i = 0; i < 10000; i += 97)
+        CHECK_EQUAL(table->get_object_with_primary_key(i).get<String>(col_str).size(), size_t(i % 1000 % 100));
+}
+
 #endif // TEST_TABLE
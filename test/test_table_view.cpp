@@ -26,6 +26,7 @@
 #include <cwchar>
 
 #include <realm.hpp>
+#include <realm/history.hpp>
 
 #include "util/misc.hpp"
 
@@ -2884,6 +2885,66 @@ TEST(TableView_Copy)
     CHECK_EQUAL(k2, copy_2.get_key(0));
 }
 
+TEST(TableView_CopyFrozen)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col_id;
+    {
+        auto wt = db->start_write();
+        auto table = wt->add_table("table");
+        col_id = table->add_column(type_Int, "id");
+        for (int i = 0; i < 1000; ++i)
+            table->create_object().set(col_id, i % 10);
+        wt->commit();
+    }
+
+    auto frozen = db->start_frozen();
+    auto table = frozen->get_table("table");
+    auto tv = std::make_unique<TableView>((table->column<Int>(col_id) > 4).find_all());
+    CHECK_EQUAL(500, tv->size());
+    std::vector<ObjKey> expected;
+    for (size_t i = 0; i < tv->size(); ++i)
+        expected.push_back(tv->get_key(i));
+
+    auto check_keys = [&](const ConstTableView& view) {
+        CHECK_EQUAL(expected.size(), view.size());
+        for (size_t i = 0; i < view.size(); ++i)
+            CHECK_EQUAL(expected[i], view.get_key(i));
+    };
+
+    // Copies, and imports into another frozen transaction at the same version
+    // share the keys of the original view
+    TableView copy_1(*tv);
+    TableView copy_2;
+    copy_2 = *tv;
+    auto frozen_2 = db->start_frozen(frozen->get_version_of_current_transaction());
+    auto imported = frozen_2->import_copy_of(*tv, PayloadPolicy::Copy);
+    CHECK_EQUAL(frozen_2->get_table("table"), imported->get_parent());
+    check_keys(copy_1);
+    check_keys(copy_2);
+    check_keys(*imported);
+
+    // The shared keys outlive the view they were created by
+    tv.reset();
+    check_keys(copy_1);
+    check_keys(*imported);
+
+    // Modifying one of the copies does not affect the others
+    copy_1.sort(col_id, false);
+    CHECK_EQUAL(9, copy_1.get_object(0).get<Int>(col_id));
+    CHECK_EQUAL(5, copy_1.get_object(499).get<Int>(col_id));
+    check_keys(copy_2);
+    check_keys(*imported);
+
+    TableView moved(std::move(copy_2));
+    check_keys(moved);
+    moved.distinct(col_id);
+    CHECK_EQUAL(5, moved.size());
+    check_keys(*imported);
+}
+
 TEST(TableView_RemoveColumnsAfterSort)
 {
     Table table;
@@ -27,6 +27,13 @@
 #include <iomanip>
 #include <thread>
 
+// Need fork() and waitpid() for Transactions_NonDurableCommitsOfDeadWriter
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 #include <realm/history.hpp>
 #include <realm/util/file.hpp>
 #include <realm/db.hpp>
@@ -487,6 +494,152 @@ TEST(Transactions_ObjectLifetime)
     CHECK_NOT(obj.is_valid());
 }
 
+TEST(Transactions_CommitAndContinueWritingWithoutSync)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    DBRef db = DB::create(*hist_w);
+
+    // The file header is only updated by durable commits, so this shows what
+    // would be left after a crash
+    auto size_on_disk = [&] {
+        Group g(path);
+        auto table = g.get_table("t0");
+        return table ? table->size() : size_t(-1);
+    };
+
+    TransactionRef tr = db->start_write();
+    auto table = tr->add_table("t0");
+    auto col = table->add_column(type_Int, "integers");
+    auto version = tr->commit_and_continue_writing(false);
+    CHECK_EQUAL(tr->get_version(), version);
+    CHECK_EQUAL(size_on_disk(), size_t(-1));
+
+    table->create_object().set(col, 1);
+    tr->commit_and_continue_writing(false);
+    table->create_object().set(col, 2);
+    tr->commit_and_continue_writing(false);
+    CHECK_EQUAL(size_on_disk(), size_t(-1));
+
+    // Non-durable commits are visible to readers
+    {
+        auto rt = db->start_read();
+        CHECK_EQUAL(rt->get_table("t0")->size(), 2);
+    }
+
+    // A durable commit makes all of them durable
+    table->create_object().set(col, 3);
+    tr->commit_and_continue_writing();
+    CHECK_EQUAL(size_on_disk(), 3);
+
+    // The data of the durable version is not overwritten by non-durable
+    // commits, even though nothing else is reading it
+    for (int i = 0; i < 50; ++i) {
+        for (auto& obj : *table)
+            obj.set(col, obj.get<int64_t>(col) + 10);
+        tr->commit_and_continue_writing(false);
+    }
+    {
+        Group g(path);
+        g.verify();
+        int64_t sum = 0;
+        for (auto& obj : *g.get_table("t0"))
+            sum += obj.get<int64_t>(col);
+        CHECK_EQUAL(sum, 6);
+    }
+    for (auto& obj : *table)
+        obj.set(col, obj.get<int64_t>(col) - 500);
+    tr->commit_and_continue_writing();
+
+    // Rolling back discards the changes since the last commit, and makes the
+    // earlier commits durable
+    table->create_object().set(col, 4);
+    tr->commit_and_continue_writing(false);
+    table->create_object().set(col, 5);
+    CHECK_EQUAL(size_on_disk(), 3);
+    tr->rollback_and_continue_as_read();
+    CHECK_EQUAL(tr->get_table("t0")->size(), 4);
+    CHECK_EQUAL(size_on_disk(), 4);
+
+    tr->promote_to_write();
+    table = tr->get_table("t0");
+    for (int i = 0; i < 10; ++i) {
+        table->create_object().set(col, i);
+        tr->commit_and_continue_writing(false);
+    }
+    tr->commit();
+    CHECK_EQUAL(size_on_disk(), 14);
+
+    tr = db->start_write();
+    tr->get_table("t0")->clear();
+    tr->commit_and_continue_writing(false);
+    tr->close();
+    CHECK_EQUAL(size_on_disk(), 0);
+
+    tr = db->start_read();
+    tr->verify();
+}
+
+#if !defined(_WIN32) && !REALM_ANDROID
+TEST(Transactions_NonDurableCommitsOfDeadWriter)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    DBRef db = DB::create(*hist);
+    ColKey col;
+    {
+        auto wt = db->start_write();
+        col = wt->add_table("t0")->add_column(type_Int, "integers");
+        wt->commit();
+    }
+
+    auto size_on_disk = [&] {
+        Group g(path);
+        return g.get_table("t0")->size();
+    };
+
+    pid_t pid = fork();
+    if (pid == pid_t(-1))
+        REALM_TERMINATE("fork() failed");
+    if (pid == 0) {
+        // Child
+        std::unique_ptr<Replication> hist_c(make_in_realm_history(path));
+        DBRef db_c = DB::create(*hist_c);
+        auto wt = db_c->start_write();
+        auto table = wt->get_table("t0");
+        for (int i = 0; i < 5; ++i) {
+            table->create_object().set(col, i);
+            wt->commit_and_continue_writing(false);
+        }
+        _Exit(42); // Die with non-durable commits and an active write transaction
+    }
+
+    int stat_loc = 0;
+    pid = waitpid(pid, &stat_loc, 0);
+    if (pid == pid_t(-1))
+        REALM_TERMINATE("waitpid() failed");
+    CHECK(WIFEXITED(stat_loc));
+    CHECK_EQUAL(42, WEXITSTATUS(stat_loc));
+
+    // The commits are visible to readers, but haven't been synced
+    CHECK_EQUAL(db->start_read()->get_table("t0")->size(), 5);
+    CHECK_EQUAL(size_on_disk(), 0);
+
+    // The next writer makes them durable before it writes anything itself, as
+    // the dead writer's pages were never protected by this process
+    auto wt = db->start_write();
+    CHECK_EQUAL(size_on_disk(), 5);
+    wt->get_table("t0")->create_object().set(col, 5);
+    wt->commit_and_continue_writing(false);
+    wt->rollback();
+    CHECK_EQUAL(size_on_disk(), 6);
+
+    auto rt = db->start_read();
+    rt->verify();
+    CHECK_EQUAL(rt->get_table("t0")->size(), 6);
+}
+#endif
+
 TEST(Transactions_Continuous_ParallelWrites)
 {
     SHARED_GROUP_TEST_PATH(path);
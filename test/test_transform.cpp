@@ -2386,4 +2386,62 @@ TEST(Transform_ArrayClearVersusClearRegression)
     server->integrate_next_changeset_from(*client_2);
 }
 
+TEST(Transform_NonconflictingLocalChangesets)
+{
+    // Local changesets that touch none of the objects modified remotely are
+    // left out of the merge, unless they are connected to such objects
+    // through links set by other local changesets.
+
+    auto changeset_dump_dir_gen = get_changeset_dump_dir_generator(test_context);
+    Associativity assoc{test_context, 2, changeset_dump_dir_gen.get()};
+    assoc.for_each_permutation([&](auto& it) {
+        auto client_1 = &*it.clients[0];
+        auto client_2 = &*it.clients[1];
+
+        // Create baseline
+        client_1->transaction([&](Peer& c) {
+            auto& tr = *c.group;
+            auto table = tr.add_table_with_primary_key("class_Table", type_Int, "id");
+            table->add_column(type_Int, "int");
+            table->add_column(*table, "link");
+            for (int64_t i = 1; i <= 5; ++i)
+                table->create_object_with_primary_key(i);
+        });
+
+        it.sync_all();
+
+        client_1->history.advance_time(1);
+        client_1->transaction([&](Peer& c) {
+            auto table = c.group->get_table("class_Table");
+            table->get_object_with_primary_key(4).set("int", 1);
+        });
+        client_1->transaction([&](Peer& c) {
+            auto table = c.group->get_table("class_Table");
+            auto target = table->get_object_with_primary_key(3).get_key();
+            table->get_object_with_primary_key(2).set("link", target);
+        });
+        client_1->transaction([&](Peer& c) {
+            auto table = c.group->get_table("class_Table");
+            table->get_object_with_primary_key(2).set("int", 7);
+            table->get_object_with_primary_key(5).set("int", 8);
+        });
+
+        client_2->history.advance_time(2);
+        client_2->transaction([&](Peer& c) {
+            auto table = c.group->get_table("class_Table");
+            table->get_object_with_primary_key(3).remove();
+            table->get_object_with_primary_key(5).set("int", 9);
+        });
+
+        it.sync_all();
+
+        ReadTransaction read_server(it.server->shared_group);
+        auto table = read_server.get_table("class_Table");
+        CHECK_EQUAL(table->size(), 4);
+        CHECK_EQUAL(table->get_object_with_primary_key(2).template get<int64_t>("int"), 7);
+        CHECK_EQUAL(table->get_object_with_primary_key(4).template get<int64_t>("int"), 1);
+        CHECK_EQUAL(table->get_object_with_primary_key(5).template get<int64_t>("int"), 9);
+    });
+}
+
 } // unnamed namespace
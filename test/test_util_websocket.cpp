@@ -402,6 +402,41 @@ TEST(WebSocket_Messages)
     }
 }
 
+TEST(WebSocket_Batched_Messages)
+{
+    Fixture fixt{test_context.logger};
+    WSConfig& config_1 = fixt.config_1;
+    WSConfig& config_2 = fixt.config_2;
+
+    websocket::Socket& socket_1 = fixt.socket_1;
+    websocket::Socket& socket_2 = fixt.socket_2;
+
+    socket_1.initiate_client_handshake("/uri", "host", "protocol");
+    socket_2.initiate_server_handshake();
+
+    int n_handler_calls = 0;
+    auto handler = [&]() {
+        ++n_handler_calls;
+    };
+
+    // Client to server (masked) and server to client (unmasked)
+    std::vector<size_t> sizes{0, 1, 125, 126, 65535, 65536, 3};
+    std::string data;
+    for (size_t i = 0; i < sizes.size(); ++i)
+        data.append(sizes[i], char('a' + i));
+    socket_1.async_write_binary_batch(data.data(), sizes.data(), sizes.size(), handler);
+    CHECK_EQUAL(n_handler_calls, 1);
+    socket_2.async_write_binary_batch(data.data(), sizes.data(), sizes.size(), handler);
+    CHECK_EQUAL(n_handler_calls, 2);
+
+    for (WSConfig* config : {&config_2, &config_1}) {
+        if (CHECK_EQUAL(config->binary_messages.size(), sizes.size())) {
+            for (size_t i = 0; i < sizes.size(); ++i)
+                CHECK_EQUAL(config->binary_messages[i], std::string(sizes[i], char('a' + i)));
+        }
+    }
+}
+
 TEST(WebSocket_Fragmented_Messages)
 {
     Fixture fixt{test_context.logger};
@@ -435,6 +470,15 @@ TEST(WebSocket_Fragmented_Messages)
     socket_1.async_write_frame(true, websocket::Opcode::continuation, "C", 1, handler_no_op);
     CHECK_EQUAL(config_2.binary_messages.size(), 2);
     CHECK_EQUAL(config_2.binary_messages[1], "ABC");
+
+    // A short fragment followed by a large one, whose payload is written
+    // directly from the caller's buffer.
+    std::string body(100000, 'x');
+    socket_2.async_write_frame(false, websocket::Opcode::binary, "header\n", 7, handler_no_op);
+    CHECK_EQUAL(config_1.binary_messages.size(), 0);
+    socket_2.async_write_frame(true, websocket::Opcode::continuation, body.data(), body.size(), handler_no_op);
+    CHECK_EQUAL(config_1.binary_messages.size(), 1);
+    CHECK_EQUAL(config_1.binary_messages[0], "header\n" + body);
 }
 
 TEST(WebSocket_Interleaved_Fragmented_Messages)
@@ -596,18 +596,6 @@ bool compare_objects(const Obj& obj_1, const Obj& obj_2, const std::vector<Colum
     auto& table_2 = *ptable_2;
 
     for (const Column& col : columns) {
-        if (col.is_nullable()) {
-            bool a = obj_1.is_null(col.key_1);
-            bool b = obj_2.is_null(col.key_2);
-            if (a && b)
-                continue;
-            if (a || b) {
-                logger.error("Null/nonnull disagreement in column '%1' (%2 vs %3)", col.name, a, b);
-                equal = false;
-                continue;
-            }
-        }
-
         if (col.is_dictionary()) {
             auto a = obj_1.get_dictionary(col.key_1);
             auto b = obj_2.get_dictionary(col.key_2);
@@ -633,6 +621,18 @@ bool compare_objects(const Obj& obj_1, const Obj& obj_2, const std::vector<Colum
             continue;
         }
 
+        if (col.is_nullable()) {
+            bool a = obj_1.is_null(col.key_1);
+            bool b = obj_2.is_null(col.key_2);
+            if (a && b)
+                continue;
+            if (a || b) {
+                logger.error("Null/nonnull disagreement in column '%1' (%2 vs %3)", col.name, a, b);
+                equal = false;
+                continue;
+            }
+        }
+
         auto obj_a = obj_1;
         auto obj_b = obj_2;
         const bool nullable = table_1.is_nullable(col.key_1);